@@ -0,0 +1,94 @@
+#ifndef TPCH_ARROW_IPC_WRITER_HPP
+#define TPCH_ARROW_IPC_WRITER_HPP
+
+#include <memory>
+#include <string>
+#include <arrow/io/interfaces.h>
+#include <arrow/record_batch.h>
+
+#include "writer_interface.hpp"
+#include "buffer_lifetime_manager.hpp"
+
+// Forward declarations
+namespace arrow {
+namespace ipc {
+class RecordBatchWriter;
+}
+}
+
+namespace tpch {
+
+class GatherOutputStream;
+
+/**
+ * Arrow IPC writer: the record batches the converters build, written as an
+ * Arrow IPC file (Feather v2, "--format arrow", .arrow) or as an IPC stream
+ * ("--format arrow-stream", .arrows). No encoding beyond optional LZ4/ZSTD
+ * buffer compression, so it doubles as a generation-speed baseline.
+ *
+ * By default the output is a GatherOutputStream: body buffers go to the
+ * kernel in place with pwritev(2) (or io_uring writev when the driver
+ * injects a stream with a ring), without an intermediate serialization
+ * copy. set_output_stream_factory() accepts any other stream (pipe, S3,
+ * shared ring...), which then copies as usual.
+ */
+class ArrowIpcWriter : public WriterInterface {
+public:
+    /**
+     * Create an Arrow IPC writer for filepath. The file is created on the
+     * first write (the schema comes from the first batch).
+     *
+     * @param filepath Output path
+     * @param stream_format true: IPC stream format (no footer, no random access)
+     */
+    explicit ArrowIpcWriter(const std::string& filepath, bool stream_format = false);
+
+    ~ArrowIpcWriter() override;
+
+    /**
+     * Write a batch of rows. Its buffers are referenced until written.
+     *
+     * @throws std::runtime_error if the write fails or the schema changes
+     */
+    void write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) override;
+
+    /**
+     * Write a batch whose buffers wrap memory owned by the lifetime manager
+     * (true zero-copy converters); the manager is kept until the bytes are
+     * written, which may be after this call returns.
+     */
+    void write_managed_batch(const ManagedRecordBatch& managed_batch);
+
+    /**
+     * Write the footer (file format) or end-of-stream marker and close the file.
+     */
+    void close() override;
+
+    /**
+     * Replace the default GatherOutputStream with factory(filepath) (before first write).
+     */
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
+
+    /**
+     * Buffer compression: "none" (default), "lz4" (LZ4 frame) or "zstd".
+     *
+     * @throws std::runtime_error for any other codec
+     */
+    void set_compression(const std::string& codec);
+
+private:
+    void open(const std::shared_ptr<arrow::Schema>& schema);
+
+    std::string filepath_;
+    bool stream_format_;
+    std::string compression_ = "none";
+    bool closed_ = false;
+
+    std::shared_ptr<arrow::io::OutputStream> stream_;
+    std::shared_ptr<GatherOutputStream> gather_;   // stream_, when it gathers in place
+    std::shared_ptr<arrow::ipc::RecordBatchWriter> writer_;
+};
+
+}  // namespace tpch
+
+#endif  // TPCH_ARROW_IPC_WRITER_HPP
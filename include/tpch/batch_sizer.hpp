@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <arrow/type_fwd.h>
+
+namespace tpch {
+
+/**
+ * AdaptiveBatchSizer — picks generator→writer batch sizes in bytes, not rows.
+ *
+ * A fixed row count is wrong for every table at once: 8192 lineitem rows with
+ * comments are ~1.5 MB of Arrow output while 8192 region rows are a few KB.
+ * The sizer starts from a byte budget derived from the L2 cache (plus this
+ * CPU's share of L3), so that the dbgen rows being converted and the Arrow
+ * buffers being filled stay cache-resident, and converts it to rows with the
+ * measured bytes/row of the table.
+ *
+ * Row counts are then aligned to the writer's preferred unit (Parquet row
+ * group, ORC row-index stride, Lance max_rows_per_group): a batch either
+ * divides the unit exactly or is a whole multiple of it, so batches never
+ * straddle a unit boundary.
+ *
+ * Feedback: record() takes the measured conversion + encode time per batch.
+ * Every FEEDBACK_WINDOW full batches the sizer compares the cost per row with
+ * the previous window and hill-climbs the byte budget (×/÷ STEP) in the
+ * direction that lowered it, within [budget/4, budget×4].
+ *
+ * Not thread-safe; one sizer per generation loop.
+ */
+class AdaptiveBatchSizer {
+public:
+    static constexpr size_t DEFAULT_MIN_ROWS = 1024;
+    static constexpr size_t DEFAULT_MAX_ROWS = 65536;
+    static constexpr size_t FEEDBACK_WINDOW  = 8;
+    static constexpr double STEP             = 1.25;
+
+    /**
+     * @param row_bytes_estimate  initial Arrow bytes/row (see estimate_row_bytes)
+     * @param cache_bytes         byte budget; 0 = cache_budget_bytes()
+     */
+    explicit AdaptiveBatchSizer(size_t row_bytes_estimate, size_t cache_bytes = 0);
+
+    /**
+     * Align batches to the writer's natural unit.  Either argument may be 0;
+     * a byte unit is converted to rows with the current bytes/row estimate.
+     */
+    void set_writer_unit(size_t unit_rows, size_t unit_bytes);
+
+    /** Upper bound on rows per batch (e.g. memory-driven cap); 0 = DEFAULT_MAX_ROWS. */
+    void set_max_rows(size_t max_rows);
+
+    /** Pin the batch size (e.g. --batch-size); disables adaptation. 0 = adaptive. */
+    void set_fixed_rows(size_t rows);
+
+    /** Rows to request for the next batch. */
+    size_t rows() const { return rows_; }
+
+    /**
+     * Feed back one batch.
+     * @param rows             rows in the batch
+     * @param bytes            Arrow bytes produced (measure_batch_bytes)
+     * @param convert_seconds  time spent converting rows → RecordBatch
+     * @param write_seconds    time spent in writer->write_batch()
+     */
+    void record(size_t rows, int64_t bytes, double convert_seconds, double write_seconds);
+
+    /** Current byte budget per batch (after feedback scaling). */
+    size_t target_bytes() const;
+
+    /** Current bytes/row estimate (EWMA of measured batches). */
+    double row_bytes() const { return row_bytes_; }
+
+    /** Effective writer unit in rows (0 = none). */
+    size_t unit_rows() const;
+
+    /**
+     * Per-core cache budget: L2 + this core's share of L3, halved because the
+     * dbgen input rows and the Arrow output buffers are live together.
+     * Falls back to 1 MiB when sysconf/sysfs report nothing.
+     */
+    static size_t cache_budget_bytes();
+
+    /** Largest d <= rows with unit % d == 0 (d >= rows/2), else a multiple of unit. */
+    static size_t align_rows(size_t rows, size_t unit);
+
+private:
+    void recompute();
+
+    size_t cache_bytes_;
+    double row_bytes_;
+    double scale_ = 1.0;
+    int    direction_ = 1;
+    size_t unit_rows_ = 0;
+    size_t unit_bytes_ = 0;
+    size_t max_rows_ = DEFAULT_MAX_ROWS;
+    size_t fixed_rows_ = 0;
+    size_t rows_ = 0;
+
+    // feedback window
+    size_t window_batches_ = 0;
+    size_t window_rows_ = 0;
+    double window_seconds_ = 0.0;
+    double prev_cost_per_row_ = 0.0;
+};
+
+/** Schema-based Arrow bytes/row guess used before the first batch is measured. */
+size_t estimate_row_bytes(const arrow::Schema& schema);
+
+/** Sum of Arrow buffer sizes of a batch (dictionaries excluded). */
+int64_t measure_batch_bytes(const arrow::RecordBatch& batch);
+
+}  // namespace tpch
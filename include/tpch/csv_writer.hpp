@@ -3,27 +3,29 @@
 
 #include <memory>
 #include <string>
-#include <vector>
-#include <array>
-#include <bitset>
 #include <cstdint>
 
 #include "writer_interface.hpp"
+#include "io_uring_output_stream.hpp"
 
 namespace tpch {
 
-class AsyncIOContext;
-
 /**
  * CSV writer implementation using Arrow's CSV API.
  * Writes Arrow RecordBatch data to CSV files with proper escaping and quoting.
- * Supports optional async I/O with io_uring when AsyncIOContext is provided.
+ *
+ * Each batch is formatted into one string and handed to an
+ * arrow::io::OutputStream. By default that is a synchronous
+ * IoUringOutputStream (1 MiB aligned staging buffer, pwrite), which also
+ * provides O_DIRECT and page-cache control; set_output_stream_factory()
+ * replaces it with an io_uring, shared-ring or I/O-process stream.
  */
 class CSVWriter : public WriterInterface {
 public:
     /**
      * Create a CSV writer for the specified filepath.
-     * The file will be created or overwritten.
+     * The file is created or overwritten on the first write (or on close),
+     * so an injected stream never touches filepath on disk.
      *
      * @param filepath Path to the output CSV file
      * @param use_direct_io Enable O_DIRECT for bypassing page cache (default: false)
@@ -46,43 +48,26 @@ public:
     void close() override;
 
     /**
-     * Set async I/O context for non-blocking writes.
-     *
-     * @param context AsyncIOContext for io_uring support
+     * Replace the default stream with factory(filepath) (before first write).
      */
-    void set_async_context(std::shared_ptr<AsyncIOContext> context) override;
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
 
     /**
      * Enable or disable O_DIRECT mode (must be called before first write).
      * O_DIRECT bypasses page cache for direct disk writes, improving throughput for large sequential writes.
+     * Only applies to the default stream; injected streams carry their own config.
      *
-     * @param enable Enable O_DIRECT (requires buffer alignment)
+     * @param enable Enable O_DIRECT (tail padding is truncated on close)
      */
     void enable_direct_io(bool enable);
 
 private:
     std::string filepath_;
-    int file_descriptor_ = -1;
     bool header_written_ = false;
-    std::shared_ptr<AsyncIOContext> async_context_;
-    static constexpr size_t BUFFER_SIZE = 1024 * 1024;  // 1MB buffer
-    static constexpr size_t NUM_BUFFERS = 8;  // Match reasonable queue depth
-    static constexpr size_t ALIGNMENT = 4096;  // O_DIRECT alignment requirement
-
-    // O_DIRECT support
-    bool use_direct_io_ = false;
-
-    // Buffer pool for async I/O
-    std::array<std::vector<uint8_t>, NUM_BUFFERS> buffer_pool_;
-    std::bitset<NUM_BUFFERS> buffer_in_flight_;  // Track which are pending
-    size_t current_buffer_idx_ = 0;
-    size_t buffer_fill_size_ = 0;  // Current fill level of active buffer
-    off_t current_offset_ = 0;  // Track cumulative file position
-
-    /**
-     * Initialize aligned buffers for O_DIRECT if enabled.
-     */
-    void init_aligned_buffers();
+    bool closed_ = false;
+    bool injected_ = false;               // stream_ came from a factory
+    IoUringStreamConfig stream_config_;   // default stream settings
+    std::shared_ptr<arrow::io::OutputStream> stream_;
 
     /**
      * Write CSV header (field names) to the output.
@@ -101,37 +86,18 @@ private:
     static std::string escape_csv_value(const std::string& value);
 
     /**
-     * Flush buffered data (async or sync).
+     * Open the default IoUringOutputStream on filepath_ with stream_config_
+     * (lazily, unless a factory was injected first).
      */
-    void flush_buffer();
+    void open_default_stream();
 
     /**
-     * Write data directly or buffer for async I/O.
+     * Write data to the output stream.
      *
      * @param data Pointer to data
      * @param size Number of bytes
      */
     void write_data(const void* data, size_t size);
-
-    /**
-     * Acquire a free buffer from the pool.
-     * Waits for completion if all buffers are in-flight.
-     *
-     * @return Index of free buffer
-     */
-    size_t acquire_buffer();
-
-    /**
-     * Wait for at least one in-flight operation to complete.
-     */
-    void wait_for_completion();
-
-    /**
-     * Release a buffer back to the pool (mark as not in-flight).
-     *
-     * @param idx Buffer index
-     */
-    void release_buffer(size_t idx);
 };
 
 }  // namespace tpch
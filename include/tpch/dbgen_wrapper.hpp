@@ -9,12 +9,21 @@
 #include <span>
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 
 #include <arrow/api.h>
 
 // Include dbgen types and API
 extern "C" {
 #include "tpch_dbgen.h"
+
+// Whole-Seed[] save/load (src/dbgen/dbgen_stubs.c); lets batch iterators
+// keep private RNG state so several tables can be interleaved in one process.
+size_t dbgen_seed_state_size(void);
+void dbgen_save_seed_state(void* dst);
+void dbgen_load_seed_state(const void* src);
 }
 
 namespace tpch {
@@ -122,6 +131,72 @@ struct DBGenBatch {
     bool empty() const { return rows.empty(); }
 };
 
+/**
+ * Batch handed out from a BatchRing slot.
+ *
+ * Non-owning: rows point into the iterator's preallocated ring and stay valid
+ * until the batch is given back with release().  Copying converters (the
+ * *_to_recordbatch family) can release right after conversion.
+ */
+template<typename T>
+struct RingBatch {
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    std::span<const T> rows;
+    size_t slot = NO_SLOT;
+
+    std::span<const T> span() const { return rows; }
+    size_t size() const { return rows.size(); }
+    bool empty() const { return rows.empty(); }
+};
+
+/**
+ * Fixed ring of K preallocated row buffers.
+ *
+ * Slots are allocated once (and regrown only when a larger batch size is
+ * requested), so the steady-state generation loop performs no heap
+ * allocation.  Acquiring while all K slots are still held is a caller bug
+ * (batches not released) and throws.
+ */
+template<typename T>
+class BatchRing {
+public:
+    explicit BatchRing(size_t slots = 2) : slots_(slots > 0 ? slots : 1) {}
+
+    /** Take the next free slot with room for at least `capacity` rows. */
+    size_t acquire(size_t capacity) {
+        for (size_t probe = 0; probe < slots_.size(); ++probe) {
+            size_t idx = (next_ + probe) % slots_.size();
+            Slot& slot = slots_[idx];
+            if (slot.in_use) continue;
+            if (slot.rows.size() < capacity) {
+                slot.rows.resize(capacity);
+            }
+            slot.in_use = true;
+            next_ = (idx + 1) % slots_.size();
+            return idx;
+        }
+        throw std::runtime_error("BatchRing: all " + std::to_string(slots_.size()) +
+                                 " slots in use; release() batches before requesting more");
+    }
+
+    T* data(size_t slot) { return slots_[slot].rows.data(); }
+
+    void release(size_t slot) {
+        if (slot < slots_.size()) slots_[slot].in_use = false;
+    }
+
+    size_t slots() const { return slots_.size(); }
+
+private:
+    struct Slot {
+        std::vector<T> rows;
+        bool in_use = false;
+    };
+    std::vector<Slot> slots_;
+    size_t next_ = 0;
+};
+
 /**
  * C++ wrapper around TPC-H dbgen reference implementation
  *
@@ -137,6 +212,9 @@ struct DBGenBatch {
  * 1. Single-threaded: One DBGenWrapper per process/thread
  * 2. Multi-process: Fork separate processes (OS provides memory isolation)
  * 3. Sequential: Generate one table completely before next
+ * 4. Interleaved batch iterators from one thread: each iterator swaps its
+ *    own copy of Seed[] in around next()/next_span(), so iterators of
+ *    different tables may be stepped alternately (see --single-process)
  *
  * UNSAFE patterns:
  * - Calling generate_*() from multiple threads concurrently
@@ -340,150 +418,152 @@ public:
             } else if constexpr (Traits::table == TableType::REGION) {
                 row_start(DBGEN_REGION);
             }
+
+            // Own copy of Seed[]: swapped in around every fill() so iterators of
+            // different tables (or orders + lineitem, which both drive mk_order)
+            // can be stepped alternately without disturbing each other.
+            seeds_.resize(dbgen_seed_state_size());
+            dbgen_save_seed_state(seeds_.data());
         }
 
         bool has_next() const { 
             return remaining_ > 0 && current_source_row_ <= total_source_rows_;
         }
 
+        /**
+         * Change the row count used by subsequent next() calls.
+         * Lets an AdaptiveBatchSizer retune the batch between calls.
+         */
+        void set_batch_size(size_t batch_size) {
+            if (batch_size > 0) batch_size_ = batch_size;
+        }
+
+        size_t batch_size() const { return batch_size_; }
+
+        /**
+         * Return the next batch as an owning vector.
+         * Allocates per call; prefer next_span() in hot loops.
+         */
         Batch next() {
             Batch batch;
             if (!has_next()) return batch;
 
-            batch.rows.reserve(std::min(batch_size_, remaining_));
-
-            while (batch.rows.size() < batch_size_ && remaining_ > 0 && current_source_row_ <= total_source_rows_) {
-                Row r{};
-                if constexpr (Traits::table == TableType::ORDERS) {
-                        if (mk_order(static_cast<DSS_HUGE>(current_source_row_), &r, 0) < 0) { remaining_ = 0; break; }
-                        batch.rows.push_back(r);
-                        remaining_--;
-                        current_source_row_++;
-                } else if constexpr (Traits::table == TableType::CUSTOMER) {
-                    if (mk_cust(static_cast<DSS_HUGE>(current_source_row_), &r) < 0) { remaining_ = 0; break; }
-                    batch.rows.push_back(r);
-                    remaining_--;
-                    current_source_row_++;
-                } else if constexpr (Traits::table == TableType::PART) {
-                    if (mk_part(static_cast<DSS_HUGE>(current_source_row_), &r) < 0) { remaining_ = 0; break; }
-                    batch.rows.push_back(r);
-                    remaining_--;
-                    current_source_row_++;
-                } else if constexpr (Traits::table == TableType::SUPPLIER) {
-                    if (mk_supp(static_cast<DSS_HUGE>(current_source_row_), &r) < 0) { remaining_ = 0; break; }
-                    batch.rows.push_back(r);
-                    remaining_--;
-                    current_source_row_++;
-                } else if constexpr (Traits::table == TableType::NATION) {
-                    if (mk_nation(static_cast<DSS_HUGE>(current_source_row_), &r) < 0) { remaining_ = 0; break; }
-                    batch.rows.push_back(r);
-                    remaining_--;
-                    current_source_row_++;
-                } else if constexpr (Traits::table == TableType::REGION) {
-                    if (mk_region(static_cast<DSS_HUGE>(current_source_row_), &r) < 0) { remaining_ = 0; break; }
-                    batch.rows.push_back(r);
-                    remaining_--;
-                    current_source_row_++;
-                } else if constexpr (Traits::table == TableType::LINEITEM) {
-                    // First, resume any pending children from a partially-emitted order
-                    while (pending_index_ < pending_children_.size() && batch.rows.size() < batch_size_ && remaining_ > 0) {
-                        batch.rows.push_back(pending_children_[pending_index_++]);
-                        remaining_--;
-                    }
-
-                    if (pending_index_ == pending_children_.size() && !pending_children_.empty()) {
-                        // We finished emitting the pending order's children; advance to next order
-                        pending_children_.clear();
-                        pending_index_ = 0;
-                        current_source_row_++;
-                    }
-
-                    if (batch.rows.size() >= batch_size_ || remaining_ == 0) break;
-
-                    // No pending children (or we completed them) — generate the next order
-                    if (current_source_row_ > total_source_rows_) break; 
-                    
-                    order_t ord{};
-                    if (mk_order(static_cast<DSS_HUGE>(current_source_row_), &ord, 0) < 0) { remaining_ = 0; break; }
-
-                    // Fill pending_children_ with this order's lineitems and emit as many as fit
-                    pending_children_.clear();
-                    pending_index_ = 0;
-                    for (int j = 0; j < (int)ord.lines && j < O_LCNT_MAX; ++j) {
-                        pending_children_.push_back(ord.l[j]);
-                    }
-
-                    // Emit from pending_children_ in this same loop iteration
-                    while (pending_index_ < pending_children_.size() && batch.rows.size() < batch_size_ && remaining_ > 0) {
-                        batch.rows.push_back(pending_children_[pending_index_++]);
-                        remaining_--;
-                    }
-
-                    // If we consumed all children, advance to next order now
-                    if (pending_index_ == pending_children_.size()) {
-                        pending_children_.clear();
-                        pending_index_ = 0;
-                        current_source_row_++;
-                    }
+            batch.rows.resize(std::min(batch_size_, remaining_));
+            batch.rows.resize(fill(batch.rows.data(), batch.rows.size()));
+            return batch;
+        }
 
-                    // If batch is full or we're done, break; otherwise continue outer while
-                    if (batch.rows.size() >= batch_size_ || remaining_ == 0) break;
-                    else continue;
-                } else if constexpr (Traits::table == TableType::PARTSUPP) {
-                    // Resume any pending partsupp children
-                    while (pending_index_ < pending_children_.size() && batch.rows.size() < batch_size_ && remaining_ > 0) {
-                        batch.rows.push_back(pending_children_[pending_index_++]);
-                        remaining_--;
-                    }
+        /**
+         * Return the next batch filled in place into a preallocated ring slot.
+         * The span stays valid until release(); at most ring_slots() batches
+         * may be outstanding at once.
+         */
+        RingBatch<Row> next_span() {
+            RingBatch<Row> batch;
+            if (!has_next()) return batch;
 
-                    if (pending_index_ == pending_children_.size() && !pending_children_.empty()) {
-                        pending_children_.clear();
-                        pending_index_ = 0;
-                        current_source_row_++;
-                    }
+            const size_t want = std::min(batch_size_, remaining_);
+            const size_t slot = ring_.acquire(want);
+            Row* out = ring_.data(slot);
+            batch.rows = std::span<const Row>(out, fill(out, want));
+            batch.slot = slot;
+            return batch;
+        }
 
-                    if (batch.rows.size() >= batch_size_ || remaining_ == 0) break;
+        /** Give a next_span() batch's slot back to the ring. */
+        void release(RingBatch<Row>& batch) {
+            if (batch.slot != RingBatch<Row>::NO_SLOT) {
+                ring_.release(batch.slot);
+            }
+            batch.slot = RingBatch<Row>::NO_SLOT;
+        }
 
-                    if (current_source_row_ > total_source_rows_) break;
+        /**
+         * Number of ring slots (default 2).  Raise it when a consumer keeps
+         * references to several batches, e.g. Buffer::Wrap'd conversions.
+         * Must be called before the first next_span().
+         */
+        void set_ring_slots(size_t slots) { ring_ = BatchRing<Row>(slots); }
 
-                    part_t prt{};
-                    if (mk_part(static_cast<DSS_HUGE>(current_source_row_), &prt) < 0) { remaining_ = 0; break; }
+        size_t ring_slots() const { return ring_.slots(); }
 
-                    pending_children_.clear();
-                    pending_index_ = 0;
-                    for (int j = 0; j < SUPP_PER_PART; ++j) {
-                        pending_children_.push_back(prt.s[j]);
+    private:
+        /**
+         * Generate up to `capacity` rows directly into `out`; returns rows written.
+         *
+         * LINEITEM/PARTSUPP: mk_order/mk_part fill fixed child arrays inside
+         * order_t/part_t, so children are copied once from the member parent
+         * into `out`.  A parent whose children span a batch boundary is kept in
+         * parent_ and resumed on the next call (no intermediate buffer).
+         */
+        size_t fill(Row* out, size_t capacity) {
+            dbgen_load_seed_state(seeds_.data());
+            size_t n = 0;
+
+            while (n < capacity && remaining_ > 0 && current_source_row_ <= total_source_rows_) {
+                const auto row_num = static_cast<DSS_HUGE>(current_source_row_);
+                if constexpr (Traits::table == TableType::LINEITEM ||
+                              Traits::table == TableType::PARTSUPP) {
+                    if (child_next_ == child_count_) {
+                        parent_ = Parent{};
+                        if constexpr (Traits::table == TableType::LINEITEM) {
+                            if (mk_order(row_num, &parent_, 0) < 0) { remaining_ = 0; break; }
+                            child_count_ = std::min<size_t>(static_cast<size_t>(parent_.lines), O_LCNT_MAX);
+                        } else {
+                            if (mk_part(row_num, &parent_) < 0) { remaining_ = 0; break; }
+                            child_count_ = SUPP_PER_PART;
+                        }
+                        child_next_ = 0;
                     }
 
-                    while (pending_index_ < pending_children_.size() && batch.rows.size() < batch_size_) {
-                        batch.rows.push_back(pending_children_[pending_index_++]);
+                    while (child_next_ < child_count_ && n < capacity && remaining_ > 0) {
+                        if constexpr (Traits::table == TableType::LINEITEM) {
+                            out[n++] = parent_.l[child_next_++];
+                        } else {
+                            out[n++] = parent_.s[child_next_++];
+                        }
                         remaining_--;
                     }
 
-                    if (pending_index_ == pending_children_.size()) {
-                        pending_children_.clear();
-                        pending_index_ = 0;
+                    if (child_next_ == child_count_) {
+                        // All children of this parent emitted; advance to the next one
+                        child_next_ = child_count_ = 0;
                         current_source_row_++;
                     }
-
-                    if (batch.rows.size() >= batch_size_ || remaining_ == 0) break;
-                    else continue;
                 } else {
-                    static_assert(always_false<Traits>::value, "Unsupported batch iterator table");
+                    Row& r = out[n];
+                    r = Row{};
+                    int rc;
+                    if constexpr (Traits::table == TableType::ORDERS) {
+                        rc = static_cast<int>(mk_order(row_num, &r, 0));
+                    } else if constexpr (Traits::table == TableType::CUSTOMER) {
+                        rc = static_cast<int>(mk_cust(row_num, &r));
+                    } else if constexpr (Traits::table == TableType::PART) {
+                        rc = static_cast<int>(mk_part(row_num, &r));
+                    } else if constexpr (Traits::table == TableType::SUPPLIER) {
+                        rc = static_cast<int>(mk_supp(row_num, &r));
+                    } else if constexpr (Traits::table == TableType::NATION) {
+                        rc = static_cast<int>(mk_nation(row_num, &r));
+                    } else if constexpr (Traits::table == TableType::REGION) {
+                        rc = static_cast<int>(mk_region(row_num, &r));
+                    } else {
+                        static_assert(always_false<Traits>::value, "Unsupported batch iterator table");
+                    }
+                    if (rc < 0) { remaining_ = 0; break; }
+                    n++;
+                    remaining_--;
+                    current_source_row_++;
                 }
             }
 
             // Stop generation if complete.
             if (remaining_ == 0 || current_source_row_ > total_source_rows_) {
-               // ... cleanup logic (unchanged) ...
-               if (current_source_row_ > total_source_rows_) {
+                if (current_source_row_ > total_source_rows_) {
                     remaining_ = 0;
-               } 
-               // ...
-               if constexpr (Traits::table == TableType::ORDERS) {
+                }
+                if constexpr (Traits::table == TableType::ORDERS) {
                     row_stop(DBGEN_ORDER);
                 } else if constexpr (Traits::table == TableType::CUSTOMER) {
-
                     row_stop(DBGEN_CUST);
                 } else if constexpr (Traits::table == TableType::PART) {
                     row_stop(DBGEN_PART);
@@ -500,20 +580,29 @@ public:
                 }
             }
 
-            return batch;
+            dbgen_save_seed_state(seeds_.data());
+            return n;
         }
 
-    private:
+        // Parent row type whose children this iterator emits (order_t for
+        // LINEITEM, part_t for PARTSUPP); unused otherwise.
+        using Parent = std::conditional_t<Traits::table == TableType::LINEITEM, order_t,
+                       std::conditional_t<Traits::table == TableType::PARTSUPP, part_t, char>>;
+
         DBGenWrapper* wrapper_;
         size_t batch_size_;
         size_t remaining_;
         size_t current_source_row_;
         size_t total_source_rows_;
-        // Buffer to hold child rows when an order/part's children are split
-        // across batch boundaries (LINEITEM, PARTSUPP). We keep them here
-        // and resume emitting on the next next() call.
-        std::vector<Row> pending_children_;
-        size_t pending_index_ = 0;
+        // Parent whose children are split across batch boundaries
+        // (LINEITEM, PARTSUPP); emission resumes at child_next_.
+        Parent parent_{};
+        size_t child_next_ = 0;
+        size_t child_count_ = 0;
+        // Preallocated output slots for next_span()
+        BatchRing<Row> ring_;
+        // This iterator's dbgen Seed[] state between fill() calls
+        std::vector<unsigned char> seeds_;
     };
 
     /**
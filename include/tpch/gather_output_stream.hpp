@@ -0,0 +1,153 @@
+#pragma once
+
+#include <arrow/buffer.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/status.h>
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tpch {
+
+/** Tuning knobs for GatherOutputStream. */
+struct GatherStreamConfig {
+    /** Bytes gathered into one writev (pwritev or io_uring writev). */
+    size_t batch_bytes = size_t{8} << 20;
+
+    /**
+     * Bytes queued in the kernel (io_uring mode). Write() reaps completions
+     * while a new batch would exceed it.
+     */
+    size_t max_inflight_bytes = size_t{32} << 20;
+
+    /**
+     * Buffers smaller than this (IPC message headers, padding) and all raw
+     * Write(data, nbytes) calls are copied into a small arena instead of
+     * getting an iovec of their own.
+     */
+    size_t copy_threshold = size_t{4} << 10;
+
+    /** Close() issues fdatasync(2) after draining. */
+    bool fdatasync_on_close = false;
+};
+
+/**
+ * Arrow OutputStream that writes Arrow buffers in place with gathered writes.
+ *
+ * Built for ArrowIpcWriter: Arrow's IPC writer hands every record batch
+ * body buffer to Write(std::shared_ptr<Buffer>), so the column data can go
+ * to the kernel straight from the buffers the converter built.
+ * - Write(buffer) keeps a reference to the buffer and appends an iovec;
+ *   small buffers and Write(data, nbytes) are copied into an arena.
+ * - Once batch_bytes are gathered, they go out as one pwritev(2), or as one
+ *   io_uring writev SQE when a ring is given. In-flight batches hold their
+ *   buffer references until the CQE arrives; at most max_inflight_bytes are
+ *   queued (Write() reaps while the window is full).
+ * - Buffers that don't own their memory (Buffer::Wrap over a vector kept
+ *   alive elsewhere) need that owner to outlive the write: pass it to
+ *   retain() right after the write that references it.
+ * - Errors (failed CQEs) are recorded and returned by the next Write(),
+ *   Flush() or Close(). Short writes are resubmitted.
+ * - Close() submits the tail, drains every CQE, optionally fdatasyncs, then
+ *   closes the fd.
+ *
+ * No O_DIRECT: Arrow buffers are only 8/64-byte aligned.
+ *
+ * Thread safety: NOT thread-safe (single producer, like the writers).
+ */
+class GatherOutputStream : public arrow::io::OutputStream {
+public:
+    /**
+     * Open path (O_WRONLY | O_CREAT | O_TRUNC).
+     *
+     * @param ring_struct Opaque io_uring* from IoUringPool::create_child_ring_struct(),
+     *                    or nullptr for synchronous pwritev. The stream takes
+     *                    ownership and frees it with IoUringPool::free_ring().
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    explicit GatherOutputStream(const std::string& path, void* ring_struct = nullptr,
+                                GatherStreamConfig config = {});
+    ~GatherOutputStream() override;
+
+    GatherOutputStream(const GatherOutputStream&) = delete;
+    GatherOutputStream& operator=(const GatherOutputStream&) = delete;
+
+    // ---- arrow::io::OutputStream ----
+
+    /** Copy into the arena. */
+    arrow::Status Write(const void* data, int64_t nbytes) override;
+
+    /** Reference the buffer in place (copied if below copy_threshold). */
+    arrow::Status Write(const std::shared_ptr<arrow::Buffer>& data) override;
+
+    /** Submit what is gathered (does not wait for io_uring completions). */
+    arrow::Status Flush() override;
+
+    /** Submit the tail, drain all CQEs, optional fdatasync, close the fd. */
+    arrow::Status Close() override;
+
+    arrow::Result<int64_t> Tell() const override;
+    bool closed() const override;
+
+    /**
+     * Keep owner alive until every byte written so far is on its way to the
+     * file (written, or its CQE reaped).
+     */
+    void retain(std::shared_ptr<void> owner);
+
+    /** Bytes currently queued in the kernel (0 in sync mode). */
+    size_t inflight_bytes() const { return inflight_bytes_; }
+
+    /** Bytes that went out from caller buffers without a copy. */
+    int64_t gathered_bytes() const { return gathered_bytes_; }
+
+private:
+    // One writev: its iovecs and everything they point into.
+    struct Batch {
+        std::vector<struct iovec>          iov;
+        std::vector<std::shared_ptr<void>> refs;
+        size_t  bytes   = 0;
+        size_t  written = 0;   // confirmed by pwritev / CQEs
+        int64_t offset  = 0;   // file offset of the first byte
+    };
+
+    void append(const uint8_t* ptr, size_t len, std::shared_ptr<void> ref);
+    arrow::Status copy_in(const uint8_t* ptr, size_t len);
+
+    // Hand pending_ to the kernel (or pwritev it in sync mode).
+    void submit_pending();
+
+    // Queue the unwritten part of inflight_[idx] as one writev SQE.
+    void queue_writev(size_t idx);
+
+    // Process available CQEs (wait for at least one if block). False if the
+    // ring itself failed, so callers stop waiting.
+    bool reap(bool block);
+    void drain();
+
+    arrow::Status write_sync(Batch& batch);
+    void record_error(arrow::Status st);
+
+    int                fd_   = -1;
+    void*              ring_ = nullptr;  // io_uring*, owned
+    GatherStreamConfig config_;
+    bool               closed_ = false;
+    arrow::Status      error_;
+
+    Batch pending_;
+    std::shared_ptr<arrow::ResizableBuffer> arena_;  // current copy arena
+    size_t arena_used_ = 0;
+
+    std::vector<std::unique_ptr<Batch>> inflight_;   // slot per in-flight SQE (nullptr = free)
+    size_t  inflight_bytes_ = 0;
+    int64_t write_offset_   = 0;   // file offset of pending_
+    int64_t position_       = 0;
+    int64_t gathered_bytes_ = 0;
+};
+
+}  // namespace tpch
@@ -5,10 +5,18 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include <unordered_map>
 #include <arrow/record_batch.h>
 
 #include "writer_interface.hpp"
 
+namespace parquet {
+class FileMetaData;
+namespace arrow {
+class FileWriter;
+}  // namespace arrow
+}  // namespace parquet
+
 namespace tpch {
 
 /**
@@ -27,8 +35,8 @@ namespace tpch {
  *       manifest-1.avro          - Manifest file  (Avro binary, per spec)
  *       version-hint.text        - Pointer to current metadata version
  *     data/
- *       data_00000.parquet
- *       data_00001.parquet
+ *       data_00000.parquet       - unpartitioned table
+ *       l_shipdate_month=1995-03/data_00001.parquet  - partitioned table
  *       ...
  *
  * Iceberg v1 compliance:
@@ -36,10 +44,25 @@ namespace tpch {
  *     (not JSON) as required by the specification.
  *   - Column field IDs are 1-based (field 1 … N).
  *   - Per-file record counts and file sizes are populated accurately.
- *   - Unpartitioned tables only (single partition spec with no fields).
+ *   - Per-file column statistics (column sizes, value and null counts,
+ *     lower/upper bounds) come from the Parquet footer, so engines can
+ *     prune files; Parquet columns carry their Iceberg field IDs.
+ *   - One partition spec: unpartitioned, or identity, year, month, day and
+ *     truncate[W] fields (set_partition_spec).
  *   - Single schema version (no schema evolution).
  *   - Append-only snapshots.
  *   - Parquet backing format.
+ *
+ * Data files are streamed: each partition keeps one open Parquet file and
+ * buffers rows only until a row group is full, and all partitions together
+ * hold at most the write buffer (set_write_buffer_size) before the largest
+ * one is written out as a row group. A file is closed once it reaches the
+ * target file size, so memory stays bounded at any scale factor.
+ *
+ * Several writers can fill one table (two-phase commit): each one defers
+ * its commit (set_deferred_commit) and, on close(), leaves its data files
+ * plus a sidecar in _pending/ describing them. commit() then turns every
+ * sidecar into a single manifest and snapshot.
  */
 class IcebergWriter : public WriterInterface {
 public:
@@ -54,7 +77,48 @@ public:
     explicit IcebergWriter(const std::string& table_path,
                            const std::string& table_name = "tpch_table");
 
-    ~IcebergWriter() override = default;
+    ~IcebergWriter() override;
+
+    /** Iceberg's default write.target-file-size-bytes. */
+    static constexpr int64_t DEFAULT_TARGET_FILE_SIZE = 512LL << 20;
+
+    /** Arrow bytes buffered over all open partitions before a row group is forced. */
+    static constexpr int64_t DEFAULT_WRITE_BUFFER_SIZE = 256LL << 20;
+
+    /** One field of the partition spec: transform of a source column. */
+    struct PartitionField {
+        std::string source;     // source column name
+        std::string transform;  // identity, year, month, day or truncate
+        int64_t     width = 0;  // truncate width
+        std::string name;       // partition field name, e.g. l_shipdate_month
+    };
+
+    /** Value of one partition field; null if the source value was null. */
+    struct PartitionValue {
+        bool        is_null = true;
+        int64_t     number  = 0;  // every transform but identity of a string
+        std::string text;         // identity of a string column
+    };
+
+    /** Per-column statistics of a data file, keyed by Iceberg field ID. */
+    struct ColumnStats {
+        int32_t     field_id;
+        int64_t     column_size;  // compressed bytes
+        int64_t     value_count;  // including nulls
+        int64_t     null_count;
+        bool        has_bounds = false;
+        std::string lower_bound;  // Iceberg single-value binary serialization
+        std::string upper_bound;
+    };
+
+    // Metadata tracked for each written data file.
+    struct DataFileInfo {
+        std::string filename;      // relative to data/, e.g. "l_shipdate_month=1995-03/data_00000.parquet"
+        int64_t     record_count;
+        int64_t     file_size;     // bytes
+        std::vector<PartitionValue> partition;
+        std::vector<ColumnStats>    columns;
+    };
 
     /**
      * Write a batch of records to the Iceberg table.
@@ -74,12 +138,69 @@ public:
      */
     void close() override;
 
+    /** Open each Parquet data file via factory instead of FileOutputStream. */
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
+
+    /**
+     * Partition the table by spec, a comma-separated list of fields:
+     * "col" (identity), "year(col)", "month(col)", "day(col)" or
+     * "truncate[W](col)", e.g. "month(l_shipdate)" or
+     * "truncate[30](ss_sold_date_sk)". Fields whose column the table lacks
+     * are dropped, so one spec can serve several tables. year, month and day
+     * of a string column of ISO dates (TPC-H's l_shipdate) make that column
+     * an Iceberg date. Must be called before the first write.
+     *
+     * @throws std::invalid_argument for a malformed spec, or (at the first
+     *         write) a transform the column's type does not support
+     */
+    void set_partition_spec(const std::string& spec);
+
+    /** Close data files once they reach bytes (default DEFAULT_TARGET_FILE_SIZE). */
+    void set_target_file_size(int64_t bytes);
+
+    /** Bound on rows buffered over all partitions (default DEFAULT_WRITE_BUFFER_SIZE). */
+    void set_write_buffer_size(int64_t bytes);
+
+    /** Parse a partition spec (see set_partition_spec). @throws std::invalid_argument */
+    static std::vector<PartitionField> parse_partition_spec(const std::string& spec);
+
+    /** Partition fields in effect: the spec minus columns the table lacks. */
+    const std::vector<PartitionField>& partition_fields() const { return partition_fields_; }
+
+    /** Data files written so far; complete after close(). */
+    const std::vector<DataFileInfo>& data_files() const { return written_files_; }
+
+    /**
+     * Write data files only: close() leaves them uncommitted, described by
+     * _pending/<writer_id>.json (files, partition values, column stats),
+     * for commit(). Data files are named after writer_id, so writers with
+     * distinct ids can share a table. Must be called before the first write.
+     *
+     * @throws std::invalid_argument unless writer_id is [A-Za-z0-9_.-]+
+     */
+    void set_deferred_commit(const std::string& writer_id);
+
+    /**
+     * Commit what every deferred writer left in table_path as one snapshot:
+     * read the sidecars in _pending/, write manifest, manifest list,
+     * metadata and version hint, then remove _pending/.
+     *
+     * @return data files committed; 0 if there are no sidecars
+     * @throws std::runtime_error if the table already has a snapshot or the
+     *         sidecars disagree on schema or partition spec
+     */
+    static size_t commit(const std::string& table_path);
+
 private:
-    // Metadata tracked for each written data file.
-    struct DataFileInfo {
-        std::string filename;      // basename only, e.g. "data_00000.parquet"
-        int64_t     record_count;
-        int64_t     file_size;     // bytes
+    struct Partition;
+
+    // What committing needs of the table: fixed at the first write, carried by sidecars.
+    struct Layout {
+        std::string schema;                 // Iceberg schema JSON
+        int32_t     last_column_id = 0;
+        std::string partition_spec;         // JSON array of partition fields
+        std::string manifest_entry_schema;  // Avro, with this table's partition record
+        std::vector<bool> string_partitions;  // per partition field: string-valued
     };
 
     std::string table_path_;
@@ -90,16 +211,61 @@ private:
     int32_t file_count_           = 0;
     int64_t current_snapshot_id_  = 1;
 
-    // RecordBatches accumulated until the per-file row threshold is met.
-    std::vector<std::shared_ptr<arrow::RecordBatch>> batches_;
+    OutputStreamFactory stream_factory_;  // empty = arrow::io::FileOutputStream
+    std::shared_ptr<arrow::Schema> file_schema_;  // schema_ plus PARQUET:field_id
+    int64_t target_file_size_  = DEFAULT_TARGET_FILE_SIZE;
+    int64_t write_buffer_size_ = DEFAULT_WRITE_BUFFER_SIZE;
+
+    std::vector<PartitionField> partition_fields_;
+    std::vector<int> partition_sources_;  // schema index of each field's source column
+    std::vector<int> date_columns_;       // ISO-date string columns written as dates
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    std::unordered_map<std::string, size_t> partition_index_;  // encoded values → partitions_
+    int64_t buffered_bytes_ = 0;          // Arrow bytes pending over all partitions
+
     // One entry per Parquet file written to data/.
     std::vector<DataFileInfo> written_files_;
 
+    Layout layout_;
+    std::string writer_id_;  // non-empty: deferred commit
+
     // Initialise subdirectories and lock schema on the first batch.
     void initialize_iceberg_table(const std::shared_ptr<arrow::RecordBatch>& first_batch);
 
-    // Flush accumulated batches → one Parquet data file; update written_files_.
-    std::string write_data_file();
+    // batch with its date_columns_ parsed into date32.
+    std::shared_ptr<arrow::RecordBatch> convert_dates(
+        const std::shared_ptr<arrow::RecordBatch>& batch) const;
+
+    // Partition of row i of batch, created on first use; key is scratch space.
+    Partition& partition_of(const arrow::RecordBatch& batch, int64_t i, std::string& key);
+
+    // Buffer rows of one partition; write a row group when it is full.
+    void add_rows(Partition& partition, const std::shared_ptr<arrow::RecordBatch>& rows);
+
+    // Write the pending rows of partition as one row group; roll the file at the target size.
+    void write_row_group(Partition& partition);
+
+    // Open the next data file of partition.
+    void open_data_file(Partition& partition);
+
+    // Close the data file of partition; record it in written_files_.
+    void close_data_file(Partition& partition);
+
+    // Column statistics of a closed data file, from its Parquet footer.
+    std::vector<ColumnStats> column_stats(const parquet::FileMetaData& metadata) const;
+
+    // Iceberg schema and partition spec as JSON (metadata and manifest headers).
+    std::string schema_json() const;
+    std::string partition_spec_json() const;
+
+    // Avro schema of manifest entries, with this table's partition record.
+    std::string manifest_entry_schema() const;
+
+    // Write the sidecar of a deferred commit: _pending/<writer_id_>.json.
+    void write_pending() const;
+
+    // Manifest, manifest list, metadata and version hint for written_files_.
+    void commit_files() const;
 
     // Write manifest-1.avro; return {absolute_path, file_size_bytes}.
     std::pair<std::string, int64_t> write_manifest_avro() const;
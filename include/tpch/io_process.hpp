@@ -0,0 +1,116 @@
+#pragma once
+
+#include "tpch/shm_ring.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+namespace tpch {
+
+/**
+ * Dedicated I/O process for fork-after-init parallel generation.
+ *
+ * Instead of every child opening its own file and io_uring ring, children
+ * encode into per-slot ShmRing buffers (memfd shared memory) through
+ * ShmRingOutputStream, and one forked I/O process drains all rings:
+ * - Its ring comes from IoUringPool::create_child_ring_struct(), so it is
+ *   attached to the anchor ring's kernel worker pool.
+ * - Every ShmRing's double-mapped data area is registered as a fixed buffer;
+ *   writes are issued straight from shared memory (write_fixed), with
+ *   adjacent descriptors of the same file coalesced up to MAX_WRITE_BYTES.
+ * - Submission is bandwidth-aware: the in-flight byte window tracks the
+ *   measured completion bandwidth times TARGET_LATENCY_MS, and rings with the
+ *   largest backlog are served first so blocked producers resume soonest
+ *   and writes stay long and sequential.
+ * - A write error is reported back on the producing ring; the child sees it
+ *   on its next Write() or on Close().
+ *
+ * Without TPCH_ENABLE_ASYNC_IO (or if the ring cannot be created) the same
+ * loop drains with pwrite(2).
+ *
+ * Usage — parent:
+ *   IoProcess io(slots, IoProcess::DEFAULT_RING_BYTES);
+ *   io.start();
+ *   // child in slot s: ShmRingOutputStream(io.ring(s), path)
+ *   // waitpid loop: if (io.reap(pid, status)) { ... I/O process died ... }
+ *   int rc = io.finish();
+ *
+ * Thread safety: NOT thread-safe; parent-side calls from the scheduler thread.
+ */
+class IoProcess {
+public:
+    /** Default per-slot ring size. Counts as shmem against memory.max. */
+    static constexpr size_t DEFAULT_RING_BYTES = size_t{32} << 20;
+
+    /** Upper bound on one coalesced write. */
+    static constexpr size_t MAX_WRITE_BYTES = size_t{4} << 20;
+
+    /** In-flight window = measured bandwidth x this latency. */
+    static constexpr int TARGET_LATENCY_MS = 25;
+
+    /** Window bounds. */
+    static constexpr size_t MIN_WINDOW_BYTES = size_t{4} << 20;
+    static constexpr size_t MAX_WINDOW_BYTES = size_t{256} << 20;
+
+    /**
+     * Create one ShmRing per slot and the doorbell eventfd.
+     * @throws std::runtime_error on memfd/eventfd/mmap failure
+     */
+    IoProcess(size_t slots, size_t ring_bytes);
+    ~IoProcess();
+
+    IoProcess(const IoProcess&) = delete;
+    IoProcess& operator=(const IoProcess&) = delete;
+
+    /**
+     * fdatasync(2) each file before closing it (--fdatasync). The drain loop
+     * waits for the sync, so other rings pause meanwhile. Set before start().
+     */
+    void set_fdatasync_on_close(bool on) { fdatasync_on_close_ = on; }
+
+    /**
+     * Fork the I/O process. Call before forking generator children.
+     * @throws std::runtime_error if fork() fails
+     */
+    void start();
+
+    /** Ring of a child slot (valid in parent and children). */
+    ShmRing* ring(size_t slot) { return rings_.at(slot).get(); }
+
+    size_t slots() const { return rings_.size(); }
+
+    /** pid of the I/O process, or -1 before start(). */
+    pid_t pid() const { return pid_; }
+
+    /**
+     * (Parent) Feed a pid reaped by waitpid(-1).
+     * @return true if it was the I/O process. An early exit fails every ring
+     *         so blocked producers stop waiting.
+     */
+    bool reap(pid_t pid, int status);
+
+    /**
+     * (Parent) After all children have exited: tell the I/O process to
+     * drain and exit, then wait for it.
+     * @return 0 if every write succeeded, 1 otherwise
+     */
+    int finish();
+
+private:
+    struct Drainer;
+
+    [[noreturn]] void run_child();
+
+    std::vector<std::unique_ptr<ShmRing>> rings_;
+    int   doorbell_fd_ = -1;
+    std::atomic<uint32_t>* shutdown_ = nullptr;  // MAP_SHARED page
+    pid_t pid_         = -1;
+    int   exit_status_ = -1;  // set once reaped
+    bool  fdatasync_on_close_ = false;
+};
+
+}  // namespace tpch
@@ -1,39 +1,75 @@
 #pragma once
 
 #include <arrow/io/interfaces.h>
+#include <arrow/status.h>
 
-#include <atomic>
-#include <condition_variable>
+#include "tpch/page_cache_window.hpp"
+
+#include <cstddef>
 #include <cstdint>
-#include <future>
 #include <memory>
-#include <mutex>
-#include <queue>
 #include <string>
-#include <thread>
 #include <vector>
 
 namespace tpch {
 
+/** Tuning knobs for IoUringOutputStream. */
+struct IoUringStreamConfig {
+    /** Size of one pooled staging buffer, i.e. of one write SQE. */
+    size_t staging_bytes = size_t{1} << 20;
+
+    /**
+     * In-flight byte window. The pool holds max_inflight_bytes / staging_bytes
+     * buffers (clamped to [2, queue depth]); Write() blocks only when every
+     * buffer is queued in the kernel.
+     */
+    size_t max_inflight_bytes = size_t{32} << 20;
+
+    /** Close() issues fdatasync(2) after draining. */
+    bool fdatasync_on_close = false;
+
+    /**
+     * Open with O_DIRECT (--direct-io). Every write is a whole 4 KiB-aligned
+     * staging buffer; Flush() keeps partial data staged, Close() zero-pads
+     * the tail block and ftruncate()s back to the logical size. Falls back
+     * to buffered I/O if the filesystem rejects O_DIRECT.
+     */
+    bool direct_io = false;
+
+    /** fallocate preallocation and rolling dirty-page window (off by default). */
+    PageCacheConfig page_cache;
+};
+
 /**
  * Format-agnostic Arrow OutputStream backed by io_uring.
  *
  * Designed for the parallel TPC-DS generation pipeline (DS-10):
  * - One instance per output file, owned by a single child process.
- * - A worker thread owns the io_uring ring for the file's lifetime,
- *   eliminating per-write ring setup overhead.
- * - Write() pre-claims the file offset atomically (fetch_add), copies
- *   data into a WriteJob, enqueues it to the worker, and blocks until
- *   the worker has drained all CQEs — preserving the sequential ordering
- *   that Arrow format writers expect.
- * - Large writes are broken into 512 KB SQEs for pipelining.
- * - No SQPOLL, no O_DIRECT (both hurt on WSL2/VirtIO).
+ * - Write() copies into the current staging buffer and returns; small
+ *   Arrow writes (page headers, footers) are coalesced there. A full
+ *   buffer is submitted as one SQE at the next file offset, and the
+ *   stream moves on to another pooled buffer without waiting.
+ * - Staging buffers are registered with the ring (write_fixed) when the
+ *   kernel allows it; otherwise plain writes are used.
+ * - Backpressure: when every pooled buffer is in flight, Write() reaps
+ *   completions until one is free, bounding memory and queued I/O to
+ *   IoUringStreamConfig::max_inflight_bytes.
+ * - Errors (failed or zero-length CQEs) are recorded and returned by the
+ *   next Write(), Flush() or Close(). Short writes are resubmitted.
+ * - Close() submits the tail, drains every CQE, optionally fdatasyncs,
+ *   then closes the fd.
+ * - Page-cache pressure (IoUringStreamConfig::page_cache): the file is
+ *   preallocated on open, and writeback is driven behind the completed
+ *   prefix each time a staging buffer is acquired.
+ * - No SQPOLL. O_DIRECT only on request (IoUringStreamConfig::direct_io):
+ *   it hurts on WSL2/VirtIO but avoids dirty-page throttling on bare-metal
+ *   NVMe.
  *
- * Sync fallback: when ring_struct == nullptr (io_uring unavailable),
- * Write() falls back to pwrite(2) with no worker thread.
+ * Sync fallback: when ring_struct == nullptr (io_uring unavailable), one
+ * staging buffer is flushed with pwrite(2) each time it fills.
  *
  * Thread safety: NOT thread-safe (single producer assumed — Arrow writers
- * call Write() from a single thread).
+ * call Write() from a single thread). No internal threads.
  */
 class IoUringOutputStream : public arrow::io::OutputStream {
 public:
@@ -45,57 +81,90 @@ public:
      *                    or nullptr for synchronous pwrite fallback.
      *                    The stream takes ownership; destructor calls
      *                    IoUringPool::free_ring(ring_struct).
+     * @param config      staging size, in-flight window, fdatasync on close
      */
     explicit IoUringOutputStream(const std::string& path,
-                                  void* ring_struct = nullptr);
+                                 void* ring_struct = nullptr,
+                                 IoUringStreamConfig config = {});
     ~IoUringOutputStream() override;
 
-    // Not copyable or movable (owns file fd + thread)
+    // Not copyable or movable (owns file fd + ring + registered buffers)
     IoUringOutputStream(const IoUringOutputStream&) = delete;
     IoUringOutputStream& operator=(const IoUringOutputStream&) = delete;
 
     // ---- arrow::io::OutputStream ----
 
-    /** Pre-claim offset, copy data, enqueue to worker, wait for completion. */
+    /** Copy into a staging buffer; submit it when full. Returns deferred errors. */
     arrow::Status Write(const void* data, int64_t nbytes) override;
 
     /** Convenience overload accepting a Buffer. */
     arrow::Status Write(const std::shared_ptr<arrow::Buffer>& data) override;
 
-    /** No-op: Write() blocks until CQEs are drained (data in page cache). */
+    /** Submit the partially filled staging buffer (does not wait; no-op with O_DIRECT). */
     arrow::Status Flush() override;
 
-    /** Stop worker thread (if running), close file fd. */
+    /** Submit the tail, drain all CQEs, optional fdatasync, close the fd. */
     arrow::Status Close() override;
 
     arrow::Result<int64_t> Tell() const override;
     bool closed() const override;
 
+    /** Bytes currently queued in the kernel (0 in sync mode). */
+    size_t inflight_bytes() const { return inflight_bytes_; }
+
+    /** True if the file was opened with O_DIRECT. */
+    bool direct_io() const { return direct_; }
+
 private:
-    // Each Write() call creates one WriteJob.
-    struct WriteJob {
-        std::vector<uint8_t>        data;
-        int64_t                     offset;
-        std::promise<arrow::Status> done;
+    struct Staging {
+        uint8_t* data     = nullptr;
+        size_t   used     = 0;      // bytes filled
+        size_t   written  = 0;      // bytes confirmed by CQEs
+        int64_t  offset   = 0;      // file offset of data[0]
+        bool     inflight = false;
     };
 
-    // Synchronous pwrite path (used when ring_ == nullptr).
-    arrow::Status write_sync(const void* data, int64_t nbytes, int64_t offset);
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    // Make current_ a free buffer, reaping CQEs while the pool is exhausted.
+    arrow::Status acquire_buffer();
+
+    // Hand current_ to the kernel (or pwrite it in sync mode).
+    void submit_current();
 
-    // Worker thread: pop jobs, submit io_uring SQEs, drain CQEs, signal done.
-    void worker_loop();
+    // Queue one SQE for buffer idx covering [ptr, ptr+len) at offset.
+    void queue_write(size_t idx, const uint8_t* ptr, size_t len, int64_t offset);
 
-    int   file_fd_ = -1;
-    void* ring_    = nullptr;  // io_uring* or nullptr (sync mode)
-    bool  closed_  = false;
+    // Process available CQEs (wait for at least one if block). False if the
+    // ring itself failed, so callers stop waiting.
+    bool reap(bool block);
 
-    std::atomic<int64_t> write_offset_{0};  // next byte offset to claim
+    // Wait for every in-flight buffer.
+    void drain();
+
+    // End of the contiguously completed prefix of the file.
+    int64_t completed_offset() const;
+
+    void record_error(arrow::Status st);
+
+    // Synchronous pwrite path (used when ring_ == nullptr).
+    arrow::Status write_sync(const void* data, int64_t nbytes, int64_t offset);
 
-    std::thread             worker_;
-    std::mutex              mu_;
-    std::condition_variable cv_;
-    std::queue<std::unique_ptr<WriteJob>> queue_;
-    bool stop_ = false;
+    int   file_fd_    = -1;
+    void* ring_       = nullptr;  // io_uring* or nullptr (sync mode)
+    bool  closed_     = false;
+    bool  registered_ = false;    // staging buffers registered with ring_
+    bool  direct_     = false;    // file opened with O_DIRECT
+
+    IoUringStreamConfig  config_;
+    std::vector<Staging> pool_;
+    std::vector<size_t>  free_;
+    size_t  current_        = NONE;
+    int64_t position_       = 0;  // bytes accepted by Write()
+    int64_t write_offset_   = 0;  // file offset of the next submitted buffer
+    size_t  inflight_bytes_ = 0;
+    arrow::Status error_;         // first deferred error
+    PageCacheWindow page_cache_;
 };
 
 }  // namespace tpch
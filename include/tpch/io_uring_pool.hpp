@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -24,8 +25,13 @@ namespace tpch {
  *   // to reap:
  *   for (uint64_t idx : IoUringPool::wait_any()) { ... }
  *
+ * Striped output (several drives): the parent also calls add_device(dir)
+ * for every output directory; each distinct block device gets its own anchor
+ * (own kernel worker pool and queue depth), so a saturated drive's blocked
+ * workers cannot starve writes headed for the others.
+ *
  * Usage — child (immediately after fork):
- *   void* ring = IoUringPool::create_child_ring_struct();
+ *   void* ring = IoUringPool::create_child_ring_struct(device);
  *   auto stream = std::make_shared<IoUringOutputStream>(path, ring);
  *   // stream destructor calls IoUringPool::free_ring(ring)
  *
@@ -41,6 +47,14 @@ public:
      */
     static bool init(const std::string& output_dir);
 
+    /**
+     * (Parent, after init) Anchor for another output directory. A directory
+     * on an already registered device reuses that anchor.
+     * @return device index for create_child_ring_struct()/queue_depth();
+     *         0 (the init() anchor) if io_uring is unavailable or setup fails
+     */
+    static int add_device(const std::string& dir);
+
     /**
      * (Parent) Submit POLL_ADD on a child pidfd.
      * user_data is returned verbatim in wait_any() when this child exits.
@@ -61,8 +75,9 @@ public:
      * Returns opaque heap-allocated io_uring* (to avoid exposing liburing.h),
      * or nullptr if io_uring is entirely unavailable.
      * Caller should pass this to IoUringOutputStream; the stream owns lifetime.
+     * @param device  anchor from add_device(); 0 = the init() anchor
      */
-    static void* create_child_ring_struct();
+    static void* create_child_ring_struct(int device = 0);
 
     /**
      * Release a ring created by create_child_ring_struct().
@@ -81,13 +96,21 @@ public:
     static int anchor_fd();
 
     /** Calibrated queue depth (sysfs nr_requests/2, clamped [8, 128]). */
-    static uint32_t queue_depth();
+    static uint32_t queue_depth(int device = 0);
 
 private:
-    static void*    anchor_ring_;      // io_uring* cast to void*
-    static int      anchor_fd_;        // ring->ring_fd of the anchor
-    static uint32_t calibrated_qd_;   // sysfs-calibrated QD
-    static bool     available_;
+    struct Anchor {
+        void*    ring = nullptr;   // io_uring* cast to void*
+        int      fd   = -1;        // ring->ring_fd
+        uint32_t qd   = 32;        // sysfs-calibrated QD of this device
+        uint64_t dev  = 0;         // st_dev of the directory
+    };
+
+    // Valid index into anchors_ (unknown devices map to 0). anchors_ non-empty.
+    static size_t anchor_index(int device);
+
+    static std::vector<Anchor> anchors_;  // [0] = init(); scheduler ring
+    static bool available_;
 };
 
 }  // namespace tpch
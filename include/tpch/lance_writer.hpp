@@ -15,6 +15,7 @@ namespace tpch {
 
 struct StreamState;
 class StreamRecordBatchReader;
+class RowGroupClusterer;
 
 /**
  * Lance columnar format writer using Rust FFI bridge.
@@ -100,6 +101,17 @@ public:
      */
     void set_stream_queue_depth(size_t depth) { stream_queue_depth_ = depth; }
 
+    /**
+     * Sort the rows of each preferred_unit_rows() group by these dictionary
+     * columns before they reach the Rust writer (before first write).
+     */
+    bool set_cluster_columns(const std::vector<std::string>& columns) override;
+
+    /** Rows per Lance row group (lance-ffi default 8192 unless set_write_params overrides). */
+    size_t preferred_unit_rows() const override {
+        return max_rows_per_group_ > 0 ? static_cast<size_t>(max_rows_per_group_) : 8192;
+    }
+
     /**
      * Configure Tokio runtime settings used by Rust streaming writer.
      *
@@ -198,6 +210,11 @@ private:
     size_t buffered_flush_row_threshold_ = 1'000'000;
     std::shared_ptr<StreamState> stream_state_;
     std::shared_ptr<StreamRecordBatchReader> stream_reader_;
+    std::vector<std::string> cluster_columns_;
+    std::unique_ptr<RowGroupClusterer> clusterer_;  // created on the first batch
+
+    /** Validate batch against the locked schema and hand it to the Rust writer. */
+    void write_rows(const std::shared_ptr<arrow::RecordBatch>& batch);
 
     /**
      * Initialize Lance writer on first batch.
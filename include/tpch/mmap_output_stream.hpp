@@ -0,0 +1,95 @@
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/status.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace tpch {
+
+/** Settings for MmapOutputStream. */
+struct MmapStreamConfig {
+    /** File growth / mapping unit. Each extent is allocated and mapped once. */
+    size_t extent_bytes = 64ULL << 20;
+
+    /** Start writeback (sync_file_range) on each retired extent before unmapping. */
+    bool writeback = false;
+
+    /** Copies at least this large use non-temporal stores where available. */
+    size_t non_temporal_bytes = 256 * 1024;
+};
+
+/**
+ * Arrow OutputStream that writes through MAP_SHARED mappings instead of
+ * write(2): Write() is a memcpy into the current extent, with no syscall
+ * until the extent is full. Aimed at tmpfs and pmem staging targets, where
+ * the per-write syscall is the dominant cost; on block devices it is a
+ * comparison point for IoUringOutputStream.
+ *
+ * - The file grows by extent_bytes with fallocate (ftruncate where that is
+ *   unsupported), so ENOSPC is reported by Write() instead of SIGBUS. Each
+ *   extent is mapped with MAP_POPULATE so the copy does not fault per page.
+ * - Large copies use non-temporal stores (SSE2) so multi-GB outputs do not
+ *   evict the generator's working set from the cache.
+ * - Full extents are handed to a background thread that optionally starts
+ *   writeback and munmaps them, keeping TLB shootdowns off the write path.
+ * - Close() waits for the thread and truncates the file to its real size.
+ *
+ * Thread safety: NOT thread-safe (single producer, like the writers).
+ */
+class MmapOutputStream : public arrow::io::OutputStream {
+public:
+    /** @throws std::runtime_error if the file cannot be opened */
+    explicit MmapOutputStream(const std::string& path, MmapStreamConfig config = {});
+    ~MmapOutputStream() override;
+
+    MmapOutputStream(const MmapOutputStream&) = delete;
+    MmapOutputStream& operator=(const MmapOutputStream&) = delete;
+
+    // ---- arrow::io::OutputStream ----
+
+    arrow::Status Write(const void* data, int64_t nbytes) override;
+
+    /** No-op: mapped data is already in the page cache. */
+    arrow::Status Flush() override;
+
+    arrow::Status Close() override;
+    arrow::Result<int64_t> Tell() const override;
+    bool closed() const override;
+
+private:
+    struct Extent {
+        uint8_t* addr   = nullptr;
+        int64_t  offset = 0;  // file offset of addr
+        size_t   len    = 0;
+    };
+
+    arrow::Status map_next();
+    void retire_current();       // hand the mapped extent to the unmapper
+    void unmapper_loop();
+
+    std::string      path_;
+    MmapStreamConfig config_;
+    int              fd_     = -1;
+    bool             closed_ = false;
+
+    Extent  current_;
+    size_t  used_      = 0;   // bytes written into current_
+    int64_t position_  = 0;
+    int64_t file_size_ = 0;   // after ftruncate growth
+
+    // Background unmapper
+    std::thread             unmapper_;
+    std::mutex              mu_;
+    std::condition_variable cv_;
+    std::deque<Extent>      retired_;
+    bool                    stopping_ = false;
+};
+
+}  // namespace tpch
@@ -3,6 +3,7 @@
 
 #include "writer_interface.hpp"
 #include "dbgen_wrapper.hpp"
+#include <functional>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -18,7 +19,14 @@ class SharedAsyncIOContext;
  *
  * This class manages multiple writer instances (one per table) and provides
  * a unified interface for batching writes to all tables. It's designed to work
- * with SharedAsyncIOContext to enable concurrent file I/O.
+ * with SharedAsyncIOContext to enable concurrent file I/O: with async I/O on,
+ * every writer that accepts an OutputStreamFactory (Parquet in streaming
+ * mode, CSV, ORC, Paimon/Iceberg data files) opens its files as
+ * SharedAsyncOutputStreams, so all tables go through one io_uring ring.
+ * Lance writes through its own runtime.
+ *
+ * Tables are keyed by name, so TPC-DS tables can share the same coordinator;
+ * the TableType overloads use table_type_name().
  *
  * Usage example:
  * ```
@@ -56,6 +64,23 @@ public:
      */
     void start_tables(const std::vector<TableType>& tables);
 
+    /**
+     * Initialize the writer for one table by name (e.g. a TPC-DS table).
+     * Output goes to <output_dir>/<name>.<format>.
+     *
+     * @param name Table name
+     */
+    void start_table(const std::string& name);
+
+    /**
+     * Initialize the writer for one table at an explicit path, e.g. in
+     * another directory when output is striped over several drives.
+     *
+     * @param name Table name
+     * @param filepath Output path passed to the writer
+     */
+    void start_table(const std::string& name, const std::string& filepath);
+
     /**
      * Write a batch to a specific table.
      *
@@ -63,6 +88,16 @@ public:
      * @param batch Arrow RecordBatch to write
      */
     void write_batch(TableType table_type, const std::shared_ptr<arrow::RecordBatch>& batch);
+    void write_batch(const std::string& name, const std::shared_ptr<arrow::RecordBatch>& batch);
+
+    /**
+     * Close one table early (e.g. its generator is exhausted) so its writer
+     * and buffers are released while other tables keep going.
+     *
+     * @param name Table name
+     */
+    void finish_table(const std::string& name);
+    void finish_table(TableType table_type);
 
     /**
      * Finalize all tables.
@@ -77,6 +112,15 @@ public:
      * @return Pointer to the WriterInterface (may be null if table not started)
      */
     WriterInterface* get_writer(TableType table_type);
+    WriterInterface* get_writer(const std::string& name);
+
+    /**
+     * Factory used instead of the built-in per-format construction, so a
+     * driver can apply its own options (compression, streaming, Lance
+     * tuning).  Called with the output path; must be set before start_*().
+     */
+    using WriterFactory = std::function<WriterPtr(const std::string& filepath)>;
+    void set_writer_factory(WriterFactory factory);
 
     /**
      * Get the shared async I/O context.
@@ -103,25 +147,32 @@ public:
 private:
     struct TableWriter {
         WriterPtr writer;      // Actual writer implementation
-        TableType table_type;  // Associated table type
+        std::string name;      // Table name (output file stem)
         bool initialized = false;
     };
 
     std::string output_dir_;
     std::string format_;
     bool use_async_io_;
-    std::unordered_map<int, TableWriter> table_writers_;
+    std::unordered_map<std::string, TableWriter> table_writers_;
+    std::vector<std::string> table_order_;  // start order, for deterministic close
     std::shared_ptr<SharedAsyncIOContext> async_ctx_;
+    WriterFactory factory_;
 
     /**
      * Create output filepath for a table.
      */
-    std::string get_table_filename(TableType table_type) const;
+    std::string get_table_filename(const std::string& name) const;
 
     /**
      * Create a writer for a specific table and format.
      */
-    WriterPtr create_writer(TableType table_type, const std::string& filepath);
+    WriterPtr create_writer(const std::string& filepath);
+
+    /**
+     * Route a writer's output through the shared ring (not Lance).
+     */
+    void attach_async_stream(WriterInterface* writer);
 };
 
 }  // namespace tpch
@@ -1,14 +1,18 @@
 #ifndef TPCH_ORC_WRITER_HPP
 #define TPCH_ORC_WRITER_HPP
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 #include <arrow/record_batch.h>
 
 #include "writer_interface.hpp"
 
 namespace tpch {
 
+class RowGroupClusterer;
+
 /**
  * ORC writer implementation using Apache ORC C++ library.
  * Writes Arrow RecordBatch data to ORC files with compression and schema support.
@@ -37,19 +41,71 @@ public:
 
     /**
      * Finalize and close the output file.
+     *
+     * @throws std::runtime_error if the footer or the stream's final flush fails
      */
     void close() override;
 
+    /**
+     * Write the ORC file through factory(filepath) instead of
+     * orc::writeLocalFile (before first write).
+     */
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
+
+    /**
+     * Sort the rows of each ROW_INDEX_STRIDE-row group (ORC's "row group")
+     * by these dictionary columns before they are added (before first write).
+     */
+    bool set_cluster_columns(const std::vector<std::string>& columns) override;
+
+    /** Stripe size handed to orc::WriterOptions. */
+    static constexpr size_t STRIPE_SIZE_BYTES = 64 * 1024 * 1024;
+
+    /** Rows per ORC row-index entry. */
+    static constexpr size_t ROW_INDEX_STRIDE = 10000;
+
+    /**
+     * Distinct/non-null ratio up to which a string column keeps ORC
+     * dictionary encoding (the ORC Java default); set when the schema has
+     * Arrow dictionary columns. ORC C++ has no per-column switch, so every
+     * string column then tries a dictionary first: measured on 2M
+     * comment-like strings, that costs nothing visible with ZLIB and
+     * about 10-15% of that column's write time uncompressed or with ZSTD,
+     * while flag/mode columns shrink by half (ZLIB) or more.
+     */
+    static constexpr double DICTIONARY_KEY_SIZE_THRESHOLD = 0.8;
+
+    /**
+     * The row-index stride, not the stripe: the ORC library cuts stripes
+     * when its encoded (compressed) size reaches STRIPE_SIZE_BYTES, a row
+     * count no caller can predict, whereas stride boundaries are fixed and
+     * are also the unit --cluster-within-rowgroup sorts. Batch sizers and
+     * RollingFileWriter therefore align to strides.
+     */
+    size_t preferred_unit_rows() const override { return ROW_INDEX_STRIDE; }
+
+    /** Stripe target; informational, preferred_unit_rows() takes precedence. */
+    size_t preferred_unit_bytes() const override { return STRIPE_SIZE_BYTES; }
+
 private:
     std::string filepath_;
     std::shared_ptr<arrow::RecordBatch> first_batch_;
     bool schema_locked_ = false;
+    bool closed_ = false;
+    OutputStreamFactory stream_factory_;  // empty = orc::writeLocalFile
+    std::vector<std::string> cluster_columns_;
+    std::unique_ptr<RowGroupClusterer> clusterer_;  // created on the first batch
 
     // Opaque ORC implementations (void* to avoid exposing ORC headers)
     // In the implementation file, these are cast to their actual types
     void* orc_writer_;           // orc::Writer*
     void* orc_output_stream_;    // unique_ptr<OrcFile::OutStream>
     void* orc_type_;             // unique_ptr<orc::Type>
+    void* orc_row_batch_;        // unique_ptr<orc::ColumnVectorBatch>, reused per batch
+    uint64_t row_batch_capacity_ = 0;
+
+    // Convert one batch to an ORC row batch and add it (opens the file first)
+    void write_rows(const std::shared_ptr<arrow::RecordBatch>& batch);
 };
 
 }  // namespace tpch
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tpch {
+
+/** Page-cache pressure knobs for a single output file. Zero disables each. */
+struct PageCacheConfig {
+    /**
+     * Expected file size. fallocate(FALLOC_FL_KEEP_SIZE) reserves it up
+     * front so extents are contiguous and block allocation leaves the write
+     * path; the unused tail is released on close.
+     */
+    int64_t preallocate_bytes = 0;
+
+    /**
+     * Rolling writeback window. Each time a window's worth of bytes reaches
+     * the page cache, writeback is started on it (sync_file_range WRITE),
+     * the previous window is waited for and dropped (POSIX_FADV_DONTNEED).
+     * A writer keeps at most ~2 windows dirty instead of letting the kernel
+     * throttle every writer at once at dirty_ratio.
+     */
+    size_t dirty_window_bytes = 0;
+
+    bool enabled() const { return preallocate_bytes > 0 || dirty_window_bytes > 0; }
+};
+
+/**
+ * Applies a PageCacheConfig to one open fd.
+ *
+ * The owner reports how far the file is contiguously written with
+ * advance(); the window only ever touches ranges below that point, so it
+ * is safe with out-of-order io_uring completions. All calls are hints:
+ * EOPNOTSUPP/ENOSYS and friends are ignored, only finish() reports errors.
+ *
+ * Thread safety: NOT thread-safe (one per writer, like the writers).
+ */
+class PageCacheWindow {
+public:
+    PageCacheWindow() = default;
+
+    /** Bind to fd and preallocate. direct_io disables the window (no page cache). */
+    void open(int fd, const PageCacheConfig& config, bool direct_io = false);
+
+    /** Bytes [0, done) have been handed to the kernel. May block on writeback. */
+    void advance(int64_t done);
+
+    /**
+     * Release preallocated blocks past size and unbind.
+     * @return 0 or errno if the blocks could not be released
+     */
+    int finish(int64_t size);
+
+    bool active() const { return fd_ >= 0; }
+
+private:
+    int     fd_       = -1;
+    int64_t prealloc_ = 0;  // bytes actually reserved
+    int64_t window_   = 0;
+    int64_t started_  = 0;  // writeback started on [0, started_)
+};
+
+}  // namespace tpch
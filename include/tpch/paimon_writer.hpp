@@ -1,14 +1,53 @@
 #ifndef TPCH_PAIMON_WRITER_HPP
 #define TPCH_PAIMON_WRITER_HPP
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <arrow/record_batch.h>
 
 #include "writer_interface.hpp"
 
+namespace arrow::internal {
+class ThreadPool;
+}
+
 namespace tpch {
 
+class AvroFileWriter;
+
+namespace paimon_detail {
+
+/**
+ * Paimon's MurmurHashUtils.hashBytesByWords: MurmurHash3 (x86, 32-bit) of
+ * length bytes, length a multiple of 4, read as little-endian words.
+ */
+int32_t hash_words(const uint8_t* data, size_t length, int32_t seed = 42);
+
+/**
+ * Bucket of every row of batch in a fixed-bucket table, the way Paimon's
+ * default bucket function assigns it: the key columns are laid out as a
+ * BinaryRow, hashed with hash_words and mapped to abs(hash % buckets).
+ *
+ * @throws std::invalid_argument for a key column type Paimon cannot hash
+ *         the same way (only integers, dates, booleans, floating point,
+ *         strings and compact decimals are supported)
+ */
+void compute_buckets(const arrow::RecordBatch& batch, const std::vector<int>& key_columns,
+                     int32_t buckets, std::vector<int32_t>* out);
+
+/**
+ * Key columns of row i as Paimon serializes a BinaryRow in manifests
+ * (SerializationUtils.serializeBinaryRow): big-endian field count, then the
+ * row bytes. Used for the minKey/maxKey of data files.
+ */
+std::vector<uint8_t> serialize_key(const arrow::RecordBatch& batch,
+                                   const std::vector<int>& key_columns, int64_t i);
+
+}  // namespace paimon_detail
+
 /**
  * Apache Paimon table writer (spec-compliant, Flink/Spark compatible).
  *
@@ -36,6 +75,27 @@ namespace tpch {
  *       manifest-list-<UUID>-0     - Manifest list (Avro binary)
  *     bucket-0/
  *       data-<UUID>-0.parquet      - Parquet data files
+ *     bucket-1/ ...                - fixed-bucket tables (set_buckets)
+ *
+ * Data files are streamed: every bucket has one open Parquet FileWriter
+ * that rolls to a new file at the first row group boundary past the target
+ * file size, and the manifest entry of each file is encoded as it closes.
+ * Buckets are written concurrently on a private thread pool, at most one
+ * batch per bucket in flight, so memory stays O(batch) at any scale.
+ *
+ * Primary-key tables (set_primary_key) write every bucket as sorted runs in
+ * Paimon's KeyValue layout (_KEY_<pk>..., _SEQUENCE_NUMBER, _VALUE_KIND,
+ * then the row). Rows that arrive in key order, as most generated tables
+ * do, stream straight into one run at the top LSM level. Once a bucket sees
+ * a row out of order, the rest of its rows go through a bounded-memory
+ * spill sort (sorted Arrow IPC runs merged at close) into a second run one
+ * level down. Each file's min/max key and level are recorded in the
+ * manifest, so the table is readable without merging and ready to compact.
+ *
+ * Several writers can fill one table (two-phase commit): each one defers
+ * its commit (set_deferred_commit) and, on close(), leaves its data files
+ * plus a sidecar in _pending/ describing them. commit() then writes one
+ * manifest and snapshot for all of them.
  */
 class PaimonWriter : public WriterInterface {
 public:
@@ -68,27 +128,140 @@ public:
      *
      * Creates snapshot metadata and manifest files to make written data visible.
      * Must be called before reading the table with other tools.
+     *
+     * @throws std::runtime_error if a data file (written asynchronously) or
+     *         the table metadata could not be written; no snapshot is made
      */
     void close() override;
 
-private:
+    /**
+     * Open each Parquet data file in bucket-0/ via factory instead of
+     * arrow::io::FileOutputStream (before first write).
+     */
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
+
+    /** Paimon's default target-file-size. */
+    static constexpr int64_t DEFAULT_TARGET_FILE_SIZE = 128LL << 20;
+
+    /** Arrow bytes held for the primary-key sort before spilling, over all buckets. */
+    static constexpr int64_t DEFAULT_SORT_BUFFER_SIZE = 256LL << 20;
+
+    /** Paimon's default num-levels; sorted runs go to the highest levels. */
+    static constexpr int32_t NUM_LEVELS = 6;
+
     struct DataFileInfo {
         std::string name;
         int64_t size;
         int64_t rows;
+        int32_t bucket;
+        int32_t level = 0;
+        std::vector<uint8_t> min_key;  // serialized BinaryRow; empty = none
+        std::vector<uint8_t> max_key;
+        int64_t max_sequence = 0;
     };
 
+    /**
+     * Write a fixed-bucket table (bucket=N): rows are hashed on bucket_key
+     * into buckets bucket-0 .. bucket-<N-1>, written concurrently. An empty
+     * key uses the first column (the TPC-H/TPC-DS key). buckets <= 0 keeps
+     * the default bucket-unaware table (bucket=-1, every file in bucket-0).
+     * Must be called before the first write.
+     *
+     * @throws std::runtime_error if writing has begun
+     */
+    void set_buckets(int32_t buckets, std::vector<std::string> bucket_key = {});
+
+    /**
+     * Roll data files at about this many bytes (default
+     * DEFAULT_TARGET_FILE_SIZE). Must be called before the first write.
+     *
+     * @throws std::invalid_argument if bytes <= 0
+     */
+    void set_target_file_size(int64_t bytes);
+
+    /**
+     * Write a primary-key table keyed on columns; empty = the table's
+     * TPC-H/TPC-DS primary key (default_primary_key). Rows are bucketed on
+     * the key (set_buckets count, default 1) and every bucket is written as
+     * sorted runs. Must be called before the first write.
+     *
+     * @throws std::runtime_error if writing has begun
+     */
+    void set_primary_key(std::vector<std::string> columns = {});
+
+    /**
+     * Memory for the primary-key sort, shared by all buckets (default
+     * DEFAULT_SORT_BUFFER_SIZE); a bucket spills a sorted run when its share
+     * is full. Must be called before the first write.
+     *
+     * @throws std::invalid_argument if bytes <= 0
+     */
+    void set_sort_buffer_size(int64_t bytes);
+
+    /**
+     * Primary key of a TPC-H or TPC-DS table, recognised by column names
+     * (e.g. l_orderkey, l_linenumber; ss_item_sk, ss_ticket_number). Empty
+     * for any other schema.
+     */
+    static std::vector<std::string> default_primary_key(const arrow::Schema& schema);
+
+    /** Data files written so far; complete after close(). */
+    const std::vector<DataFileInfo>& data_files() const { return data_files_; }
+
+    /**
+     * Write data files only: close() leaves them uncommitted, described by
+     * _pending/<writer_id>.json (file, bucket, rows, level, key range), for
+     * commit(). Writers with distinct ids can share a table. Must be called
+     * before the first write.
+     *
+     * @throws std::invalid_argument unless writer_id is [A-Za-z0-9_.-]+
+     */
+    void set_deferred_commit(const std::string& writer_id);
+
+    /**
+     * Commit what every deferred writer left in table_path as snapshot 1:
+     * read the sidecars in _pending/, write manifest, manifest list,
+     * snapshot and hints, then remove _pending/. In a primary-key table,
+     * the sorted runs of a bucket that several writers filled may overlap,
+     * so they are committed at level 0 (merged on read).
+     *
+     * @return data files committed; 0 if there are no sidecars
+     * @throws std::runtime_error if the table already has a snapshot or the
+     *         sidecars disagree on buckets or primary key
+     */
+    static size_t commit(const std::string& table_path);
+
+private:
+    struct Bucket;
+
     std::string table_path_;
     std::string table_name_;
     std::shared_ptr<arrow::Schema> schema_;
     bool schema_locked_ = false;
     bool closed_ = false;
     int64_t row_count_ = 0;
-    int32_t file_count_ = 0;
+    OutputStreamFactory stream_factory_;  // empty = arrow::io::FileOutputStream
+    int32_t bucket_count_ = -1;           // -1 = bucket-unaware
+    std::vector<std::string> bucket_key_;
+    std::vector<int> bucket_key_indices_;
+    int64_t target_file_size_ = DEFAULT_TARGET_FILE_SIZE;
+    std::vector<int32_t> row_buckets_;
+
+    // Primary-key tables
+    bool has_primary_key_ = false;
+    std::vector<std::string> primary_key_;
+    std::vector<int> primary_key_indices_;
+    std::shared_ptr<arrow::Schema> file_schema_;  // KeyValue layout; schema_ for append tables
+    int64_t sort_buffer_size_ = DEFAULT_SORT_BUFFER_SIZE;
 
-    // Store batches for buffered writing to Parquet
-    std::vector<std::shared_ptr<arrow::RecordBatch>> batches_;
+    std::shared_ptr<arrow::internal::ThreadPool> pool_;
+    std::vector<std::unique_ptr<Bucket>> buckets_;
+
+    // Closed data files and their manifest entries; appended from pool threads
+    std::mutex files_mutex_;
     std::vector<DataFileInfo> data_files_;
+    std::unique_ptr<AvroFileWriter> manifest_;
+    std::string writer_id_;  // non-empty: deferred commit
 
     /**
      * Initialize Paimon write context on first batch.
@@ -97,10 +270,48 @@ private:
     void initialize_paimon_table(const std::shared_ptr<arrow::RecordBatch>& first_batch);
 
     /**
-     * Write accumulated batches to Parquet data file.
-     * Creates a data file in bucket-0/ and tracks metadata.
+     * Take rows of bucket (pool thread): append them to its data files, or
+     * for a primary-key table, to its sorted run or its sort buffer.
      */
-    void write_data_file();
+    void write_to_bucket(Bucket& bucket, const std::shared_ptr<arrow::RecordBatch>& rows);
+
+    /**
+     * Append rows (key-sorted for a primary-key table) to the open data file
+     * of bucket, opening one first if needed; roll the file once it reaches
+     * the target size.
+     */
+    void append_to_file(Bucket& bucket, const std::shared_ptr<arrow::RecordBatch>& rows);
+
+    /** Primary-key rows in KeyValue layout, sequence numbers from first_sequence. */
+    std::shared_ptr<arrow::RecordBatch> to_key_value(const arrow::RecordBatch& rows,
+                                                     int64_t first_sequence) const;
+
+    /** Sort the buffered rows of bucket and write them to a spill file. */
+    void spill(Bucket& bucket);
+
+    /** Write the rows still held by bucket and close its data file (pool thread). */
+    void finish_bucket(Bucket& bucket);
+
+    /** Merge the spill files of bucket into its data files. */
+    void merge_spills(Bucket& bucket);
+
+    /** Open the next data file in bucket-<id>/. */
+    void open_data_file(Bucket& bucket);
+
+    /** Finish the open data file of bucket and record its manifest entry. */
+    void close_data_file(Bucket& bucket);
+
+    /** Wait for the batch in flight on bucket; rethrows its failure. */
+    static void await(Bucket& bucket);
+
+    /** Spill files of this writer: _spill/, or _spill/<writer_id>/ when deferred. */
+    std::string spill_dir() const;
+
+    /** Write the sidecar of a deferred commit: _pending/<writer_id_>.json. */
+    void write_pending();
+
+    /** Manifest, manifest list, snapshot and hints for data_files_. */
+    void commit_files();
 
     /**
      * Write OPTIONS file.
@@ -113,7 +324,7 @@ private:
     void write_schema_file();
 
     /**
-     * Write manifest (Avro binary) containing all data file entries.
+     * Write manifest (Avro binary) with the entries collected as files closed.
      * @return Manifest filename (not full path)
      */
     std::string write_data_manifest();
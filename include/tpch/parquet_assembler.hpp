@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/buffer.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/memory_pool.h>
+#include <arrow/record_batch.h>
+#include <arrow/util/future.h>
+#include <parquet/properties.h>
+
+#include "thrift_compact.hpp"
+
+namespace arrow {
+namespace internal {
+class ThreadPool;
+}
+}
+
+namespace parquet {
+class FileMetaData;
+}
+
+namespace tpch {
+
+/**
+ * Builds one Parquet file out of complete in-memory Parquet files that
+ * share a schema, one append() per file, in order. Column chunk bytes are
+ * copied verbatim; the footer offsets are rebased to the output position.
+ *
+ * Layout matches Arrow's writer except for bloom filters: each file's
+ * filters follow its row groups, so memory stays O(appended file). Column
+ * and offset indexes (small) are kept until finish() and written, with
+ * rebased page offsets, ahead of the merged footer.
+ *
+ * Encrypted files are rejected. Not thread-safe.
+ */
+class ParquetFileAssembler {
+public:
+    /** @param sink written sequentially from its current position 0 */
+    explicit ParquetFileAssembler(std::shared_ptr<arrow::io::OutputStream> sink);
+
+    /**
+     * Append the row groups of a complete Parquet file.
+     * @throws std::runtime_error if file is not a readable Parquet file, or
+     *         if the output would exceed 32768 row groups (i16 ordinals)
+     */
+    void append(const std::shared_ptr<arrow::Buffer>& file);
+
+    /**
+     * Write the page indexes and the merged footer. Does not close the sink.
+     * @throws std::runtime_error if nothing was appended or a write fails
+     */
+    void finish();
+
+    int64_t num_row_groups() const { return num_row_groups_; }
+    int64_t num_rows() const { return num_rows_; }
+
+    /** Merged footer, parsed; null before finish(). */
+    std::shared_ptr<parquet::FileMetaData> metadata() const { return metadata_; }
+
+private:
+    struct PageIndex {
+        std::string column_index;
+        std::string offset_index;
+    };
+
+    void write(std::shared_ptr<arrow::Buffer> data);
+
+    std::shared_ptr<arrow::io::OutputStream> sink_;
+    int64_t pos_ = 0;
+    bool finished_ = false;
+    ThriftValue footer_;                                // first file's FileMetaData
+    std::vector<ThriftValue> row_groups_;               // rebased RowGroup structs
+    std::vector<std::vector<PageIndex>> page_indexes_;  // [row group][column]
+    int64_t num_rows_ = 0;
+    int64_t num_row_groups_ = 0;
+    std::shared_ptr<parquet::FileMetaData> metadata_;
+};
+
+/**
+ * Parquet file encoder that compresses several row groups at once
+ * (--row-group-threads). Batches are cut into row groups of
+ * props->max_row_group_length() rows. Each full row group is encoded on a
+ * private thread pool into its own in-memory Parquet file, and a
+ * ParquetFileAssembler appends the results to the sink in order.
+ *
+ * At most `threads` row groups are encoding at a time; write() blocks on
+ * the oldest when the window is full. Memory is about threads × (Arrow row
+ * group + encoded row group).
+ */
+class ParallelRowGroupWriter {
+public:
+    /**
+     * @throws std::runtime_error if the thread pool cannot be created
+     */
+    ParallelRowGroupWriter(std::shared_ptr<arrow::io::OutputStream> sink,
+                           std::shared_ptr<arrow::Schema> schema,
+                           std::shared_ptr<parquet::WriterProperties> props,
+                           int threads,
+                           arrow::MemoryPool* pool = arrow::default_memory_pool());
+
+    /** Waits for encodes still running; the file is left incomplete unless close() ran. */
+    ~ParallelRowGroupWriter();
+
+    /**
+     * Queue batch rows. owner (e.g. the lifetime manager of wrapped
+     * buffers) is kept until the row groups using them are encoded.
+     *
+     * @throws std::runtime_error if an earlier row group failed to encode
+     */
+    void write(const std::shared_ptr<arrow::RecordBatch>& batch,
+               std::shared_ptr<void> owner = nullptr);
+
+    /** Encode the last, partial row group and write the footer (sink stays open). */
+    void close();
+
+    int64_t num_row_groups() const { return assembler_.num_row_groups(); }
+
+    /** Footer of the finished file; null before close(). */
+    std::shared_ptr<parquet::FileMetaData> metadata() const { return assembler_.metadata(); }
+
+private:
+    void submit();
+    void drain(size_t keep);
+
+    std::shared_ptr<arrow::Schema> schema_;
+    std::shared_ptr<parquet::WriterProperties> props_;
+    arrow::MemoryPool* pool_;
+    size_t threads_;
+    int64_t row_group_rows_;
+    std::shared_ptr<arrow::internal::ThreadPool> encoders_;
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> pending_;
+    std::vector<std::shared_ptr<void>> pending_owners_;
+    int64_t pending_rows_ = 0;
+    std::deque<arrow::Future<std::shared_ptr<arrow::Buffer>>> inflight_;
+    ParquetFileAssembler assembler_;
+    bool closed_ = false;
+};
+
+}  // namespace tpch
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/type_fwd.h>
+#include <parquet/properties.h>
+
+namespace tpch {
+
+/**
+ * How ParquetWriter picks column encodings (--encoding-profile).
+ * - Plain: PLAIN pages, dictionary off for numeric and string columns
+ *   (Arrow dictionary columns keep their dictionary).
+ * - Tuned: fixed rules by type and name — DELTA_BINARY_PACKED for keys
+ *   (*key, *_sk, *_number, *_id), RLE_DICTIONARY for other integers,
+ *   BYTE_STREAM_SPLIT for floating point, strings as in Plain.
+ * - Auto: encode a sample of the first batch with every candidate and lock
+ *   in the smallest result per column (a faster one within
+ *   ParquetOptions::auto_size_slack of it wins).
+ */
+enum class EncodingProfile { Plain, Tuned, Auto };
+
+/** Encoding chosen for one column. */
+struct ColumnEncoding {
+    std::string             column;
+    parquet::Encoding::type encoding   = parquet::Encoding::PLAIN;
+    bool                    dictionary = false;  // RLE_DICTIONARY (PLAIN fallback)
+    int64_t                 sample_bytes = 0;    // Auto: encoded sample size, else 0
+    double                  sample_ms    = 0;    // Auto: encode time of the sample
+
+    /** "DELTA_BINARY_PACKED", "RLE_DICTIONARY", ... */
+    std::string encoding_name() const;
+};
+
+/** Parquet file layout settings shared by the TPC-H and TPC-DS drivers. */
+struct ParquetOptions {
+    EncodingProfile encoding_profile = EncodingProfile::Plain;
+
+    /** zstd level for every column; 0 = codec default. */
+    int zstd_level = 0;
+
+    /** Per-column zstd levels, overriding zstd_level. */
+    std::map<std::string, int> column_zstd_levels;
+
+    /** Auto: rows of the first batch encoded per candidate. */
+    int64_t sample_rows = 65536;
+
+    /** Auto: a faster candidate at most this much larger than the smallest wins. */
+    double auto_size_slack = 0.03;
+
+    /** Write the column and offset index (--page-index); false = library default. */
+    bool page_index = false;
+
+    /** Columns that get a bloom filter; columns a table lacks are skipped. */
+    std::vector<std::string> bloom_filter_columns;
+
+    /** Bloom filter false-positive probability. */
+    double bloom_filter_fpp = 0.05;
+
+    /** Declare the generation key order as sorting_columns (--declare-sort-order). */
+    bool declare_sort_order = false;
+
+    /**
+     * Dictionary columns the rows of each row group are sorted by
+     * (--cluster-within-rowgroup), most significant first; declared as
+     * sorting_columns in place of the generation order. Columns a table
+     * lacks are skipped. The drivers pass the same list to ORC and Lance.
+     */
+    std::vector<std::string> cluster_columns;
+
+    /** Row group target in Arrow (uncompressed) bytes; 0 = 1M rows. */
+    int64_t row_group_bytes = 0;
+
+    /** Data page target in bytes; 0 = library default (1 MiB). */
+    int64_t page_bytes = 0;
+
+    /**
+     * Row groups encoded concurrently into one file (--row-group-threads),
+     * streaming writes only; 0 or 1 = Arrow's sequential writer.
+     */
+    int row_group_threads = 0;
+
+    /** @throws std::invalid_argument unless plain, tuned or auto */
+    static EncodingProfile parse_profile(const std::string& name);
+
+    /**
+     * Parse --zstd-level: "N" and/or "column=N" items separated by commas,
+     * e.g. "3,l_comment=9". Levels must be 1..22.
+     * @throws std::invalid_argument on malformed input
+     */
+    void parse_zstd_levels(const std::string& spec);
+
+    /** True if any zstd level was set. */
+    bool has_zstd_levels() const { return zstd_level != 0 || !column_zstd_levels.empty(); }
+
+    /**
+     * Parse --bloom-filter: column names separated by commas; "keys" stands
+     * for default_bloom_filter_columns().
+     * @throws std::invalid_argument on an empty item
+     */
+    void parse_bloom_filter_columns(const std::string& spec);
+
+    /**
+     * Parse --cluster-within-rowgroup: column names separated by commas,
+     * most significant first.
+     * @throws std::invalid_argument on an empty item
+     */
+    void parse_cluster_columns(const std::string& spec);
+};
+
+/**
+ * Join keys that are not in generation order, where min/max statistics
+ * cannot prune: l_partkey, l_suppkey, ps_suppkey, o_custkey, ss_item_sk,
+ * ss_customer_sk, cs_item_sk, ws_item_sk, the *_item_sk of the returns
+ * tables and inv_item_sk.
+ */
+const std::vector<std::string>& default_bloom_filter_columns();
+
+/**
+ * Columns a table is generated in ascending order of, recognised by column
+ * name: the primary key of every TPC-H table (lineitem: l_orderkey,
+ * l_linenumber), the ticket / order number of the TPC-DS fact tables,
+ * inv_date_sk, and the surrogate key of every TPC-DS dimension. Empty for
+ * any other schema.
+ */
+std::vector<std::string> generation_sort_columns(const arrow::Schema& schema);
+
+/**
+ * Choose column encodings for schema under options.profile. Auto encodes
+ * slices of sample (up to options.sample_rows rows) in memory with codec;
+ * without a sample it falls back to the Tuned rules.
+ */
+std::vector<ColumnEncoding> choose_column_encodings(
+    const arrow::Schema& schema, const ParquetOptions& options,
+    parquet::Compression::type codec,
+    const std::shared_ptr<arrow::RecordBatch>& sample = nullptr);
+
+/** Apply encodings and zstd levels to a WriterProperties builder. */
+void apply_parquet_options(parquet::WriterProperties::Builder& builder,
+                           const std::vector<ColumnEncoding>& encodings,
+                           const ParquetOptions& options,
+                           parquet::Compression::type codec);
+
+/**
+ * Apply page index, bloom filters, sorting_columns and row group / page
+ * sizes for a file with schema. row_bytes is the measured Arrow bytes/row
+ * used to turn row_group_bytes into rows (<= 0: keep the row default).
+ *
+ * @throws std::runtime_error if the Parquet library is too old for a
+ *         requested feature
+ */
+void apply_layout_options(parquet::WriterProperties::Builder& builder,
+                          const arrow::Schema& schema,
+                          const ParquetOptions& options,
+                          int64_t row_bytes);
+
+}  // namespace tpch
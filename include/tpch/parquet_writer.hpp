@@ -3,15 +3,18 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <arrow/record_batch.h>
 #include <arrow/memory_pool.h>
 #include <arrow/io/interfaces.h>
 
 #include "writer_interface.hpp"
 #include "buffer_lifetime_manager.hpp"
+#include "parquet_options.hpp"
 
 // Forward declarations
 namespace parquet {
+class FileMetaData;
 namespace arrow {
 class FileWriter;
 }
@@ -21,6 +24,8 @@ namespace tpch {
 
 // Forward declaration
 class AsyncIOContext;
+class ParallelRowGroupWriter;
+class RowGroupClusterer;
 
 /**
  * Parquet writer implementation using Apache Parquet C++ library.
@@ -91,6 +96,9 @@ public:
      */
     void enable_streaming_write(bool use_threads = true);
 
+    /** True once enable_streaming_write() has been called. */
+    bool streaming_enabled() const { return streaming_mode_; }
+
     /**
      * Set compression codec for Parquet output.
      * Must be called before the first write_batch().
@@ -98,6 +106,25 @@ public:
      */
     void set_compression(const std::string& codec);
 
+    /**
+     * Column encodings, zstd levels, page index, bloom filters, sort order
+     * and row group / page sizes (see ParquetOptions).
+     * Must be called before the first write_batch().
+     */
+    void set_parquet_options(const ParquetOptions& options);
+
+    /**
+     * Encodings in effect, per column the profile touches; filled when the
+     * file writer is created (empty before the first write).
+     */
+    const std::vector<ColumnEncoding>& column_encodings() const { return column_encodings_; }
+
+    /**
+     * Footer of the written file (row groups, statistics, offsets); null
+     * before close() or when nothing was written.
+     */
+    std::shared_ptr<parquet::FileMetaData> file_metadata() const { return file_metadata_; }
+
     /**
      * Inject an external output stream (e.g. IoUringOutputStream).
      * When set, init_file_writer() uses this stream instead of opening filepath_.
@@ -105,6 +132,25 @@ public:
      */
     void set_output_stream(std::shared_ptr<arrow::io::OutputStream> stream);
 
+    /**
+     * Sets ParquetOptions::cluster_columns: rows are buffered per row group
+     * and sorted by these columns before encoding.
+     */
+    bool set_cluster_columns(const std::vector<std::string>& columns) override;
+
+    /** Enable streaming if needed, then set_output_stream(factory(filepath)). */
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
+
+    /**
+     * max_row_group_length the FileWriter is configured with: the library
+     * default, or row_group_bytes / measured bytes-per-row once the first
+     * batch has been seen (0 before that; preferred_unit_bytes() applies).
+     */
+    size_t preferred_unit_rows() const override;
+
+    /** ParquetOptions::row_group_bytes, when row groups are sized in bytes. */
+    size_t preferred_unit_bytes() const override;
+
 private:
     std::string filepath_;
     std::shared_ptr<arrow::RecordBatch> first_batch_;
@@ -123,13 +169,30 @@ private:
     bool streaming_mode_ = false;
     bool use_threads_ = true;
     std::unique_ptr<parquet::arrow::FileWriter> parquet_file_writer_;
+    std::unique_ptr<ParallelRowGroupWriter> row_group_writer_;  // --row-group-threads > 1
     std::string compression_codec_ = "zstd";     // snappy, zstd, none
+    ParquetOptions parquet_options_;
+    std::vector<ColumnEncoding> column_encodings_;
+    bool encodings_chosen_ = false;
+    int64_t row_group_rows_ = 0;  // max_row_group_length of the last make_writer_props()
+    std::shared_ptr<parquet::FileMetaData> file_metadata_;
+    std::unique_ptr<RowGroupClusterer> clusterer_;  // streaming, --cluster-within-rowgroup
 
     // DS-10.3: injected output stream (io_uring or other backend)
     std::shared_ptr<arrow::io::OutputStream> injected_stream_;
 
     // Initialize the Parquet FileWriter for streaming mode
     void init_file_writer();
+
+    // WriterProperties for first_batch_'s schema (chooses encodings once)
+    std::shared_ptr<parquet::WriterProperties> make_writer_props();
+
+    // Streaming: hand one batch to the FileWriter or the row group writer
+    void write_streaming(const std::shared_ptr<arrow::RecordBatch>& batch,
+                         std::shared_ptr<void> owner = nullptr);
+
+    // Batch mode: write batches_ and managed_batches_, clustered if requested
+    void write_buffered(parquet::arrow::FileWriter& writer, int64_t row_group_rows);
 };
 
 }  // namespace tpch
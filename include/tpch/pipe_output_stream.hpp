@@ -0,0 +1,86 @@
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/status.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tpch {
+
+/**
+ * Arrow OutputStream onto a pipe, FIFO or stdout, for streaming a table
+ * straight into a loader (COPY FROM STDIN, clickhouse-client, ...).
+ *
+ * - Write() stages small writes in one reused buffer of CHUNK_BYTES and
+ *   hands it to write(2) when full. A write of CHUNK_BYTES or more goes to
+ *   write(2) straight from the caller's memory, after the staged bytes.
+ * - vmsplice(2) is not used: the pipe, or whatever the reader splices it on
+ *   to, may reference user pages long after they were read, so spliced
+ *   pages could never be reused. Mapping fresh ones per chunk cost more
+ *   than the copy write(2) makes.
+ * - A pipe/FIFO is grown to PIPE_BYTES (best effort).
+ * - A non-blocking fd (e.g. an inherited O_NONBLOCK stdout) waits in
+ *   poll(POLLOUT) instead of failing with EAGAIN.
+ *
+ * Thread safety: NOT thread-safe (single producer, like the writers).
+ */
+class PipeOutputStream : public arrow::io::OutputStream {
+public:
+    /** Bytes staged before a write(2); larger writes are not staged. */
+    static constexpr size_t CHUNK_BYTES = 256 * 1024;
+
+    /** Pipe capacity requested with F_SETPIPE_SZ (best effort). */
+    static constexpr size_t PIPE_BYTES = 1024 * 1024;
+
+    /**
+     * @param fd       write end of a pipe/FIFO, or any writable fd
+     * @param name     for error messages
+     * @param owns_fd  close fd in Close() (the reader then sees EOF)
+     */
+    PipeOutputStream(int fd, std::string name, bool owns_fd = true);
+    ~PipeOutputStream() override;
+
+    PipeOutputStream(const PipeOutputStream&) = delete;
+    PipeOutputStream& operator=(const PipeOutputStream&) = delete;
+
+    /**
+     * Create the FIFO at path if needed (mkfifo 0644) and open it for
+     * writing. Blocks until a reader opens the other end.
+     * @throws std::runtime_error if path exists and is not a FIFO, or open fails
+     */
+    static std::shared_ptr<PipeOutputStream> open_fifo(const std::string& path);
+
+    // ---- arrow::io::OutputStream ----
+
+    arrow::Status Write(const void* data, int64_t nbytes) override;
+
+    /** Write the staged bytes to the fd. */
+    arrow::Status Flush() override;
+
+    /** Write the staged bytes and close the fd if owned. */
+    arrow::Status Close() override;
+
+    arrow::Result<int64_t> Tell() const override;
+    bool closed() const override;
+
+private:
+    // Wait until fd_ accepts more data (non-blocking fds only).
+    arrow::Status wait_writable();
+
+    arrow::Status write_all(const uint8_t* p, size_t n);
+
+    int         fd_;
+    std::string name_;
+    bool        owns_fd_;
+    bool        closed_   = false;
+
+    std::vector<uint8_t> chunk_;  // staging buffer, CHUNK_BYTES, reused
+    size_t   used_     = 0;       // bytes filled in chunk_
+    int64_t  position_ = 0;       // bytes accepted by Write()
+};
+
+}  // namespace tpch
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tpch {
+
+/**
+ * ResourceLimits — CPU / memory envelope the process is actually allowed to use.
+ *
+ * Inside a container the host view (hardware_concurrency, /proc/meminfo) is
+ * misleading: a pod may see 128 CPUs but carry a 16-CPU CFS quota and a
+ * 64 GiB memory.max.  detect_resource_limits() reads the cgroup v2 controls
+ * along the process' cgroup path (the tightest ancestor wins) plus the
+ * scheduler affinity mask, so callers can size worker pools to the quota.
+ *
+ * cgroup v1 is not consulted; on v1 hosts only the affinity mask applies.
+ */
+struct ResourceLimits {
+    unsigned host_cpus   = 1;    // std::thread::hardware_concurrency()
+    unsigned cpuset_cpus = 1;    // sched_getaffinity / cpuset.cpus.effective
+    double   cpu_quota   = 0.0;  // cpu.max quota/period in CPUs; 0 = unlimited
+    int64_t  memory_max  = 0;    // memory.max in bytes; 0 = unlimited
+    bool     cgroup_v2   = false;
+    std::string cgroup_path;     // cgroup v2 directory the limits were read from
+
+    /** CPUs we can keep busy: min(cpuset, ceil(quota)), at least 1. */
+    unsigned effective_cpus() const;
+};
+
+/**
+ * Detect limits for the calling process.
+ * @param cgroup_root  cgroup v2 mount point (overridable for tests).
+ */
+ResourceLimits detect_resource_limits(const std::string& cgroup_root = "/sys/fs/cgroup");
+
+/** Parse cgroup v2 cpu.max ("<quota> <period>" or "max <period>"). Returns CPUs, 0 = unlimited. */
+double parse_cgroup_cpu_max(const std::string& content);
+
+/** Parse cgroup v2 memory.max ("max" or bytes). Returns bytes, 0 = unlimited. */
+int64_t parse_cgroup_memory_max(const std::string& content);
+
+/** Count CPUs in a cpuset list such as "0-3,8,10-11". Returns 0 on parse failure. */
+unsigned parse_cpu_list_count(const std::string& content);
+
+/**
+ * AutoTuning — knobs derived from ResourceLimits for the fork-per-table drivers.
+ *
+ * The parent picks the number of concurrent table children; each child then
+ * receives an equal share of the CPU quota for its Arrow pools and (for Lance)
+ * the Rust blocking-thread pool, so slots × per-child threads ≈ quota instead
+ * of slots × host_cpus.
+ */
+struct AutoTuning {
+    size_t parallel_slots    = 1;   // concurrent table children
+    int    arrow_cpu_threads = 1;   // arrow::SetCpuThreadPoolCapacity per child
+    int    arrow_io_threads  = 1;   // arrow::io::SetIOThreadPoolCapacity per child
+    int    lance_threads     = 1;   // LanceWriter::set_runtime_config per child
+    size_t max_batch_rows    = 0;   // cap for AdaptiveBatchSizer; 0 = no memory-driven cap
+};
+
+/** Per-child memory the planner reserves when memory.max is set (1 GiB). */
+constexpr int64_t AUTO_TUNE_CHILD_MEMORY_BYTES = int64_t{1} << 30;
+
+/**
+ * Derive AutoTuning from the detected limits.
+ * @param limits           result of detect_resource_limits()
+ * @param ntables          tables the driver will generate (upper bound on slots)
+ * @param requested_slots  --parallel-tables value; 0 = choose automatically
+ */
+AutoTuning plan_auto_tuning(const ResourceLimits& limits,
+                            size_t ntables,
+                            size_t requested_slots = 0);
+
+/** One-line human-readable summary, e.g. for "tpch_benchmark: resources ..." logs. */
+std::string describe(const ResourceLimits& limits, const AutoTuning& tuning);
+
+}  // namespace tpch
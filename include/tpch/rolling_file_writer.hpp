@@ -0,0 +1,138 @@
+#ifndef TPCH_ROLLING_FILE_WRITER_HPP
+#define TPCH_ROLLING_FILE_WRITER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arrow/io/interfaces.h>
+#include <arrow/record_batch.h>
+
+#include "writer_interface.hpp"
+
+// Forward declarations
+namespace parquet {
+class FileMetaData;
+}
+
+namespace tpch {
+
+/**
+ * Writes one table as a directory of size-bounded files
+ * (--target-file-size): <dir>/part-00000.<ext>, part-00001.<ext>, ...
+ * Each part is an ordinary file from the wrapped format's writer, so
+ * Spark/Trino can split the table by file and a failed part can be
+ * regenerated alone.
+ *
+ * A part is closed once it reaches the target, checked only where the rows
+ * written so far fill whole units of the part writer's preferred_unit_rows()
+ * (Parquet row groups, ORC row-index strides). Batches that cross a unit
+ * boundary are split there (zero-copy slices), so any batch size reaches
+ * every boundary. Parts overshoot the target by at most one unit plus what the
+ * writer still buffers. The size is the part stream's Tell() (or the file
+ * size on disk); for writers that hold the whole file until close(), it is
+ * estimated from the Arrow bytes and the previous part's encoded ratio.
+ *
+ * close() adds _manifest.json with every part's rows and bytes. Parquet
+ * parts also get the Hive/Spark summary files: _common_metadata (schema
+ * only) and _metadata (every row group, with file_path set to its part).
+ */
+class RollingFileWriter : public WriterInterface {
+public:
+    /** Creates the writer for one part file. */
+    using PartFactory = std::function<WriterPtr(const std::string& path)>;
+
+    struct Part {
+        std::string name;    // relative to dir(), e.g. "part-00000.parquet"
+        int64_t rows  = 0;
+        int64_t bytes = 0;
+    };
+
+    /**
+     * @param dir          output directory (created if local)
+     * @param extension    part file extension, without the dot
+     * @param target_bytes roll to a new part at this size (> 0)
+     * @param factory      creates the writer for each part path
+     * @throws std::invalid_argument if target_bytes <= 0
+     */
+    RollingFileWriter(std::string dir, std::string extension, int64_t target_bytes,
+                      PartFactory factory);
+
+    /** Without close(), the manifest and summary files are not written. */
+    ~RollingFileWriter() override;
+
+    void write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) override;
+
+    /**
+     * Close the last part and write _manifest.json (and the Parquet
+     * summary files).
+     * @throws std::runtime_error if a part or summary file cannot be written
+     */
+    void close() override;
+
+    /** Applied to every part writer. */
+    void set_async_context(std::shared_ptr<AsyncIOContext> context) override;
+
+    /** Every part (and summary file) is opened through factory. */
+    bool set_output_stream_factory(OutputStreamFactory factory) override;
+
+    /** Applied to every part writer. */
+    bool set_cluster_columns(const std::vector<std::string>& columns) override;
+
+    size_t preferred_unit_rows() const override;
+    size_t preferred_unit_bytes() const override;
+
+    const std::string& dir() const { return dir_; }
+
+    /** Parts closed so far (all of them after close()). */
+    const std::vector<Part>& parts() const { return parts_; }
+
+    /** "part-00007.parquet" */
+    static std::string part_name(size_t index, const std::string& extension);
+
+    /**
+     * Directory a rolled table goes to, in place of its single file:
+     * the file path without its extension ("out/lineitem.parquet" -> "out/lineitem").
+     */
+    static std::string dataset_dir(const std::string& file_path);
+
+private:
+    void open_part();
+    void close_part();
+    int64_t current_bytes() const;
+    std::shared_ptr<arrow::io::OutputStream> open_side_file(const std::string& name) const;
+    void write_side_file(const std::string& name, const std::string& contents) const;
+    void write_parquet_summaries();
+    void write_manifest();
+
+    std::string dir_;
+    std::string extension_;
+    int64_t target_bytes_;
+    PartFactory factory_;
+    OutputStreamFactory stream_factory_;
+    std::shared_ptr<AsyncIOContext> async_context_;
+    std::vector<std::string> cluster_columns_;
+
+    WriterPtr current_;
+    std::string current_path_;
+    std::shared_ptr<arrow::io::OutputStream> current_stream_;  // when a factory is set
+    int64_t part_rows_ = 0;
+    int64_t part_arrow_bytes_ = 0;
+    double encoded_ratio_ = 1.0;  // encoded / Arrow bytes of the last part
+
+    std::vector<Part> parts_;
+    std::vector<std::shared_ptr<parquet::FileMetaData>> parquet_footers_;
+    bool closed_ = false;
+};
+
+/**
+ * Parse a byte size: "536870912", "512MB", "512M", "1.5GiB", "64k".
+ * Suffixes K/M/G/T (optionally followed by B or iB) are powers of 1024.
+ * @throws std::invalid_argument on malformed input or a non-positive size
+ */
+int64_t parse_byte_size(const std::string& text);
+
+}  // namespace tpch
+
+#endif  // TPCH_ROLLING_FILE_WRITER_HPP
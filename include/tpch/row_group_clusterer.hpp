@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/type_fwd.h>
+
+namespace tpch {
+
+/**
+ * RowGroupClusterer — reorders the rows of each row group by low-cardinality
+ * columns before encoding (--cluster-within-rowgroup).
+ *
+ * Generated rows are in key order, so flag/status/mode columns such as
+ * l_returnflag, l_linestatus or l_shipmode change value on almost every row.
+ * Sorting the rows of one row group by those columns turns each of them into
+ * a handful of runs: RLE/dictionary pages collapse, the correlated columns
+ * next to them compress better, and page statistics become selective. Row
+ * groups keep their generation order and their key ranges; only the order
+ * inside a group changes, which is what Parquet's sorting_columns declares.
+ *
+ * Batches are buffered until group_rows rows are available; each full group
+ * is returned as one batch, stably sorted (LSD counting sort, last key first)
+ * by the dictionary values of the key columns in ascending byte order, nulls
+ * first. Only dictionary-encoded columns can be keys; a group's dictionaries
+ * may differ between batches and are merged. Rows are gathered into new
+ * buffers, so buffered batches (and their owners) are released once their
+ * group has been emitted.
+ *
+ * Not thread-safe; one clusterer per writer.
+ */
+class RowGroupClusterer {
+public:
+    /** Source of one gathered row: index into the chunks and row within it. */
+    struct RowRef {
+        uint32_t chunk;
+        uint32_t row;
+    };
+
+    /**
+     * @param schema     schema of every batch that will be pushed
+     * @param columns    sort keys, most significant first; names the schema
+     *                   lacks are ignored
+     * @param group_rows rows per clustered group (> 0)
+     * @throws std::invalid_argument if a key column is not dictionary-encoded
+     *         or group_rows is out of range
+     */
+    RowGroupClusterer(const std::shared_ptr<arrow::Schema>& schema,
+                      const std::vector<std::string>& columns, int64_t group_rows);
+
+    ~RowGroupClusterer();
+
+    /** False if the schema has none of the key columns: nothing to cluster. */
+    bool active() const { return !keys_.empty(); }
+
+    /** Key columns present in the schema, most significant first. */
+    const std::vector<std::string>& key_names() const { return key_names_; }
+
+    int64_t group_rows() const { return group_rows_; }
+
+    /**
+     * Buffer batch (owner is kept alive with it) and return the groups it
+     * completed, each clustered into one batch of group_rows() rows.
+     */
+    std::vector<std::shared_ptr<arrow::RecordBatch>> push(
+        const std::shared_ptr<arrow::RecordBatch>& batch,
+        std::shared_ptr<void> owner = nullptr);
+
+    /** Cluster the rows still buffered; null if there are none. */
+    std::shared_ptr<arrow::RecordBatch> flush();
+
+    /**
+     * Concatenate chunks (same schema) into one batch with its rows stably
+     * sorted by the dictionary columns at key_indices, most significant first.
+     * @throws std::invalid_argument for a non-dictionary key or a column type
+     *         that cannot be gathered (nested types)
+     */
+    static std::shared_ptr<arrow::RecordBatch> cluster(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks,
+        const std::vector<int>& key_indices,
+        arrow::MemoryPool* pool = nullptr);
+
+    /**
+     * Copy the rows of chunks (same schema) listed in order into one batch.
+     * Dictionary columns get one dictionary, merged if the chunks differ.
+     * @throws std::invalid_argument for a column type that cannot be gathered
+     */
+    static std::shared_ptr<arrow::RecordBatch> gather(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks,
+        const std::vector<RowRef>& order,
+        arrow::MemoryPool* pool = nullptr);
+
+private:
+    std::shared_ptr<arrow::RecordBatch> take_group(int64_t rows);
+
+    std::shared_ptr<arrow::Schema> schema_;
+    std::vector<int> keys_;
+    std::vector<std::string> key_names_;
+    int64_t group_rows_;
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> pending_;
+    std::vector<std::shared_ptr<void>> owners_;
+    int64_t pending_rows_ = 0;
+};
+
+}  // namespace tpch
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <arrow/io/interfaces.h>
+#include <arrow/memory_pool.h>
+#include <arrow/status.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace tpch {
+
+/** True for "s3://bucket/key" style object store URIs. */
+inline bool is_s3_uri(const std::string& path) {
+    return path.rfind("s3://", 0) == 0;
+}
+
+/** Settings for S3OutputStream. */
+struct S3UploadConfig {
+    /** Part size of Arrow's S3 output stream (kPartUploadSize in Arrow 26). */
+    static constexpr size_t ARROW_PART_BYTES = 10ULL << 20;
+
+    /**
+     * Part buffers (filling, queued or uploading) a table may hold before
+     * Write() blocks; rounded up to whole ARROW_PART_BYTES parts.
+     * 0 = max_uploads + 1 parts: every upload slot busy while the next part fills.
+     */
+    size_t window_bytes = 0;
+
+    /** Concurrent part uploads (Arrow's IO pool is sized to this). */
+    int max_uploads = 4;
+};
+
+/**
+ * Memory pool for the part buffers of Arrow's S3 output stream. Arrow copies
+ * every write into part buffers from its IOContext pool and frees each one
+ * once the part is acknowledged (or has failed), so the bytes held here are
+ * the parts still queued or uploading: the only per-part completion signal
+ * the stream exposes. Shared by every stream of the S3FileSystem.
+ *
+ * Thread safety: thread-safe (parts are freed on the IO pool threads).
+ */
+class UploadWindow : public arrow::MemoryPool {
+public:
+    explicit UploadWindow(arrow::MemoryPool* base = arrow::default_memory_pool())
+        : base_(base) {}
+
+    /** Block until at most limit bytes of parts are held. */
+    void wait_until_at_most(int64_t limit);
+
+    arrow::Status Allocate(int64_t size, int64_t alignment, uint8_t** out) override;
+    arrow::Status Reallocate(int64_t old_size, int64_t new_size, int64_t alignment,
+                             uint8_t** ptr) override;
+    void Free(uint8_t* buffer, int64_t size, int64_t alignment) override;
+
+    int64_t bytes_allocated() const override;
+    int64_t total_bytes_allocated() const override;
+    int64_t num_allocations() const override;
+    std::string backend_name() const override { return base_->backend_name(); }
+
+private:
+    arrow::MemoryPool*      base_;
+    mutable std::mutex      mu_;
+    std::condition_variable freed_;
+    int64_t held_  = 0;
+    int64_t total_ = 0;
+    int64_t count_ = 0;
+};
+
+/**
+ * Arrow OutputStream that streams a multipart upload while the table is
+ * generated, with bounded memory.
+ *
+ * - Write() forwards straight to the upload stream (Arrow's S3 output stream
+ *   with background writes), which copies the bytes into its 10 MiB part
+ *   buffers: the only copy. Writes are cut at part boundaries, so each part
+ *   is one buffer of exactly ARROW_PART_BYTES.
+ * - Before the first byte of a part, Write() waits until the UploadWindow
+ *   holds at most window_bytes minus one part. Part buffers are freed as
+ *   their uploads are acknowledged, so the parts held never exceed
+ *   window_bytes and a slow network throttles generation instead of piling
+ *   up buffers. Without a window (an upload stream that does not allocate
+ *   from one) there is no backpressure.
+ * - Parts upload on Arrow's IO pool, sized to max_uploads by open().
+ * - Close() uploads the tail and completes the upload. Abort(), or
+ *   destroying the stream without Close(), cancels it, so a failed child
+ *   leaves no half-written object behind.
+ *
+ * Thread safety: NOT thread-safe (single producer, like the writers).
+ */
+class S3OutputStream : public arrow::io::OutputStream {
+public:
+    /**
+     * @param upload  multipart upload stream the bytes are handed to
+     * @param name    for error messages
+     * @param window  pool upload allocates its part buffers from;
+     *                nullptr = not observable, no backpressure
+     */
+    S3OutputStream(std::shared_ptr<arrow::io::OutputStream> upload, std::string name,
+                   S3UploadConfig config = {}, std::shared_ptr<UploadWindow> window = nullptr);
+    ~S3OutputStream() override;
+
+    S3OutputStream(const S3OutputStream&) = delete;
+    S3OutputStream& operator=(const S3OutputStream&) = delete;
+
+    /**
+     * Open "s3://bucket/key" for writing. Endpoint, region and credentials
+     * come from the usual AWS environment (AWS_ENDPOINT_URL for MinIO,
+     * AWS_REGION, AWS_ACCESS_KEY_ID, AWS_SECRET_ACCESS_KEY). S3 is set up on
+     * first use in the calling process, never before fork().
+     * @throws std::runtime_error if the build has no S3 support or the open fails
+     */
+    static std::shared_ptr<S3OutputStream> open(const std::string& uri, S3UploadConfig config = {});
+
+    // ---- arrow::io::OutputStream ----
+
+    arrow::Status Write(const void* data, int64_t nbytes) override;
+
+    /** Wait for the parts in flight. A partly filled part stays buffered. */
+    arrow::Status Flush() override;
+
+    /** Upload the tail and complete the multipart upload. */
+    arrow::Status Close() override;
+
+    /** Cancel the multipart upload. */
+    arrow::Status Abort() override;
+
+    arrow::Result<int64_t> Tell() const override;
+    bool closed() const override;
+
+    /** Parts started so far (the last one may be short). */
+    int64_t parts() const {
+        return (position_ + static_cast<int64_t>(S3UploadConfig::ARROW_PART_BYTES) - 1) /
+               static_cast<int64_t>(S3UploadConfig::ARROW_PART_BYTES);
+    }
+
+private:
+    std::shared_ptr<arrow::io::OutputStream> upload_;
+    std::string    name_;
+    S3UploadConfig config_;
+    std::shared_ptr<UploadWindow> window_;
+    bool           closed_ = false;
+    int64_t        position_ = 0;   // bytes handed to upload_
+};
+
+}  // namespace tpch
@@ -72,6 +72,24 @@ public:
      */
     void queue_write(int file_handle, const void* buf, size_t count);
 
+    /**
+     * Queue and submit a write whose buffer the context owns until the
+     * completion is reaped, so the caller can refill its staging memory at once.
+     * Blocks (reaping completions) while more than max_inflight_bytes() are
+     * outstanding across all files.
+     *
+     * @param file_handle File handle from register_file()
+     * @param data Bytes to append to the file (moved in)
+     */
+    void queue_write(int file_handle, std::vector<uint8_t> data);
+
+    /** Bytes queued via the owning queue_write() and not yet completed. */
+    size_t inflight_bytes() const;
+
+    /** Backpressure threshold for the owning queue_write() (default 64 MiB). */
+    void set_max_inflight_bytes(size_t bytes);
+    size_t max_inflight_bytes() const;
+
     /**
      * Submit all queued write operations across all files.
      * After this call, operations are submitted to the kernel.
@@ -104,6 +122,7 @@ public:
 
     /**
      * Close a file and clean up its resources.
+     * Waits for the file's outstanding owned writes first.
      *
      * @param file_handle File handle to close
      */
@@ -128,11 +147,28 @@ private:
         int fd;                 // Linux file descriptor
         std::string path;       // File path
         off_t offset = 0;       // Current write offset
+        int inflight = 0;       // Owned writes not yet completed
+    };
+
+    struct OwnedWrite {
+        int file_handle;
+        std::vector<uint8_t> data;
     };
 
+    // user_data tag for owned writes; plain queue_write() uses the file handle
+    static constexpr uint64_t OWNED_WRITE_TAG = uint64_t{1} << 63;
+
+    // Reap at least min_complete completions and free finished owned buffers.
+    int reap(int min_complete);
+
     std::shared_ptr<AsyncIOContext> async_ctx_;  // Shared io_uring ring
     std::unordered_map<int, FileState> files_;   // Registered files
     int next_file_handle_ = 1;                    // Counter for file handles
+
+    std::unordered_map<uint64_t, OwnedWrite> owned_;  // in-flight owned buffers
+    uint64_t next_write_id_ = 0;
+    size_t inflight_bytes_ = 0;
+    size_t max_inflight_bytes_ = size_t{64} << 20;
 };
 
 }  // namespace tpch
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <arrow/io/interfaces.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tpch {
+
+class SharedAsyncIOContext;
+
+/**
+ * Arrow OutputStream that writes through a SharedAsyncIOContext.
+ *
+ * Used by MultiTableWriter so that every table of a single-process run
+ * writes through the same io_uring ring:
+ * - Write() appends to a staging buffer; full buffers (STAGING_BYTES) are
+ *   handed to the context, which owns them until their CQE is reaped.
+ *   Write() therefore returns without waiting for the disk.
+ * - Backpressure comes from the context's in-flight byte window, shared by
+ *   all tables.
+ * - Close() queues the tail, waits for this file's writes and closes the fd.
+ *
+ * Without TPCH_ENABLE_ASYNC_IO the context writes synchronously, so the
+ * stream degrades to buffered write(2).
+ *
+ * Thread safety: NOT thread-safe; the context is single-threaded too.
+ */
+class SharedAsyncOutputStream : public arrow::io::OutputStream {
+public:
+    /** Staging buffer size: one io_uring write per STAGING_BYTES of output. */
+    static constexpr size_t STAGING_BYTES = size_t{1} << 20;
+
+    /**
+     * Register path with the context (O_WRONLY | O_CREAT | O_TRUNC).
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    SharedAsyncOutputStream(std::shared_ptr<SharedAsyncIOContext> ctx,
+                            const std::string& path);
+    ~SharedAsyncOutputStream() override;
+
+    SharedAsyncOutputStream(const SharedAsyncOutputStream&) = delete;
+    SharedAsyncOutputStream& operator=(const SharedAsyncOutputStream&) = delete;
+
+    // ---- arrow::io::OutputStream ----
+
+    /** Copy into the staging buffer; queue it when full. */
+    arrow::Status Write(const void* data, int64_t nbytes) override;
+
+    /** Queue the staging buffer (does not wait for completion). */
+    arrow::Status Flush() override;
+
+    /** Queue the tail, wait for this file's writes, close the fd. */
+    arrow::Status Close() override;
+
+    arrow::Result<int64_t> Tell() const override;
+    bool closed() const override;
+
+private:
+    arrow::Status queue_staging();
+
+    std::shared_ptr<SharedAsyncIOContext> ctx_;
+    int handle_ = -1;
+    int64_t position_ = 0;
+    bool closed_ = false;
+    std::vector<uint8_t> staging_;
+};
+
+}  // namespace tpch
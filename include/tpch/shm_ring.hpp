@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tpch {
+
+/**
+ * One descriptor of a ShmRing. `pos`/`len` address the data area:
+ * - SHM_OPEN:  payload is the file path (not NUL-terminated)
+ * - SHM_DATA:  payload is file bytes, appended at the file's current end
+ * - SHM_CLOSE: no payload; the consumer closes the file once every earlier
+ *              write of this ring has completed
+ */
+struct ShmRingDesc {
+    uint32_t kind;
+    uint32_t file;
+    uint64_t pos;
+    uint64_t len;
+    uint64_t reserved;
+};
+
+enum : uint32_t {
+    SHM_OPEN  = 1,
+    SHM_DATA  = 2,
+    SHM_CLOSE = 3,
+};
+
+/**
+ * Single-producer / single-consumer byte ring in memfd-backed shared memory.
+ *
+ * Created by the parent before fork(); a generator child is the producer and
+ * the I/O process (IoProcess) is the consumer. Layout of the memfd:
+ *
+ *   [ header (4 KiB) | descriptors (DESC_SLOTS x 32 B) | data (capacity) ]
+ *
+ * The data area is mapped twice back to back, so any span of up to
+ * `capacity` bytes starting anywhere in the ring is contiguous in memory:
+ * the consumer writes straight out of the ring with one SQE per run, and
+ * the whole double mapping can be registered as one io_uring fixed buffer.
+ *
+ * Positions are free-running 64-bit byte/descriptor counters stored in the
+ * header, so a later child forked into the same slot continues where the
+ * previous one stopped.
+ *
+ * The producer blocks (futex on `tail_seq`) when the ring is full and rings
+ * the consumer's eventfd doorbell when the consumer has declared itself idle.
+ *
+ * Thread safety: one producer thread and one consumer thread (in different
+ * processes). Not safe for multiple producers.
+ */
+class ShmRing {
+public:
+    static constexpr size_t DESC_SLOTS   = 1024;
+    static constexpr size_t HEADER_BYTES = 4096;
+
+    /** Producer cuts a SHM_DATA descriptor every RECORD_BYTES of payload. */
+    static constexpr size_t RECORD_BYTES = size_t{1} << 20;
+
+    /**
+     * Create the memfd and map it.
+     * @param capacity     data area size; rounded up to a page multiple
+     * @param doorbell_fd  eventfd of the consumer (not owned)
+     * @throws std::runtime_error if memfd_create/ftruncate/mmap fail
+     */
+    ShmRing(size_t capacity, int doorbell_fd);
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    /** Start of the double-mapped data area (2 * capacity() bytes). */
+    uint8_t* data() const { return data_; }
+
+    // ---- producer ----
+
+    /** Queue SHM_OPEN for path; returns the ring-local file id. */
+    uint32_t open_file(const std::string& path);
+
+    /** Copy bytes into the ring; blocks while the ring is full. */
+    void write(uint32_t file, const void* data, size_t nbytes);
+
+    /** Publish any partially filled SHM_DATA descriptor. */
+    void flush();
+
+    /** Queue SHM_CLOSE (after publishing pending data). */
+    void close_file(uint32_t file);
+
+    /**
+     * Block until the consumer has retired everything published so far.
+     * @throws std::runtime_error if the consumer reported a write error
+     */
+    void wait_drained();
+
+    /** errno of the first failed consumer write on this ring, or 0. */
+    int error() const;
+
+    // ---- consumer ----
+
+    /** Descriptors published so far (acquire). */
+    uint64_t desc_head() const;
+
+    /** Descriptor number n (n < desc_head()). */
+    const ShmRingDesc& desc(uint64_t n) const;
+
+    /** Pointer to data at free-running position pos. */
+    const uint8_t* data_at(uint64_t pos) const { return data_ + (pos % capacity_); }
+
+    /** Retire descriptors below desc_tail and data below data_tail; wakes the producer. */
+    void release(uint64_t desc_tail, uint64_t data_tail);
+
+    /** Record a consumer-side write error (first one wins). */
+    void set_error(int err);
+
+    /** Consumer is about to sleep on the doorbell (true) or is running (false). */
+    void set_consumer_idle(bool idle);
+
+private:
+    struct Header;
+
+    void publish_pending();
+    void push_desc(uint32_t kind, uint32_t file, uint64_t pos, uint64_t len);
+    void wait_for_space();
+    void ring_doorbell();
+
+    int          memfd_       = -1;
+    int          doorbell_fd_ = -1;
+    size_t       capacity_    = 0;
+    size_t       map_bytes_   = 0;   // header + descriptors
+    Header*      header_      = nullptr;
+    ShmRingDesc* descs_       = nullptr;
+    uint8_t*     data_        = nullptr;  // 2 * capacity_ reserved, double-mapped
+};
+
+}  // namespace tpch
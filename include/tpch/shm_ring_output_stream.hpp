@@ -0,0 +1,54 @@
+#pragma once
+
+#include <arrow/io/interfaces.h>
+
+#include <cstdint>
+#include <string>
+
+namespace tpch {
+
+class ShmRing;
+
+/**
+ * Arrow OutputStream that hands file bytes to the I/O process (IoProcess)
+ * through a shared-memory ShmRing instead of writing them itself.
+ *
+ * - Constructor queues SHM_OPEN; the I/O process creates the file.
+ * - Write() copies into the ring and returns; it blocks only when the ring
+ *   is full, i.e. when the disk is the bottleneck.
+ * - Close() queues SHM_CLOSE and waits until the I/O process has written
+ *   everything, so a child that exits 0 has its data on the file.
+ * - Errors from the I/O process surface as IOError on Write()/Close().
+ *
+ * Thread safety: NOT thread-safe; one stream per ring at a time.
+ */
+class ShmRingOutputStream : public arrow::io::OutputStream {
+public:
+    /** @param ring  producer side of this child's slot ring (not owned) */
+    ShmRingOutputStream(ShmRing* ring, const std::string& path);
+    ~ShmRingOutputStream() override;
+
+    ShmRingOutputStream(const ShmRingOutputStream&) = delete;
+    ShmRingOutputStream& operator=(const ShmRingOutputStream&) = delete;
+
+    // ---- arrow::io::OutputStream ----
+
+    arrow::Status Write(const void* data, int64_t nbytes) override;
+
+    /** Publish the partially filled record (does not wait for the disk). */
+    arrow::Status Flush() override;
+
+    /** Queue close and wait for the I/O process to retire this ring. */
+    arrow::Status Close() override;
+
+    arrow::Result<int64_t> Tell() const override;
+    bool closed() const override;
+
+private:
+    ShmRing* ring_;
+    uint32_t file_     = 0;
+    int64_t  position_ = 0;
+    bool     closed_   = false;
+};
+
+}  // namespace tpch
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tpch {
+
+/**
+ * Places output files over several directories, typically one per drive
+ * (--output-dir /nvme0/tpch,/nvme1/tpch,...), and records where each
+ * landed.
+ *
+ * - LeastBytes (default): each piece goes to the directory with the fewest
+ *   bytes placed so far, by the caller's size estimate; ties (and unknown
+ *   sizes, passed as 0) fall back to the fewest pieces, then list order.
+ *   Placing the largest pieces first gives a near-even split.
+ * - RoundRobin: directories in turn, ignoring sizes.
+ *
+ * write_manifest() measures every placed path (file or table directory)
+ * and writes a JSON manifest, so loaders can find the pieces.
+ *
+ * Thread safety: NOT thread-safe (placement happens in the parent).
+ */
+class StripeLayout {
+public:
+    enum class Policy { LeastBytes, RoundRobin };
+
+    struct Piece {
+        std::string name;           // table (or part) name
+        std::string path;           // full output path
+        size_t      dir      = 0;   // index into dirs()
+        int64_t     expected = 0;   // caller's size estimate
+    };
+
+    /** @throws std::invalid_argument if dirs is empty */
+    explicit StripeLayout(std::vector<std::string> dirs, Policy policy = Policy::LeastBytes);
+
+    /** Split a comma-separated --output-dir value; empty entries are dropped. */
+    static std::vector<std::string> parse(const std::string& spec);
+
+    /** Parse "bytes" / "rr"; @throws std::invalid_argument otherwise */
+    static Policy parse_policy(const std::string& name);
+
+    /** Index of the directory the next piece goes to (does not record it). */
+    size_t choose() const;
+
+    /**
+     * Place a piece: choose() a directory, record filename under it.
+     * @return the full path, <dir>/<filename>
+     */
+    std::string place(const std::string& name, const std::string& filename,
+                      int64_t expected_bytes = 0);
+
+    const std::vector<std::string>& dirs() const { return dirs_; }
+    const std::vector<Piece>& pieces() const { return pieces_; }
+    bool striped() const { return dirs_.size() > 1; }
+
+    /**
+     * Write {"directories": [...], "files": [{"table", "path", "bytes"}...]}
+     * to path; bytes are measured now (recursively for table directories).
+     * @throws std::runtime_error if the file cannot be written
+     */
+    void write_manifest(const std::string& path) const;
+
+private:
+    std::vector<std::string> dirs_;
+    Policy                   policy_;
+    std::vector<int64_t>     bytes_;    // placed bytes per dir
+    std::vector<size_t>      count_;    // placed pieces per dir
+    std::vector<Piece>       pieces_;
+};
+
+}  // namespace tpch
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tpch {
+
+/**
+ * Schema-less value tree for the Thrift compact protocol, enough to edit
+ * Parquet footers (FileMetaData, OffsetIndex, BloomFilterHeader) without
+ * the generated Thrift classes, which Arrow does not install. Decoding and
+ * re-encoding an unmodified struct reproduces it; unknown fields survive.
+ */
+struct ThriftValue {
+    enum Type : uint8_t {
+        STOP = 0, BOOL_TRUE = 1, BOOL_FALSE = 2, BYTE = 3, I16 = 4, I32 = 5,
+        I64 = 6, DOUBLE = 7, BINARY = 8, LIST = 9, SET = 10, MAP = 11, STRUCT = 12
+    };
+
+    uint8_t     type = STOP;   // BOOL_TRUE for either boolean value
+    int64_t     i    = 0;      // bool (0/1), byte, i16, i32, i64
+    uint64_t    bits = 0;      // double, as stored
+    std::string bin;           // binary / string
+    uint8_t     elem_type = 0; // list/set element; map value
+    uint8_t     key_type  = 0; // map key
+    std::vector<ThriftValue> items;                      // list/set; map as k, v, k, v...
+    std::vector<std::pair<int16_t, ThriftValue>> fields; // struct, in wire order
+
+    /** Struct field by id, or nullptr. */
+    ThriftValue* field(int16_t id);
+    const ThriftValue* field(int16_t id) const;
+
+    /** Integer field by id, or fallback when absent. */
+    int64_t int_field(int16_t id, int64_t fallback = 0) const;
+
+    static ThriftValue make_i64(int64_t v) { ThriftValue t; t.type = I64; t.i = v; return t; }
+};
+
+/**
+ * Decode one struct from data[0, size).
+ * @param consumed bytes the struct occupied (may be nullptr)
+ * @throws std::runtime_error on truncated or malformed input
+ */
+ThriftValue decode_thrift_struct(const uint8_t* data, size_t size, size_t* consumed = nullptr);
+
+/** Encode a struct built by decode_thrift_struct (possibly edited). */
+std::string encode_thrift_struct(const ThriftValue& value);
+
+}  // namespace tpch
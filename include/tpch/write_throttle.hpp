@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tpch {
+
+/**
+ * WriteThrottle — process-shared token bucket for disk writes, so a
+ * generator co-located with live services cannot saturate the device.
+ *
+ * The bucket lives in a MAP_SHARED anonymous page created by init() in the
+ * parent before fork(); every child (and the I/O process) inherits it, so
+ * the limit applies to the whole run, not per child. Two independent limits:
+ * bytes/s and write calls/s (IOPS). Either may be 0 (unlimited).
+ *
+ * Scheduling is GCRA: each acquire() atomically reserves the next slot on a
+ * shared virtual clock (CLOCK_MONOTONIC is system-wide) and sleeps until the
+ * slot starts. Idle time accrues up to BURST_NS of credit.
+ *
+ * Plugged into every path that issues file writes: IoUringOutputStream
+ * (Parquet/CSV/ORC and table-format data files), SharedAsyncOutputStream
+ * (--single-process), the I/O process drainer (--io-process), and
+ * LanceWriter (by in-memory batch size, before handing it to Rust).
+ *
+ * All functions are no-ops until init() enabled a limit.
+ */
+class WriteThrottle {
+public:
+    /** Credit an idle writer may accumulate (100 ms worth of the limit). */
+    static constexpr int64_t BURST_NS = 100'000'000;
+
+    /**
+     * (Parent, before fork) Create the shared bucket.
+     * @param bytes_per_sec  0 = no bandwidth limit
+     * @param ops_per_sec    0 = no IOPS limit
+     * @return true if a limit is active
+     * @throws std::runtime_error if the shared page cannot be mapped
+     */
+    static bool init(double bytes_per_sec, double ops_per_sec);
+
+    static bool enabled();
+
+    /** Wait until one write of bytes fits within the limits. */
+    static void acquire(size_t bytes);
+
+    /** Seconds this process spent sleeping in acquire(), summed over its threads. */
+    static double throttled_seconds();
+
+    /** Seconds all processes sharing the bucket spent sleeping. */
+    static double total_throttled_seconds();
+
+private:
+    struct Bucket;
+    static Bucket* bucket_;
+    static std::atomic<int64_t> local_throttled_ns_;  // acquire() runs on writer pool threads
+};
+
+}  // namespace tpch
@@ -1,7 +1,12 @@
 #ifndef TPCH_WRITER_INTERFACE_HPP
 #define TPCH_WRITER_INTERFACE_HPP
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
+#include <arrow/io/type_fwd.h>
 #include <arrow/record_batch.h>
 
 namespace tpch {
@@ -9,6 +14,14 @@ namespace tpch {
 // Forward declaration
 class AsyncIOContext;
 
+/**
+ * Opens the output stream for one file the writer produces (its main file,
+ * or each data file of a table format). Lets the driver route any format
+ * through IoUringOutputStream, SharedAsyncOutputStream, ShmRingOutputStream...
+ */
+using OutputStreamFactory =
+    std::function<std::shared_ptr<arrow::io::OutputStream>(const std::string& path)>;
+
 /**
  * Abstract base class for output format writers.
  * Implementations handle writing Arrow RecordBatch data to specific formats.
@@ -34,10 +47,57 @@ public:
     virtual void set_async_context(std::shared_ptr<AsyncIOContext> context) {
         (void)context;  // Default: ignore async context
     }
+
+    /**
+     * Route the writer's file I/O through streams opened by factory.
+     * Must be called before the first write_batch.
+     *
+     * @return false if the format manages its own I/O (default), in which
+     *         case the factory is not used
+     */
+    virtual bool set_output_stream_factory(OutputStreamFactory factory) {
+        (void)factory;
+        return false;
+    }
+
+    /**
+     * Sort the rows inside each row group (ORC: row-index stride) by these
+     * dictionary columns before encoding (--cluster-within-rowgroup).
+     * Columns the table lacks are skipped. Must be called before the first
+     * write_batch.
+     *
+     * @return false if the format has no row groups to cluster (default)
+     */
+    virtual bool set_cluster_columns(const std::vector<std::string>& columns) {
+        (void)columns;
+        return false;
+    }
+
+    /**
+     * Natural write granularity of the format in rows (Parquet row group,
+     * Lance max_rows_per_group, ORC row-index stride).  Generators align
+     * batch sizes to it so a batch never straddles a unit boundary.
+     * 0 = no preference.
+     */
+    virtual size_t preferred_unit_rows() const { return 0; }
+
+    /**
+     * Natural write granularity in bytes (e.g. ORC stripe size), used when
+     * the format has no row-based unit.  0 = no preference.
+     */
+    virtual size_t preferred_unit_bytes() const { return 0; }
 };
 
 using WriterPtr = std::unique_ptr<WriterInterface>;
 
+/**
+ * File extension for a --format name: the name itself, except the Arrow IPC
+ * stream variant ("arrow-stream" -> "arrows").
+ */
+inline std::string format_extension(const std::string& format) {
+    return format == "arrow-stream" ? "arrows" : format;
+}
+
 }  // namespace tpch
 
 #endif  // TPCH_WRITER_INTERFACE_HPP
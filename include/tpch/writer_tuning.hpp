@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+#include <arrow/type_fwd.h>
+
+#include "batch_sizer.hpp"
+#include "resource_limits.hpp"
+
+namespace tpch {
+
+class WriterInterface;
+
+// Per-writer tuning shared by tpch_benchmark and tpcds_benchmark.
+
+/**
+ * Batch sizer for one table: byte budget from the cache hierarchy, aligned to
+ * the writer's preferred unit (Parquet row group, ORC row-index stride, Lance group).
+ *
+ * @param tuning      auto-tuning plan whose max_batch_rows caps the batch;
+ *                    nullptr = no memory-driven cap
+ * @param fixed_rows  --batch-size; pins the size and disables feedback (0 = adaptive)
+ */
+AdaptiveBatchSizer make_batch_sizer(const arrow::Schema& schema,
+                                    const WriterInterface& writer,
+                                    const AutoTuning* tuning,
+                                    size_t fixed_rows);
+
+/**
+ * Size this process' Arrow CPU / IO pools (and, for Lance, the Rust runtime)
+ * to the child's share of the CPU quota.  Arrow otherwise defaults to
+ * hardware_concurrency() threads per process, which oversubscribes a
+ * cgroup-limited pod by slots × host_cpus / quota.
+ */
+void apply_auto_tuning(const AutoTuning& tuning, WriterInterface* writer);
+
+}  // namespace tpch
@@ -7,7 +7,10 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <cerrno>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 
 namespace tpch {
 
@@ -49,6 +52,33 @@ void SharedAsyncIOContext::queue_write(int file_handle, const void* buf, size_t
     (void)result;
 }
 
+void SharedAsyncIOContext::queue_write(int file_handle, std::vector<uint8_t> data) {
+    // Synchronous write; the buffer is released on return
+    const uint8_t* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = write(file_handle, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+}
+
+size_t SharedAsyncIOContext::inflight_bytes() const {
+    return 0;  // Writes complete synchronously in stub
+}
+
+void SharedAsyncIOContext::set_max_inflight_bytes(size_t bytes) {
+    max_inflight_bytes_ = bytes > 0 ? bytes : 1;
+}
+
+size_t SharedAsyncIOContext::max_inflight_bytes() const {
+    return max_inflight_bytes_;
+}
+
 int SharedAsyncIOContext::submit_all() {
     return 0;  // Nothing to submit in stub
 }
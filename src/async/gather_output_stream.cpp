@@ -0,0 +1,353 @@
+#include "tpch/gather_output_stream.hpp"
+#include "tpch/io_uring_pool.hpp"
+#include "tpch/write_throttle.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <arrow/memory_pool.h>
+#include <arrow/result.h>
+
+#ifdef TPCH_ENABLE_ASYNC_IO
+#include <liburing.h>
+#endif
+
+namespace tpch {
+
+namespace {
+
+constexpr size_t ARENA_BYTES = size_t{64} << 10;
+
+#ifdef IOV_MAX
+constexpr size_t MAX_IOV = IOV_MAX;
+#else
+constexpr size_t MAX_IOV = 1024;
+#endif
+
+// Drop the first n bytes from iov (after a short write).
+void advance(std::vector<struct iovec>& iov, size_t n) {
+    size_t drop = 0;
+    while (drop < iov.size() && n >= iov[drop].iov_len) {
+        n -= iov[drop].iov_len;
+        ++drop;
+    }
+    iov.erase(iov.begin(), iov.begin() + static_cast<std::ptrdiff_t>(drop));
+    if (!iov.empty() && n > 0) {
+        iov.front().iov_base = static_cast<uint8_t*>(iov.front().iov_base) + n;
+        iov.front().iov_len -= n;
+    }
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Constructor / Destructor
+// ---------------------------------------------------------------------------
+
+GatherOutputStream::GatherOutputStream(const std::string& path, void* ring_struct,
+                                       GatherStreamConfig config)
+    : ring_(ring_struct), config_(config) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        IoUringPool::free_ring(ring_);
+        ring_ = nullptr;
+        throw std::runtime_error("GatherOutputStream: cannot open '" + path +
+                                 "': " + strerror(errno));
+    }
+    config_.batch_bytes = std::max<size_t>(config_.batch_bytes, ARENA_BYTES);
+    config_.max_inflight_bytes = std::max(config_.max_inflight_bytes, config_.batch_bytes);
+}
+
+GatherOutputStream::~GatherOutputStream() {
+    if (!closed_) {
+        (void)Close();
+    }
+    IoUringPool::free_ring(ring_);
+    ring_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// OutputStream interface
+// ---------------------------------------------------------------------------
+
+arrow::Result<int64_t> GatherOutputStream::Tell() const {
+    return position_;
+}
+
+bool GatherOutputStream::closed() const { return closed_; }
+
+arrow::Status GatherOutputStream::Write(const void* data, int64_t nbytes) {
+    if (closed_)
+        return arrow::Status::IOError("GatherOutputStream: stream is closed");
+    if (!error_.ok()) return error_;
+    if (nbytes <= 0) return arrow::Status::OK();
+
+    ARROW_RETURN_NOT_OK(copy_in(static_cast<const uint8_t*>(data), static_cast<size_t>(nbytes)));
+    position_ += nbytes;
+    return error_;
+}
+
+arrow::Status GatherOutputStream::Write(const std::shared_ptr<arrow::Buffer>& data) {
+    if (closed_)
+        return arrow::Status::IOError("GatherOutputStream: stream is closed");
+    if (!error_.ok()) return error_;
+    const auto len = static_cast<size_t>(data->size());
+    if (len == 0) return arrow::Status::OK();
+    if (len < config_.copy_threshold || !data->is_cpu()) {
+        return Write(data->data(), data->size());
+    }
+
+    append(data->data(), len, data);
+    gathered_bytes_ += data->size();
+    position_       += data->size();
+    return error_;
+}
+
+arrow::Status GatherOutputStream::Flush() {
+    if (closed_) return arrow::Status::OK();
+    if (pending_.bytes > 0) {
+        submit_pending();
+    }
+    return error_;
+}
+
+arrow::Status GatherOutputStream::Close() {
+    if (closed_) return error_;
+    closed_ = true;
+
+    if (pending_.bytes > 0) {
+        submit_pending();
+    }
+    drain();
+    arena_.reset();
+
+    if (config_.fdatasync_on_close && error_.ok() && ::fdatasync(fd_) != 0) {
+        record_error(arrow::Status::IOError("GatherOutputStream: fdatasync: ",
+                                            strerror(errno)));
+    }
+    if (fd_ >= 0) {
+        if (::close(fd_) != 0) {
+            record_error(arrow::Status::IOError("GatherOutputStream: close: ",
+                                                strerror(errno)));
+        }
+        fd_ = -1;
+    }
+    return error_;
+}
+
+void GatherOutputStream::retain(std::shared_ptr<void> owner) {
+    if (pending_.bytes > 0) {
+        pending_.refs.push_back(std::move(owner));
+        return;
+    }
+    // Everything is submitted: tie it to the most recent batch in flight.
+    Batch* last = nullptr;
+    for (auto& b : inflight_) {
+        if (b && (!last || b->offset > last->offset)) last = b.get();
+    }
+    if (last) last->refs.push_back(std::move(owner));
+}
+
+// ---------------------------------------------------------------------------
+// Gathering
+// ---------------------------------------------------------------------------
+
+void GatherOutputStream::record_error(arrow::Status st) {
+    if (error_.ok()) error_ = std::move(st);
+}
+
+void GatherOutputStream::append(const uint8_t* ptr, size_t len, std::shared_ptr<void> ref) {
+    auto& iov = pending_.iov;
+    if (!iov.empty() &&
+        static_cast<const uint8_t*>(iov.back().iov_base) + iov.back().iov_len == ptr) {
+        iov.back().iov_len += len;  // contiguous with the previous piece
+    } else {
+        iov.push_back({const_cast<uint8_t*>(ptr), len});
+    }
+    if (ref) pending_.refs.push_back(std::move(ref));
+    pending_.bytes += len;
+
+    if (pending_.bytes >= config_.batch_bytes || iov.size() >= MAX_IOV) {
+        submit_pending();
+    }
+}
+
+arrow::Status GatherOutputStream::copy_in(const uint8_t* ptr, size_t len) {
+    while (len > 0) {
+        if (!arena_ || arena_used_ == static_cast<size_t>(arena_->size())) {
+            ARROW_ASSIGN_OR_RAISE(arena_, arrow::AllocateResizableBuffer(
+                                              static_cast<int64_t>(ARENA_BYTES)));
+            arena_used_ = 0;
+        }
+        const size_t n   = std::min(len, static_cast<size_t>(arena_->size()) - arena_used_);
+        uint8_t*     dst = arena_->mutable_data() + arena_used_;
+        std::memcpy(dst, ptr, n);
+        arena_used_ += n;
+        ptr += n;
+        len -= n;
+        // Referencing the arena once per batch is enough; append() coalesces
+        // adjacent pieces of it.
+        const bool referenced = !pending_.refs.empty() && pending_.refs.back() == arena_;
+        append(dst, n, referenced ? nullptr : arena_);
+    }
+    return arrow::Status::OK();
+}
+
+// ---------------------------------------------------------------------------
+// Submission
+// ---------------------------------------------------------------------------
+
+void GatherOutputStream::submit_pending() {
+    auto batch = std::make_unique<Batch>(std::move(pending_));
+    pending_   = Batch{};
+    batch->offset  = write_offset_;
+    batch->written = 0;
+    write_offset_ += static_cast<int64_t>(batch->bytes);
+
+    WriteThrottle::acquire(batch->bytes);
+
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (ring_ != nullptr) {
+        // Window: bytes in flight and one SQE per slot, within the queue depth.
+        const size_t max_slots = std::max<size_t>(IoUringPool::queue_depth(), 1);
+        auto active = [this] {
+            return static_cast<size_t>(std::count_if(inflight_.begin(), inflight_.end(),
+                                                     [](const auto& b) { return b != nullptr; }));
+        };
+        while (inflight_bytes_ > 0 &&
+               (inflight_bytes_ + batch->bytes > config_.max_inflight_bytes ||
+                active() >= max_slots)) {
+            if (!reap(true)) break;
+        }
+        if (error_.ok() && ring_ != nullptr) {
+            size_t idx = 0;
+            while (idx < inflight_.size() && inflight_[idx]) ++idx;
+            if (idx == inflight_.size()) inflight_.emplace_back();
+            inflight_bytes_ += batch->bytes;
+            inflight_[idx]   = std::move(batch);
+            queue_writev(idx);
+            io_uring_submit(static_cast<io_uring*>(ring_));
+            return;
+        }
+    }
+#endif
+
+    auto st = write_sync(*batch);
+    if (!st.ok()) record_error(std::move(st));
+}
+
+void GatherOutputStream::queue_writev(size_t idx) {
+#ifdef TPCH_ENABLE_ASYNC_IO
+    auto*  ring = static_cast<io_uring*>(ring_);
+    Batch& b    = *inflight_[idx];
+    struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+    }
+    if (!sqe) {
+        // Cannot happen with slots <= queue depth; keep the data anyway.
+        auto st = write_sync(b);
+        if (!st.ok()) record_error(std::move(st));
+        inflight_bytes_ -= b.bytes;
+        inflight_[idx].reset();
+        return;
+    }
+    io_uring_prep_writev(sqe, fd_, b.iov.data(), static_cast<unsigned>(b.iov.size()),
+                         static_cast<__u64>(b.offset + static_cast<int64_t>(b.written)));
+    sqe->user_data = static_cast<uint64_t>(idx);
+#else
+    (void)idx;
+#endif
+}
+
+bool GatherOutputStream::reap(bool block) {
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (ring_ == nullptr) return false;
+    auto* ring = static_cast<io_uring*>(ring_);
+
+    struct io_uring_cqe* cqe = nullptr;
+    int ret = block ? io_uring_wait_cqe(ring, &cqe) : io_uring_peek_cqe(ring, &cqe);
+    if (ret == -EINTR) return true;
+    if (ret < 0) {
+        if (block) {
+            record_error(arrow::Status::IOError("io_uring_wait_cqe: ", strerror(-ret)));
+            return false;
+        }
+        return true;  // -EAGAIN: nothing ready
+    }
+
+    bool resubmitted = false;
+    while (cqe) {
+        const auto idx = static_cast<size_t>(cqe->user_data);
+        const int  res = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+
+        Batch& b = *inflight_[idx];
+        if (res < 0) {
+            record_error(arrow::Status::IOError("io_uring writev: ", strerror(-res)));
+        } else if (res == 0) {
+            record_error(arrow::Status::IOError("io_uring writev: short write"));
+        } else {
+            b.written += static_cast<size_t>(res);
+        }
+        if (res > 0 && b.written < b.bytes) {
+            // Short write: resubmit the rest of the same iovecs.
+            advance(b.iov, static_cast<size_t>(res));
+            queue_writev(idx);
+            resubmitted = true;
+        } else {
+            inflight_bytes_ -= b.bytes;
+            inflight_[idx].reset();  // drops the buffer references
+        }
+
+        cqe = nullptr;
+        if (io_uring_peek_cqe(ring, &cqe) != 0) break;
+    }
+    if (resubmitted) {
+        io_uring_submit(ring);
+    }
+    return true;
+#else
+    (void)block;
+    return false;
+#endif
+}
+
+void GatherOutputStream::drain() {
+    while (inflight_bytes_ > 0) {
+        if (!reap(true)) break;  // ring failed; error_ already set
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Synchronous path (ring_ == nullptr)
+// ---------------------------------------------------------------------------
+
+arrow::Status GatherOutputStream::write_sync(Batch& batch) {
+    auto&   iov    = batch.iov;
+    int64_t offset = batch.offset + static_cast<int64_t>(batch.written);
+    while (!iov.empty()) {
+        ssize_t n = ::pwritev(fd_, iov.data(), static_cast<int>(iov.size()), offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return arrow::Status::IOError("GatherOutputStream: pwritev: ", strerror(errno));
+        }
+        if (n == 0) {
+            return arrow::Status::IOError("GatherOutputStream: pwritev: short write");
+        }
+        batch.written += static_cast<size_t>(n);
+        offset        += n;
+        advance(iov, static_cast<size_t>(n));
+    }
+    return arrow::Status::OK();
+}
+
+}  // namespace tpch
@@ -0,0 +1,590 @@
+#include "tpch/io_process.hpp"
+#include "tpch/io_uring_pool.hpp"
+#include "tpch/write_throttle.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <new>
+#include <numeric>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#ifdef TPCH_ENABLE_ASYNC_IO
+#include <liburing.h>
+#endif
+
+namespace tpch {
+
+namespace {
+
+// CQE user_data: ring index in the high bits, per-ring write sequence below.
+constexpr uint64_t DOORBELL_TAG = ~uint64_t{0};
+constexpr int      RING_SHIFT   = 40;
+constexpr uint64_t SEQ_MASK     = (uint64_t{1} << RING_SHIFT) - 1;
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Drainer — the body of the I/O process
+// ---------------------------------------------------------------------------
+
+struct IoProcess::Drainer {
+    Drainer(std::vector<std::unique_ptr<ShmRing>>& rings, int doorbell_fd,
+            std::atomic<uint32_t>* shutdown, bool fdatasync_on_close);
+    ~Drainer();
+
+    int run();
+
+private:
+    // One coalesced write, or a control record that completed on the spot.
+    // Entries retire in ring order, which is what lets the ring tail advance.
+    struct Entry {
+        uint64_t       seq;
+        uint64_t       desc_end;
+        uint64_t       data_end;
+        int            fd;
+        const uint8_t* ptr;
+        size_t         len;
+        uint64_t       offset;
+        bool           done;
+    };
+
+    struct FileOut {
+        int      fd     = -1;
+        uint64_t offset = 0;
+    };
+
+    struct Cursor {
+        uint64_t scan     = 0;  // next descriptor to look at
+        uint64_t next_seq = 0;
+        size_t   pending  = 0;  // entries not yet done
+        std::deque<Entry> entries;
+        std::unordered_map<uint32_t, FileOut> files;
+    };
+
+    bool scan_ring(size_t r);
+    void push_done(Cursor& c, uint64_t data_end);
+    void submit(size_t r, Entry& e);
+    void complete(size_t r, uint64_t seq, int res);
+    void retire(size_t r);
+    bool reap(bool block);
+    void wait_doorbell();
+    void drain_doorbell();
+    void update_window(size_t bytes);
+    bool has_work() const;
+    bool all_drained() const;
+
+    std::vector<std::unique_ptr<ShmRing>>& rings_;
+    std::vector<Cursor>    cursors_;
+    std::vector<size_t>    order_;
+    int                    doorbell_fd_;
+    std::atomic<uint32_t>* shutdown_;
+    bool                   fdatasync_on_close_;
+
+    void*    uring_          = nullptr;  // io_uring* or nullptr (pwrite)
+    bool     fixed_          = false;    // ring data areas registered
+    bool     doorbell_armed_ = false;
+    unsigned unsubmitted_    = 0;
+    size_t   max_ops_        = SIZE_MAX;
+    size_t   inflight_ops_   = 0;
+    size_t   inflight_bytes_ = 0;
+    size_t   window_         = size_t{16} << 20;
+    size_t   peak_window_    = 0;
+
+    std::chrono::steady_clock::time_point sample_start_;
+    size_t sample_bytes_ = 0;
+    double bw_ewma_      = 0.0;
+
+    std::vector<std::pair<uint64_t, int>> sync_done_;  // pwrite completions
+    uint64_t total_bytes_  = 0;
+    uint64_t total_writes_ = 0;
+    int      failures_     = 0;
+};
+
+IoProcess::Drainer::Drainer(std::vector<std::unique_ptr<ShmRing>>& rings, int doorbell_fd,
+                            std::atomic<uint32_t>* shutdown, bool fdatasync_on_close)
+    : rings_(rings), cursors_(rings.size()), order_(rings.size()),
+      doorbell_fd_(doorbell_fd), shutdown_(shutdown), fdatasync_on_close_(fdatasync_on_close) {
+    std::iota(order_.begin(), order_.end(), size_t{0});
+
+#ifdef TPCH_ENABLE_ASYNC_IO
+    // Attached to the anchor ring's worker pool when IoUringPool::init() ran.
+    uring_ = IoUringPool::create_child_ring_struct();
+    if (uring_) {
+        max_ops_ = IoUringPool::queue_depth();
+        std::vector<struct iovec> iov;
+        iov.reserve(rings_.size());
+        for (auto& ring : rings_) {
+            iov.push_back({ring->data(), 2 * ring->capacity()});
+        }
+        int ret = io_uring_register_buffers(static_cast<io_uring*>(uring_), iov.data(),
+                                            static_cast<unsigned>(iov.size()));
+        fixed_ = (ret == 0);
+        if (!fixed_) {
+            fprintf(stderr, "IoProcess: buffer registration failed (%s); using plain writes\n",
+                    strerror(-ret));
+        }
+    }
+#endif
+}
+
+IoProcess::Drainer::~Drainer() {
+    for (auto& c : cursors_) {
+        for (auto& [id, f] : c.files) {
+            if (f.fd >= 0) ::close(f.fd);
+        }
+    }
+    IoUringPool::free_ring(uring_);
+}
+
+void IoProcess::Drainer::push_done(Cursor& c, uint64_t data_end) {
+    c.entries.push_back(Entry{c.next_seq++, c.scan, data_end, -1, nullptr, 0, 0, true});
+}
+
+bool IoProcess::Drainer::scan_ring(size_t r) {
+    ShmRing& ring = *rings_[r];
+    Cursor&  c    = cursors_[r];
+    const uint64_t head = ring.desc_head();
+    bool acted = false;
+
+    while (c.scan < head && inflight_bytes_ < window_ && inflight_ops_ < max_ops_) {
+        const ShmRingDesc d = ring.desc(c.scan);
+
+        if (d.kind == SHM_DATA) {
+            // Coalesce adjacent runs of the same file into one write.
+            uint64_t len = d.len;
+            uint64_t end = c.scan + 1;
+            while (end < head) {
+                const ShmRingDesc& n = ring.desc(end);
+                if (n.kind != SHM_DATA || n.file != d.file || n.pos != d.pos + len ||
+                    len + n.len > MAX_WRITE_BYTES) {
+                    break;
+                }
+                len += n.len;
+                ++end;
+            }
+            c.scan = end;
+
+            auto it = c.files.find(d.file);
+            if (it == c.files.end() || it->second.fd < 0) {
+                push_done(c, d.pos + len);  // open failed; error already on the ring
+            } else {
+                c.entries.push_back(Entry{c.next_seq++, end, d.pos + len, it->second.fd,
+                                          ring.data_at(d.pos), len,
+                                          it->second.offset, false});
+                it->second.offset += len;
+                ++c.pending;
+                ++inflight_ops_;
+                inflight_bytes_ += len;
+                submit(r, c.entries.back());
+            }
+        } else if (d.kind == SHM_OPEN) {
+            std::string path(reinterpret_cast<const char*>(ring.data_at(d.pos)), d.len);
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                int err = errno;
+                fprintf(stderr, "IoProcess: cannot open '%s': %s\n", path.c_str(), strerror(err));
+                ring.set_error(err);
+                ++failures_;
+            }
+            c.files[d.file] = FileOut{fd, 0};
+            ++c.scan;
+            push_done(c, d.pos + d.len);
+        } else if (d.kind == SHM_CLOSE) {
+            if (c.pending > 0) {
+                break;  // earlier writes of this ring must land first
+            }
+            auto it = c.files.find(d.file);
+            if (it != c.files.end()) {
+                const int fd = it->second.fd;
+                if (fd >= 0 && fdatasync_on_close_ && ::fdatasync(fd) != 0) {
+                    int err = errno;
+                    fprintf(stderr, "IoProcess: fdatasync: %s\n", strerror(err));
+                    ring.set_error(err);
+                    ++failures_;
+                }
+                if (fd >= 0) ::close(fd);
+                c.files.erase(it);
+            }
+            ++c.scan;
+            push_done(c, d.pos);
+        } else {
+            ++c.scan;
+            push_done(c, d.pos + d.len);
+        }
+        acted = true;
+    }
+
+    retire(r);
+    return acted;
+}
+
+void IoProcess::Drainer::submit(size_t r, Entry& e) {
+    const uint64_t tag = (r << RING_SHIFT) | (e.seq & SEQ_MASK);
+
+    // One budget for all children: the I/O process issues every write.
+    WriteThrottle::acquire(e.len);
+
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (uring_) {
+        auto* ring = static_cast<io_uring*>(uring_);
+        struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+        while (!sqe) {
+            io_uring_submit(ring);
+            unsubmitted_ = 0;
+            sqe = io_uring_get_sqe(ring);
+            if (!sqe) {
+                // SQ still full (CQ backed up): complete a write to make room
+                reap(true);
+                sqe = io_uring_get_sqe(ring);
+            }
+        }
+        if (fixed_) {
+            io_uring_prep_write_fixed(sqe, e.fd, e.ptr, static_cast<unsigned>(e.len),
+                                      e.offset, static_cast<int>(r));
+        } else {
+            io_uring_prep_write(sqe, e.fd, e.ptr, static_cast<unsigned>(e.len), e.offset);
+        }
+        sqe->user_data = tag;
+        ++unsubmitted_;
+        return;
+    }
+#endif
+
+    const uint8_t* p   = e.ptr;
+    size_t         rem = e.len;
+    off_t          off = static_cast<off_t>(e.offset);
+    int            res = static_cast<int>(e.len);
+    while (rem > 0) {
+        ssize_t n = pwrite(e.fd, p, rem, off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            res = -errno;
+            break;
+        }
+        p   += n;
+        off += n;
+        rem -= static_cast<size_t>(n);
+    }
+    sync_done_.emplace_back(tag, res);
+}
+
+void IoProcess::Drainer::complete(size_t r, uint64_t seq, int res) {
+    Cursor& c = cursors_[r];
+    Entry&  e = c.entries[(seq - c.entries.front().seq) & SEQ_MASK];
+
+    if (res > 0 && static_cast<size_t>(res) < e.len) {
+        // Short write: resubmit the tail from the same registered buffer.
+        e.ptr    += res;
+        e.offset += static_cast<uint64_t>(res);
+        e.len    -= static_cast<size_t>(res);
+        inflight_bytes_ -= static_cast<size_t>(res);
+        total_bytes_    += static_cast<uint64_t>(res);
+        update_window(static_cast<size_t>(res));
+        submit(r, e);
+        return;
+    }
+    if (res <= 0 && e.len > 0) {
+        int err = (res < 0) ? -res : EIO;
+        fprintf(stderr, "IoProcess: write failed: %s\n", strerror(err));
+        rings_[r]->set_error(err);
+        ++failures_;
+    } else {
+        total_bytes_ += e.len;
+        ++total_writes_;
+        update_window(e.len);
+    }
+
+    inflight_bytes_ -= e.len;
+    --inflight_ops_;
+    --c.pending;
+    e.done = true;
+    retire(r);
+}
+
+void IoProcess::Drainer::retire(size_t r) {
+    Cursor& c = cursors_[r];
+    uint64_t desc_tail = 0;
+    uint64_t data_tail = 0;
+    bool     any       = false;
+    while (!c.entries.empty() && c.entries.front().done) {
+        desc_tail = c.entries.front().desc_end;
+        data_tail = c.entries.front().data_end;
+        c.entries.pop_front();
+        any = true;
+    }
+    if (any) {
+        rings_[r]->release(desc_tail, data_tail);
+    }
+}
+
+bool IoProcess::Drainer::reap(bool block) {
+    bool any = false;
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (uring_) {
+        auto* ring = static_cast<io_uring*>(uring_);
+        if (unsubmitted_ > 0) {
+            io_uring_submit(ring);
+            unsubmitted_ = 0;
+        }
+        struct io_uring_cqe* cqe = nullptr;
+        int ret = block ? io_uring_wait_cqe(ring, &cqe) : io_uring_peek_cqe(ring, &cqe);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN) {
+            throw std::runtime_error(std::string("IoProcess: io_uring_wait_cqe: ") +
+                                     strerror(-ret));
+        }
+        if (ret < 0) {
+            cqe = nullptr;
+        }
+        while (cqe) {
+            const uint64_t ud  = cqe->user_data;
+            const int      res = cqe->res;
+            io_uring_cqe_seen(ring, cqe);
+            if (ud == DOORBELL_TAG) {
+                doorbell_armed_ = false;
+                drain_doorbell();
+            } else {
+                complete(static_cast<size_t>(ud >> RING_SHIFT), ud & SEQ_MASK, res);
+            }
+            any = true;
+            cqe = nullptr;
+            if (io_uring_peek_cqe(ring, &cqe) != 0) break;
+        }
+    }
+#endif
+    (void)block;
+    // Synchronous writes (no io_uring) complete here, with or without a ring
+    std::vector<std::pair<uint64_t, int>> done;
+    done.swap(sync_done_);
+    for (const auto& [tag, res] : done) {
+        complete(tag >> RING_SHIFT, tag & SEQ_MASK, res);
+    }
+    return any || !done.empty();
+}
+
+void IoProcess::Drainer::drain_doorbell() {
+    uint64_t v;
+    while (::read(doorbell_fd_, &v, sizeof(v)) == static_cast<ssize_t>(sizeof(v))) {
+    }
+}
+
+void IoProcess::Drainer::wait_doorbell() {
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (uring_) {
+        if (!doorbell_armed_) {
+            auto* ring = static_cast<io_uring*>(uring_);
+            struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+            if (!sqe) {
+                io_uring_submit(ring);
+                unsubmitted_ = 0;
+                sqe = io_uring_get_sqe(ring);
+            }
+            if (sqe) {
+                io_uring_prep_poll_add(sqe, doorbell_fd_, POLLIN);
+                sqe->user_data = DOORBELL_TAG;
+                ++unsubmitted_;
+                doorbell_armed_ = true;
+            }
+        }
+        if (doorbell_armed_) {
+            reap(true);
+            return;
+        }
+    }
+#endif
+    struct pollfd p{doorbell_fd_, POLLIN, 0};
+    (void)poll(&p, 1, 100);
+    drain_doorbell();
+}
+
+void IoProcess::Drainer::update_window(size_t bytes) {
+    sample_bytes_ += bytes;
+    auto   now = std::chrono::steady_clock::now();
+    double dt  = std::chrono::duration<double>(now - sample_start_).count();
+    if (dt < 0.02) {
+        return;
+    }
+    double bw = static_cast<double>(sample_bytes_) / dt;
+    bw_ewma_  = (bw_ewma_ == 0.0) ? bw : 0.75 * bw_ewma_ + 0.25 * bw;
+    window_   = std::clamp(static_cast<size_t>(bw_ewma_ * TARGET_LATENCY_MS / 1000.0),
+                           MIN_WINDOW_BYTES, MAX_WINDOW_BYTES);
+    peak_window_  = std::max(peak_window_, window_);
+    sample_start_ = now;
+    sample_bytes_ = 0;
+}
+
+bool IoProcess::Drainer::has_work() const {
+    for (size_t r = 0; r < rings_.size(); ++r) {
+        if (rings_[r]->desc_head() > cursors_[r].scan) return true;
+    }
+    return false;
+}
+
+bool IoProcess::Drainer::all_drained() const {
+    for (const auto& c : cursors_) {
+        if (!c.entries.empty()) return false;
+    }
+    return !has_work();
+}
+
+int IoProcess::Drainer::run() {
+    sample_start_ = std::chrono::steady_clock::now();
+
+    for (;;) {
+        // Largest backlog first: those producers are closest to blocking.
+        std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+            return rings_[a]->desc_head() - cursors_[a].scan >
+                   rings_[b]->desc_head() - cursors_[b].scan;
+        });
+
+        bool acted = false;
+        for (size_t r : order_) {
+            acted |= scan_ring(r);
+        }
+        acted |= reap(false);
+        if (acted) {
+            continue;
+        }
+        if (inflight_ops_ > 0) {
+            reap(true);
+            continue;
+        }
+        if (shutdown_->load(std::memory_order_acquire) && all_drained()) {
+            break;
+        }
+
+        // Idle: tell producers to ring the doorbell, then re-check before
+        // sleeping so a descriptor published in between is not missed.
+        for (auto& ring : rings_) ring->set_consumer_idle(true);
+        if (!has_work() && !shutdown_->load(std::memory_order_acquire)) {
+            wait_doorbell();
+        }
+        for (auto& ring : rings_) ring->set_consumer_idle(false);
+
+        // Idle time is not bandwidth; restart the sample.
+        sample_start_ = std::chrono::steady_clock::now();
+        sample_bytes_ = 0;
+    }
+
+    fprintf(stderr,
+            "IoProcess: drained %.1f MiB in %llu writes (avg %.0f KiB)  peak_window=%.0f MiB"
+            "  io_uring=%s  fixed_buffers=%s%s\n",
+            static_cast<double>(total_bytes_) / 1048576.0,
+            static_cast<unsigned long long>(total_writes_),
+            total_writes_ ? static_cast<double>(total_bytes_) / 1024.0 /
+                                static_cast<double>(total_writes_)
+                          : 0.0,
+            static_cast<double>(std::max(peak_window_, window_)) / 1048576.0,
+            uring_ ? "yes" : "no",
+            fixed_ ? "yes" : "no", failures_ ? "  ERRORS" : "");
+    return failures_ ? 1 : 0;
+}
+
+// ---------------------------------------------------------------------------
+// IoProcess — parent-side handle
+// ---------------------------------------------------------------------------
+
+IoProcess::IoProcess(size_t slots, size_t ring_bytes) {
+    doorbell_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (doorbell_fd_ < 0) {
+        throw std::runtime_error(std::string("IoProcess: eventfd: ") + strerror(errno));
+    }
+    void* page = mmap(nullptr, sizeof(std::atomic<uint32_t>), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        int err = errno;
+        ::close(doorbell_fd_);
+        throw std::runtime_error(std::string("IoProcess: mmap: ") + strerror(err));
+    }
+    shutdown_ = new (page) std::atomic<uint32_t>(0);
+
+    rings_.reserve(slots);
+    for (size_t s = 0; s < slots; ++s) {
+        rings_.push_back(std::make_unique<ShmRing>(ring_bytes, doorbell_fd_));
+    }
+}
+
+IoProcess::~IoProcess() {
+    if (pid_ > 0 && exit_status_ < 0) {
+        (void)finish();
+    }
+    rings_.clear();
+    if (shutdown_) munmap(shutdown_, sizeof(std::atomic<uint32_t>));
+    if (doorbell_fd_ >= 0) ::close(doorbell_fd_);
+}
+
+void IoProcess::start() {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = ::fork();
+    if (pid < 0) {
+        throw std::runtime_error(std::string("IoProcess: fork: ") + strerror(errno));
+    }
+    if (pid == 0) {
+        run_child();
+    }
+    pid_ = pid;
+}
+
+void IoProcess::run_child() {
+    int rc = 1;
+    try {
+        Drainer drainer(rings_, doorbell_fd_, shutdown_, fdatasync_on_close_);
+        rc = drainer.run();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "IoProcess: %s\n", e.what());
+    }
+    fflush(stderr);
+    _exit(rc);
+}
+
+bool IoProcess::reap(pid_t pid, int status) {
+    if (pid_ < 0 || pid != pid_) {
+        return false;
+    }
+    exit_status_ = status;
+    // Exiting before finish() means nobody drains the rings any more.
+    for (auto& ring : rings_) {
+        ring->set_error(EPIPE);
+    }
+    fprintf(stderr, "IoProcess: I/O process exited early (pid=%d status=%d)\n", pid, status);
+    return true;
+}
+
+int IoProcess::finish() {
+    if (pid_ < 0) {
+        return 0;
+    }
+    if (exit_status_ >= 0) {
+        return 1;  // already reaped by reap(): it died before shutdown
+    }
+    shutdown_->store(1, std::memory_order_release);
+    uint64_t one = 1;
+    (void)!::write(doorbell_fd_, &one, sizeof(one));
+
+    int status = 0;
+    while (::waitpid(pid_, &status, 0) < 0) {
+        if (errno != EINTR) {
+            perror("waitpid");
+            exit_status_ = 0;
+            return 1;
+        }
+    }
+    exit_status_ = status;
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : 1;
+}
+
+}  // namespace tpch
@@ -1,15 +1,20 @@
 #include "tpch/io_uring_output_stream.hpp"
 #include "tpch/io_uring_pool.hpp"
+#include "tpch/write_throttle.hpp"
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
 #include <stdexcept>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <arrow/buffer.h>
+#include <arrow/result.h>
 
 #ifdef TPCH_ENABLE_ASYNC_IO
 #include <liburing.h>
@@ -17,23 +22,80 @@
 
 namespace tpch {
 
+namespace {
+
+constexpr size_t STAGING_ALIGN = 4096;
+
+}  // namespace
+
 // ---------------------------------------------------------------------------
 // Constructor / Destructor
 // ---------------------------------------------------------------------------
 
 IoUringOutputStream::IoUringOutputStream(const std::string& path,
-                                          void* ring_struct)
-    : ring_(ring_struct) {
-    file_fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                                         void* ring_struct,
+                                         IoUringStreamConfig config)
+    : ring_(ring_struct), config_(config) {
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (config_.direct_io) {
+        file_fd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+        direct_  = file_fd_ >= 0;
+        if (file_fd_ < 0 && errno == EINVAL) {
+            // tmpfs and some FUSE filesystems reject O_DIRECT.
+            fprintf(stderr, "IoUringOutputStream: O_DIRECT not supported for '%s'; "
+                            "using buffered I/O\n", path.c_str());
+        }
+    }
+    if (file_fd_ < 0) {
+        file_fd_ = open(path.c_str(), flags, 0644);
+    }
     if (file_fd_ < 0) {
+        IoUringPool::free_ring(ring_);
+        ring_ = nullptr;
         throw std::runtime_error(
             "IoUringOutputStream: cannot open '" + path +
             "': " + strerror(errno));
     }
 
+    page_cache_.open(file_fd_, config_.page_cache, direct_);
+
+    config_.staging_bytes = std::max<size_t>(
+        (config_.staging_bytes + STAGING_ALIGN - 1) / STAGING_ALIGN * STAGING_ALIGN,
+        STAGING_ALIGN);
+
+    // Sync mode needs one staging buffer; io_uring mode a window's worth,
+    // never more than the ring can hold in flight.
+    size_t nbuf = 1;
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (ring_ != nullptr) {
+        nbuf = std::clamp<size_t>(config_.max_inflight_bytes / config_.staging_bytes,
+                                  2, std::max<size_t>(IoUringPool::queue_depth(), 2));
+    }
+#endif
+
+    pool_.resize(nbuf);
+    for (size_t i = 0; i < nbuf; ++i) {
+        pool_[i].data = static_cast<uint8_t*>(
+            std::aligned_alloc(STAGING_ALIGN, config_.staging_bytes));
+        if (!pool_[i].data) {
+            for (auto& b : pool_) std::free(b.data);
+            ::close(file_fd_);
+            IoUringPool::free_ring(ring_);
+            ring_ = nullptr;
+            throw std::runtime_error("IoUringOutputStream: cannot allocate staging buffers");
+        }
+        free_.push_back(nbuf - 1 - i);
+    }
+
 #ifdef TPCH_ENABLE_ASYNC_IO
     if (ring_ != nullptr) {
-        worker_ = std::thread([this] { worker_loop(); });
+        std::vector<struct iovec> iov(nbuf);
+        for (size_t i = 0; i < nbuf; ++i) {
+            iov[i] = {pool_[i].data, config_.staging_bytes};
+        }
+        // May fail under a low RLIMIT_MEMLOCK; plain writes work regardless.
+        registered_ = io_uring_register_buffers(static_cast<io_uring*>(ring_), iov.data(),
+                                                static_cast<unsigned>(nbuf)) == 0;
     }
 #endif
 }
@@ -42,8 +104,12 @@ IoUringOutputStream::~IoUringOutputStream() {
     if (!closed_) {
         (void)Close();
     }
+    // Ring first: it may still reference (registered) staging memory.
     IoUringPool::free_ring(ring_);
     ring_ = nullptr;
+    for (auto& b : pool_) {
+        std::free(b.data);
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -51,7 +117,7 @@ IoUringOutputStream::~IoUringOutputStream() {
 // ---------------------------------------------------------------------------
 
 arrow::Result<int64_t> IoUringOutputStream::Tell() const {
-    return write_offset_.load(std::memory_order_relaxed);
+    return position_;
 }
 
 bool IoUringOutputStream::closed() const { return closed_; }
@@ -59,33 +125,27 @@ bool IoUringOutputStream::closed() const { return closed_; }
 arrow::Status IoUringOutputStream::Write(const void* data, int64_t nbytes) {
     if (closed_)
         return arrow::Status::IOError("IoUringOutputStream: stream is closed");
+    if (!error_.ok()) return error_;
     if (nbytes <= 0) return arrow::Status::OK();
 
-    // Pre-claim offset atomically so multiple future async writes don't overlap
-    int64_t off =
-        write_offset_.fetch_add(nbytes, std::memory_order_relaxed);
-
-#ifdef TPCH_ENABLE_ASYNC_IO
-    if (ring_ != nullptr) {
-        auto job    = std::make_unique<WriteJob>();
-        job->data.assign(static_cast<const uint8_t*>(data),
-                         static_cast<const uint8_t*>(data) + nbytes);
-        job->offset = off;
-        auto fut    = job->done.get_future();
-
-        {
-            std::lock_guard<std::mutex> lk(mu_);
-            queue_.push(std::move(job));
+    const auto* src = static_cast<const uint8_t*>(data);
+    auto        rem = static_cast<size_t>(nbytes);
+    while (rem > 0) {
+        if (current_ == NONE) {
+            ARROW_RETURN_NOT_OK(acquire_buffer());
+        }
+        Staging& b = pool_[current_];
+        size_t   n = std::min(rem, config_.staging_bytes - b.used);
+        std::memcpy(b.data + b.used, src, n);
+        b.used += n;
+        src    += n;
+        rem    -= n;
+        if (b.used == config_.staging_bytes) {
+            submit_current();
         }
-        cv_.notify_one();
-
-        // Block until worker has submitted + drained all CQEs for this job.
-        // Preserves the sequential write ordering that Arrow writers expect.
-        return fut.get();
     }
-#endif
-
-    return write_sync(data, nbytes, off);
+    position_ += nbytes;
+    return error_;
 }
 
 arrow::Status IoUringOutputStream::Write(
@@ -93,153 +153,250 @@ arrow::Status IoUringOutputStream::Write(
     return Write(data->data(), data->size());
 }
 
-// Write() blocks until the worker drains all CQEs for the job (data in kernel
-// page cache). No fsync is performed — sufficient for benchmark use.
-arrow::Status IoUringOutputStream::Flush() { return arrow::Status::OK(); }
+arrow::Status IoUringOutputStream::Flush() {
+    if (closed_) return arrow::Status::OK();
+    // O_DIRECT writes must be whole aligned blocks: keep the tail staged.
+    if (!direct_ && current_ != NONE && pool_[current_].used > 0) {
+        submit_current();
+    }
+    return error_;
+}
 
 arrow::Status IoUringOutputStream::Close() {
-    if (closed_) return arrow::Status::OK();
+    if (closed_) return error_;
     closed_ = true;
 
-#ifdef TPCH_ENABLE_ASYNC_IO
-    if (ring_ != nullptr && worker_.joinable()) {
-        {
-            std::lock_guard<std::mutex> lk(mu_);
-            stop_ = true;
+    if (current_ != NONE) {
+        Staging& tail = pool_[current_];
+        if (direct_ && tail.used % STAGING_ALIGN != 0) {
+            // Zero-pad to the block size; ftruncate() below drops the padding.
+            size_t padded = (tail.used + STAGING_ALIGN - 1) / STAGING_ALIGN * STAGING_ALIGN;
+            std::memset(tail.data + tail.used, 0, padded - tail.used);
+            tail.used = padded;
+        }
+        if (tail.used > 0) {
+            submit_current();
+        } else {
+            free_.push_back(current_);
+            current_ = NONE;
         }
-        cv_.notify_one();
-        worker_.join();
     }
-#endif
+    drain();
 
+    if (direct_ && error_.ok() && ::ftruncate(file_fd_, position_) != 0) {
+        record_error(arrow::Status::IOError("IoUringOutputStream: ftruncate: ",
+                                            strerror(errno)));
+    }
+    if (int err = page_cache_.finish(position_); err != 0 && error_.ok()) {
+        record_error(arrow::Status::IOError("IoUringOutputStream: release preallocation: ",
+                                            strerror(err)));
+    }
+    if (config_.fdatasync_on_close && error_.ok() && ::fdatasync(file_fd_) != 0) {
+        record_error(arrow::Status::IOError("IoUringOutputStream: fdatasync: ",
+                                            strerror(errno)));
+    }
     if (file_fd_ >= 0) {
-        ::close(file_fd_);
+        if (::close(file_fd_) != 0) {
+            record_error(arrow::Status::IOError("IoUringOutputStream: close: ",
+                                                strerror(errno)));
+        }
         file_fd_ = -1;
     }
-    return arrow::Status::OK();
+    return error_;
 }
 
 // ---------------------------------------------------------------------------
-// Synchronous fallback (ring_ == nullptr)
+// Staging pool
 // ---------------------------------------------------------------------------
 
-arrow::Status IoUringOutputStream::write_sync(const void* data, int64_t nbytes,
-                                               int64_t offset) {
-    const uint8_t* ptr     = static_cast<const uint8_t*>(data);
-    int64_t        remaining = nbytes;
-    while (remaining > 0) {
-        ssize_t n =
-            pwrite(file_fd_, ptr, static_cast<size_t>(remaining), offset);
-        if (n < 0) {
-            if (errno == EINTR) continue;
-            return arrow::Status::IOError("IoUringOutputStream: pwrite: ",
-                                          strerror(errno));
+void IoUringOutputStream::record_error(arrow::Status st) {
+    if (error_.ok()) error_ = std::move(st);
+}
+
+arrow::Status IoUringOutputStream::acquire_buffer() {
+    if (ring_ != nullptr) {
+        reap(false);  // opportunistic: recycle whatever already finished
+    }
+    while (free_.empty()) {
+        if (!reap(true)) {
+            return error_.ok()
+                ? arrow::Status::IOError("IoUringOutputStream: no staging buffer available")
+                : error_;
         }
-        ptr       += n;
-        offset    += n;
-        remaining -= n;
     }
+    current_ = free_.back();
+    free_.pop_back();
+    Staging& b = pool_[current_];
+    b.used    = 0;
+    b.written = 0;
+
+    page_cache_.advance(completed_offset());
     return arrow::Status::OK();
 }
 
-// ---------------------------------------------------------------------------
-// io_uring worker thread
-// ---------------------------------------------------------------------------
+int64_t IoUringOutputStream::completed_offset() const {
+    int64_t done = write_offset_;
+    for (const Staging& b : pool_) {
+        if (b.inflight) done = std::min(done, b.offset);
+    }
+    return done;
+}
+
+void IoUringOutputStream::submit_current() {
+    const size_t idx = current_;
+    Staging&     b   = pool_[idx];
+    current_ = NONE;
+
+    WriteThrottle::acquire(b.used);
+
+    b.offset       = write_offset_;
+    b.written      = 0;
+    write_offset_ += static_cast<int64_t>(b.used);
 
 #ifdef TPCH_ENABLE_ASYNC_IO
+    if (ring_ != nullptr) {
+        b.inflight       = true;
+        inflight_bytes_ += b.used;
+        queue_write(idx, b.data, b.used, b.offset);
+        io_uring_submit(static_cast<io_uring*>(ring_));
+        return;
+    }
+#endif
 
-void IoUringOutputStream::worker_loop() {
-    static constexpr size_t CHUNK_SIZE = 512UL * 1024;  // 512 KB per SQE
+    auto st = write_sync(b.data, static_cast<int64_t>(b.used), b.offset);
+    if (!st.ok()) record_error(std::move(st));
+    free_.push_back(idx);
+}
+
+void IoUringOutputStream::queue_write(size_t idx, const uint8_t* ptr, size_t len,
+                                      int64_t offset) {
+#ifdef TPCH_ENABLE_ASYNC_IO
     auto* ring = static_cast<io_uring*>(ring_);
+    struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+    }
+    if (!sqe) {
+        // Cannot happen with pool size <= queue depth; keep the data anyway.
+        Staging& b = pool_[idx];
+        auto st = write_sync(ptr, static_cast<int64_t>(len), offset);
+        if (!st.ok()) record_error(std::move(st));
+        b.inflight       = false;
+        inflight_bytes_ -= b.used;
+        free_.push_back(idx);
+        return;
+    }
+    if (registered_) {
+        io_uring_prep_write_fixed(sqe, file_fd_, ptr, static_cast<unsigned>(len),
+                                  static_cast<__u64>(offset), static_cast<int>(idx));
+    } else {
+        io_uring_prep_write(sqe, file_fd_, ptr, static_cast<unsigned>(len),
+                            static_cast<__u64>(offset));
+    }
+    sqe->user_data = idx;
+#else
+    (void)idx; (void)ptr; (void)len; (void)offset;
+#endif
+}
 
-    while (true) {
-        // --- wait for a job ---
-        std::unique_ptr<WriteJob> job;
-        {
-            std::unique_lock<std::mutex> lk(mu_);
-            cv_.wait(lk, [this] { return !queue_.empty() || stop_; });
-            if (queue_.empty()) break;  // stop_ set and queue drained
-            job = std::move(queue_.front());
-            queue_.pop();
+bool IoUringOutputStream::reap(bool block) {
+#ifdef TPCH_ENABLE_ASYNC_IO
+    if (ring_ == nullptr) return false;
+    auto* ring = static_cast<io_uring*>(ring_);
+
+    struct io_uring_cqe* cqe = nullptr;
+    int ret = block ? io_uring_wait_cqe(ring, &cqe) : io_uring_peek_cqe(ring, &cqe);
+    if (ret == -EINTR) return true;
+    if (ret < 0) {
+        if (block) {
+            record_error(arrow::Status::IOError("io_uring_wait_cqe: ", strerror(-ret)));
+            return false;
         }
+        return true;  // -EAGAIN: nothing ready
+    }
 
-        const uint8_t* ptr    = job->data.data();
-        size_t         rem    = job->data.size();
-        int64_t        off    = job->offset;
-        int            inflight = 0;
-        arrow::Status  st     = arrow::Status::OK();
-
-        // --- fill SQ with 512 KB chunks ---
-        while (rem > 0) {
-            size_t chunk = std::min(CHUNK_SIZE, rem);
-
-            struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
-            if (!sqe) {
-                // SQ full: submit what we have, wait for one CQE to free a slot
-                io_uring_submit(ring);
-                struct io_uring_cqe* cqe = nullptr;
-                int r = io_uring_wait_cqe(ring, &cqe);
-                if (r < 0) {
-                    if (st.ok())
-                        st = arrow::Status::IOError(
-                            "io_uring_wait_cqe: ", strerror(-r));
-                } else {
-                    size_t expected = static_cast<size_t>(cqe->user_data);
-                    if (cqe->res < 0 && st.ok())
-                        st = arrow::Status::IOError(
-                            "io_uring write: ", strerror(-cqe->res));
-                    else if (st.ok() && static_cast<size_t>(cqe->res) != expected)
-                        st = arrow::Status::IOError("io_uring write: short write");
-                    io_uring_cqe_seen(ring, cqe);
-                    --inflight;
-                }
-                sqe = io_uring_get_sqe(ring);
-                if (!sqe) {
-                    if (st.ok())
-                        st = arrow::Status::IOError(
-                            "io_uring: cannot get SQE after flush");
-                    break;
+    bool resubmitted = false;
+    while (cqe) {
+        const auto idx = static_cast<size_t>(cqe->user_data);
+        const int  res = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+
+        Staging& b = pool_[idx];
+        const size_t before = b.written;
+        if (res < 0) {
+            record_error(arrow::Status::IOError("io_uring write: ", strerror(-res)));
+        } else if (res == 0) {
+            record_error(arrow::Status::IOError("io_uring write: short write"));
+        } else {
+            b.written += static_cast<size_t>(res);
+            if (direct_ && b.written < b.used) {
+                // O_DIRECT needs aligned offsets and lengths: rewrite the
+                // partly written block rather than resubmit an unaligned tail
+                b.written = b.written / STAGING_ALIGN * STAGING_ALIGN;
+                if (b.written == before) {
+                    record_error(arrow::Status::IOError("io_uring write: short O_DIRECT write"));
                 }
             }
+        }
+        if (res > 0 && b.written < b.used && b.written > before) {
+            // Short write: resubmit the remainder from the same buffer.
+            queue_write(idx, b.data + b.written, b.used - b.written,
+                        b.offset + static_cast<int64_t>(b.written));
+            resubmitted = true;
+        } else if (b.inflight) {
+            b.inflight       = false;
+            inflight_bytes_ -= b.used;
+            free_.push_back(idx);
+        }
+
+        cqe = nullptr;
+        if (io_uring_peek_cqe(ring, &cqe) != 0) break;
+    }
+    if (resubmitted) {
+        io_uring_submit(ring);
+    }
+    return true;
+#else
+    (void)block;
+    return false;
+#endif
+}
 
-            io_uring_prep_write(sqe, file_fd_, ptr,
-                                static_cast<unsigned>(chunk),
-                                static_cast<off_t>(off));
-            sqe->user_data = static_cast<uint64_t>(chunk);  // for partial-write check
-            ++inflight;
+void IoUringOutputStream::drain() {
+    while (inflight_bytes_ > 0) {
+        if (!reap(true)) break;  // ring failed; error_ already set
+    }
+}
 
-            ptr  += chunk;
-            off  += static_cast<int64_t>(chunk);
-            rem  -= chunk;
-        }
+// ---------------------------------------------------------------------------
+// Synchronous fallback (ring_ == nullptr)
+// ---------------------------------------------------------------------------
 
-        // --- submit remainder + drain all in-flight CQEs ---
-        if (inflight > 0) {
-            io_uring_submit(ring);
-            while (inflight > 0) {
-                struct io_uring_cqe* cqe = nullptr;
-                int r = io_uring_wait_cqe(ring, &cqe);
-                if (r < 0) {
-                    if (st.ok())
-                        st = arrow::Status::IOError(
-                            "io_uring_wait_cqe: ", strerror(-r));
-                    break;  // ring in bad state; remaining SQEs are abandoned
-                }
-                size_t expected = static_cast<size_t>(cqe->user_data);
-                if (cqe->res < 0 && st.ok())
-                    st = arrow::Status::IOError(
-                        "io_uring write: ", strerror(-cqe->res));
-                else if (st.ok() && static_cast<size_t>(cqe->res) != expected)
-                    st = arrow::Status::IOError("io_uring write: short write");
-                io_uring_cqe_seen(ring, cqe);
-                --inflight;
+arrow::Status IoUringOutputStream::write_sync(const void* data, int64_t nbytes,
+                                              int64_t offset) {
+    const uint8_t* ptr       = static_cast<const uint8_t*>(data);
+    int64_t        remaining = nbytes;
+    while (remaining > 0) {
+        ssize_t n =
+            pwrite(file_fd_, ptr, static_cast<size_t>(remaining), offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return arrow::Status::IOError("IoUringOutputStream: pwrite: ",
+                                          strerror(errno));
+        }
+        if (direct_ && n < remaining) {
+            // O_DIRECT: continue from the last whole block, never mid-block
+            n = n / static_cast<ssize_t>(STAGING_ALIGN) * static_cast<ssize_t>(STAGING_ALIGN);
+            if (n == 0) {
+                return arrow::Status::IOError("IoUringOutputStream: short O_DIRECT pwrite");
             }
         }
-
-        job->done.set_value(st);
+        ptr       += n;
+        offset    += n;
+        remaining -= n;
     }
+    return arrow::Status::OK();
 }
 
-#endif  // TPCH_ENABLE_ASYNC_IO
-
 }  // namespace tpch
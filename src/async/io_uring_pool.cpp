@@ -15,10 +15,13 @@
 namespace tpch {
 
 // Static member definitions
-void*    IoUringPool::anchor_ring_   = nullptr;
-int      IoUringPool::anchor_fd_     = -1;
-uint32_t IoUringPool::calibrated_qd_ = 32;
-bool     IoUringPool::available_     = false;
+std::vector<IoUringPool::Anchor> IoUringPool::anchors_;
+bool                             IoUringPool::available_ = false;
+
+size_t IoUringPool::anchor_index(int device) {
+    return device > 0 && static_cast<size_t>(device) < anchors_.size()
+        ? static_cast<size_t>(device) : 0;
+}
 
 // ---- real implementation ------------------------------------------------
 #ifdef TPCH_ENABLE_ASYNC_IO
@@ -69,34 +72,73 @@ static uint32_t sysfs_queue_depth(const std::string& dir) {
     return result;
 }
 
+static uint64_t dir_device(const std::string& dir) {
+    struct stat st;
+    return stat(dir.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_dev) : 0;
+}
+
 bool IoUringPool::init(const std::string& output_dir) {
     if (available_) return true;
 
-    calibrated_qd_ = sysfs_queue_depth(output_dir);
+    Anchor a;
+    a.qd  = sysfs_queue_depth(output_dir);
+    a.dev = dir_device(output_dir);
 
     auto* ring = new io_uring{};
-    int ret = io_uring_queue_init(calibrated_qd_, ring, 0);
+    int ret = io_uring_queue_init(a.qd, ring, 0);
     if (ret < 0) {
         delete ring;
         fprintf(stderr,
                 "IoUringPool: io_uring_queue_init(QD=%u) failed: %s\n",
-                calibrated_qd_, strerror(-ret));
+                a.qd, strerror(-ret));
         return false;
     }
 
-    anchor_ring_ = ring;
-    anchor_fd_   = ring->ring_fd;
-    available_   = true;
+    a.ring = ring;
+    a.fd   = ring->ring_fd;
+    anchors_.assign(1, a);
+    available_ = true;
 
     fprintf(stderr,
             "IoUringPool: anchor ring initialised (QD=%u, ring_fd=%d)\n",
-            calibrated_qd_, anchor_fd_);
+            a.qd, a.fd);
     return true;
 }
 
+int IoUringPool::add_device(const std::string& dir) {
+    if (!available_) return 0;
+
+    const uint64_t dev = dir_device(dir);
+    for (size_t i = 0; i < anchors_.size(); ++i) {
+        if (anchors_[i].dev == dev) return static_cast<int>(i);
+    }
+
+    // Plain ring: its own io-wq, not attached to the scheduler anchor.
+    Anchor a;
+    a.qd  = sysfs_queue_depth(dir);
+    a.dev = dev;
+    auto* ring = new io_uring{};
+    int ret = io_uring_queue_init(a.qd, ring, 0);
+    if (ret < 0) {
+        delete ring;
+        fprintf(stderr,
+                "IoUringPool: anchor for %s failed: %s — sharing the first anchor\n",
+                dir.c_str(), strerror(-ret));
+        return 0;
+    }
+    a.ring = ring;
+    a.fd   = ring->ring_fd;
+    anchors_.push_back(a);
+
+    fprintf(stderr,
+            "IoUringPool: device anchor %zu for %s (QD=%u, ring_fd=%d)\n",
+            anchors_.size() - 1, dir.c_str(), a.qd, a.fd);
+    return static_cast<int>(anchors_.size() - 1);
+}
+
 void IoUringPool::watch_child(int pidfd, uint64_t user_data) {
     if (!available_) return;
-    auto* ring = static_cast<io_uring*>(anchor_ring_);
+    auto* ring = static_cast<io_uring*>(anchors_[0].ring);
 
     struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
     if (!sqe) {
@@ -114,7 +156,7 @@ void IoUringPool::watch_child(int pidfd, uint64_t user_data) {
 
 std::vector<uint64_t> IoUringPool::wait_any() {
     if (!available_) return {};
-    auto* ring = static_cast<io_uring*>(anchor_ring_);
+    auto* ring = static_cast<io_uring*>(anchors_[0].ring);
 
     // Block until at least one CQE arrives
     struct io_uring_cqe* cqe = nullptr;
@@ -134,23 +176,26 @@ std::vector<uint64_t> IoUringPool::wait_any() {
     return results;
 }
 
-void* IoUringPool::create_child_ring_struct() {
+void* IoUringPool::create_child_ring_struct(int device) {
     auto* ring = new io_uring{};
 
+    const int      anchor_fd = available_ ? anchors_[anchor_index(device)].fd : -1;
+    const uint32_t qd        = queue_depth(device);
+
     struct io_uring_params params{};
-    if (anchor_fd_ >= 0) {
+    if (anchor_fd >= 0) {
         params.flags |= IORING_SETUP_ATTACH_WQ;
-        params.wq_fd  = static_cast<unsigned>(anchor_fd_);
+        params.wq_fd  = static_cast<unsigned>(anchor_fd);
     }
 
-    int ret = io_uring_queue_init_params(calibrated_qd_, ring, &params);
+    int ret = io_uring_queue_init_params(qd, ring, &params);
     if (ret < 0) {
         fprintf(stderr,
                 "IoUringPool::create_child_ring_struct: ATTACH_WQ failed: %s"
                 " — retrying as plain ring\n",
                 strerror(-ret));
         params = {};
-        ret = io_uring_queue_init_params(calibrated_qd_, ring, &params);
+        ret = io_uring_queue_init_params(qd, ring, &params);
         if (ret < 0) {
             delete ring;
             fprintf(stderr,
@@ -173,16 +218,20 @@ void IoUringPool::free_ring(void* ring_struct) {
 #else
 
 bool IoUringPool::init(const std::string& /*output_dir*/) { return false; }
+int  IoUringPool::add_device(const std::string& /*dir*/) { return 0; }
 void IoUringPool::watch_child(int /*pidfd*/, uint64_t /*user_data*/) {}
 std::vector<uint64_t> IoUringPool::wait_any() { return {}; }
-void* IoUringPool::create_child_ring_struct() { return nullptr; }
+void* IoUringPool::create_child_ring_struct(int /*device*/) { return nullptr; }
 void  IoUringPool::free_ring(void* /*ring*/) {}
 
 #endif  // TPCH_ENABLE_ASYNC_IO
 
 // ---- always-available accessors -----------------------------------------
-bool     IoUringPool::available()   { return available_; }
-int      IoUringPool::anchor_fd()   { return anchor_fd_; }
-uint32_t IoUringPool::queue_depth() { return calibrated_qd_; }
+bool IoUringPool::available() { return available_; }
+int  IoUringPool::anchor_fd() { return anchors_.empty() ? -1 : anchors_[0].fd; }
+
+uint32_t IoUringPool::queue_depth(int device) {
+    return anchors_.empty() ? 32 : anchors_[anchor_index(device)].qd;
+}
 
 }  // namespace tpch
@@ -0,0 +1,194 @@
+#include "tpch/mmap_output_stream.hpp"
+#include "tpch/write_throttle.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <arrow/result.h>
+
+namespace tpch {
+
+namespace {
+
+constexpr size_t PAGE = 4096;
+
+// memcpy that bypasses the cache for the aligned bulk of large copies.
+void copy_out(uint8_t* dst, const uint8_t* src, size_t n, size_t nt_threshold) {
+#if defined(__SSE2__)
+    if (n >= nt_threshold) {
+        size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+        std::memcpy(dst, src, head);
+        dst += head;
+        src += head;
+        n   -= head;
+        auto*       d = reinterpret_cast<__m128i*>(dst);
+        const auto* s = reinterpret_cast<const __m128i*>(src);
+        size_t blocks = n / 64;
+        for (size_t i = 0; i < blocks; ++i, d += 4, s += 4) {
+            __m128i a = _mm_loadu_si128(s);
+            __m128i b = _mm_loadu_si128(s + 1);
+            __m128i c = _mm_loadu_si128(s + 2);
+            __m128i e = _mm_loadu_si128(s + 3);
+            _mm_stream_si128(d, a);
+            _mm_stream_si128(d + 1, b);
+            _mm_stream_si128(d + 2, c);
+            _mm_stream_si128(d + 3, e);
+        }
+        _mm_sfence();
+        std::memcpy(d, s, n % 64);
+        return;
+    }
+#else
+    (void)nt_threshold;
+#endif
+    std::memcpy(dst, src, n);
+}
+
+}  // namespace
+
+MmapOutputStream::MmapOutputStream(const std::string& path, MmapStreamConfig config)
+    : path_(path), config_(config) {
+    config_.extent_bytes = std::max<size_t>((config_.extent_bytes + PAGE - 1) / PAGE * PAGE, PAGE);
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("MmapOutputStream: cannot open " + path + ": " + strerror(errno));
+    }
+    unmapper_ = std::thread([this] { unmapper_loop(); });
+}
+
+MmapOutputStream::~MmapOutputStream() {
+    if (!closed_) {
+        (void)Close();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// OutputStream interface
+// ---------------------------------------------------------------------------
+
+arrow::Status MmapOutputStream::Write(const void* data, int64_t nbytes) {
+    if (closed_) {
+        return arrow::Status::IOError("MmapOutputStream: write after close");
+    }
+    const auto* src = static_cast<const uint8_t*>(data);
+    size_t      rem = nbytes > 0 ? static_cast<size_t>(nbytes) : 0;
+    while (rem > 0) {
+        if (used_ == current_.len) {
+            retire_current();
+            ARROW_RETURN_NOT_OK(map_next());
+        }
+        size_t n = std::min(rem, current_.len - used_);
+        copy_out(current_.addr + used_, src, n, config_.non_temporal_bytes);
+        used_     += n;
+        src       += n;
+        rem       -= n;
+        position_ += static_cast<int64_t>(n);
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status MmapOutputStream::Flush() {
+    return arrow::Status::OK();
+}
+
+arrow::Status MmapOutputStream::Close() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    closed_ = true;
+    retire_current();
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    unmapper_.join();
+
+    arrow::Status st;
+    if (::ftruncate(fd_, position_) != 0) {  // drop the unused tail of the last extent
+        st = arrow::Status::IOError("MmapOutputStream: ftruncate ", path_, ": ", strerror(errno));
+    }
+    if (::close(fd_) != 0 && st.ok()) {
+        st = arrow::Status::IOError("MmapOutputStream: close ", path_, ": ", strerror(errno));
+    }
+    fd_ = -1;
+    return st;
+}
+
+arrow::Result<int64_t> MmapOutputStream::Tell() const {
+    return position_;
+}
+
+bool MmapOutputStream::closed() const {
+    return closed_;
+}
+
+// ---------------------------------------------------------------------------
+// Extents
+// ---------------------------------------------------------------------------
+
+arrow::Status MmapOutputStream::map_next() {
+    const int64_t offset = file_size_;
+    const size_t  len    = config_.extent_bytes;
+    // fallocate reserves the blocks, so a full disk is an error here rather
+    // than SIGBUS on a store into the mapping; ftruncate if unsupported.
+    if (::fallocate(fd_, 0, offset, static_cast<off_t>(len)) != 0) {
+        if (errno != EOPNOTSUPP && errno != ENOSYS) {
+            return arrow::Status::IOError("MmapOutputStream: fallocate ", path_, ": ", strerror(errno));
+        }
+        if (::ftruncate(fd_, offset + static_cast<int64_t>(len)) != 0) {
+            return arrow::Status::IOError("MmapOutputStream: ftruncate ", path_, ": ", strerror(errno));
+        }
+    }
+    file_size_ = offset + static_cast<int64_t>(len);
+
+    void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+    if (p == MAP_FAILED) {
+        return arrow::Status::IOError("MmapOutputStream: mmap ", path_, ": ", strerror(errno));
+    }
+    current_ = {static_cast<uint8_t*>(p), offset, len};
+    used_    = 0;
+    return arrow::Status::OK();
+}
+
+void MmapOutputStream::retire_current() {
+    if (!current_.addr) return;
+    WriteThrottle::acquire(used_);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        retired_.push_back(current_);
+    }
+    cv_.notify_one();
+    current_ = {};
+    used_    = 0;
+}
+
+void MmapOutputStream::unmapper_loop() {
+    for (;;) {
+        Extent e;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return stopping_ || !retired_.empty(); });
+            if (retired_.empty()) return;  // stopping and drained
+            e = retired_.front();
+            retired_.pop_front();
+        }
+        if (config_.writeback) {
+            ::sync_file_range(fd_, e.offset, static_cast<off64_t>(e.len), SYNC_FILE_RANGE_WRITE);
+        }
+        ::munmap(e.addr, e.len);
+    }
+}
+
+}  // namespace tpch
@@ -0,0 +1,142 @@
+#include "tpch/pipe_output_stream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <arrow/result.h>
+
+namespace tpch {
+
+PipeOutputStream::PipeOutputStream(int fd, std::string name, bool owns_fd)
+    : fd_(fd), name_(std::move(name)), owns_fd_(owns_fd), chunk_(CHUNK_BYTES) {
+    struct stat st{};
+    if (::fstat(fd_, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        (void)::fcntl(fd_, F_SETPIPE_SZ, static_cast<int>(PIPE_BYTES));  // may exceed pipe-max-size
+    }
+}
+
+PipeOutputStream::~PipeOutputStream() {
+    if (!closed_) {
+        (void)Close();
+    }
+}
+
+std::shared_ptr<PipeOutputStream> PipeOutputStream::open_fifo(const std::string& path) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) == 0) {
+        if (!S_ISFIFO(st.st_mode)) {
+            throw std::runtime_error("PipeOutputStream: '" + path + "' exists and is not a FIFO");
+        }
+    } else if (::mkfifo(path.c_str(), 0644) != 0 && errno != EEXIST) {
+        throw std::runtime_error("PipeOutputStream: mkfifo '" + path + "': " + strerror(errno));
+    }
+
+    int fd;
+    do {
+        fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);  // waits for a reader
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        throw std::runtime_error("PipeOutputStream: open '" + path + "': " + strerror(errno));
+    }
+    return std::make_shared<PipeOutputStream>(fd, path);
+}
+
+// ---------------------------------------------------------------------------
+// OutputStream interface
+// ---------------------------------------------------------------------------
+
+arrow::Status PipeOutputStream::Write(const void* data, int64_t nbytes) {
+    if (closed_) {
+        return arrow::Status::IOError("PipeOutputStream: write after close");
+    }
+    const auto* src = static_cast<const uint8_t*>(data);
+    auto        rem = nbytes > 0 ? static_cast<size_t>(nbytes) : 0;
+    if (rem >= CHUNK_BYTES) {
+        // Staging a large write would only add a copy
+        ARROW_RETURN_NOT_OK(Flush());
+        ARROW_RETURN_NOT_OK(write_all(src, rem));
+        rem = 0;
+    }
+    while (rem > 0) {
+        size_t n = std::min(rem, CHUNK_BYTES - used_);
+        std::memcpy(chunk_.data() + used_, src, n);
+        used_ += n;
+        src   += n;
+        rem   -= n;
+        if (used_ == CHUNK_BYTES) {
+            ARROW_RETURN_NOT_OK(Flush());
+        }
+    }
+    position_ += nbytes > 0 ? nbytes : 0;
+    return arrow::Status::OK();
+}
+
+arrow::Status PipeOutputStream::Flush() {
+    if (closed_ || used_ == 0) {
+        return arrow::Status::OK();
+    }
+    const size_t n = used_;
+    used_ = 0;
+    return write_all(chunk_.data(), n);
+}
+
+arrow::Status PipeOutputStream::Close() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    arrow::Status st = Flush();
+    closed_ = true;
+    if (owns_fd_ && ::close(fd_) != 0 && st.ok()) {
+        st = arrow::Status::IOError("PipeOutputStream: close ", name_, ": ", strerror(errno));
+    }
+    return st;
+}
+
+arrow::Result<int64_t> PipeOutputStream::Tell() const {
+    return position_;
+}
+
+bool PipeOutputStream::closed() const {
+    return closed_;
+}
+
+// ---------------------------------------------------------------------------
+// write(2)
+// ---------------------------------------------------------------------------
+
+arrow::Status PipeOutputStream::wait_writable() {
+    struct pollfd pfd{fd_, POLLOUT, 0};
+    while (::poll(&pfd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            return arrow::Status::IOError("PipeOutputStream: poll ", name_, ": ", strerror(errno));
+        }
+    }
+    return arrow::Status::OK();  // POLLERR/POLLHUP: the next write reports it
+}
+
+arrow::Status PipeOutputStream::write_all(const uint8_t* p, size_t n) {
+    while (n > 0) {
+        ssize_t r = ::write(fd_, p, n);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                ARROW_RETURN_NOT_OK(wait_writable());
+                continue;
+            }
+            return arrow::Status::IOError("PipeOutputStream: write ", name_, ": ",
+                                          strerror(errno));
+        }
+        p += r;
+        n -= static_cast<size_t>(r);
+    }
+    return arrow::Status::OK();
+}
+
+}  // namespace tpch
@@ -0,0 +1,255 @@
+#include "tpch/s3_output_stream.hpp"
+
+#include "tpch/write_throttle.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+
+#include <arrow/memory_pool.h>
+#include <arrow/result.h>
+
+#ifdef TPCH_ENABLE_S3
+#include <arrow/filesystem/s3fs.h>
+#include <arrow/io/type_fwd.h>
+#endif
+
+namespace tpch {
+
+namespace {
+
+#ifdef TPCH_ENABLE_S3
+
+std::mutex                               g_s3_mu;
+std::shared_ptr<arrow::fs::S3FileSystem> g_s3_fs;
+std::shared_ptr<UploadWindow>            g_s3_window;    // outlives g_s3_fs: parts free into it
+int                                      g_s3_pool = 0;  // IO pool size we set
+
+const char* env_or(const char* a, const char* b = nullptr) {
+    const char* v = std::getenv(a);
+    if ((!v || !*v) && b) v = std::getenv(b);
+    return v && *v ? v : nullptr;
+}
+
+void finalize_s3() {
+    std::lock_guard<std::mutex> lock(g_s3_mu);
+    g_s3_fs.reset();
+    (void)arrow::fs::EnsureS3Finalized();
+}
+
+// Set up S3 in this process on first use. The AWS SDK starts threads, so
+// this must run in the child after fork(), never in the parent before it.
+std::shared_ptr<arrow::fs::S3FileSystem> s3_filesystem(int max_uploads) {
+    std::lock_guard<std::mutex> lock(g_s3_mu);
+    if (g_s3_fs) return g_s3_fs;
+
+    auto st = arrow::fs::EnsureS3Initialized();
+    if (!st.ok()) {
+        throw std::runtime_error("S3OutputStream: S3 init failed: " + st.ToString());
+    }
+
+    arrow::fs::S3Options options = arrow::fs::S3Options::Defaults();
+    if (const char* ep = env_or("AWS_ENDPOINT_URL_S3", "AWS_ENDPOINT_URL")) {
+        std::string endpoint = ep;
+        for (const char* scheme : {"http", "https"}) {
+            std::string prefix = std::string(scheme) + "://";
+            if (endpoint.rfind(prefix, 0) == 0) {
+                options.scheme = scheme;
+                endpoint       = endpoint.substr(prefix.size());
+            }
+        }
+        options.endpoint_override = endpoint;
+    }
+    if (const char* region = env_or("AWS_REGION", "AWS_DEFAULT_REGION")) {
+        options.region = region;
+    } else if (!options.endpoint_override.empty()) {
+        options.region = "us-east-1";  // MinIO and most S3-compatible stores accept it
+    }
+    options.background_writes = true;
+
+    // Uploads run on Arrow's IO pool: size it to the upload window.
+    if (max_uploads > g_s3_pool) {
+        (void)arrow::io::SetIOThreadPoolCapacity(max_uploads);
+        g_s3_pool = max_uploads;
+    }
+
+    // Part buffers come from the IOContext pool: count them for the window
+    g_s3_window = std::make_shared<UploadWindow>();
+    auto fs = arrow::fs::S3FileSystem::Make(options, arrow::io::IOContext(g_s3_window.get()));
+    if (!fs.ok()) {
+        throw std::runtime_error("S3OutputStream: " + fs.status().ToString());
+    }
+    g_s3_fs = *fs;
+    // Registered last, so it runs before the statics created above (IO pool,
+    // AWS SDK) are torn down.
+    std::atexit(finalize_s3);
+    return g_s3_fs;
+}
+
+#endif  // TPCH_ENABLE_S3
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// UploadWindow
+// ---------------------------------------------------------------------------
+
+void UploadWindow::wait_until_at_most(int64_t limit) {
+    std::unique_lock<std::mutex> lock(mu_);
+    freed_.wait(lock, [&] { return held_ <= limit; });
+}
+
+arrow::Status UploadWindow::Allocate(int64_t size, int64_t alignment, uint8_t** out) {
+    ARROW_RETURN_NOT_OK(base_->Allocate(size, alignment, out));
+    std::lock_guard<std::mutex> lock(mu_);
+    held_  += size;
+    total_ += size;
+    ++count_;
+    return arrow::Status::OK();
+}
+
+arrow::Status UploadWindow::Reallocate(int64_t old_size, int64_t new_size, int64_t alignment,
+                                       uint8_t** ptr) {
+    ARROW_RETURN_NOT_OK(base_->Reallocate(old_size, new_size, alignment, ptr));
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        held_ += new_size - old_size;
+        if (new_size > old_size) total_ += new_size - old_size;
+    }
+    if (new_size < old_size) freed_.notify_all();
+    return arrow::Status::OK();
+}
+
+void UploadWindow::Free(uint8_t* buffer, int64_t size, int64_t alignment) {
+    base_->Free(buffer, size, alignment);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        held_ -= size;
+    }
+    freed_.notify_all();
+}
+
+int64_t UploadWindow::bytes_allocated() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return held_;
+}
+
+int64_t UploadWindow::total_bytes_allocated() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return total_;
+}
+
+int64_t UploadWindow::num_allocations() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return count_;
+}
+
+// ---------------------------------------------------------------------------
+// S3OutputStream
+// ---------------------------------------------------------------------------
+
+S3OutputStream::S3OutputStream(std::shared_ptr<arrow::io::OutputStream> upload,
+                               std::string name, S3UploadConfig config,
+                               std::shared_ptr<UploadWindow> window)
+    : upload_(std::move(upload)), name_(std::move(name)), config_(config),
+      window_(std::move(window)) {
+    constexpr size_t part = S3UploadConfig::ARROW_PART_BYTES;
+    config_.max_uploads = std::max(config_.max_uploads, 1);
+    if (config_.window_bytes == 0) {
+        config_.window_bytes = static_cast<size_t>(config_.max_uploads + 1) * part;
+    }
+    config_.window_bytes = std::max<size_t>((config_.window_bytes + part - 1) / part, 1) * part;
+}
+
+S3OutputStream::~S3OutputStream() {
+    if (!closed_) {
+        (void)Abort();  // never publish a table that was not closed
+    }
+}
+
+std::shared_ptr<S3OutputStream> S3OutputStream::open(const std::string& uri,
+                                                     S3UploadConfig config) {
+    if (!is_s3_uri(uri)) {
+        throw std::runtime_error("S3OutputStream: not an s3:// URI: " + uri);
+    }
+#ifdef TPCH_ENABLE_S3
+    auto fs = s3_filesystem(config.max_uploads);
+    auto upload = fs->OpenOutputStream(uri.substr(5));  // "bucket/key"
+    if (!upload.ok()) {
+        throw std::runtime_error("S3OutputStream: open " + uri + ": " +
+                                 upload.status().ToString());
+    }
+    return std::make_shared<S3OutputStream>(*upload, uri, config, g_s3_window);
+#else
+    (void)config;
+    throw std::runtime_error("S3OutputStream: built without S3 support (-DTPCH_ENABLE_S3=ON): " + uri);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// OutputStream interface
+// ---------------------------------------------------------------------------
+
+arrow::Status S3OutputStream::Write(const void* data, int64_t nbytes) {
+    if (closed_) {
+        return arrow::Status::IOError("S3OutputStream: write after close");
+    }
+    constexpr auto part = static_cast<int64_t>(S3UploadConfig::ARROW_PART_BYTES);
+    const auto*    src  = static_cast<const uint8_t*>(data);
+    while (nbytes > 0) {
+        const int64_t offset = position_ % part;
+        if (offset == 0 && window_) {
+            // A new part buffer is allocated with this write: make room first
+            window_->wait_until_at_most(static_cast<int64_t>(config_.window_bytes) - part);
+        }
+        const int64_t n = std::min(nbytes, part - offset);
+        WriteThrottle::acquire(static_cast<size_t>(n));
+        arrow::Status st = upload_->Write(src, n);
+        if (!st.ok()) {
+            return arrow::Status::IOError("S3OutputStream: upload part ", position_ / part + 1,
+                                          " of ", name_, ": ", st.ToString());
+        }
+        position_ += n;
+        src       += n;
+        nbytes    -= n;
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status S3OutputStream::Flush() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    return upload_->Flush();
+}
+
+arrow::Status S3OutputStream::Close() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    closed_ = true;
+    arrow::Status st = upload_->Close();  // uploads the tail, waits for all parts
+    if (!st.ok()) {
+        return arrow::Status::IOError("S3OutputStream: complete ", name_, ": ", st.ToString());
+    }
+    return st;
+}
+
+arrow::Status S3OutputStream::Abort() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    closed_ = true;
+    return upload_->Abort();
+}
+
+arrow::Result<int64_t> S3OutputStream::Tell() const {
+    return position_;
+}
+
+bool S3OutputStream::closed() const {
+    return closed_;
+}
+
+}  // namespace tpch
@@ -51,17 +51,86 @@ void SharedAsyncIOContext::queue_write(int file_handle, const void* buf, size_t
     state.offset += count;
 }
 
+void SharedAsyncIOContext::queue_write(int file_handle, std::vector<uint8_t> data) {
+    auto it = files_.find(file_handle);
+    if (it == files_.end()) {
+        throw std::runtime_error("Invalid file handle");
+    }
+    if (data.empty()) {
+        return;
+    }
+
+    // Backpressure: keep the owned bytes in flight under the window
+    while (inflight_bytes_ > 0 && inflight_bytes_ + data.size() > max_inflight_bytes_) {
+        reap(1);
+    }
+
+    FileState& state = it->second;
+    const uint64_t id = OWNED_WRITE_TAG | next_write_id_++;
+    auto& owned = owned_[id];
+    owned.file_handle = file_handle;
+    owned.data = std::move(data);
+
+    try {
+        async_ctx_->queue_write(state.fd, owned.data.data(), owned.data.size(), state.offset, id);
+    } catch (...) {
+        owned_.erase(id);
+        throw;
+    }
+    state.offset += static_cast<off_t>(owned.data.size());
+    state.inflight++;
+    inflight_bytes_ += owned.data.size();
+
+    // Submit right away: the caller goes back to generating while the kernel writes
+    async_ctx_->submit_queued();
+}
+
+size_t SharedAsyncIOContext::inflight_bytes() const {
+    return inflight_bytes_;
+}
+
+void SharedAsyncIOContext::set_max_inflight_bytes(size_t bytes) {
+    max_inflight_bytes_ = bytes > 0 ? bytes : 1;
+}
+
+size_t SharedAsyncIOContext::max_inflight_bytes() const {
+    return max_inflight_bytes_;
+}
+
+int SharedAsyncIOContext::reap(int min_complete) {
+    std::vector<uint64_t> completed_ids;
+    int completed = async_ctx_->wait_completions(min_complete, &completed_ids);
+    for (uint64_t id : completed_ids) {
+        if ((id & OWNED_WRITE_TAG) == 0) {
+            continue;
+        }
+        auto it = owned_.find(id);
+        if (it == owned_.end()) {
+            continue;
+        }
+        inflight_bytes_ -= it->second.data.size();
+        auto file = files_.find(it->second.file_handle);
+        if (file != files_.end()) {
+            file->second.inflight--;
+        }
+        owned_.erase(it);
+    }
+    return completed;
+}
+
 int SharedAsyncIOContext::submit_all() {
     return async_ctx_->submit_queued();
 }
 
 int SharedAsyncIOContext::wait_any(int min_complete) {
-    std::vector<uint64_t> completed_ids;
-    return async_ctx_->wait_completions(min_complete, &completed_ids);
+    return reap(min_complete);
 }
 
 void SharedAsyncIOContext::flush() {
-    async_ctx_->flush();
+    async_ctx_->submit_queued();
+    while (async_ctx_->pending_count() > 0) {
+        reap(async_ctx_->pending_count());
+    }
 }
 
 int SharedAsyncIOContext::pending_count() const {
@@ -70,6 +139,12 @@ int SharedAsyncIOContext::pending_count() const {
 
 void SharedAsyncIOContext::close_file(int file_handle) {
     auto it = files_.find(file_handle);
+    if (it != files_.end() && it->second.inflight > 0) {
+        async_ctx_->submit_queued();
+        while (it->second.inflight > 0 && async_ctx_->pending_count() > 0) {
+            reap(1);
+        }
+    }
     if (it != files_.end()) {
         if (it->second.fd != -1) {
             close(it->second.fd);
@@ -0,0 +1,97 @@
+#include "tpch/shared_async_output_stream.hpp"
+#include "tpch/shared_async_io.hpp"
+#include "tpch/write_throttle.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+namespace tpch {
+
+SharedAsyncOutputStream::SharedAsyncOutputStream(
+    std::shared_ptr<SharedAsyncIOContext> ctx, const std::string& path)
+    : ctx_(std::move(ctx)) {
+    handle_ = ctx_->register_file(path);
+    staging_.reserve(STAGING_BYTES);
+}
+
+SharedAsyncOutputStream::~SharedAsyncOutputStream() {
+    if (!closed_) {
+        (void)Close();
+    }
+}
+
+arrow::Status SharedAsyncOutputStream::queue_staging() {
+    if (staging_.empty()) {
+        return arrow::Status::OK();
+    }
+    WriteThrottle::acquire(staging_.size());
+    try {
+        ctx_->queue_write(handle_, std::move(staging_));
+    } catch (const std::exception& e) {
+        return arrow::Status::IOError("SharedAsyncOutputStream: ", e.what());
+    }
+    staging_ = std::vector<uint8_t>();
+    staging_.reserve(STAGING_BYTES);
+    return arrow::Status::OK();
+}
+
+arrow::Status SharedAsyncOutputStream::Write(const void* data, int64_t nbytes) {
+    if (closed_) {
+        return arrow::Status::Invalid("SharedAsyncOutputStream: write after close");
+    }
+    if (nbytes <= 0) {
+        return arrow::Status::OK();
+    }
+
+    const auto* src = static_cast<const uint8_t*>(data);
+    auto left = static_cast<size_t>(nbytes);
+    while (left > 0) {
+        size_t room = STAGING_BYTES - std::min(staging_.size(), STAGING_BYTES);
+        size_t n = std::min(left, room);
+        staging_.insert(staging_.end(), src, src + n);
+        src += n;
+        left -= n;
+        if (staging_.size() >= STAGING_BYTES) {
+            ARROW_RETURN_NOT_OK(queue_staging());
+        }
+    }
+    position_ += nbytes;
+    return arrow::Status::OK();
+}
+
+arrow::Status SharedAsyncOutputStream::Flush() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    return queue_staging();
+}
+
+arrow::Status SharedAsyncOutputStream::Close() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    closed_ = true;
+    auto status = queue_staging();
+    try {
+        ctx_->close_file(handle_);
+    } catch (const std::exception& e) {
+        if (status.ok()) {
+            status = arrow::Status::IOError("SharedAsyncOutputStream: ", e.what());
+        }
+    }
+    return status;
+}
+
+arrow::Result<int64_t> SharedAsyncOutputStream::Tell() const {
+    return position_;
+}
+
+bool SharedAsyncOutputStream::closed() const {
+    return closed_;
+}
+
+}  // namespace tpch
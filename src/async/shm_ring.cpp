@@ -0,0 +1,259 @@
+#include "tpch/shm_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/futex.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace tpch {
+
+struct ShmRing::Header {
+    // Producer-owned (kept in shared memory so the next child in the same
+    // slot resumes from the right positions).
+    alignas(64) std::atomic<uint64_t> desc_head{0};
+    uint64_t data_head    = 0;  // bytes copied in, published or not
+    uint64_t pending_pos  = 0;  // unpublished SHM_DATA run
+    uint64_t pending_len  = 0;
+    uint32_t pending_file = 0;
+    uint32_t next_file    = 0;
+
+    // Consumer-owned.
+    alignas(64) std::atomic<uint64_t> desc_tail{0};
+    std::atomic<uint64_t> data_tail{0};
+    std::atomic<uint32_t> tail_seq{0};  // futex word, bumped on every release()
+    std::atomic<int32_t>  error{0};
+
+    // Handshake flags.
+    alignas(64) std::atomic<uint32_t> producer_waiting{0};
+    std::atomic<uint32_t> consumer_idle{0};
+};
+
+static_assert(sizeof(ShmRingDesc) == 32, "descriptor layout is shared between processes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free (address-free)");
+
+namespace {
+
+size_t round_up_to_page(size_t n) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (n + page - 1) / page * page;
+}
+
+// Shared (not FUTEX_PRIVATE) futex: the word lives in a MAP_SHARED memfd.
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, long timeout_ns) {
+    struct timespec ts{0, timeout_ns};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts,
+            nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr,
+            nullptr, 0);
+}
+
+// Re-check period while blocked; bounds the damage of a lost wake-up and
+// lets a producer notice a consumer error.
+constexpr long WAIT_SLICE_NS = 50L * 1000 * 1000;
+
+}  // namespace
+
+ShmRing::ShmRing(size_t capacity, int doorbell_fd) : doorbell_fd_(doorbell_fd) {
+    capacity_  = round_up_to_page(std::max(capacity, RECORD_BYTES));
+    map_bytes_ = round_up_to_page(HEADER_BYTES + DESC_SLOTS * sizeof(ShmRingDesc));
+    static_assert(sizeof(Header) <= HEADER_BYTES, "ShmRing header too large");
+
+    memfd_ = memfd_create("tpch-shm-ring", MFD_CLOEXEC);
+    if (memfd_ < 0) {
+        throw std::runtime_error(std::string("ShmRing: memfd_create: ") + strerror(errno));
+    }
+    if (ftruncate(memfd_, static_cast<off_t>(map_bytes_ + capacity_)) != 0) {
+        int err = errno;
+        ::close(memfd_);
+        throw std::runtime_error(std::string("ShmRing: ftruncate: ") + strerror(err));
+    }
+
+    void* meta = mmap(nullptr, map_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, memfd_, 0);
+    if (meta == MAP_FAILED) {
+        int err = errno;
+        ::close(memfd_);
+        throw std::runtime_error(std::string("ShmRing: mmap header: ") + strerror(err));
+    }
+
+    // Reserve 2 * capacity of address space, then map the data pages into
+    // both halves so wrap-around spans stay contiguous.
+    void* base = mmap(nullptr, 2 * capacity_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* lo   = (base == MAP_FAILED) ? MAP_FAILED
+        : mmap(base, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd_,
+               static_cast<off_t>(map_bytes_));
+    void* hi   = (lo == MAP_FAILED) ? MAP_FAILED
+        : mmap(static_cast<uint8_t*>(base) + capacity_, capacity_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED, memfd_, static_cast<off_t>(map_bytes_));
+    if (hi == MAP_FAILED) {
+        int err = errno;
+        if (base != MAP_FAILED) munmap(base, 2 * capacity_);
+        munmap(meta, map_bytes_);
+        ::close(memfd_);
+        throw std::runtime_error(std::string("ShmRing: mmap data: ") + strerror(err));
+    }
+
+    header_ = new (meta) Header();
+    descs_  = reinterpret_cast<ShmRingDesc*>(static_cast<uint8_t*>(meta) + HEADER_BYTES);
+    data_   = static_cast<uint8_t*>(base);
+}
+
+ShmRing::~ShmRing() {
+    if (data_) munmap(data_, 2 * capacity_);
+    if (header_) munmap(header_, map_bytes_);
+    if (memfd_ >= 0) ::close(memfd_);
+}
+
+// ---------------------------------------------------------------------------
+// Producer
+// ---------------------------------------------------------------------------
+
+void ShmRing::ring_doorbell() {
+    if (header_->consumer_idle.load(std::memory_order_seq_cst) && doorbell_fd_ >= 0) {
+        uint64_t one = 1;
+        (void)!::write(doorbell_fd_, &one, sizeof(one));
+    }
+}
+
+void ShmRing::wait_for_space() {
+    uint32_t seq = header_->tail_seq.load(std::memory_order_acquire);
+    header_->producer_waiting.store(1, std::memory_order_seq_cst);
+    // Make sure the consumer is awake to retire what we are waiting on.
+    ring_doorbell();
+    futex_wait(&header_->tail_seq, seq, WAIT_SLICE_NS);
+    header_->producer_waiting.store(0, std::memory_order_relaxed);
+    if (int err = error()) {
+        throw std::runtime_error(std::string("ShmRing: I/O process write failed: ") + strerror(err));
+    }
+}
+
+void ShmRing::push_desc(uint32_t kind, uint32_t file, uint64_t pos, uint64_t len) {
+    uint64_t head = header_->desc_head.load(std::memory_order_relaxed);
+    while (head - header_->desc_tail.load(std::memory_order_acquire) >= DESC_SLOTS) {
+        wait_for_space();
+    }
+    descs_[head % DESC_SLOTS] = ShmRingDesc{kind, file, pos, len, 0};
+    header_->desc_head.store(head + 1, std::memory_order_seq_cst);
+    ring_doorbell();
+}
+
+void ShmRing::publish_pending() {
+    if (header_->pending_len == 0) return;
+    push_desc(SHM_DATA, header_->pending_file, header_->pending_pos, header_->pending_len);
+    header_->pending_len = 0;
+}
+
+uint32_t ShmRing::open_file(const std::string& path) {
+    publish_pending();
+    const uint32_t id = header_->next_file++;
+    while (capacity_ - (header_->data_head - header_->data_tail.load(std::memory_order_acquire))
+           < path.size()) {
+        wait_for_space();
+    }
+    const uint64_t pos = header_->data_head;
+    std::memcpy(data_ + pos % capacity_, path.data(), path.size());
+    header_->data_head += path.size();
+    push_desc(SHM_OPEN, id, pos, path.size());
+    return id;
+}
+
+void ShmRing::write(uint32_t file, const void* data, size_t nbytes) {
+    if (int err = error()) {
+        throw std::runtime_error(std::string("ShmRing: I/O process write failed: ") + strerror(err));
+    }
+    Header& h = *header_;
+    if (h.pending_len > 0 && h.pending_file != file) {
+        publish_pending();
+    }
+
+    const auto* src = static_cast<const uint8_t*>(data);
+    while (nbytes > 0) {
+        uint64_t used = h.data_head - h.data_tail.load(std::memory_order_acquire);
+        size_t   room = capacity_ - used;
+        if (room == 0) {
+            publish_pending();
+            wait_for_space();
+            continue;
+        }
+        if (h.pending_len == 0) {
+            h.pending_pos  = h.data_head;
+            h.pending_file = file;
+        }
+        size_t n = std::min({nbytes, room, RECORD_BYTES - h.pending_len});
+        std::memcpy(data_ + h.data_head % capacity_, src, n);
+        h.data_head   += n;
+        h.pending_len += n;
+        src    += n;
+        nbytes -= n;
+        if (h.pending_len >= RECORD_BYTES) {
+            publish_pending();
+        }
+    }
+}
+
+void ShmRing::flush() {
+    publish_pending();
+}
+
+void ShmRing::close_file(uint32_t file) {
+    publish_pending();
+    push_desc(SHM_CLOSE, file, header_->data_head, 0);
+}
+
+void ShmRing::wait_drained() {
+    publish_pending();
+    const uint64_t target = header_->desc_head.load(std::memory_order_relaxed);
+    while (header_->desc_tail.load(std::memory_order_acquire) < target) {
+        wait_for_space();
+    }
+    if (int err = error()) {
+        throw std::runtime_error(std::string("ShmRing: I/O process write failed: ") + strerror(err));
+    }
+}
+
+int ShmRing::error() const {
+    return header_->error.load(std::memory_order_acquire);
+}
+
+// ---------------------------------------------------------------------------
+// Consumer
+// ---------------------------------------------------------------------------
+
+uint64_t ShmRing::desc_head() const {
+    return header_->desc_head.load(std::memory_order_seq_cst);
+}
+
+const ShmRingDesc& ShmRing::desc(uint64_t n) const {
+    return descs_[n % DESC_SLOTS];
+}
+
+void ShmRing::release(uint64_t desc_tail, uint64_t data_tail) {
+    header_->data_tail.store(data_tail, std::memory_order_release);
+    header_->desc_tail.store(desc_tail, std::memory_order_release);
+    header_->tail_seq.fetch_add(1, std::memory_order_seq_cst);
+    if (header_->producer_waiting.load(std::memory_order_seq_cst)) {
+        futex_wake(&header_->tail_seq);
+    }
+}
+
+void ShmRing::set_error(int err) {
+    int32_t expected = 0;
+    header_->error.compare_exchange_strong(expected, err, std::memory_order_acq_rel);
+    header_->tail_seq.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(&header_->tail_seq);
+}
+
+void ShmRing::set_consumer_idle(bool idle) {
+    header_->consumer_idle.store(idle ? 1 : 0, std::memory_order_seq_cst);
+}
+
+}  // namespace tpch
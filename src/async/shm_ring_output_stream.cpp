@@ -0,0 +1,72 @@
+#include "tpch/shm_ring_output_stream.hpp"
+#include "tpch/shm_ring.hpp"
+
+#include <exception>
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+namespace tpch {
+
+ShmRingOutputStream::ShmRingOutputStream(ShmRing* ring, const std::string& path)
+    : ring_(ring) {
+    file_ = ring_->open_file(path);
+}
+
+ShmRingOutputStream::~ShmRingOutputStream() {
+    if (!closed_) {
+        (void)Close();
+    }
+}
+
+arrow::Status ShmRingOutputStream::Write(const void* data, int64_t nbytes) {
+    if (closed_) {
+        return arrow::Status::Invalid("ShmRingOutputStream: write after close");
+    }
+    if (nbytes <= 0) {
+        return arrow::Status::OK();
+    }
+    try {
+        ring_->write(file_, data, static_cast<size_t>(nbytes));
+    } catch (const std::exception& e) {
+        return arrow::Status::IOError("ShmRingOutputStream: ", e.what());
+    }
+    position_ += nbytes;
+    return arrow::Status::OK();
+}
+
+arrow::Status ShmRingOutputStream::Flush() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    try {
+        ring_->flush();
+    } catch (const std::exception& e) {
+        return arrow::Status::IOError("ShmRingOutputStream: ", e.what());
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Status ShmRingOutputStream::Close() {
+    if (closed_) {
+        return arrow::Status::OK();
+    }
+    closed_ = true;
+    try {
+        ring_->close_file(file_);
+        ring_->wait_drained();
+    } catch (const std::exception& e) {
+        return arrow::Status::IOError("ShmRingOutputStream: ", e.what());
+    }
+    return arrow::Status::OK();
+}
+
+arrow::Result<int64_t> ShmRingOutputStream::Tell() const {
+    return position_;
+}
+
+bool ShmRingOutputStream::closed() const {
+    return closed_;
+}
+
+}  // namespace tpch
@@ -104,6 +104,21 @@ void dbgen_restore_seed_snapshot(void) {
     }
 }
 
+/* Save/load the whole Seed[] array into caller-owned storage.  Used by the
+ * C++ batch iterators to keep per-table RNG state, so generation of several
+ * tables can be interleaved in one process without sharing streams. */
+size_t dbgen_seed_state_size(void) {
+    return sizeof(seed_snapshot);
+}
+
+void dbgen_save_seed_state(void *dst) {
+    memcpy(dst, Seed, sizeof(seed_snapshot));
+}
+
+void dbgen_load_seed_state(const void *src) {
+    memcpy(Seed, src, sizeof(seed_snapshot));
+}
+
 void dbg_text(char *tgt, int min, int max, int sd)
 {
     /* Generate a simple deterministic comment based on seed and length */
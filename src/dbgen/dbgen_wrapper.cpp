@@ -178,12 +178,13 @@ void tpch::DBGenWrapper::generate_orders(
     long max_rows) {
     auto batch_iter = generate_orders_batches(10000, max_rows);
     while (batch_iter.has_next()) {
-        auto batch = batch_iter.next();
+        auto batch = batch_iter.next_span();
         for (size_t i = 0; i < batch.size(); ++i) {
             if (callback) {
                 callback(&batch.rows[i]);
             }
         }
+        batch_iter.release(batch);
     }
 }
 
@@ -192,12 +193,13 @@ void tpch::DBGenWrapper::generate_customer(
     long max_rows) {
     auto batch_iter = generate_customer_batches(10000, max_rows);
     while (batch_iter.has_next()) {
-        auto batch = batch_iter.next();
+        auto batch = batch_iter.next_span();
         for (size_t i = 0; i < batch.size(); ++i) {
             if (callback) {
                 callback(&batch.rows[i]);
             }
         }
+        batch_iter.release(batch);
     }
 }
 
@@ -206,12 +208,13 @@ void tpch::DBGenWrapper::generate_part(
     long max_rows) {
     auto batch_iter = generate_part_batches(10000, max_rows);
     while (batch_iter.has_next()) {
-        auto batch = batch_iter.next();
+        auto batch = batch_iter.next_span();
         for (size_t i = 0; i < batch.size(); ++i) {
             if (callback) {
                 callback(&batch.rows[i]);
             }
         }
+        batch_iter.release(batch);
     }
 }
 
@@ -257,12 +260,13 @@ void tpch::DBGenWrapper::generate_supplier(
     long max_rows) {
     auto batch_iter = generate_supplier_batches(10000, max_rows);
     while (batch_iter.has_next()) {
-        auto batch = batch_iter.next();
+        auto batch = batch_iter.next_span();
         for (size_t i = 0; i < batch.size(); ++i) {
             if (callback) {
                 callback(&batch.rows[i]);
             }
         }
+        batch_iter.release(batch);
     }
 }
 
@@ -270,10 +274,11 @@ void tpch::DBGenWrapper::generate_nation(
     std::function<void(const void* row)> callback) {
     auto batch_iter = generate_nation_batches(1024, -1);
     while (batch_iter.has_next()) {
-        auto batch = batch_iter.next();
+        auto batch = batch_iter.next_span();
         for (size_t i = 0; i < batch.size(); ++i) {
             callback(&batch.rows[i]);
         }
+        batch_iter.release(batch);
     }
 }
 
@@ -281,10 +286,11 @@ void tpch::DBGenWrapper::generate_region(
     std::function<void(const void* row)> callback) {
     auto batch_iter = generate_region_batches(1024, -1);
     while (batch_iter.has_next()) {
-        auto batch = batch_iter.next();
+        auto batch = batch_iter.next_span();
         for (size_t i = 0; i < batch.size(); ++i) {
             callback(&batch.rows[i]);
         }
+        batch_iter.release(batch);
     }
 }
 
@@ -1,7 +1,9 @@
 #include "tpch/multi_table_writer.hpp"
 #include "tpch/shared_async_io.hpp"
+#include "tpch/shared_async_output_stream.hpp"
 #include "tpch/csv_writer.hpp"
 #include "tpch/parquet_writer.hpp"
+#include "tpch/arrow_ipc_writer.hpp"
 #include "tpch/async_io.hpp"
 #ifdef TPCH_ENABLE_ORC
 #include "tpch/orc_writer.hpp"
@@ -29,7 +31,12 @@ MultiTableWriter::MultiTableWriter(const std::string& output_dir, const std::str
 
     // Initialize async I/O context if requested
     if (use_async_io) {
-        async_ctx_ = std::make_shared<SharedAsyncIOContext>(512);
+        try {
+            async_ctx_ = std::make_shared<SharedAsyncIOContext>(512);
+        } catch (const std::exception&) {
+            // io_uring unavailable (old kernel, seccomp): fall back to sync writes
+            use_async_io_ = false;
+        }
     }
 }
 
@@ -41,9 +48,8 @@ MultiTableWriter::~MultiTableWriter() {
     }
 }
 
-std::string MultiTableWriter::get_table_filename(TableType table_type) const {
-    std::string table_name = table_type_name(table_type);
-    std::string filename = table_name + "." + format_;
+std::string MultiTableWriter::get_table_filename(const std::string& name) const {
+    std::string filename = name + "." + format_extension(format_);
 
     if (!output_dir_.empty() && output_dir_.back() == '/') {
         return output_dir_ + filename;
@@ -51,13 +57,17 @@ std::string MultiTableWriter::get_table_filename(TableType table_type) const {
     return output_dir_ + "/" + filename;
 }
 
-WriterPtr MultiTableWriter::create_writer(TableType /*table_type*/, const std::string& filepath) {
+WriterPtr MultiTableWriter::create_writer(const std::string& filepath) {
     WriterPtr writer;
 
-    if (format_ == "csv") {
+    if (factory_) {
+        writer = factory_(filepath);
+    } else if (format_ == "csv") {
         writer = std::make_unique<CSVWriter>(filepath);
     } else if (format_ == "parquet") {
         writer = std::make_unique<ParquetWriter>(filepath);
+    } else if (format_ == "arrow" || format_ == "arrow-stream") {
+        writer = std::make_unique<ArrowIpcWriter>(filepath, format_ == "arrow-stream");
     }
 #ifdef TPCH_ENABLE_ORC
     else if (format_ == "orc") {
@@ -87,40 +97,61 @@ WriterPtr MultiTableWriter::create_writer(TableType /*table_type*/, const std::s
         throw std::invalid_argument("Unknown format: " + format_);
     }
 
-    // Set async context if available
     if (use_async_io_ && async_ctx_) {
-        // For SharedAsyncIOContext support, we would need to enhance writers
-        // For now, use the existing AsyncIOContext capability if the writer supports it
-        // This is a bridge - writers will need SharedAsyncIOContext support in next phase
+        attach_async_stream(writer.get());
     }
 
     return writer;
 }
 
+void MultiTableWriter::attach_async_stream(WriterInterface* writer) {
+    // Parquet switches to streaming mode here, which is required anyway:
+    // buffering every table of a single-process run in memory would defeat
+    // the purpose.  Formats without stream injection (Lance) ignore this.
+    auto ctx = async_ctx_;
+    writer->set_output_stream_factory([ctx](const std::string& path) {
+        return std::make_shared<SharedAsyncOutputStream>(ctx, path);
+    });
+}
+
+void MultiTableWriter::set_writer_factory(WriterFactory factory) {
+    factory_ = std::move(factory);
+}
+
 void MultiTableWriter::start_tables(const std::vector<TableType>& tables) {
     for (TableType table : tables) {
-        int table_idx = static_cast<int>(table);
-        if (table_writers_.find(table_idx) != table_writers_.end()) {
-            continue;  // Already initialized
-        }
-
-        std::string filepath = get_table_filename(table);
-        WriterPtr writer = create_writer(table, filepath);
+        start_table(table_type_name(table));
+    }
+}
 
-        TableWriter tw;
-        tw.writer = std::move(writer);
-        tw.table_type = table;
-        tw.initialized = true;
+void MultiTableWriter::start_table(const std::string& name) {
+    start_table(name, get_table_filename(name));
+}
 
-        table_writers_[table_idx] = std::move(tw);
+void MultiTableWriter::start_table(const std::string& name, const std::string& filepath) {
+    if (table_writers_.find(name) != table_writers_.end()) {
+        return;  // Already initialized
     }
+
+    WriterPtr writer = create_writer(filepath);
+
+    TableWriter tw;
+    tw.writer = std::move(writer);
+    tw.name = name;
+    tw.initialized = true;
+
+    table_writers_[name] = std::move(tw);
+    table_order_.push_back(name);
 }
 
 void MultiTableWriter::write_batch(TableType table_type, const std::shared_ptr<arrow::RecordBatch>& batch) {
-    int table_idx = static_cast<int>(table_type);
-    auto it = table_writers_.find(table_idx);
+    write_batch(table_type_name(table_type), batch);
+}
+
+void MultiTableWriter::write_batch(const std::string& name, const std::shared_ptr<arrow::RecordBatch>& batch) {
+    auto it = table_writers_.find(name);
     if (it == table_writers_.end()) {
-        throw std::runtime_error("Table not initialized");
+        throw std::runtime_error("Table not initialized: " + name);
     }
 
     if (it->second.writer) {
@@ -128,28 +159,41 @@ void MultiTableWriter::write_batch(TableType table_type, const std::shared_ptr<a
     }
 }
 
-void MultiTableWriter::finish_all() {
-    // Flush async I/O if enabled
-    if (async_ctx_) {
-        async_ctx_->flush();
+void MultiTableWriter::finish_table(TableType table_type) {
+    finish_table(table_type_name(table_type));
+}
+
+void MultiTableWriter::finish_table(const std::string& name) {
+    auto it = table_writers_.find(name);
+    if (it == table_writers_.end() || !it->second.initialized) {
+        return;
+    }
+    it->second.initialized = false;
+    if (it->second.writer) {
+        it->second.writer->close();
+        it->second.writer.reset();  // releases the stream and its file handle
     }
+}
 
-    // Close all writers
-    for (auto& entry : table_writers_) {
-        if (entry.second.writer) {
-            entry.second.writer->close();
-        }
+void MultiTableWriter::finish_all() {
+    // Close all writers; each shared-ring stream drains its own file on close
+    for (const auto& name : table_order_) {
+        finish_table(name);
     }
 
-    // Close all async files
+    // Flush and close anything registered directly on the context
     if (async_ctx_) {
+        async_ctx_->flush();
         async_ctx_->close_all();
     }
 }
 
 WriterInterface* MultiTableWriter::get_writer(TableType table_type) {
-    int table_idx = static_cast<int>(table_type);
-    auto it = table_writers_.find(table_idx);
+    return get_writer(table_type_name(table_type));
+}
+
+WriterInterface* MultiTableWriter::get_writer(const std::string& name) {
+    auto it = table_writers_.find(name);
     if (it == table_writers_.end()) {
         return nullptr;
     }
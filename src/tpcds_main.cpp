@@ -9,6 +9,7 @@
  *   ./tpcds_benchmark --format parquet --table inventory   --scale-factor 5
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -17,6 +18,8 @@
 #include <string>
 #include <chrono>
 #include <cctype>
+#include <filesystem>
+#include <map>
 #include <vector>
 #include <getopt.h>
 #include <stdexcept>
@@ -27,6 +30,7 @@
 
 #include <arrow/api.h>
 #include <arrow/builder.h>
+#include <arrow/io/interfaces.h>
 
 #include "tpch/writer_interface.hpp"
 #include "tpch/csv_writer.hpp"
@@ -35,6 +39,14 @@
 #include "tpch/dsdgen_converter.hpp"
 #include "tpch/io_uring_pool.hpp"
 #include "tpch/io_uring_output_stream.hpp"
+#include "tpch/io_process.hpp"
+#include "tpch/pipe_output_stream.hpp"
+#include "tpch/shm_ring_output_stream.hpp"
+#include "tpch/resource_limits.hpp"
+#include "tpch/writer_tuning.hpp"
+#include "tpch/multi_table_writer.hpp"
+#include "tpch/rolling_file_writer.hpp"
+#include "tpch/stripe_layout.hpp"
 
 #ifdef TPCH_ENABLE_ORC
 #include "tpch/orc_writer.hpp"
@@ -54,7 +66,10 @@ namespace {
 struct Options {
     long        scale_factor    = 1;
     std::string format          = "parquet";
-    std::string output_dir      = "/tmp";
+    std::string output_dir      = "/tmp";    // first of output_dirs
+    std::vector<std::string> output_dirs;    // --output-dir a,b,c: tables striped over them
+    std::string pipe_output;                 // "stdout" (--output-dir -), "fifo" (fifo:<dir>), "" = files
+    std::string stripe_policy   = "bytes";   // bytes (least estimated bytes), rr
     long        max_rows        = 1000;
     std::string table           = "store_sales";
     std::string compression     = "zstd";    // snappy, zstd, none
@@ -63,6 +78,20 @@ struct Options {
     std::string zero_copy_mode  = "sync";    // sync, auto, async (lance-specific selection)
     bool        parallel        = false;     // generate all tables in parallel
     int         parallel_tables = 0;         // max concurrent tables; 0 = all
+    bool        auto_tune       = true;      // size slots/threads/batches from cgroup limits
+    size_t      batch_size      = 0;         // fixed rows per batch; 0 = adaptive
+    bool        single_process  = false;     // small dimensions in one process, shared ring
+    bool        io_process      = false;     // --parallel: children hand bytes to one I/O process
+    size_t      io_inflight_mb  = 0;         // IoUringOutputStream in-flight window; 0 = default (32 MiB)
+    bool        fdatasync       = false;     // fdatasync each output file on close
+    tpch::ParquetOptions parquet;            // --encoding-profile, --zstd-level, --page-index, ...
+    int64_t     target_file_size = 0;        // roll into part-NNNNN files of ~this size; 0 = one file
+    int32_t     paimon_buckets  = 0;         // fixed-bucket Paimon tables; 0 = bucket-unaware
+    bool        paimon_primary_key = false;  // Paimon primary-key tables (sorted runs) on the TPC-DS keys
+    std::string iceberg_partition;           // Iceberg partition spec, e.g. "truncate[30](ss_sold_date_sk)"
+    std::string writer_id;                   // Iceberg/Paimon: leave data files for --commit-only
+    bool        commit_only     = false;     // commit what deferred writers left; generate nothing
+    tpch::AutoTuning tuning;                 // filled in main() from detect_resource_limits()
 };
 
 void print_usage(const char* prog) {
@@ -86,15 +115,72 @@ void print_usage(const char* prog) {
         " (default: parquet)\n"
         "  --table <name>         TPC-DS table name (default: store_sales)\n"
         "  --scale-factor <sf>    Scale factor (default: 1)\n"
-        "  --output-dir <dir>     Output directory (default: /tmp)\n"
+        "  --output-dir <dir>     Output directory (default: /tmp); 'a,b,c' stripes the\n"
+        "                         --parallel tables over several directories (one per\n"
+        "                         drive) and writes a manifest to the first; '-' streams\n"
+        "                         the table to stdout, 'fifo:<dir>' writes each table\n"
+        "                         into the named pipe <dir>/<table>.<ext> (csv, parquet, orc)\n"
+        "  --stripe-policy <p>    Striped placement: bytes (least estimated bytes,\n"
+        "                         default) or rr (round-robin)\n"
         "  --max-rows <n>         Max rows to generate (0=all, default: 1000)\n"
         "  --compression <c>      Parquet compression: zstd (default), snappy, none\n"
+        "  --encoding-profile <p> Parquet column encodings: plain (default), tuned\n"
+        "                         (delta keys, dictionary ints, byte-stream-split\n"
+        "                         doubles) or auto (pick per column from a sample)\n"
+        "  --zstd-level <spec>    Parquet zstd level, e.g. 3 or 3,ss_item_sk=9\n"
+        "  --page-index           Parquet: write column and offset indexes\n"
+        "  --bloom-filter <cols>  Parquet: bloom filters on these columns; 'keys' =\n"
+        "                         unsorted join keys (ss_item_sk, ss_customer_sk,\n"
+        "                         cs_item_sk, ws_item_sk, *r_item_sk, inv_item_sk)\n"
+        "  --declare-sort-order   Parquet: record each table's generation key order\n"
+        "                         (ticket / order number, surrogate key) as sorting_columns\n"
+        "  --cluster-within-rowgroup <cols> Sort the rows inside each row group by these\n"
+        "                         dictionary columns, e.g. cd_gender,cd_marital_status\n"
+        "                         (parquet: recorded as sorting_columns; orc: per\n"
+        "                         10000-row index stride; lance)\n"
+        "  --row-group-mb <N>     Parquet row group size in MiB of Arrow data\n"
+        "                         (default: 1M rows)\n"
+        "  --page-kb <N>          Parquet data page size in KiB (default: 1024)\n"
+        "  --row-group-threads <K> Parquet: encode K row groups of a file at once\n"
+        "                         (streaming writes; RAM grows with K row groups)\n"
+        "  --target-file-size <S> Write each table as <table>/part-NNNNN.<ext> files of\n"
+        "                         about S bytes (e.g. 512MB), cut at row group boundaries,\n"
+        "                         plus _manifest.json (Parquet: _metadata, _common_metadata).\n"
+        "                         parquet, orc, csv. Paimon, iceberg: data files roll at S\n"
+        "                         inside the table (default 128MB, iceberg 512MB)\n"
+        "  --paimon-buckets <N>   Paimon: fixed-bucket table, rows hashed on the table's\n"
+        "                         first column into N buckets written concurrently\n"
+        "  --paimon-primary-key   Paimon: primary-key table on the TPC-DS key, each bucket\n"
+        "                         written as key-sorted runs (spill sort when rows arrive\n"
+        "                         out of order); buckets hash the key (default 1 bucket)\n"
+        "  --iceberg-partition <spec> Iceberg: partition spec, comma-separated col,\n"
+        "                         year(col), month(col), day(col), truncate[W](col), e.g.\n"
+        "                         truncate[30](ss_sold_date_sk); columns a table lacks\n"
+        "                         are skipped\n"
+        "  --writer-id <id>       Iceberg, paimon: write data files only, described in\n"
+        "                         <table>/_pending/<id>.json; writers with distinct ids\n"
+        "                         can share a table (e.g. one per node)\n"
+        "  --commit-only          Iceberg, paimon: commit the files every --writer-id run\n"
+        "                         left as one snapshot per table; generates nothing\n"
         "  --zero-copy            Streaming mode: flush each batch immediately (O(batch) RAM)\n"
         "  --zero-copy-mode <m>   Zero-copy mode for Lance: sync, auto, async (default: sync)\n"
 #ifdef TPCH_ENABLE_LANCE
 #endif
         "  --parallel             Generate all tables in parallel (fork-after-init)\n"
         "  --parallel-tables <N>  Max concurrent tables (default: all)\n"
+        "  --single-process       Generate tables in-process through one shared io_uring\n"
+        "                         ring: alone, all tables; with --parallel, the small\n"
+        "                         dimensions share one child instead of one each\n"
+        "  --io-process           With --parallel: children write into shared-memory rings\n"
+        "                         drained by one dedicated I/O process (not Lance)\n"
+        "  --io-inflight-mb <N>   Bytes queued in the kernel per io_uring output file\n"
+        "                         (--parallel; default 32)\n"
+        "  --fdatasync            fdatasync each output file before closing it, so the\n"
+        "                         timing includes the flush to stable storage (not Lance)\n"
+        "  --batch-size <N>       Fixed rows per batch (default: adaptive, sized to\n"
+        "                         L2/L3 cache and aligned to the writer's row group)\n"
+        "  --no-auto-tune         Don't derive slots/threads/batch size from cgroup\n"
+        "                         cpu.max/memory.max/cpuset (use host defaults)\n"
         "  --verbose              Verbose output\n"
         "  --help                 Show this help\n"
         "\n"
@@ -117,7 +203,29 @@ Options parse_args(int argc, char* argv[]) {
         OPT_ZERO_COPY,
         OPT_ZERO_COPY_MODE,
         OPT_PARALLEL,
-        OPT_PARALLEL_TABLES
+        OPT_PARALLEL_TABLES,
+        OPT_NO_AUTO_TUNE,
+        OPT_BATCH_SIZE,
+        OPT_SINGLE_PROCESS,
+        OPT_IO_PROCESS,
+        OPT_STRIPE_POLICY,
+        OPT_ENCODING_PROFILE,
+        OPT_ZSTD_LEVEL,
+        OPT_PAGE_INDEX,
+        OPT_BLOOM_FILTER,
+        OPT_DECLARE_SORT_ORDER,
+        OPT_ROW_GROUP_MB,
+        OPT_PAGE_KB,
+        OPT_ROW_GROUP_THREADS,
+        OPT_TARGET_FILE_SIZE,
+        OPT_CLUSTER_WITHIN_ROWGROUP,
+        OPT_PAIMON_BUCKETS,
+        OPT_PAIMON_PRIMARY_KEY,
+        OPT_ICEBERG_PARTITION,
+        OPT_WRITER_ID,
+        OPT_COMMIT_ONLY,
+        OPT_IO_INFLIGHT_MB,
+        OPT_FDATASYNC
     };
     static struct option long_opts[] = {
         {"format",          required_argument, nullptr, 'f'},
@@ -130,6 +238,28 @@ Options parse_args(int argc, char* argv[]) {
         {"zero-copy-mode",  required_argument, nullptr, OPT_ZERO_COPY_MODE},
         {"parallel",        no_argument,       nullptr, OPT_PARALLEL},
         {"parallel-tables", required_argument, nullptr, OPT_PARALLEL_TABLES},
+        {"no-auto-tune",    no_argument,       nullptr, OPT_NO_AUTO_TUNE},
+        {"batch-size",      required_argument, nullptr, OPT_BATCH_SIZE},
+        {"single-process",  no_argument,       nullptr, OPT_SINGLE_PROCESS},
+        {"io-process",      no_argument,       nullptr, OPT_IO_PROCESS},
+        {"stripe-policy",   required_argument, nullptr, OPT_STRIPE_POLICY},
+        {"encoding-profile", required_argument, nullptr, OPT_ENCODING_PROFILE},
+        {"zstd-level",      required_argument, nullptr, OPT_ZSTD_LEVEL},
+        {"page-index",      no_argument,       nullptr, OPT_PAGE_INDEX},
+        {"bloom-filter",    required_argument, nullptr, OPT_BLOOM_FILTER},
+        {"declare-sort-order", no_argument,    nullptr, OPT_DECLARE_SORT_ORDER},
+        {"cluster-within-rowgroup", required_argument, nullptr, OPT_CLUSTER_WITHIN_ROWGROUP},
+        {"row-group-mb",    required_argument, nullptr, OPT_ROW_GROUP_MB},
+        {"page-kb",         required_argument, nullptr, OPT_PAGE_KB},
+        {"row-group-threads", required_argument, nullptr, OPT_ROW_GROUP_THREADS},
+        {"target-file-size", required_argument, nullptr, OPT_TARGET_FILE_SIZE},
+        {"paimon-buckets",  required_argument, nullptr, OPT_PAIMON_BUCKETS},
+        {"paimon-primary-key", no_argument,    nullptr, OPT_PAIMON_PRIMARY_KEY},
+        {"iceberg-partition", required_argument, nullptr, OPT_ICEBERG_PARTITION},
+        {"writer-id",       required_argument, nullptr, OPT_WRITER_ID},
+        {"commit-only",     no_argument,       nullptr, OPT_COMMIT_ONLY},
+        {"io-inflight-mb",  required_argument, nullptr, OPT_IO_INFLIGHT_MB},
+        {"fdatasync",       no_argument,       nullptr, OPT_FDATASYNC},
         {"verbose",         no_argument,       nullptr, 'v'},
         {"help",            no_argument,       nullptr, 'h'},
         {nullptr, 0, nullptr, 0}
@@ -141,7 +271,21 @@ Options parse_args(int argc, char* argv[]) {
             case 'f': opts.format       = optarg; break;
             case 't': opts.table        = optarg; break;
             case 's': opts.scale_factor = std::stol(optarg); break;
-            case 'o': opts.output_dir   = optarg; break;
+            case 'o':
+                opts.output_dir = optarg;
+                if (opts.output_dir == "-") {
+                    opts.pipe_output = "stdout";
+                    break;
+                }
+                if (opts.output_dir.rfind("fifo:", 0) == 0) {
+                    opts.pipe_output = "fifo";
+                    opts.output_dir = opts.output_dir.substr(5);
+                }
+                opts.output_dirs = tpch::StripeLayout::parse(opts.output_dir);
+                if (opts.output_dirs.empty())
+                    throw std::invalid_argument("--output-dir is empty");
+                opts.output_dir = opts.output_dirs.front();
+                break;
             case 'm': opts.max_rows     = std::stol(optarg); break;
             case OPT_COMPRESSION:    opts.compression     = optarg; break;
             case OPT_ZERO_COPY:      opts.zero_copy       = true;   break;
@@ -152,12 +296,103 @@ Options parse_args(int argc, char* argv[]) {
                 if (opts.parallel_tables <= 0)
                     throw std::invalid_argument("--parallel-tables must be > 0");
                 break;
+            case OPT_NO_AUTO_TUNE:   opts.auto_tune       = false;  break;
+            case OPT_BATCH_SIZE: {
+                long n = std::stol(optarg);
+                if (n <= 0)
+                    throw std::invalid_argument("--batch-size must be > 0");
+                opts.batch_size = static_cast<size_t>(n);
+                break;
+            }
+            case OPT_SINGLE_PROCESS: opts.single_process  = true;   break;
+            case OPT_IO_PROCESS:     opts.io_process      = true;   break;
+            case OPT_STRIPE_POLICY:
+                tpch::StripeLayout::parse_policy(optarg);  // validate early
+                opts.stripe_policy = optarg;
+                break;
+            case OPT_ENCODING_PROFILE:
+                opts.parquet.encoding_profile = tpch::ParquetOptions::parse_profile(optarg);
+                break;
+            case OPT_ZSTD_LEVEL:
+                opts.parquet.parse_zstd_levels(optarg);
+                break;
+            case OPT_PAGE_INDEX:
+                opts.parquet.page_index = true;
+                break;
+            case OPT_BLOOM_FILTER:
+                opts.parquet.parse_bloom_filter_columns(optarg);
+                break;
+            case OPT_DECLARE_SORT_ORDER:
+                opts.parquet.declare_sort_order = true;
+                break;
+            case OPT_CLUSTER_WITHIN_ROWGROUP:
+                opts.parquet.parse_cluster_columns(optarg);
+                break;
+            case OPT_ROW_GROUP_MB: {
+                long n = std::stol(optarg);
+                if (n <= 0)
+                    throw std::invalid_argument("--row-group-mb must be > 0");
+                opts.parquet.row_group_bytes = static_cast<int64_t>(n) * 1024 * 1024;
+                break;
+            }
+            case OPT_PAGE_KB: {
+                long n = std::stol(optarg);
+                if (n <= 0)
+                    throw std::invalid_argument("--page-kb must be > 0");
+                opts.parquet.page_bytes = static_cast<int64_t>(n) * 1024;
+                break;
+            }
+            case OPT_ROW_GROUP_THREADS:
+                opts.parquet.row_group_threads = std::stoi(optarg);
+                if (opts.parquet.row_group_threads <= 0)
+                    throw std::invalid_argument("--row-group-threads must be > 0");
+                break;
+            case OPT_TARGET_FILE_SIZE:
+                opts.target_file_size = tpch::parse_byte_size(optarg);
+                break;
+            case OPT_PAIMON_BUCKETS:
+                opts.paimon_buckets = std::stoi(optarg);
+                if (opts.paimon_buckets <= 0)
+                    throw std::invalid_argument("--paimon-buckets must be > 0");
+                break;
+            case OPT_PAIMON_PRIMARY_KEY:
+                opts.paimon_primary_key = true;
+                break;
+            case OPT_ICEBERG_PARTITION:
+#ifdef TPCH_ENABLE_ICEBERG
+                tpch::IcebergWriter::parse_partition_spec(optarg);
+#endif
+                opts.iceberg_partition = optarg;
+                break;
+            case OPT_WRITER_ID:
+                opts.writer_id = optarg;
+                if (opts.writer_id.empty() || opts.writer_id[0] == '.' ||
+                    opts.writer_id.find_first_not_of(
+                        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_.-") !=
+                        std::string::npos)
+                    throw std::invalid_argument("--writer-id takes letters, digits, '_', '.' and '-'");
+                break;
+            case OPT_COMMIT_ONLY:
+                opts.commit_only = true;
+                break;
+            case OPT_IO_INFLIGHT_MB: {
+                long mb = std::stol(optarg);
+                if (mb <= 0)
+                    throw std::invalid_argument("--io-inflight-mb must be > 0");
+                opts.io_inflight_mb = static_cast<size_t>(mb);
+                break;
+            }
+            case OPT_FDATASYNC:
+                opts.fdatasync = true;
+                break;
             case 'z': opts.zero_copy    = true;   break;
             case 'v': opts.verbose      = true;   break;
             case 'h': print_usage(argv[0]); exit(0);
             default:  print_usage(argv[0]); exit(1);
         }
     }
+    if (opts.output_dirs.empty())
+        opts.output_dirs.push_back(opts.output_dir);
     return opts;
 }
 
@@ -176,13 +411,28 @@ std::unique_ptr<tpch::WriterInterface> create_writer(
     const std::string& filepath,
     const std::string& compression,
     bool zero_copy = false,
-    bool lance_async_streaming = false)
+    bool lance_async_streaming = false,
+    const tpch::ParquetOptions& parquet_options = {},
+    int64_t target_file_size = 0,
+    int32_t paimon_buckets = 0,
+    bool paimon_primary_key = false,
+    const std::string& iceberg_partition = "")
 {
+    // Paimon and Iceberg roll their data files inside the table directory themselves
+    if (target_file_size > 0 && format != "paimon" && format != "iceberg") {
+        return std::make_unique<tpch::RollingFileWriter>(
+            tpch::RollingFileWriter::dataset_dir(filepath), tpch::format_extension(format),
+            target_file_size, [=](const std::string& path) {
+                return create_writer(format, path, compression, zero_copy,
+                                     lance_async_streaming, parquet_options);
+            });
+    }
     if (format == "csv") {
         return std::make_unique<tpch::CSVWriter>(filepath);
     } else if (format == "parquet") {
         auto w = std::make_unique<tpch::ParquetWriter>(filepath);
         w->set_compression(compression);
+        w->set_parquet_options(parquet_options);
         if (zero_copy) {
             w->enable_streaming_write();
         }
@@ -190,17 +440,38 @@ std::unique_ptr<tpch::WriterInterface> create_writer(
     }
 #ifdef TPCH_ENABLE_ORC
     else if (format == "orc") {
-        return std::make_unique<tpch::ORCWriter>(filepath);
+        auto w = std::make_unique<tpch::ORCWriter>(filepath);
+        if (!parquet_options.cluster_columns.empty()) {
+            w->set_cluster_columns(parquet_options.cluster_columns);
+        }
+        return w;
     }
 #endif
 #ifdef TPCH_ENABLE_PAIMON
     else if (format == "paimon") {
-        return std::make_unique<tpch::PaimonWriter>(filepath);
+        auto w = std::make_unique<tpch::PaimonWriter>(filepath);
+        if (paimon_primary_key) {
+            w->set_primary_key();
+        }
+        if (paimon_buckets > 0) {
+            w->set_buckets(paimon_buckets);
+        }
+        if (target_file_size > 0) {
+            w->set_target_file_size(target_file_size);
+        }
+        return w;
     }
 #endif
 #ifdef TPCH_ENABLE_ICEBERG
     else if (format == "iceberg") {
-        return std::make_unique<tpch::IcebergWriter>(filepath);
+        auto w = std::make_unique<tpch::IcebergWriter>(filepath);
+        if (!iceberg_partition.empty()) {
+            w->set_partition_spec(iceberg_partition);
+        }
+        if (target_file_size > 0) {
+            w->set_target_file_size(target_file_size);
+        }
+        return w;
     }
 #endif
 #ifdef TPCH_ENABLE_LANCE
@@ -209,12 +480,50 @@ std::unique_ptr<tpch::WriterInterface> create_writer(
         if (zero_copy && lance_async_streaming) {
             w->enable_streaming_write(true);
         }
+        if (!parquet_options.cluster_columns.empty()) {
+            w->set_cluster_columns(parquet_options.cluster_columns);
+        }
         return w;
     }
 #endif
     throw std::invalid_argument("Unknown format: " + format);
 }
 
+// Two-phase commit: the table writer leaves its data files and a sidecar in
+// <table>/_pending/ instead of a snapshot; commit_table() publishes them.
+void defer_commit(tpch::WriterInterface* writer, const std::string& writer_id)
+{
+#ifdef TPCH_ENABLE_ICEBERG
+    if (auto* w = dynamic_cast<tpch::IcebergWriter*>(writer)) {
+        w->set_deferred_commit(writer_id);
+    }
+#endif
+#ifdef TPCH_ENABLE_PAIMON
+    if (auto* w = dynamic_cast<tpch::PaimonWriter*>(writer)) {
+        w->set_deferred_commit(writer_id);
+    }
+#endif
+    (void)writer;
+    (void)writer_id;
+}
+
+// Commit the deferred writes of one table; returns the data files committed.
+size_t commit_table(const std::string& format, const std::string& table_path)
+{
+#ifdef TPCH_ENABLE_ICEBERG
+    if (format == "iceberg") {
+        return tpch::IcebergWriter::commit(table_path);
+    }
+#endif
+#ifdef TPCH_ENABLE_PAIMON
+    if (format == "paimon") {
+        return tpch::PaimonWriter::commit(table_path);
+    }
+#endif
+    (void)table_path;
+    throw std::invalid_argument("Unknown table format: " + format);
+}
+
 // Build Arrow array builders from schema (int32, int64, float64, string)
 tpcds::BuilderMap
 create_builders(std::shared_ptr<arrow::Schema> schema, int64_t capacity)
@@ -305,6 +614,21 @@ void reset_builders(tpcds::BuilderMap& builders) {
     for (auto& b : builders) { b->Reset(); }
 }
 
+// Batch sizer for one table (see tpch::make_batch_sizer), logged with -v.
+tpch::AdaptiveBatchSizer make_batch_sizer(
+    const Options& opts,
+    const arrow::Schema& schema,
+    const tpch::WriterInterface& writer)
+{
+    auto sizer = tpch::make_batch_sizer(schema, writer, opts.auto_tune ? &opts.tuning : nullptr,
+                                        opts.batch_size);
+    if (opts.verbose) {
+        fprintf(stderr, "  batch size: %zu rows (~%zu B/row, unit=%zu rows)\n",
+                sizer.rows(), static_cast<size_t>(sizer.row_bytes()), sizer.unit_rows());
+    }
+    return sizer;
+}
+
 // ---------------------------------------------------------------------------
 // main generation loop (row-by-row callback → batched Arrow writes)
 // ---------------------------------------------------------------------------
@@ -313,17 +637,19 @@ template<typename GenerateFn>
 size_t run_generation(
     const Options& opts,
     std::shared_ptr<arrow::Schema> schema,
-    std::unique_ptr<tpch::WriterInterface>& writer,
+    tpch::WriterInterface& writer,
     GenerateFn generate_fn)
 {
-    // 8192 = Lance max_rows_per_group default — aligns C++ batches to Lance row-group
-    // boundaries so the streaming encoder never sees split/leftover rows at group edges.
-    // This also benefits Parquet (common row-group granularity) and ORC stripe alignment.
-    const size_t batch_size = 8192;
+    // Batch rows are sized from the cache budget and the table's bytes/row, then
+    // aligned to the writer's unit (Lance max_rows_per_group, Parquet row group,
+    // ORC index stride) so the encoder never sees split rows at group edges.
+    auto sizer = make_batch_sizer(opts, *schema, writer);
+    size_t batch_size = sizer.rows();
     size_t rows_in_batch = 0;
     size_t total_rows = 0;
 
     auto builders = create_builders(schema, static_cast<int64_t>(batch_size));
+    auto batch_start = std::chrono::steady_clock::now();
 
     auto callback = [&](const void* row) {
         tpcds::append_dsdgen_row_to_builders(opts.table, row, builders);
@@ -331,13 +657,22 @@ size_t run_generation(
         ++total_rows;
 
         if (rows_in_batch >= batch_size) {
-            writer->write_batch(finish_batch(schema, builders, rows_in_batch));
+            auto batch = finish_batch(schema, builders, rows_in_batch);
+            auto t_converted = std::chrono::steady_clock::now();
+            writer.write_batch(batch);
+            auto t_written = std::chrono::steady_clock::now();
+            sizer.record(rows_in_batch, tpch::measure_batch_bytes(*batch),
+                         std::chrono::duration<double>(t_converted - batch_start).count(),
+                         std::chrono::duration<double>(t_written - t_converted).count());
+            batch_size = sizer.rows();
             reset_builders(builders);
-            rows_in_batch = 0;
 
-            if (opts.verbose && (total_rows % 100000 == 0)) {
+            // Batches are sized adaptively, so report each 100k threshold crossed
+            if (opts.verbose && (total_rows / 100000 != (total_rows - rows_in_batch) / 100000)) {
                 fprintf(stderr, "  Generated %zu rows...\n", total_rows);
             }
+            rows_in_batch = 0;
+            batch_start = t_written;
         }
     };
 
@@ -345,12 +680,17 @@ size_t run_generation(
 
     // Flush final partial batch
     if (rows_in_batch > 0) {
-        writer->write_batch(finish_batch(schema, builders, rows_in_batch));
+        writer.write_batch(finish_batch(schema, builders, rows_in_batch));
     }
 
     return total_rows;
 }
 
+void apply_tuning(const Options& opts, tpch::WriterInterface* writer) {
+    if (opts.auto_tune)
+        tpch::apply_auto_tuning(opts.tuning, writer);
+}
+
 // Map table name → TableType enum
 tpcds::TableType parse_table(const std::string& name) {
     if (name == "store_sales")              return tpcds::TableType::StoreSales;
@@ -391,6 +731,13 @@ std::string file_extension(const std::string& fmt) {
     return "." + fmt;
 }
 
+// A table's output for the summary: its file, or with --target-file-size
+// the directory of part files.
+std::string output_location(const Options& opts, const std::string& filepath) {
+    return opts.target_file_size > 0 && opts.format != "paimon" && opts.format != "iceberg"
+        ? tpch::RollingFileWriter::dataset_dir(filepath) : filepath;
+}
+
 // ---------------------------------------------------------------------------
 // dispatch_generation — maps TableType to the correct DSDGenWrapper method
 // ---------------------------------------------------------------------------
@@ -399,7 +746,7 @@ size_t dispatch_generation(
     const Options& opts,
     tpcds::TableType table_type,
     std::shared_ptr<arrow::Schema> schema,
-    std::unique_ptr<tpch::WriterInterface>& writer,
+    tpch::WriterInterface& writer,
     tpcds::DSDGenWrapper& dsdgen)
 {
     if (table_type == tpcds::TableType::StoreSales)
@@ -515,6 +862,62 @@ static const std::vector<std::pair<std::string, tpcds::TableType>> ALL_TPCDS_TAB
     {"store_sales",             tpcds::TableType::StoreSales},
 };
 
+// Ring of this child's slot when --io-process is active; set right after fork().
+static tpch::ShmRing* g_child_ring = nullptr;
+
+// Striped output: table -> output path and IoUringPool anchor of its drive.
+// Filled in the parent before fork(); children see it through COW.
+static std::map<std::string, std::string> g_table_paths;
+static std::map<std::string, int>         g_table_devices;
+
+static std::string table_path(const Options& opts, const std::string& tname)
+{
+    auto it = g_table_paths.find(tname);
+    return it != g_table_paths.end()
+        ? it->second
+        : opts.output_dir + "/" + tname + file_extension(opts.format);
+}
+
+// Original stdout with --output-dir -; fd 1 itself is pointed at stderr so
+// the per-table report cannot interleave with the data.
+static int g_stdout_fd = -1;
+
+// With --output-dir - or fifo:<dir>, write the table through a
+// PipeOutputStream (main() admits only formats that accept one).
+// Returns true if the writer was attached.
+static bool attach_pipe(const Options& opts, tpch::WriterInterface* writer)
+{
+    if (opts.pipe_output.empty()) return false;
+    const bool to_stdout = opts.pipe_output == "stdout";
+    return writer->set_output_stream_factory([to_stdout](const std::string& path)
+            -> std::shared_ptr<arrow::io::OutputStream> {
+        if (to_stdout)
+            return std::make_shared<tpch::PipeOutputStream>(g_stdout_fd, "stdout",
+                                                            /*owns_fd=*/false);
+        return tpch::PipeOutputStream::open_fifo(path);
+    });
+}
+
+// IoUringOutputStream settings from --io-inflight-mb and --fdatasync.
+static tpch::IoUringStreamConfig stream_config(const Options& opts)
+{
+    tpch::IoUringStreamConfig cfg;
+    cfg.fdatasync_on_close = opts.fdatasync;
+    if (opts.io_inflight_mb > 0)
+        cfg.max_inflight_bytes = opts.io_inflight_mb << 20;
+    return cfg;
+}
+
+// With --io-process, route the writer's files to the I/O process over the
+// slot's shared-memory ring.  Returns true if the writer was attached.
+static bool attach_io_ring(tpch::WriterInterface* writer)
+{
+    if (!g_child_ring) return false;
+    return writer->set_output_stream_factory([](const std::string& path) {
+        return std::make_shared<tpch::ShmRingOutputStream>(g_child_ring, path);
+    });
+}
+
 // Child process: generate one table, write output, exit.
 // dsdgen is already initialised (inherited via COW from parent).
 // Returns exit code (0 = success).
@@ -524,7 +927,7 @@ static int run_table_child(
     tpcds::DSDGenWrapper& dsdgen)
 {
     const std::string tname = tpcds::DSDGenWrapper::table_name(table_type);
-    const std::string filepath = opts.output_dir + "/" + tname + file_extension(opts.format);
+    const std::string filepath = table_path(opts, tname);
 
     bool lance_async = (opts.format == "lance" && opts.zero_copy &&
                         opts.zero_copy_mode == "async");
@@ -532,7 +935,12 @@ static int run_table_child(
     std::unique_ptr<tpch::WriterInterface> writer;
     try {
         writer = create_writer(opts.format, filepath, opts.compression,
-                               opts.zero_copy, lance_async);
+                               opts.zero_copy, lance_async, opts.parquet,
+                               opts.target_file_size, opts.paimon_buckets,
+                               opts.paimon_primary_key, opts.iceberg_partition);
+        if (!opts.writer_id.empty()) {
+            defer_commit(writer.get(), opts.writer_id);
+        }
     } catch (const std::exception& e) {
         fprintf(stderr, "[%s] failed to create writer: %s\n", tname.c_str(), e.what());
         return 1;
@@ -547,17 +955,22 @@ static int run_table_child(
     }
 #endif
 
-    // DS-10.3: inject IoUringOutputStream into Parquet streaming path when available.
-    // Works in child processes after IoUringPool::init() was called in the parent.
-    if (tpch::IoUringPool::available() &&
-        opts.format == "parquet" && opts.zero_copy) {
-        void* ring = tpch::IoUringPool::create_child_ring_struct();
-        // IoUringOutputStream takes ownership of ring; stream owns the file fd.
-        auto io_stream = std::make_shared<tpch::IoUringOutputStream>(
-            filepath, ring);
-        if (auto* pw = dynamic_cast<tpch::ParquetWriter*>(writer.get())) {
-            pw->set_output_stream(std::move(io_stream));
-        }
+    apply_tuning(opts, writer.get());
+
+    // DS-10.3: open every file the writer produces as an IoUringOutputStream
+    // (Parquet switches to streaming; Lance ignores it).  Works in child
+    // processes after IoUringPool::init() was called in the parent; without
+    // a ring, --fdatasync still needs the (synchronous) stream.
+    const bool uring = tpch::IoUringPool::available();
+    if (!attach_pipe(opts, writer.get()) && !attach_io_ring(writer.get()) &&
+        (uring || opts.fdatasync)) {
+        const int device = g_table_devices.count(tname) ? g_table_devices[tname] : 0;
+        const auto cfg = stream_config(opts);
+        writer->set_output_stream_factory([uring, device, cfg](const std::string& path) {
+            // IoUringOutputStream takes ownership of ring; stream owns the file fd.
+            void* ring = uring ? tpch::IoUringPool::create_child_ring_struct(device) : nullptr;
+            return std::make_shared<tpch::IoUringOutputStream>(path, ring, cfg);
+        });
     }
 
     // run_generation uses opts.table for append_dsdgen_row_to_builders dispatch
@@ -569,7 +982,7 @@ static int run_table_child(
     auto t0 = std::chrono::steady_clock::now();
     size_t rows = 0;
     try {
-        rows = dispatch_generation(child_opts, table_type, schema, writer, dsdgen);
+        rows = dispatch_generation(child_opts, table_type, schema, *writer, dsdgen);
         writer->close();
     } catch (const std::exception& e) {
         fprintf(stderr, "[%s] error: %s\n", tname.c_str(), e.what());
@@ -581,19 +994,134 @@ static int run_table_child(
     printf("tpcds_benchmark: %-28s  SF=%ld  rows=%zu  elapsed=%.2fs  rate=%.0f rows/s\n",
            tname.c_str(), opts.scale_factor, rows,
            elapsed, elapsed > 0 ? rows / elapsed : 0.0);
-    printf("  output: %s\n", filepath.c_str());
+    printf("  output: %s\n", output_location(opts, filepath).c_str());
     fflush(stdout);
     return 0;
 }
 
+// Tiny and small dimensions: a few thousand rows at most at any SF, so a
+// fork + ring + Arrow pool each costs more than generating them.
+static bool is_small_dimension(tpcds::TableType t)
+{
+    switch (t) {
+        case tpcds::TableType::IncomeBand:
+        case tpcds::TableType::ShipMode:
+        case tpcds::TableType::Warehouse:
+        case tpcds::TableType::Reason:
+        case tpcds::TableType::CallCenter:
+        case tpcds::TableType::WebSite:
+        case tpcds::TableType::WebPage:
+        case tpcds::TableType::CatalogPage:
+        case tpcds::TableType::HouseholdDemographics:
+        case tpcds::TableType::Promotion:
+        case tpcds::TableType::Store:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Generate several tables back-to-back in this process through one
+// MultiTableWriter, so all output shares a single io_uring ring and
+// one table's queued writes drain while the next table is generated.
+// dsdgen has no resumable per-table iterator, so tables run sequentially
+// rather than interleaved.  Returns exit code (0 = success).
+static int run_tables_in_process(
+    const Options& opts,
+    const std::vector<std::pair<std::string, tpcds::TableType>>& tables,
+    tpcds::DSDGenWrapper& dsdgen)
+{
+    // With --io-process the I/O process does the writing instead of our own ring
+    tpch::MultiTableWriter mtw(opts.output_dir, opts.format,
+                               /*use_async_io=*/g_child_ring == nullptr);
+    mtw.set_writer_factory([&](const std::string& path) {
+        bool lance_async = (opts.format == "lance" && opts.zero_copy &&
+                            opts.zero_copy_mode == "async");
+        // Parquet always streams here; nothing should buffer a whole table
+        auto writer = create_writer(opts.format, path, opts.compression,
+                                    /*zero_copy=*/true, lance_async, opts.parquet,
+                                    opts.target_file_size, opts.paimon_buckets,
+                                    opts.paimon_primary_key, opts.iceberg_partition);
+        if (!opts.writer_id.empty()) {
+            defer_commit(writer.get(), opts.writer_id);
+        }
+#ifdef TPCH_ENABLE_LANCE
+        if (auto* lw = dynamic_cast<tpch::LanceWriter*>(writer.get())) {
+            if (opts.zero_copy && !lance_async)
+                lw->set_buffered_flush_config(128, 1'048'576);
+        }
+#endif
+        apply_tuning(opts, writer.get());
+        attach_io_ring(writer.get());
+        return writer;
+    });
+
+    int failed = 0;
+    for (const auto& [tname, ttype] : tables) {
+        const std::string filepath = table_path(opts, tname);
+        Options table_opts = opts;
+        table_opts.table   = tname;
+
+        auto t0 = std::chrono::steady_clock::now();
+        size_t rows = 0;
+        try {
+            mtw.start_table(tname, filepath);
+            auto schema = tpcds::DSDGenWrapper::get_schema(ttype, opts.scale_factor);
+            rows = dispatch_generation(table_opts, ttype, schema, *mtw.get_writer(tname), dsdgen);
+            mtw.finish_table(tname);
+        } catch (const std::exception& e) {
+            fprintf(stderr, "[%s] error: %s\n", tname.c_str(), e.what());
+            ++failed;
+            continue;
+        }
+
+        double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t0).count();
+        printf("tpcds_benchmark: %-28s  SF=%ld  rows=%zu  elapsed=%.2fs  rate=%.0f rows/s\n",
+               tname.c_str(), opts.scale_factor, rows,
+               elapsed, elapsed > 0 ? rows / elapsed : 0.0);
+        printf("  output: %s\n", output_location(opts, filepath).c_str());
+    }
+
+    try {
+        mtw.finish_all();
+    } catch (const std::exception& e) {
+        fprintf(stderr, "tpcds_benchmark: in-process close failed: %s\n", e.what());
+        ++failed;
+    }
+    fflush(stdout);
+    return failed ? 1 : 0;
+}
+
 // Fork-after-init parallel generation with rolling N-slot window.
+// With --single-process the small dimensions form one job (one child)
+// instead of one child each.
 // Returns 0 if all children succeeded, 1 if any failed.
 static int generate_all_tables_parallel(const Options& opts)
 {
-    const size_t ntables = ALL_TPCDS_TABLES.size();
+    // Each job is one child: a single table, or the grouped small dimensions
+    std::vector<std::vector<std::pair<std::string, tpcds::TableType>>> jobs;
+    if (opts.single_process) {
+        jobs.emplace_back();
+        for (const auto& entry : ALL_TPCDS_TABLES)
+            if (is_small_dimension(entry.second)) jobs.front().push_back(entry);
+    }
+    for (const auto& entry : ALL_TPCDS_TABLES)
+        if (!opts.single_process || !is_small_dimension(entry.second)) jobs.push_back({entry});
+
+    // Iceberg/Paimon: children leave their files uncommitted and the parent
+    // writes one snapshot per table once they are done, unless --writer-id
+    // leaves that to --commit-only
+    const bool table_format = opts.format == "iceberg" || opts.format == "paimon";
+    Options child_opts = opts;
+    if (table_format && opts.writer_id.empty()) {
+        child_opts.writer_id = "parallel";
+    }
+
+    const size_t ntables = jobs.size();
     const size_t slot_limit = (opts.parallel_tables > 0)
         ? static_cast<size_t>(opts.parallel_tables)
-        : ntables;
+        : (opts.auto_tune ? opts.tuning.parallel_slots : ntables);
 
     // Initialise dsdgen ONCE in the parent.  All children inherit the loaded
     // distributions and seeded RNG streams via COW — no re-init needed.
@@ -604,15 +1132,64 @@ static int generate_all_tables_parallel(const Options& opts)
     // attach via IORING_SETUP_ATTACH_WQ and share one kernel worker pool.
     bool io_uring_ready = tpch::IoUringPool::init(opts.output_dir);
 
+    // Striped output: place tables largest first (rows x columns as the size
+    // proxy) so the least-bytes policy evens out the drives; one anchor per drive.
+    tpch::StripeLayout layout(opts.output_dirs, tpch::StripeLayout::parse_policy(opts.stripe_policy));
+    if (layout.striped()) {
+        std::vector<std::pair<int64_t, std::string>> by_size;
+        for (const auto& [tname, ttype] : ALL_TPCDS_TABLES) {
+            long rows = parent_dsdgen.get_row_count(ttype);
+            if (opts.max_rows > 0 && rows > opts.max_rows) rows = opts.max_rows;
+            int cols = tpcds::DSDGenWrapper::get_schema(ttype, opts.scale_factor)->num_fields();
+            by_size.emplace_back(static_cast<int64_t>(rows) * cols * 8, tname);
+        }
+        std::stable_sort(by_size.begin(), by_size.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (const auto& [bytes, tname] : by_size)
+            g_table_paths[tname] = layout.place(tname, tname + file_extension(opts.format), bytes);
+
+        std::vector<int> devices(layout.dirs().size(), 0);
+        if (io_uring_ready)
+            for (size_t d = 0; d < devices.size(); ++d)
+                devices[d] = tpch::IoUringPool::add_device(layout.dirs()[d]);
+        for (const auto& p : layout.pieces())
+            g_table_devices[p.name] = devices[p.dir];
+    }
+
+    // The parent commits: start every table afresh, so a previous run's
+    // snapshot or stale _pending/ sidecars cannot clash with this run's commit
+    if (table_format && opts.writer_id.empty()) {
+        for (const auto& [tname, ttype] : ALL_TPCDS_TABLES) {
+            std::error_code ec;
+            std::filesystem::remove_all(table_path(opts, tname), ec);
+        }
+    }
+
+    // One I/O process drains per-slot shared-memory rings; fork it before the
+    // children so they all inherit the ring mappings.
+    std::unique_ptr<tpch::IoProcess> io;
+    if (opts.io_process) {
+        try {
+            io = std::make_unique<tpch::IoProcess>(slot_limit, tpch::IoProcess::DEFAULT_RING_BYTES);
+            io->set_fdatasync_on_close(opts.fdatasync);
+            io->start();
+        } catch (const std::exception& e) {
+            fprintf(stderr, "tpcds_benchmark: I/O process unavailable (%s); children write directly\n",
+                    e.what());
+            io.reset();
+        }
+    }
+
     auto t_wall = std::chrono::steady_clock::now();
 
     fprintf(stderr,
-        "tpcds_benchmark: parallel  SF=%ld  tables=%zu  slots=%zu  format=%s  io_uring=%s\n",
-        opts.scale_factor, ntables, slot_limit, opts.format.c_str(),
-        io_uring_ready ? "yes" : "no");
+        "tpcds_benchmark: parallel  SF=%ld  tables=%zu  jobs=%zu  slots=%zu  format=%s  io_uring=%s  io_process=%s\n",
+        opts.scale_factor, ALL_TPCDS_TABLES.size(), ntables, slot_limit, opts.format.c_str(),
+        io_uring_ready ? "yes" : "no", io ? "yes" : "no");
 
     // pid → table index map so we can report which table finished
     std::vector<pid_t>  pids(ntables, -1);
+    std::vector<bool>   succeeded(ntables, false);
     std::vector<size_t> slot_table(slot_limit, SIZE_MAX); // slot → table index
     size_t next   = 0;   // index of next table to fork
     size_t active = 0;   // number of live children
@@ -620,7 +1197,7 @@ static int generate_all_tables_parallel(const Options& opts)
 
     auto fork_next = [&](size_t slot) {
         if (next >= ntables) return;
-        const auto& [tname, ttype] = ALL_TPCDS_TABLES[next];
+        const auto& job = jobs[next];
 
         pid_t pid = ::fork();
         if (pid < 0) {
@@ -632,7 +1209,10 @@ static int generate_all_tables_parallel(const Options& opts)
         if (pid == 0) {
             // Child: temp file belongs to parent — don't unlink on exit.
             parent_dsdgen.clear_tmp_path();
-            int rc = run_table_child(opts, ttype, parent_dsdgen);
+            if (io) g_child_ring = io->ring(slot);
+            int rc = (job.size() == 1)
+                ? run_table_child(child_opts, job.front().second, parent_dsdgen)
+                : run_tables_in_process(child_opts, job, parent_dsdgen);
             std::exit(rc);
         }
         // Parent
@@ -651,6 +1231,7 @@ static int generate_all_tables_parallel(const Options& opts)
         int status;
         pid_t done = ::waitpid(-1, &status, 0);
         if (done < 0) { perror("waitpid"); break; }
+        if (io && io->reap(done, status)) { ++failed; continue; }
 
         // Find which slot this pid occupied
         size_t freed_slot = SIZE_MAX;
@@ -663,11 +1244,15 @@ static int generate_all_tables_parallel(const Options& opts)
 
         if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
             const char* tname = (freed_slot < slot_limit && slot_table[freed_slot] < ntables)
-                ? ALL_TPCDS_TABLES[slot_table[freed_slot]].first.c_str()
+                ? (jobs[slot_table[freed_slot]].size() == 1
+                       ? jobs[slot_table[freed_slot]].front().first.c_str()
+                       : "small dimensions")
                 : "unknown";
             fprintf(stderr, "tpcds_benchmark: [%s] child failed (pid=%d status=%d)\n",
                     tname, done, status);
             ++failed;
+        } else if (freed_slot != SIZE_MAX) {
+            succeeded[slot_table[freed_slot]] = true;
         }
         --active;
 
@@ -675,12 +1260,41 @@ static int generate_all_tables_parallel(const Options& opts)
             fork_next(freed_slot);
     }
 
+    if (io && io->finish() != 0) ++failed;
+
+    // A failed job's tables stay uncommitted, hence invisible; a job that
+    // exited 0 but left nothing to commit lost its table
+    if (table_format && opts.writer_id.empty()) {
+        for (size_t j = 0; j < ntables; ++j) {
+            if (!succeeded[j]) continue;
+            for (const auto& [tname, ttype] : jobs[j]) {
+                try {
+                    if (commit_table(opts.format, table_path(opts, tname)) == 0)
+                        throw std::runtime_error("no data files to commit");
+                } catch (const std::exception& e) {
+                    fprintf(stderr, "tpcds_benchmark: [%s] commit failed: %s\n", tname.c_str(), e.what());
+                    ++failed;
+                }
+            }
+        }
+    }
+
+    if (layout.striped()) {
+        const std::string manifest = opts.output_dir + "/tpcds_manifest.json";
+        try {
+            layout.write_manifest(manifest);
+            fprintf(stderr, "tpcds_benchmark: manifest %s\n", manifest.c_str());
+        } catch (const std::exception& e) {
+            fprintf(stderr, "tpcds_benchmark: %s\n", e.what());
+        }
+    }
+
     // Parent owns the temp distribution file — destructor unlinks it.
     double wall = std::chrono::duration<double>(
         std::chrono::steady_clock::now() - t_wall).count();
     fprintf(stderr,
         "tpcds_benchmark: parallel done  SF=%ld  %zu tables  wall=%.2fs  %s\n",
-        opts.scale_factor, ntables, wall,
+        opts.scale_factor, ALL_TPCDS_TABLES.size(), wall,
         failed ? "SOME TABLES FAILED" : "all ok");
 
     return failed ? 1 : 0;
@@ -710,11 +1324,162 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "tpcds_benchmark: --zero-copy-mode must be one of: auto, sync, async\n");
         return 1;
     }
+    if (opts.format == "parquet" && opts.parquet.has_zstd_levels() && opts.compression != "zstd") {
+        fprintf(stderr, "tpcds_benchmark: --zstd-level requires --compression zstd\n");
+        return 1;
+    }
+    // Only streaming writers cut row groups for the encoder pool; without
+    // --parallel, --single-process streams every table
+    if (opts.parquet.row_group_threads > 0 && !opts.zero_copy &&
+        !(opts.single_process && !opts.parallel)) {
+        fprintf(stderr, "tpcds_benchmark: --row-group-threads requires --zero-copy (streaming writes)\n");
+        return 1;
+    }
+    if (!opts.parquet.cluster_columns.empty() && opts.format != "parquet" &&
+        opts.format != "orc" && opts.format != "lance") {
+        fprintf(stderr, "tpcds_benchmark: --cluster-within-rowgroup supports parquet, orc and lance\n");
+        return 1;
+    }
+    if (opts.target_file_size > 0 && opts.format != "parquet" && opts.format != "csv" &&
+        opts.format != "orc" && opts.format != "paimon" && opts.format != "iceberg") {
+        fprintf(stderr, "tpcds_benchmark: --target-file-size supports parquet, orc, csv, paimon "
+                        "and iceberg (%s manages its own files)\n", opts.format.c_str());
+        return 1;
+    }
+    if (opts.paimon_buckets > 0 && opts.format != "paimon") {
+        fprintf(stderr, "tpcds_benchmark: --paimon-buckets requires --format paimon\n");
+        return 1;
+    }
+    if (opts.paimon_primary_key && opts.format != "paimon") {
+        fprintf(stderr, "tpcds_benchmark: --paimon-primary-key requires --format paimon\n");
+        return 1;
+    }
+    // One data file open per bucket at a time: a single ring cannot carry them
+    if (opts.paimon_buckets > 1 && opts.io_process) {
+        fprintf(stderr, "tpcds_benchmark: --paimon-buckets > 1 cannot write through --io-process\n");
+        return 1;
+    }
+    if (!opts.iceberg_partition.empty() && opts.format != "iceberg") {
+        fprintf(stderr, "tpcds_benchmark: --iceberg-partition requires --format iceberg\n");
+        return 1;
+    }
+    // One data file open per partition, likewise
+    if (!opts.iceberg_partition.empty() && opts.io_process) {
+        fprintf(stderr, "tpcds_benchmark: --iceberg-partition cannot write through --io-process\n");
+        return 1;
+    }
+
+    if ((!opts.writer_id.empty() || opts.commit_only) &&
+        opts.format != "iceberg" && opts.format != "paimon") {
+        fprintf(stderr, "tpcds_benchmark: %s requires --format iceberg or paimon\n",
+                opts.commit_only ? "--commit-only" : "--writer-id");
+        return 1;
+    }
+    if (opts.commit_only && !opts.writer_id.empty()) {
+        fprintf(stderr, "tpcds_benchmark: --commit-only commits every writer; drop --writer-id\n");
+        return 1;
+    }
+    // Striped placement depends on dsdgen row counts; --commit-only must find the tables again
+    if ((!opts.writer_id.empty() || opts.commit_only) && opts.output_dirs.size() > 1) {
+        fprintf(stderr, "tpcds_benchmark: --writer-id and --commit-only take one --output-dir\n");
+        return 1;
+    }
+
+    if (opts.commit_only) {
+        std::vector<std::string> names = {opts.table};
+        if (opts.parallel || opts.single_process) {
+            names.clear();
+            for (const auto& entry : ALL_TPCDS_TABLES) names.push_back(entry.first);
+        }
+        int failed = 0;
+        for (const auto& tname : names) {
+            const std::string path = table_path(opts, tname);
+            try {
+                size_t files = commit_table(opts.format, path);
+                if (files == 0)
+                    throw std::runtime_error("no data files to commit (already committed, or "
+                                             "no writer finished)");
+                printf("tpcds_benchmark: %-28s  committed %zu data files  %s\n",
+                       tname.c_str(), files, path.c_str());
+            } catch (const std::exception& e) {
+                fprintf(stderr, "tpcds_benchmark: [%s] commit failed: %s\n", tname.c_str(), e.what());
+                ++failed;
+            }
+        }
+        return failed ? 1 : 0;
+    }
+
+    if (opts.auto_tune) {
+        auto limits = tpch::detect_resource_limits();
+        opts.tuning = tpch::plan_auto_tuning(
+            limits, opts.parallel ? ALL_TPCDS_TABLES.size() : 1,
+            static_cast<size_t>(opts.parallel_tables));
+        if (opts.parallel || opts.single_process || opts.verbose) {
+            fprintf(stderr, "tpcds_benchmark: resources  %s\n",
+                    tpch::describe(limits, opts.tuning).c_str());
+        }
+    }
+
+    if (opts.io_process && !opts.parallel)
+        fprintf(stderr, "tpcds_benchmark: --io-process only applies to --parallel; ignored\n");
+    if (opts.fdatasync && opts.single_process)
+        fprintf(stderr, "tpcds_benchmark: --fdatasync ignored for tables written through the "
+                        "--single-process shared ring\n");
+    if (opts.io_inflight_mb > 0 && (!opts.parallel || opts.io_process))
+        fprintf(stderr, "tpcds_benchmark: --io-inflight-mb applies to --parallel io_uring "
+                        "children; ignored\n");
+
+    if (!opts.pipe_output.empty()) {
+        const char* spelling = opts.pipe_output == "stdout" ? "-" : "fifo:";
+        if (opts.format != "csv" && opts.format != "parquet" && opts.format != "orc") {
+            fprintf(stderr, "tpcds_benchmark: --output-dir %s supports csv, parquet and orc "
+                            "(single-file formats)\n", spelling);
+            return 1;
+        }
+        if (opts.single_process || (opts.pipe_output == "stdout" && opts.parallel)) {
+            fprintf(stderr, "tpcds_benchmark: --output-dir - streams one table; use fifo:<dir> "
+                            "with --parallel (no --single-process)\n");
+            return 1;
+        }
+        if (opts.target_file_size > 0) {
+            fprintf(stderr, "tpcds_benchmark: --target-file-size writes a directory of files, "
+                            "not a pipe\n");
+            return 1;
+        }
+        if (opts.io_process || opts.fdatasync) {
+            fprintf(stderr, "tpcds_benchmark: --io-process and --fdatasync ignored when writing "
+                            "to a pipe\n");
+            opts.io_process = opts.fdatasync = false;
+        }
+        if (opts.pipe_output == "stdout") {
+            fflush(stdout);
+            g_stdout_fd = ::dup(STDOUT_FILENO);
+            if (g_stdout_fd < 0 || ::dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+                perror("tpcds_benchmark: redirecting stdout");
+                return 1;
+            }
+        }
+    }
 
     // Parallel mode: generate all tables and return immediately
     if (opts.parallel)
         return generate_all_tables_parallel(opts);
 
+    // Single-process mode: every table in this process, one shared ring
+    if (opts.single_process) {
+        tpcds::DSDGenWrapper dsdgen(opts.scale_factor, opts.verbose);
+        auto t_wall = std::chrono::steady_clock::now();
+        fprintf(stderr, "tpcds_benchmark: single-process  SF=%ld  tables=%zu  format=%s\n",
+                opts.scale_factor, ALL_TPCDS_TABLES.size(), opts.format.c_str());
+        int rc = run_tables_in_process(opts, ALL_TPCDS_TABLES, dsdgen);
+        double wall = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t_wall).count();
+        fprintf(stderr, "tpcds_benchmark: single-process done  SF=%ld  %zu tables  wall=%.2fs  %s\n",
+                opts.scale_factor, ALL_TPCDS_TABLES.size(), wall,
+                rc ? "SOME TABLES FAILED" : "all ok");
+        return rc;
+    }
+
     // Resolve table (single-table path)
     tpcds::TableType table_type;
     try {
@@ -750,7 +1515,15 @@ int main(int argc, char* argv[]) {
             filepath,
             opts.compression,
             opts.zero_copy,
-            lance_async_streaming);
+            lance_async_streaming,
+            opts.parquet,
+            opts.target_file_size,
+            opts.paimon_buckets,
+            opts.paimon_primary_key,
+            opts.iceberg_partition);
+        if (!opts.writer_id.empty()) {
+            defer_commit(writer.get(), opts.writer_id);
+        }
     } catch (const std::exception& e) {
         fprintf(stderr, "tpcds_benchmark: failed to create writer: %s\n", e.what());
         return 1;
@@ -768,6 +1541,14 @@ int main(int argc, char* argv[]) {
     }
 #endif
 
+    apply_tuning(opts, writer.get());
+    if (!attach_pipe(opts, writer.get()) && opts.fdatasync) {
+        const auto cfg = stream_config(opts);
+        writer->set_output_stream_factory([cfg](const std::string& path) {
+            return std::make_shared<tpch::IoUringOutputStream>(path, nullptr, cfg);
+        });
+    }
+
     // Get Arrow schema
     auto schema = tpcds::DSDGenWrapper::get_schema(table_type, opts.scale_factor);
 
@@ -779,7 +1560,7 @@ int main(int argc, char* argv[]) {
     // Generate
     size_t actual_rows = 0;
     try {
-        actual_rows = dispatch_generation(opts, table_type, schema, writer, dsdgen);
+        actual_rows = dispatch_generation(opts, table_type, schema, *writer, dsdgen);
     } catch (const std::exception& e) {
         fprintf(stderr, "tpcds_benchmark: generation error: %s\n", e.what());
         return 1;
@@ -796,7 +1577,7 @@ int main(int argc, char* argv[]) {
     printf("tpcds_benchmark: %s  SF=%ld  rows=%ld  elapsed=%.2fs  rate=%.0f rows/s\n",
            opts.table.c_str(), opts.scale_factor, actual,
            elapsed, (elapsed > 0) ? actual / elapsed : 0.0);
-    printf("  output: %s\n", filepath.c_str());
+    printf("  output: %s\n", output_location(opts, filepath).c_str());
 
     return 0;
 }
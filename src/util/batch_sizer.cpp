@@ -0,0 +1,182 @@
+#include "tpch/batch_sizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include <arrow/array.h>
+#include <arrow/record_batch.h>
+#include <arrow/type.h>
+
+namespace tpch {
+
+namespace {
+
+// sysfs cache size ("2048K", "32M") for cpu0's cache index N; 0 if unknown.
+size_t sysfs_cache_size(int index) {
+    std::ifstream in("/sys/devices/system/cpu/cpu0/cache/index" +
+                     std::to_string(index) + "/size");
+    std::string s;
+    if (!(in >> s) || s.empty()) return 0;
+    size_t mult = 1;
+    char unit = s.back();
+    if (unit == 'K' || unit == 'k') mult = 1024;
+    else if (unit == 'M' || unit == 'm') mult = 1024 * 1024;
+    try {
+        return static_cast<size_t>(std::stoull(s)) * mult;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+size_t cache_level_bytes(int level) {
+    long v = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    if (level == 2) v = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    if (level == 3) v = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if (v > 0) return static_cast<size_t>(v);
+    // index0/1 are L1d/L1i on x86 and arm64; index2 = L2, index3 = L3
+    return sysfs_cache_size(level);
+}
+
+}  // anonymous namespace
+
+AdaptiveBatchSizer::AdaptiveBatchSizer(size_t row_bytes_estimate, size_t cache_bytes)
+    : cache_bytes_(cache_bytes > 0 ? cache_bytes : cache_budget_bytes())
+    , row_bytes_(static_cast<double>(std::max<size_t>(1, row_bytes_estimate))) {
+    recompute();
+}
+
+void AdaptiveBatchSizer::set_writer_unit(size_t unit_rows, size_t unit_bytes) {
+    unit_rows_ = unit_rows;
+    unit_bytes_ = unit_bytes;
+    recompute();
+}
+
+void AdaptiveBatchSizer::set_max_rows(size_t max_rows) {
+    max_rows_ = max_rows > 0 ? max_rows : DEFAULT_MAX_ROWS;
+    recompute();
+}
+
+void AdaptiveBatchSizer::set_fixed_rows(size_t rows) {
+    fixed_rows_ = rows;
+    recompute();
+}
+
+size_t AdaptiveBatchSizer::target_bytes() const {
+    return static_cast<size_t>(static_cast<double>(cache_bytes_) * scale_);
+}
+
+size_t AdaptiveBatchSizer::unit_rows() const {
+    if (unit_rows_ > 0) return unit_rows_;
+    if (unit_bytes_ > 0) {
+        return std::max<size_t>(1, static_cast<size_t>(
+            static_cast<double>(unit_bytes_) / row_bytes_));
+    }
+    return 0;
+}
+
+size_t AdaptiveBatchSizer::align_rows(size_t rows, size_t unit) {
+    if (unit == 0 || rows == 0) return rows;
+    if (rows >= unit) {
+        return rows / unit * unit;  // whole multiples of the unit
+    }
+    for (size_t d = rows; d >= rows / 2 && d > 0; --d) {
+        if (unit % d == 0) return d;
+    }
+    // No divisor close enough (e.g. a prime-ish byte-derived unit): split the
+    // unit into equal parts so only the last batch of each unit is short.
+    size_t parts = (unit + rows - 1) / rows;
+    return (unit + parts - 1) / parts;
+}
+
+void AdaptiveBatchSizer::recompute() {
+    if (fixed_rows_ > 0) {
+        rows_ = fixed_rows_;
+        return;
+    }
+    auto rows = static_cast<size_t>(static_cast<double>(target_bytes()) / row_bytes_);
+    rows = std::clamp(rows, DEFAULT_MIN_ROWS, std::max(DEFAULT_MIN_ROWS, max_rows_));
+    rows = align_rows(rows, unit_rows());
+    rows_ = std::max<size_t>(1, std::min(rows, std::max(DEFAULT_MIN_ROWS, max_rows_)));
+}
+
+void AdaptiveBatchSizer::record(size_t rows, int64_t bytes,
+                                double convert_seconds, double write_seconds) {
+    if (rows == 0) return;
+
+    if (bytes > 0) {
+        // EWMA so a few unusually wide batches don't swing the size
+        double measured = static_cast<double>(bytes) / static_cast<double>(rows);
+        row_bytes_ = 0.75 * row_bytes_ + 0.25 * measured;
+    }
+
+    // Only full-size batches are comparable; the tail batch is always short.
+    if (fixed_rows_ > 0 || rows < rows_) return;
+
+    window_rows_ += rows;
+    window_seconds_ += convert_seconds + write_seconds;
+    if (++window_batches_ < FEEDBACK_WINDOW) return;
+
+    double cost = window_seconds_ / static_cast<double>(window_rows_);
+    if (prev_cost_per_row_ > 0.0 && cost > prev_cost_per_row_ * 1.03) {
+        direction_ = -direction_;  // last step made things worse: turn around
+    }
+    prev_cost_per_row_ = cost;
+    scale_ = std::clamp(direction_ > 0 ? scale_ * STEP : scale_ / STEP, 0.25, 4.0);
+
+    window_batches_ = 0;
+    window_rows_ = 0;
+    window_seconds_ = 0.0;
+    recompute();
+}
+
+size_t AdaptiveBatchSizer::cache_budget_bytes() {
+    size_t l2 = cache_level_bytes(2);
+    size_t l3 = cache_level_bytes(3);
+    size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    size_t budget = (l2 + l3 / cpus) / 2;
+    if (budget == 0) return size_t{1} << 20;
+    return std::clamp(budget, size_t{256} << 10, size_t{8} << 20);
+}
+
+size_t estimate_row_bytes(const arrow::Schema& schema) {
+    size_t bytes = 0;
+    for (const auto& field : schema.fields()) {
+        const auto& type = *field->type();
+        const auto id = type.id();
+        if (id == arrow::Type::STRING || id == arrow::Type::BINARY) {
+            bytes += 4 + 24;  // offset + typical dbgen/dsdgen string payload
+        } else if (id == arrow::Type::LARGE_STRING || id == arrow::Type::LARGE_BINARY) {
+            bytes += 8 + 24;
+        } else if (id == arrow::Type::DICTIONARY) {
+            const auto& dict = static_cast<const arrow::DictionaryType&>(type);
+            bytes += static_cast<size_t>(std::max(1, dict.index_type()->bit_width() / 8));
+        } else {
+            int width = type.bit_width();
+            bytes += width > 0 ? static_cast<size_t>(std::max(1, width / 8)) : 8;
+        }
+    }
+    return std::max<size_t>(1, bytes);
+}
+
+int64_t measure_batch_bytes(const arrow::RecordBatch& batch) {
+    int64_t total = 0;
+    for (int i = 0; i < batch.num_columns(); ++i) {
+        const auto& array = batch.column(i);
+        if (!array || !array->data()) continue;
+        for (const auto& buf : array->data()->buffers) {
+            if (buf) total += buf->size();
+        }
+    }
+    return total;
+}
+
+}  // namespace tpch
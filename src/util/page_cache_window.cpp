@@ -0,0 +1,58 @@
+#include "tpch/page_cache_window.hpp"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tpch {
+
+namespace {
+
+constexpr int64_t PAGE = 4096;
+
+}  // namespace
+
+void PageCacheWindow::open(int fd, const PageCacheConfig& config, bool direct_io) {
+    fd_       = fd;
+    prealloc_ = 0;
+    started_  = 0;
+    window_   = direct_io ? 0
+              : static_cast<int64_t>((config.dirty_window_bytes + PAGE - 1) / PAGE * PAGE);
+
+    if (config.preallocate_bytes > 0 &&
+        ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, config.preallocate_bytes) == 0) {
+        prealloc_ = config.preallocate_bytes;
+    }
+}
+
+void PageCacheWindow::advance(int64_t done) {
+    if (fd_ < 0 || window_ == 0) return;
+
+    while (done - started_ >= window_) {
+        // Kick writeback on the newest full window without waiting...
+        ::sync_file_range(fd_, started_, window_, SYNC_FILE_RANGE_WRITE);
+        // ...then wait for the one before it and evict its clean pages.
+        if (started_ >= window_) {
+            const int64_t prev = started_ - window_;
+            ::sync_file_range(fd_, prev, window_,
+                              SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                              SYNC_FILE_RANGE_WAIT_AFTER);
+            ::posix_fadvise(fd_, prev, window_, POSIX_FADV_DONTNEED);
+        }
+        started_ += window_;
+    }
+}
+
+int PageCacheWindow::finish(int64_t size) {
+    int err = 0;
+    // KEEP_SIZE blocks past EOF survive close; ftruncate releases them.
+    if (fd_ >= 0 && prealloc_ > size && ::ftruncate(fd_, size) != 0) {
+        err = errno;
+    }
+    fd_       = -1;
+    prealloc_ = 0;
+    return err;
+}
+
+}  // namespace tpch
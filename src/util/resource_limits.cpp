@@ -0,0 +1,219 @@
+#include "tpch/resource_limits.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <sched.h>
+
+namespace tpch {
+
+namespace {
+
+bool read_first_line(const std::string& path, std::string& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::getline(in, out);
+    return true;
+}
+
+// cgroup v2 path of this process from /proc/self/cgroup ("0::/kubepods/...").
+std::string self_cgroup_v2_path() {
+    std::ifstream in("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind("0::", 0) == 0) {
+            return line.substr(3);
+        }
+    }
+    return "/";
+}
+
+unsigned affinity_cpu_count() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        int n = CPU_COUNT(&set);
+        if (n > 0) return static_cast<unsigned>(n);
+    }
+    return 0;
+}
+
+}  // anonymous namespace
+
+unsigned ResourceLimits::effective_cpus() const {
+    unsigned cpus = std::max(1u, std::min(host_cpus, cpuset_cpus));
+    if (cpu_quota > 0.0) {
+        auto quota = static_cast<unsigned>(std::ceil(cpu_quota));
+        cpus = std::min(cpus, std::max(1u, quota));
+    }
+    return cpus;
+}
+
+double parse_cgroup_cpu_max(const std::string& content) {
+    std::istringstream in(content);
+    std::string quota;
+    long long period = 0;
+    if (!(in >> quota) || quota == "max") return 0.0;
+    if (!(in >> period) || period <= 0) period = 100000;  // kernel default period
+    try {
+        long long q = std::stoll(quota);
+        return q > 0 ? static_cast<double>(q) / static_cast<double>(period) : 0.0;
+    } catch (const std::exception&) {
+        return 0.0;
+    }
+}
+
+int64_t parse_cgroup_memory_max(const std::string& content) {
+    std::istringstream in(content);
+    std::string value;
+    if (!(in >> value) || value == "max") return 0;
+    try {
+        long long bytes = std::stoll(value);
+        return bytes > 0 ? static_cast<int64_t>(bytes) : 0;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+unsigned parse_cpu_list_count(const std::string& content) {
+    unsigned count = 0;
+    std::istringstream in(content);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(),
+                                   [](unsigned char c) { return std::isspace(c); }),
+                    range.end());
+        if (range.empty()) continue;
+        try {
+            auto dash = range.find('-');
+            if (dash == std::string::npos) {
+                (void)std::stoul(range);
+                ++count;
+            } else {
+                unsigned long lo = std::stoul(range.substr(0, dash));
+                unsigned long hi = std::stoul(range.substr(dash + 1));
+                if (hi < lo) return 0;
+                count += static_cast<unsigned>(hi - lo + 1);
+            }
+        } catch (const std::exception&) {
+            return 0;
+        }
+    }
+    return count;
+}
+
+ResourceLimits detect_resource_limits(const std::string& cgroup_root) {
+    ResourceLimits limits;
+    limits.host_cpus = std::max(1u, std::thread::hardware_concurrency());
+    unsigned affinity = affinity_cpu_count();
+    limits.cpuset_cpus = affinity > 0 ? affinity : limits.host_cpus;
+
+    std::string probe;
+    if (!read_first_line(cgroup_root + "/cgroup.controllers", probe)) {
+        return limits;  // not a cgroup v2 unified hierarchy
+    }
+    limits.cgroup_v2 = true;
+
+    // Walk from the process' own cgroup up to the root; a limit set on any
+    // ancestor applies, so keep the tightest value seen.
+    std::string rel = self_cgroup_v2_path();
+    limits.cgroup_path = cgroup_root + (rel == "/" ? "" : rel);
+    while (true) {
+        std::string dir = cgroup_root + (rel == "/" ? "" : rel);
+        std::string line;
+        if (read_first_line(dir + "/cpu.max", line)) {
+            double q = parse_cgroup_cpu_max(line);
+            if (q > 0.0 && (limits.cpu_quota == 0.0 || q < limits.cpu_quota))
+                limits.cpu_quota = q;
+        }
+        if (read_first_line(dir + "/memory.max", line)) {
+            int64_t m = parse_cgroup_memory_max(line);
+            if (m > 0 && (limits.memory_max == 0 || m < limits.memory_max))
+                limits.memory_max = m;
+        }
+        if (read_first_line(dir + "/cpuset.cpus.effective", line)) {
+            unsigned n = parse_cpu_list_count(line);
+            if (n > 0) limits.cpuset_cpus = std::min(limits.cpuset_cpus, n);
+        }
+        if (rel.empty() || rel == "/") break;
+        auto slash = rel.find_last_of('/');
+        rel = (slash == 0 || slash == std::string::npos) ? "/" : rel.substr(0, slash);
+    }
+    return limits;
+}
+
+AutoTuning plan_auto_tuning(const ResourceLimits& limits,
+                            size_t ntables,
+                            size_t requested_slots) {
+    AutoTuning t;
+    const size_t cpus = limits.effective_cpus();
+    ntables = std::max<size_t>(1, ntables);
+
+    if (requested_slots > 0) {
+        t.parallel_slots = requested_slots;
+    } else {
+        t.parallel_slots = std::min(ntables, cpus);
+        if (limits.memory_max > 0) {
+            auto by_mem = static_cast<size_t>(
+                std::max<int64_t>(1, limits.memory_max / AUTO_TUNE_CHILD_MEMORY_BYTES));
+            t.parallel_slots = std::min(t.parallel_slots, by_mem);
+        }
+    }
+    t.parallel_slots = std::max<size_t>(1, t.parallel_slots);
+
+    // Equal CPU share per child; never below one thread.
+    const int share = static_cast<int>(std::max<size_t>(1, cpus / t.parallel_slots));
+    t.arrow_cpu_threads = share;
+    t.arrow_io_threads  = std::max(2, share);  // I/O pool threads mostly block
+    t.lance_threads     = std::min(share, 8);  // 8 = LanceWriter default ceiling
+
+    // Cap batches only when the per-child memory budget is tight; otherwise
+    // AdaptiveBatchSizer sizes them from the cache hierarchy.
+    if (limits.memory_max > 0) {
+        int64_t per_child = limits.memory_max / static_cast<int64_t>(t.parallel_slots);
+        if (per_child < AUTO_TUNE_CHILD_MEMORY_BYTES) {
+            auto scaled = static_cast<size_t>(
+                8192 * per_child / AUTO_TUNE_CHILD_MEMORY_BYTES) / 1024 * 1024;
+            t.max_batch_rows = std::max<size_t>(1024, scaled);
+        }
+    }
+    return t;
+}
+
+std::string describe(const ResourceLimits& limits, const AutoTuning& tuning) {
+    char quota[32];
+    if (limits.cpu_quota > 0.0)
+        std::snprintf(quota, sizeof(quota), "%.1f", limits.cpu_quota);
+    else
+        std::snprintf(quota, sizeof(quota), "max");
+
+    char mem[32];
+    if (limits.memory_max > 0)
+        std::snprintf(mem, sizeof(mem), "%.1fGiB",
+                      static_cast<double>(limits.memory_max) / (1024.0 * 1024.0 * 1024.0));
+    else
+        std::snprintf(mem, sizeof(mem), "max");
+
+    char cap[32];
+    if (tuning.max_batch_rows > 0)
+        std::snprintf(cap, sizeof(cap), "%zu", tuning.max_batch_rows);
+    else
+        std::snprintf(cap, sizeof(cap), "adaptive");
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+        "cpus=%u (host=%u cpuset=%u quota=%s) mem=%s%s -> slots=%zu arrow_cpu=%d arrow_io=%d "
+        "lance_threads=%d batch=%s",
+        limits.effective_cpus(), limits.host_cpus, limits.cpuset_cpus, quota, mem,
+        limits.cgroup_v2 ? "" : " (no cgroup v2)",
+        tuning.parallel_slots, tuning.arrow_cpu_threads, tuning.arrow_io_threads,
+        tuning.lance_threads, cap);
+    return buf;
+}
+
+}  // namespace tpch
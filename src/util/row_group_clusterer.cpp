@@ -0,0 +1,510 @@
+#include "tpch/row_group_clusterer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include <arrow/api.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/checked_cast.h>
+
+namespace tpch {
+
+namespace {
+
+using RowRef = RowGroupClusterer::RowRef;
+
+std::shared_ptr<arrow::Buffer> allocate(int64_t bytes, arrow::MemoryPool* pool) {
+    auto result = arrow::AllocateBuffer(bytes, pool);
+    if (!result.ok()) {
+        throw std::runtime_error("RowGroupClusterer: " + result.status().ToString());
+    }
+    return std::shared_ptr<arrow::Buffer>(std::move(*result));
+}
+
+bool is_string_type(arrow::Type::type id) {
+    return id == arrow::Type::STRING || id == arrow::Type::BINARY;
+}
+
+std::string_view binary_value(const arrow::Array& values, int64_t i) {
+    return arrow::internal::checked_cast<const arrow::BinaryArray&>(values).GetView(i);
+}
+
+/**
+ * One dictionary for a dictionary column across all chunks of a group.
+ * Chunks share the generator's static dictionary, so remap is almost always
+ * empty (identity); otherwise remap[c][i] is chunk c's index i in dictionary.
+ */
+struct MergedDictionary {
+    std::shared_ptr<arrow::Array> dictionary;
+    std::vector<std::vector<int32_t>> remap;
+};
+
+MergedDictionary merge_dictionaries(const std::vector<const arrow::ArrayData*>& chunks,
+                                    const std::string& name, arrow::MemoryPool* pool) {
+    MergedDictionary merged;
+    merged.dictionary = arrow::MakeArray(chunks[0]->dictionary);
+    merged.remap.resize(chunks.size());
+
+    std::unordered_map<std::string_view, int32_t> positions;
+    std::vector<std::shared_ptr<arrow::Array>> dictionaries{merged.dictionary};
+    std::unique_ptr<arrow::ArrayBuilder> builder;
+    for (size_t c = 1; c < chunks.size(); ++c) {
+        if (chunks[c]->dictionary == chunks[0]->dictionary) {
+            continue;
+        }
+        auto dictionary = arrow::MakeArray(chunks[c]->dictionary);
+        if (dictionary->Equals(*dictionaries[0])) {
+            continue;
+        }
+        if (!is_string_type(dictionary->type_id())) {
+            throw std::invalid_argument("RowGroupClusterer: column " + name +
+                                        " has differing non-string dictionaries");
+        }
+        if (!builder) {
+            // Start the merged dictionary from the first chunk's values
+            const auto& first = *dictionaries[0];
+            builder = *arrow::MakeBuilder(first.type(), pool);
+            auto* binary = static_cast<arrow::BinaryBuilder*>(builder.get());
+            for (int64_t i = 0; i < first.length(); ++i) {
+                positions.emplace(binary_value(first, i), static_cast<int32_t>(i));
+                (void)binary->Append(binary_value(first, i));
+            }
+        }
+        auto* binary = static_cast<arrow::BinaryBuilder*>(builder.get());
+        auto& remap = merged.remap[c];
+        remap.resize(static_cast<size_t>(dictionary->length()));
+        for (int64_t i = 0; i < dictionary->length(); ++i) {
+            const auto value = binary_value(*dictionary, i);
+            auto it = positions.find(value);
+            if (it == positions.end()) {
+                const auto next = static_cast<int32_t>(binary->length());
+                (void)binary->Append(value);
+                it = positions.emplace(value, next).first;
+            }
+            remap[static_cast<size_t>(i)] = it->second;
+        }
+        dictionaries.push_back(std::move(dictionary));  // keeps the views valid
+    }
+    if (builder) {
+        std::shared_ptr<arrow::Array> dictionary;
+        auto status = builder->Finish(&dictionary);
+        if (!status.ok()) {
+            throw std::runtime_error("RowGroupClusterer: " + status.ToString());
+        }
+        merged.dictionary = std::move(dictionary);
+    }
+    return merged;
+}
+
+/** Rank of every dictionary entry in ascending value order; 0 is reserved for null. */
+std::vector<uint32_t> dictionary_ranks(const arrow::Array& dictionary, const std::string& name) {
+    if (!is_string_type(dictionary.type_id())) {
+        throw std::invalid_argument("RowGroupClusterer: column " + name +
+                                    " must have string dictionary values");
+    }
+    std::vector<int64_t> order(static_cast<size_t>(dictionary.length()));
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+        if (dictionary.IsNull(a) != dictionary.IsNull(b)) return dictionary.IsNull(a);
+        return !dictionary.IsNull(a) && binary_value(dictionary, a) < binary_value(dictionary, b);
+    });
+    std::vector<uint32_t> ranks(order.size(), 0);
+    uint32_t rank = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (dictionary.IsNull(order[i])) continue;
+        if (i == 0 || dictionary.IsNull(order[i - 1]) ||
+            binary_value(dictionary, order[i]) != binary_value(dictionary, order[i - 1])) {
+            ++rank;
+        }
+        ranks[static_cast<size_t>(order[i])] = rank;
+    }
+    return ranks;
+}
+
+/** f(Index{}) for the integer C type of a dictionary index type. */
+template <typename F>
+decltype(auto) with_index_type(arrow::Type::type id, F&& f) {
+    if (id == arrow::Type::INT8)   return f(int8_t{});
+    if (id == arrow::Type::UINT8)  return f(uint8_t{});
+    if (id == arrow::Type::INT16)  return f(int16_t{});
+    if (id == arrow::Type::UINT16) return f(uint16_t{});
+    if (id == arrow::Type::INT32)  return f(int32_t{});
+    if (id == arrow::Type::UINT32) return f(uint32_t{});
+    if (id == arrow::Type::INT64)  return f(int64_t{});
+    if (id == arrow::Type::UINT64) return f(uint64_t{});
+    throw std::invalid_argument("RowGroupClusterer: unsupported dictionary index type");
+}
+
+template <typename Index>
+void fill_keys(const arrow::ArrayData& chunk, const std::vector<int32_t>& remap,
+               const std::vector<uint32_t>& ranks, std::vector<uint32_t>& keys) {
+    const Index* indices = chunk.GetValues<Index>(1);
+    const uint8_t* validity = chunk.buffers[0] ? chunk.buffers[0]->data() : nullptr;
+    keys.resize(static_cast<size_t>(chunk.length));
+    for (int64_t i = 0; i < chunk.length; ++i) {
+        if (validity && !arrow::bit_util::GetBit(validity, chunk.offset + i)) {
+            keys[static_cast<size_t>(i)] = 0;
+            continue;
+        }
+        const auto index = static_cast<int64_t>(indices[i]);
+        keys[static_cast<size_t>(i)] =
+            ranks[static_cast<size_t>(remap.empty() ? index : remap[static_cast<size_t>(index)])];
+    }
+}
+
+void chunk_keys(const arrow::ArrayData& chunk, const std::vector<int32_t>& remap,
+                const std::vector<uint32_t>& ranks, std::vector<uint32_t>& keys) {
+    const auto& type = arrow::internal::checked_cast<const arrow::DictionaryType&>(*chunk.type);
+    with_index_type(type.index_type()->id(), [&](auto index) {
+        fill_keys<decltype(index)>(chunk, remap, ranks, keys);
+    });
+}
+
+/** One stable counting-sort pass of order by keys[chunk][row] in [0, buckets). */
+void counting_sort(std::vector<RowRef>& order, std::vector<RowRef>& scratch,
+                   const std::vector<std::vector<uint32_t>>& keys, size_t buckets) {
+    std::vector<int64_t> start(buckets + 1, 0);
+    for (const auto& ref : order) {
+        ++start[keys[ref.chunk][ref.row] + 1];
+    }
+    for (size_t b = 0; b < buckets; ++b) {
+        if (start[b + 1] == static_cast<int64_t>(order.size())) {
+            return;  // one value throughout: the pass would not move anything
+        }
+        start[b + 1] += start[b];
+    }
+    scratch.resize(order.size());
+    for (const auto& ref : order) {
+        scratch[static_cast<size_t>(start[keys[ref.chunk][ref.row]]++)] = ref;
+    }
+    order.swap(scratch);
+}
+
+/** Validity bitmap of the gathered rows; null (and null_count 0) if no chunk has nulls. */
+std::shared_ptr<arrow::Buffer> gather_validity(const std::vector<const arrow::ArrayData*>& chunks,
+                                               const std::vector<RowRef>& order,
+                                               arrow::MemoryPool* pool, int64_t* null_count) {
+    *null_count = 0;
+    bool nulls = false;
+    for (const auto* chunk : chunks) {
+        nulls = nulls || chunk->GetNullCount() > 0;
+    }
+    if (!nulls) {
+        return nullptr;
+    }
+    const auto n = static_cast<int64_t>(order.size());
+    auto bitmap = allocate(arrow::bit_util::BytesForBits(n), pool);
+    uint8_t* bits = bitmap->mutable_data();
+    std::memset(bits, 0, static_cast<size_t>(bitmap->size()));
+    for (int64_t i = 0; i < n; ++i) {
+        const auto& ref = order[static_cast<size_t>(i)];
+        const auto* chunk = chunks[ref.chunk];
+        const uint8_t* validity = chunk->buffers[0] ? chunk->buffers[0]->data() : nullptr;
+        if (!validity || arrow::bit_util::GetBit(validity, chunk->offset + ref.row)) {
+            arrow::bit_util::SetBit(bits, i);
+        } else {
+            ++*null_count;
+        }
+    }
+    return bitmap;
+}
+
+template <int Width>
+void gather_fixed(const std::vector<const arrow::ArrayData*>& chunks,
+                  const std::vector<RowRef>& order, uint8_t* out, int width) {
+    const int w = Width > 0 ? Width : width;
+    for (const auto& ref : order) {
+        const auto* chunk = chunks[ref.chunk];
+        std::memcpy(out, chunk->buffers[1]->data() + (chunk->offset + ref.row) * w,
+                    static_cast<size_t>(w));
+        out += w;
+    }
+}
+
+std::shared_ptr<arrow::Buffer> gather_values(const std::vector<const arrow::ArrayData*>& chunks,
+                                             const std::vector<RowRef>& order, int bit_width,
+                                             arrow::MemoryPool* pool) {
+    const auto n = static_cast<int64_t>(order.size());
+    if (bit_width == 1) {
+        auto buffer = allocate(arrow::bit_util::BytesForBits(n), pool);
+        uint8_t* bits = buffer->mutable_data();
+        std::memset(bits, 0, static_cast<size_t>(buffer->size()));
+        for (int64_t i = 0; i < n; ++i) {
+            const auto& ref = order[static_cast<size_t>(i)];
+            const auto* chunk = chunks[ref.chunk];
+            if (arrow::bit_util::GetBit(chunk->buffers[1]->data(), chunk->offset + ref.row)) {
+                arrow::bit_util::SetBit(bits, i);
+            }
+        }
+        return buffer;
+    }
+    const int width = bit_width / 8;
+    auto buffer = allocate(n * width, pool);
+    uint8_t* out = buffer->mutable_data();
+    switch (width) {
+        case 1:  gather_fixed<1>(chunks, order, out, width); break;
+        case 2:  gather_fixed<2>(chunks, order, out, width); break;
+        case 4:  gather_fixed<4>(chunks, order, out, width); break;
+        case 8:  gather_fixed<8>(chunks, order, out, width); break;
+        case 16: gather_fixed<16>(chunks, order, out, width); break;
+        default: gather_fixed<0>(chunks, order, out, width); break;
+    }
+    return buffer;
+}
+
+template <typename Offset>
+void gather_binary(const std::vector<const arrow::ArrayData*>& chunks,
+                   const std::vector<RowRef>& order, arrow::MemoryPool* pool,
+                   std::shared_ptr<arrow::Buffer>* offsets_out,
+                   std::shared_ptr<arrow::Buffer>* data_out) {
+    const auto n = static_cast<int64_t>(order.size());
+    auto offsets = allocate((n + 1) * static_cast<int64_t>(sizeof(Offset)), pool);
+    auto* out_offsets = reinterpret_cast<Offset*>(offsets->mutable_data());
+    int64_t total = 0;
+    out_offsets[0] = 0;
+    for (int64_t i = 0; i < n; ++i) {
+        const auto& ref = order[static_cast<size_t>(i)];
+        const Offset* in = chunks[ref.chunk]->GetValues<Offset>(1);
+        total += in[ref.row + 1] - in[ref.row];
+        if (total > std::numeric_limits<Offset>::max()) {
+            throw std::runtime_error("RowGroupClusterer: string column exceeds its offset range");
+        }
+        out_offsets[i + 1] = static_cast<Offset>(total);
+    }
+    auto data = allocate(total, pool);
+    uint8_t* out = data->mutable_data();
+    for (int64_t i = 0; i < n; ++i) {
+        const auto& ref = order[static_cast<size_t>(i)];
+        const auto* chunk = chunks[ref.chunk];
+        const Offset* in = chunk->GetValues<Offset>(1);
+        const auto length = static_cast<size_t>(in[ref.row + 1] - in[ref.row]);
+        std::memcpy(out, chunk->buffers[2]->data() + in[ref.row], length);
+        out += length;
+    }
+    *offsets_out = std::move(offsets);
+    *data_out = std::move(data);
+}
+
+template <typename Index>
+std::shared_ptr<arrow::Buffer> gather_indices(const std::vector<const arrow::ArrayData*>& chunks,
+                                              const std::vector<RowRef>& order,
+                                              const MergedDictionary& merged,
+                                              arrow::MemoryPool* pool) {
+    if (merged.dictionary->length() - 1 > static_cast<int64_t>(std::numeric_limits<Index>::max())) {
+        throw std::runtime_error("RowGroupClusterer: merged dictionary exceeds its index type");
+    }
+    auto buffer = allocate(static_cast<int64_t>(order.size() * sizeof(Index)), pool);
+    auto* out = reinterpret_cast<Index*>(buffer->mutable_data());
+    for (const auto& ref : order) {
+        const auto* chunk = chunks[ref.chunk];
+        const Index index = chunk->GetValues<Index>(1)[ref.row];
+        const auto& remap = merged.remap[ref.chunk];
+        // Null slots may hold any index: only remap valid ones
+        *out++ = remap.empty() || static_cast<size_t>(index) >= remap.size()
+                     ? index
+                     : static_cast<Index>(remap[static_cast<size_t>(index)]);
+    }
+    return buffer;
+}
+
+std::shared_ptr<arrow::ArrayData> gather_column(const std::vector<const arrow::ArrayData*>& chunks,
+                                                const std::vector<RowRef>& order,
+                                                const MergedDictionary* merged,
+                                                const std::string& name,
+                                                arrow::MemoryPool* pool) {
+    const auto& type = chunks[0]->type;
+    const auto n = static_cast<int64_t>(order.size());
+    int64_t null_count = 0;
+    auto validity = gather_validity(chunks, order, pool, &null_count);
+
+    const auto id = type->id();
+    if (id == arrow::Type::DICTIONARY) {
+        const auto& dict_type = arrow::internal::checked_cast<const arrow::DictionaryType&>(*type);
+        auto indices = with_index_type(dict_type.index_type()->id(), [&](auto index) {
+            return gather_indices<decltype(index)>(chunks, order, *merged, pool);
+        });
+        auto data = arrow::ArrayData::Make(type, n, {validity, indices}, null_count);
+        data->dictionary = merged->dictionary->data();
+        return data;
+    }
+    if (id == arrow::Type::STRING || id == arrow::Type::BINARY) {
+        std::shared_ptr<arrow::Buffer> offsets, values;
+        gather_binary<int32_t>(chunks, order, pool, &offsets, &values);
+        return arrow::ArrayData::Make(type, n, {validity, offsets, values}, null_count);
+    }
+    if (id == arrow::Type::LARGE_STRING || id == arrow::Type::LARGE_BINARY) {
+        std::shared_ptr<arrow::Buffer> offsets, values;
+        gather_binary<int64_t>(chunks, order, pool, &offsets, &values);
+        return arrow::ArrayData::Make(type, n, {validity, offsets, values}, null_count);
+    }
+    if (!arrow::is_fixed_width(id)) {
+        throw std::invalid_argument("RowGroupClusterer: cannot reorder column " + name +
+                                    " of type " + type->ToString());
+    }
+    const int bit_width = arrow::internal::checked_cast<const arrow::FixedWidthType&>(*type).bit_width();
+    return arrow::ArrayData::Make(type, n, {validity, gather_values(chunks, order, bit_width, pool)},
+                                  null_count);
+}
+
+std::vector<const arrow::ArrayData*> column_chunks(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks, int column) {
+    std::vector<const arrow::ArrayData*> data;
+    data.reserve(chunks.size());
+    for (const auto& chunk : chunks) {
+        data.push_back(chunk->column_data(column).get());
+    }
+    return data;
+}
+
+/** Merged dictionary of every dictionary column (empty entries elsewhere). */
+std::vector<MergedDictionary> merge_all_dictionaries(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks, arrow::MemoryPool* pool) {
+    const auto& schema = chunks[0]->schema();
+    std::vector<MergedDictionary> merged(static_cast<size_t>(schema->num_fields()));
+    for (int i = 0; i < schema->num_fields(); ++i) {
+        if (schema->field(i)->type()->id() == arrow::Type::DICTIONARY) {
+            merged[static_cast<size_t>(i)] =
+                merge_dictionaries(column_chunks(chunks, i), schema->field(i)->name(), pool);
+        }
+    }
+    return merged;
+}
+
+std::shared_ptr<arrow::RecordBatch> gather_rows(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks,
+        const std::vector<RowRef>& order, const std::vector<MergedDictionary>& merged,
+        arrow::MemoryPool* pool) {
+    const auto& schema = chunks[0]->schema();
+    std::vector<std::shared_ptr<arrow::ArrayData>> columns;
+    columns.reserve(static_cast<size_t>(schema->num_fields()));
+    for (int i = 0; i < schema->num_fields(); ++i) {
+        columns.push_back(gather_column(column_chunks(chunks, i), order, &merged[static_cast<size_t>(i)],
+                                        schema->field(i)->name(), pool));
+    }
+    return arrow::RecordBatch::Make(schema, static_cast<int64_t>(order.size()), std::move(columns));
+}
+
+}  // namespace
+
+RowGroupClusterer::RowGroupClusterer(const std::shared_ptr<arrow::Schema>& schema,
+                                     const std::vector<std::string>& columns,
+                                     int64_t group_rows)
+    : schema_(schema), group_rows_(group_rows) {
+    if (group_rows_ <= 0 || group_rows_ > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("RowGroupClusterer: group rows out of range");
+    }
+    for (const auto& name : columns) {
+        const int index = schema_->GetFieldIndex(name);
+        if (index < 0 || std::find(keys_.begin(), keys_.end(), index) != keys_.end()) {
+            continue;
+        }
+        if (schema_->field(index)->type()->id() != arrow::Type::DICTIONARY) {
+            throw std::invalid_argument("cluster column " + name + " is not dictionary-encoded");
+        }
+        keys_.push_back(index);
+        key_names_.push_back(name);
+    }
+}
+
+RowGroupClusterer::~RowGroupClusterer() = default;
+
+std::vector<std::shared_ptr<arrow::RecordBatch>> RowGroupClusterer::push(
+        const std::shared_ptr<arrow::RecordBatch>& batch, std::shared_ptr<void> owner) {
+    if (!active()) {
+        return {batch};
+    }
+    std::vector<std::shared_ptr<arrow::RecordBatch>> groups;
+    if (!batch || batch->num_rows() == 0) {
+        return groups;
+    }
+    pending_.push_back(batch);
+    owners_.push_back(std::move(owner));
+    pending_rows_ += batch->num_rows();
+    while (pending_rows_ >= group_rows_) {
+        groups.push_back(take_group(group_rows_));
+    }
+    return groups;
+}
+
+std::shared_ptr<arrow::RecordBatch> RowGroupClusterer::flush() {
+    return pending_rows_ > 0 ? take_group(pending_rows_) : nullptr;
+}
+
+std::shared_ptr<arrow::RecordBatch> RowGroupClusterer::take_group(int64_t rows) {
+    std::vector<std::shared_ptr<arrow::RecordBatch>> chunks;
+    size_t used = 0;
+    for (int64_t need = rows; need > 0;) {
+        auto& batch = pending_[used];
+        if (batch->num_rows() <= need) {
+            chunks.push_back(batch);
+            need -= batch->num_rows();
+            ++used;
+        } else {
+            // Group boundary inside the batch: the rest stays for the next group
+            chunks.push_back(batch->Slice(0, need));
+            batch = batch->Slice(need);
+            need = 0;
+        }
+    }
+    auto group = cluster(chunks, keys_);
+    pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(used));
+    owners_.erase(owners_.begin(), owners_.begin() + static_cast<std::ptrdiff_t>(used));
+    pending_rows_ -= rows;
+    return group;
+}
+
+std::shared_ptr<arrow::RecordBatch> RowGroupClusterer::cluster(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks,
+        const std::vector<int>& key_indices, arrow::MemoryPool* pool) {
+    if (chunks.empty()) {
+        return nullptr;
+    }
+    pool = pool ? pool : arrow::default_memory_pool();
+    const auto& schema = chunks[0]->schema();
+
+    std::vector<RowRef> order;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (int64_t r = 0; r < chunks[c]->num_rows(); ++r) {
+            order.push_back({static_cast<uint32_t>(c), static_cast<uint32_t>(r)});
+        }
+    }
+
+    // Dictionary columns: one dictionary per group (merged if chunks differ)
+    auto merged = merge_all_dictionaries(chunks, pool);
+
+    // LSD: least significant key first, each pass stable
+    std::vector<RowRef> scratch;
+    std::vector<std::vector<uint32_t>> keys(chunks.size());
+    for (auto it = key_indices.rbegin(); it != key_indices.rend(); ++it) {
+        const auto& field = schema->field(*it);
+        if (field->type()->id() != arrow::Type::DICTIONARY) {
+            throw std::invalid_argument("cluster column " + field->name() + " is not dictionary-encoded");
+        }
+        const auto& dict = merged[static_cast<size_t>(*it)];
+        const auto ranks = dictionary_ranks(*dict.dictionary, field->name());
+        const auto data = column_chunks(chunks, *it);
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            chunk_keys(*data[c], dict.remap[c], ranks, keys[c]);
+        }
+        const uint32_t max_rank = ranks.empty() ? 0 : *std::max_element(ranks.begin(), ranks.end());
+        counting_sort(order, scratch, keys, static_cast<size_t>(max_rank) + 1);
+    }
+    return gather_rows(chunks, order, merged, pool);
+}
+
+std::shared_ptr<arrow::RecordBatch> RowGroupClusterer::gather(
+        const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks,
+        const std::vector<RowRef>& order, arrow::MemoryPool* pool) {
+    if (chunks.empty()) {
+        return nullptr;
+    }
+    pool = pool ? pool : arrow::default_memory_pool();
+    return gather_rows(chunks, order, merge_all_dictionaries(chunks, pool), pool);
+}
+
+}  // namespace tpch
@@ -0,0 +1,130 @@
+#include "tpch/stripe_layout.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace tpch {
+
+namespace {
+
+int64_t measured_bytes(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (fs::is_regular_file(path, ec)) {
+        auto n = fs::file_size(path, ec);
+        return ec ? -1 : static_cast<int64_t>(n);
+    }
+    if (!fs::is_directory(path, ec)) {
+        return -1;  // never written (failed child) or not a regular file (FIFO)
+    }
+    int64_t total = 0;
+    for (auto it = fs::recursive_directory_iterator(path, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            total += static_cast<int64_t>(it->file_size(ec));
+        }
+    }
+    return total;
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+StripeLayout::StripeLayout(std::vector<std::string> dirs, Policy policy)
+    : dirs_(std::move(dirs)), policy_(policy) {
+    if (dirs_.empty()) {
+        throw std::invalid_argument("StripeLayout: no output directories");
+    }
+    bytes_.assign(dirs_.size(), 0);
+    count_.assign(dirs_.size(), 0);
+}
+
+std::vector<std::string> StripeLayout::parse(const std::string& spec) {
+    std::vector<std::string> dirs;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        if (end > start) dirs.push_back(spec.substr(start, end - start));
+        start = end + 1;
+    }
+    return dirs;
+}
+
+StripeLayout::Policy StripeLayout::parse_policy(const std::string& name) {
+    if (name == "bytes") return Policy::LeastBytes;
+    if (name == "rr")    return Policy::RoundRobin;
+    throw std::invalid_argument("unknown stripe policy '" + name + "' (bytes, rr)");
+}
+
+size_t StripeLayout::choose() const {
+    if (policy_ == Policy::RoundRobin) {
+        return pieces_.size() % dirs_.size();
+    }
+    size_t best = 0;
+    for (size_t i = 1; i < dirs_.size(); ++i) {
+        if (bytes_[i] < bytes_[best] ||
+            (bytes_[i] == bytes_[best] && count_[i] < count_[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+std::string StripeLayout::place(const std::string& name, const std::string& filename,
+                                int64_t expected_bytes) {
+    size_t d = choose();
+    const std::string& dir = dirs_[d];
+    std::string path = (!dir.empty() && dir.back() == '/') ? dir + filename
+                                                           : dir + "/" + filename;
+    bytes_[d] += expected_bytes > 0 ? expected_bytes : 0;
+    count_[d] += 1;
+    pieces_.push_back({name, path, d, expected_bytes});
+    return path;
+}
+
+void StripeLayout::write_manifest(const std::string& path) const {
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        throw std::runtime_error("StripeLayout: cannot write " + tmp);
+    }
+    fprintf(f, "{\n  \"directories\": [");
+    for (size_t i = 0; i < dirs_.size(); ++i) {
+        fprintf(f, "%s\"%s\"", i ? ", " : "", json_escape(dirs_[i]).c_str());
+    }
+    fprintf(f, "],\n  \"files\": [");
+    for (size_t i = 0; i < pieces_.size(); ++i) {
+        const Piece& p = pieces_[i];
+        fprintf(f, "%s\n    {\"table\": \"%s\", \"path\": \"%s\", \"directory\": %zu, \"bytes\": %lld}",
+                i ? "," : "", json_escape(p.name).c_str(), json_escape(p.path).c_str(),
+                p.dir, static_cast<long long>(measured_bytes(p.path)));
+    }
+    fprintf(f, "\n  ]\n}\n");
+    bool ok = ferror(f) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("StripeLayout: cannot write " + path);
+    }
+}
+
+}  // namespace tpch
@@ -0,0 +1,251 @@
+#include "tpch/thrift_compact.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace tpch {
+
+namespace {
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : p_(data), begin_(data), end_(data + size) {}
+
+    size_t offset() const { return static_cast<size_t>(p_ - begin_); }
+
+    ThriftValue read_struct(int depth) {
+        if (depth > 64) fail("nesting too deep");
+        ThriftValue v;
+        v.type = ThriftValue::STRUCT;
+        int16_t last_id = 0;
+        for (;;) {
+            const uint8_t header = byte();
+            const uint8_t type = header & 0x0f;
+            if (type == ThriftValue::STOP) break;
+            const uint8_t delta = header >> 4;
+            const int16_t id = delta ? static_cast<int16_t>(last_id + delta)
+                                     : static_cast<int16_t>(zigzag());
+            last_id = id;
+            ThriftValue f;
+            if (type == ThriftValue::BOOL_TRUE || type == ThriftValue::BOOL_FALSE) {
+                f.type = ThriftValue::BOOL_TRUE;
+                f.i = type == ThriftValue::BOOL_TRUE;  // the type nibble is the value
+            } else {
+                f = read(type, depth + 1);
+            }
+            v.fields.emplace_back(id, std::move(f));
+        }
+        return v;
+    }
+
+private:
+    [[noreturn]] void fail(const char* what) {
+        throw std::runtime_error(std::string("thrift compact: ") + what);
+    }
+
+    uint8_t byte() {
+        if (p_ >= end_) fail("truncated");
+        return *p_++;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t b = byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        fail("varint too long");
+    }
+
+    int64_t zigzag() {
+        const uint64_t u = varint();
+        return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+    }
+
+    ThriftValue read(uint8_t type, int depth) {
+        ThriftValue v;
+        v.type = type;
+        switch (type) {
+            case ThriftValue::BOOL_TRUE:
+            case ThriftValue::BOOL_FALSE:  // list/set elements: one byte, 1 = true
+                v.type = ThriftValue::BOOL_TRUE;
+                v.i = byte() == 1;
+                break;
+            case ThriftValue::BYTE:
+                v.i = static_cast<int8_t>(byte());
+                break;
+            case ThriftValue::I16:
+            case ThriftValue::I32:
+            case ThriftValue::I64:
+                v.i = zigzag();
+                break;
+            case ThriftValue::DOUBLE:
+                if (end_ - p_ < 8) fail("truncated");
+                std::memcpy(&v.bits, p_, 8);
+                p_ += 8;
+                break;
+            case ThriftValue::BINARY: {
+                const uint64_t n = varint();
+                if (n > static_cast<uint64_t>(end_ - p_)) fail("truncated");
+                v.bin.assign(reinterpret_cast<const char*>(p_), n);
+                p_ += n;
+                break;
+            }
+            case ThriftValue::LIST:
+            case ThriftValue::SET: {
+                const uint8_t header = byte();
+                uint64_t n = header >> 4;
+                if (n == 15) n = varint();
+                v.elem_type = header & 0x0f;
+                if (n > static_cast<uint64_t>(end_ - p_)) fail("bad list size");
+                v.items.reserve(n);
+                for (uint64_t k = 0; k < n; ++k) v.items.push_back(read(v.elem_type, depth + 1));
+                break;
+            }
+            case ThriftValue::MAP: {
+                const uint64_t n = varint();
+                if (n == 0) break;
+                const uint8_t kv = byte();
+                v.key_type = kv >> 4;
+                v.elem_type = kv & 0x0f;
+                if (n > static_cast<uint64_t>(end_ - p_)) fail("bad map size");
+                for (uint64_t k = 0; k < n; ++k) {
+                    v.items.push_back(read(v.key_type, depth + 1));
+                    v.items.push_back(read(v.elem_type, depth + 1));
+                }
+                break;
+            }
+            case ThriftValue::STRUCT:
+                return read_struct(depth);
+            default:
+                fail("unknown type");
+        }
+        return v;
+    }
+
+    const uint8_t* p_;
+    const uint8_t* begin_;
+    const uint8_t* end_;
+};
+
+class Writer {
+public:
+    std::string out;
+
+    void write_struct(const ThriftValue& v) {
+        int16_t last_id = 0;
+        for (const auto& [id, f] : v.fields) {
+            uint8_t type = f.type;
+            if (type == ThriftValue::BOOL_TRUE || type == ThriftValue::BOOL_FALSE) {
+                type = f.i ? ThriftValue::BOOL_TRUE : ThriftValue::BOOL_FALSE;
+            }
+            const int delta = id - last_id;
+            if (delta > 0 && delta <= 15) {
+                byte(static_cast<uint8_t>(delta << 4 | type));
+            } else {
+                byte(type);
+                zigzag(id);
+            }
+            last_id = id;
+            if (type != ThriftValue::BOOL_TRUE && type != ThriftValue::BOOL_FALSE) write(f);
+        }
+        byte(ThriftValue::STOP);
+    }
+
+private:
+    void byte(uint8_t b) { out.push_back(static_cast<char>(b)); }
+
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            byte(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        byte(static_cast<uint8_t>(v));
+    }
+
+    void zigzag(int64_t v) {
+        varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    void write(const ThriftValue& v) {
+        switch (v.type) {
+            case ThriftValue::BOOL_TRUE:
+            case ThriftValue::BOOL_FALSE:
+                byte(v.i ? 1 : 2);
+                break;
+            case ThriftValue::BYTE:
+                byte(static_cast<uint8_t>(v.i));
+                break;
+            case ThriftValue::I16:
+            case ThriftValue::I32:
+            case ThriftValue::I64:
+                zigzag(v.i);
+                break;
+            case ThriftValue::DOUBLE: {
+                char raw[8];
+                std::memcpy(raw, &v.bits, 8);
+                out.append(raw, 8);
+                break;
+            }
+            case ThriftValue::BINARY:
+                varint(v.bin.size());
+                out.append(v.bin);
+                break;
+            case ThriftValue::LIST:
+            case ThriftValue::SET:
+                if (v.items.size() < 15) {
+                    byte(static_cast<uint8_t>(v.items.size() << 4 | v.elem_type));
+                } else {
+                    byte(static_cast<uint8_t>(0xf0 | v.elem_type));
+                    varint(v.items.size());
+                }
+                for (const auto& item : v.items) write(item);
+                break;
+            case ThriftValue::MAP:
+                varint(v.items.size() / 2);
+                if (!v.items.empty()) byte(static_cast<uint8_t>(v.key_type << 4 | v.elem_type));
+                for (const auto& item : v.items) write(item);
+                break;
+            case ThriftValue::STRUCT:
+                write_struct(v);
+                break;
+            default:
+                throw std::runtime_error("thrift compact: cannot encode type " +
+                                         std::to_string(v.type));
+        }
+    }
+};
+
+}  // namespace
+
+ThriftValue* ThriftValue::field(int16_t id) {
+    for (auto& [fid, value] : fields) {
+        if (fid == id) return &value;
+    }
+    return nullptr;
+}
+
+const ThriftValue* ThriftValue::field(int16_t id) const {
+    return const_cast<ThriftValue*>(this)->field(id);
+}
+
+int64_t ThriftValue::int_field(int16_t id, int64_t fallback) const {
+    const ThriftValue* f = field(id);
+    return f ? f->i : fallback;
+}
+
+ThriftValue decode_thrift_struct(const uint8_t* data, size_t size, size_t* consumed) {
+    Reader reader(data, size);
+    ThriftValue v = reader.read_struct(0);
+    if (consumed) *consumed = reader.offset();
+    return v;
+}
+
+std::string encode_thrift_struct(const ThriftValue& value) {
+    Writer writer;
+    writer.write_struct(value);
+    return std::move(writer.out);
+}
+
+}  // namespace tpch
@@ -0,0 +1,112 @@
+#include "tpch/write_throttle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+
+namespace tpch {
+
+// Lives in shared memory: only lock-free atomics and plain constants.
+struct WriteThrottle::Bucket {
+    double ns_per_byte = 0;   // 0 = unlimited
+    double ns_per_op   = 0;
+    std::atomic<int64_t> bytes_tat{0};     // theoretical arrival time (ns)
+    std::atomic<int64_t> ops_tat{0};
+    std::atomic<int64_t> throttled_ns{0};  // summed over all processes
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "WriteThrottle needs address-free atomics in shared memory");
+
+WriteThrottle::Bucket* WriteThrottle::bucket_             = nullptr;
+std::atomic<int64_t>   WriteThrottle::local_throttled_ns_{0};
+
+namespace {
+
+int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000'000 + ts.tv_nsec;
+}
+
+// Reserve cost on tat; returns how long to wait before the slot starts.
+int64_t reserve(std::atomic<int64_t>& tat, int64_t now, int64_t cost) {
+    int64_t old = tat.load(std::memory_order_relaxed);
+    int64_t start;
+    do {
+        start = std::max(old, now - WriteThrottle::BURST_NS);
+    } while (!tat.compare_exchange_weak(old, start + cost, std::memory_order_relaxed));
+    return start - now;
+}
+
+}  // namespace
+
+bool WriteThrottle::init(double bytes_per_sec, double ops_per_sec) {
+    if (bucket_) {
+        munmap(bucket_, sizeof(Bucket));
+        bucket_ = nullptr;
+    }
+    local_throttled_ns_.store(0, std::memory_order_relaxed);
+    if (bytes_per_sec <= 0 && ops_per_sec <= 0) {
+        return false;
+    }
+
+    void* p = mmap(nullptr, sizeof(Bucket), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error(std::string("WriteThrottle: mmap: ") + strerror(errno));
+    }
+    bucket_ = new (p) Bucket;
+    bucket_->ns_per_byte = bytes_per_sec > 0 ? 1e9 / bytes_per_sec : 0;
+    bucket_->ns_per_op   = ops_per_sec   > 0 ? 1e9 / ops_per_sec   : 0;
+    const int64_t t = now_ns();
+    bucket_->bytes_tat.store(t);
+    bucket_->ops_tat.store(t);
+    return true;
+}
+
+bool WriteThrottle::enabled() {
+    return bucket_ != nullptr;
+}
+
+void WriteThrottle::acquire(size_t bytes) {
+    if (!bucket_) return;
+
+    const int64_t now  = now_ns();
+    int64_t       wait = 0;
+    if (bucket_->ns_per_byte > 0) {
+        auto cost = static_cast<int64_t>(static_cast<double>(bytes) * bucket_->ns_per_byte);
+        wait = std::max(wait, reserve(bucket_->bytes_tat, now, cost));
+    }
+    if (bucket_->ns_per_op > 0) {
+        auto cost = static_cast<int64_t>(bucket_->ns_per_op);
+        wait = std::max(wait, reserve(bucket_->ops_tat, now, cost));
+    }
+    if (wait <= 0) return;
+
+    const int64_t until = now + wait;
+    struct timespec ts;
+    ts.tv_sec  = until / 1'000'000'000;
+    ts.tv_nsec = until % 1'000'000'000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+    local_throttled_ns_.fetch_add(wait, std::memory_order_relaxed);
+    bucket_->throttled_ns.fetch_add(wait, std::memory_order_relaxed);
+}
+
+double WriteThrottle::throttled_seconds() {
+    return static_cast<double>(local_throttled_ns_.load(std::memory_order_relaxed)) / 1e9;
+}
+
+double WriteThrottle::total_throttled_seconds() {
+    return bucket_ ? static_cast<double>(bucket_->throttled_ns.load()) / 1e9 : 0.0;
+}
+
+}  // namespace tpch
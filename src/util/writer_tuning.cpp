@@ -0,0 +1,40 @@
+#include "tpch/writer_tuning.hpp"
+
+#include <arrow/io/interfaces.h>
+#include <arrow/type.h>
+#include <arrow/util/thread_pool.h>
+
+#include "tpch/writer_interface.hpp"
+
+#ifdef TPCH_ENABLE_LANCE
+#include "tpch/lance_writer.hpp"
+#endif
+
+namespace tpch {
+
+AdaptiveBatchSizer make_batch_sizer(const arrow::Schema& schema,
+                                    const WriterInterface& writer,
+                                    const AutoTuning* tuning,
+                                    size_t fixed_rows) {
+    AdaptiveBatchSizer sizer(estimate_row_bytes(schema));
+    sizer.set_writer_unit(writer.preferred_unit_rows(), writer.preferred_unit_bytes());
+    if (tuning)
+        sizer.set_max_rows(tuning->max_batch_rows);
+    if (fixed_rows > 0)
+        sizer.set_fixed_rows(fixed_rows);
+    return sizer;
+}
+
+void apply_auto_tuning(const AutoTuning& tuning, WriterInterface* writer) {
+    (void)arrow::SetCpuThreadPoolCapacity(tuning.arrow_cpu_threads);
+    (void)arrow::io::SetIOThreadPoolCapacity(tuning.arrow_io_threads);
+#ifdef TPCH_ENABLE_LANCE
+    if (auto* lw = dynamic_cast<LanceWriter*>(writer)) {
+        lw->set_runtime_config(tuning.lance_threads);
+    }
+#else
+    (void)writer;
+#endif
+}
+
+}  // namespace tpch
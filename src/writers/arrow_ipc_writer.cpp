@@ -0,0 +1,119 @@
+#include "tpch/arrow_ipc_writer.hpp"
+#include "tpch/gather_output_stream.hpp"
+
+#include <stdexcept>
+
+#include <arrow/api.h>
+#include <arrow/ipc/api.h>
+#include <arrow/util/compression.h>
+
+namespace tpch {
+
+ArrowIpcWriter::ArrowIpcWriter(const std::string& filepath, bool stream_format)
+    : filepath_(filepath), stream_format_(stream_format) {}
+
+ArrowIpcWriter::~ArrowIpcWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Suppress exceptions in destructor
+    }
+}
+
+void ArrowIpcWriter::set_compression(const std::string& codec) {
+    if (codec != "none" && codec != "lz4" && codec != "zstd") {
+        throw std::runtime_error("Arrow IPC compression must be none, lz4 or zstd, not '" +
+                                 codec + "'");
+    }
+    if (writer_) {
+        throw std::runtime_error("Cannot change Arrow IPC compression after writing has begun");
+    }
+    compression_ = codec;
+}
+
+bool ArrowIpcWriter::set_output_stream_factory(OutputStreamFactory factory) {
+    if (writer_) {
+        throw std::runtime_error("Cannot replace the Arrow IPC output stream after writing has begun");
+    }
+    stream_ = factory(filepath_);
+    gather_ = std::dynamic_pointer_cast<GatherOutputStream>(stream_);
+    return true;
+}
+
+void ArrowIpcWriter::open(const std::shared_ptr<arrow::Schema>& schema) {
+    if (!stream_) {
+        // Synchronous gathered pwritev straight from the batch buffers
+        gather_ = std::make_shared<GatherOutputStream>(filepath_);
+        stream_ = gather_;
+    }
+
+    auto options = arrow::ipc::IpcWriteOptions::Defaults();
+    if (compression_ != "none") {
+        auto type = compression_ == "lz4" ? arrow::Compression::LZ4_FRAME
+                                          : arrow::Compression::ZSTD;
+        auto codec = arrow::util::Codec::Create(type);
+        if (!codec.ok()) {
+            throw std::runtime_error("Arrow IPC compression " + compression_ + ": " +
+                                     codec.status().ToString());
+        }
+        options.codec = std::move(*codec);
+    }
+
+    auto writer = stream_format_ ? arrow::ipc::MakeStreamWriter(stream_, schema, options)
+                                 : arrow::ipc::MakeFileWriter(stream_, schema, options);
+    if (!writer.ok()) {
+        throw std::runtime_error("Failed to open Arrow IPC writer for " + filepath_ + ": " +
+                                 writer.status().ToString());
+    }
+    writer_ = *writer;
+}
+
+void ArrowIpcWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
+    if (closed_) {
+        throw std::runtime_error("Arrow IPC output file is not open");
+    }
+    if (!writer_) {
+        open(batch->schema());
+    }
+    auto status = writer_->WriteRecordBatch(*batch);
+    if (!status.ok()) {
+        throw std::runtime_error("Arrow IPC write failed: " + status.ToString());
+    }
+}
+
+void ArrowIpcWriter::write_managed_batch(const ManagedRecordBatch& managed_batch) {
+    write_batch(managed_batch.batch);
+    if (managed_batch.lifetime_mgr) {
+        if (gather_) {
+            gather_->retain(managed_batch.lifetime_mgr);
+        }
+        // Other streams copied the bytes in Write(): nothing to keep.
+    }
+}
+
+void ArrowIpcWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    arrow::Status status;
+    if (writer_) {
+        status = writer_->Close();  // footer / end-of-stream; leaves the sink open
+        writer_.reset();
+    }
+    if (stream_) {
+        auto close_status = stream_->Close();
+        if (status.ok()) {
+            status = close_status;
+        }
+        stream_.reset();
+        gather_.reset();
+    }
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to close Arrow IPC file " + filepath_ + ": " +
+                                 status.ToString());
+    }
+}
+
+}  // namespace tpch
@@ -1,13 +1,7 @@
 #include "tpch/csv_writer.hpp"
-#include "tpch/async_io.hpp"
 
-#include <iostream>
 #include <sstream>
-#include <fcntl.h>
-#include <unistd.h>
-#include <cerrno>
-#include <cstring>
-#include <cstdlib>
+#include <stdexcept>
 
 #include <arrow/api.h>
 #include <arrow/csv/api.h>
@@ -15,27 +9,8 @@
 namespace tpch {
 
 CSVWriter::CSVWriter(const std::string& filepath, bool use_direct_io)
-    : filepath_(filepath), use_direct_io_(use_direct_io) {
-  // Use ONLY raw fd for ALL writes (async and sync)
-  int flags = O_WRONLY | O_CREAT | O_TRUNC;
-  if (use_direct_io) {
-    flags |= O_DIRECT;
-  }
-
-  file_descriptor_ = ::open(filepath.c_str(), flags, 0644);
-  if (file_descriptor_ < 0) {
-    throw std::runtime_error("Failed to open: " + filepath);
-  }
-
-  // Initialize buffers based on O_DIRECT requirement
-  if (use_direct_io) {
-    init_aligned_buffers();
-  } else {
-    // Pre-allocate regular buffer pool
-    for (auto& buf : buffer_pool_) {
-      buf.reserve(BUFFER_SIZE);
-    }
-  }
+    : filepath_(filepath) {
+  stream_config_.direct_io = use_direct_io;
 }
 
 CSVWriter::~CSVWriter() {
@@ -44,138 +19,37 @@ CSVWriter::~CSVWriter() {
   } catch (...) {
     // Suppress exceptions in destructor
   }
-  if (file_descriptor_ >= 0) {
-    ::close(file_descriptor_);
-  }
 }
 
-void CSVWriter::init_aligned_buffers() {
-  // Allocate aligned buffers for O_DIRECT
-  for (auto& buf : buffer_pool_) {
-    void* ptr = nullptr;
-    int ret = ::posix_memalign(&ptr, ALIGNMENT, BUFFER_SIZE);
-    if (ret != 0) {
-      throw std::runtime_error("posix_memalign failed: " + std::string(strerror(ret)));
-    }
-    if (ptr == nullptr) {
-      throw std::runtime_error("posix_memalign returned null");
-    }
-    // Wrap aligned memory in vector (takes ownership)
-    buf.assign(static_cast<uint8_t*>(ptr), static_cast<uint8_t*>(ptr) + BUFFER_SIZE);
-  }
+void CSVWriter::open_default_stream() {
+  // Synchronous mode (no ring): one staging buffer flushed with pwrite
+  stream_ = std::make_shared<IoUringOutputStream>(filepath_, nullptr, stream_config_);
 }
 
 void CSVWriter::enable_direct_io(bool enable) {
   if (header_written_) {
     throw std::runtime_error("Cannot enable O_DIRECT after writing has begun");
   }
-  use_direct_io_ = enable;
-
-  if (enable && file_descriptor_ >= 0) {
-    // Re-open file with O_DIRECT flag if not already set
-    ::close(file_descriptor_);
-    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT;
-    file_descriptor_ = ::open(filepath_.c_str(), flags, 0644);
-    if (file_descriptor_ < 0) {
-      throw std::runtime_error("Failed to re-open with O_DIRECT: " + filepath_);
-    }
-    init_aligned_buffers();
-  }
-}
-
-void CSVWriter::set_async_context(std::shared_ptr<AsyncIOContext> context) {
-  async_context_ = context;
-}
-
-size_t CSVWriter::acquire_buffer() {
-  // Find free buffer, or wait for completion if all in-flight
-  for (size_t i = 0; i < NUM_BUFFERS; ++i) {
-    if (!buffer_in_flight_[i]) {
-      buffer_in_flight_[i] = true;
-      return i;
-    }
-  }
-  // All buffers in-flight - wait for at least one completion
-  wait_for_completion();
-  return acquire_buffer();  // Retry
-}
-
-void CSVWriter::wait_for_completion() {
-  if (!async_context_) return;
-  std::vector<uint64_t> completed_ids;
-  async_context_->wait_completions(1, &completed_ids);
-  // Release completed buffers based on user_data (buffer index)
-  for (uint64_t buf_idx : completed_ids) {
-    if (buf_idx < NUM_BUFFERS) {
-      release_buffer(buf_idx);
-    }
+  if (injected_) {
+    throw std::runtime_error("Cannot enable O_DIRECT on an injected output stream");
   }
+  stream_config_.direct_io = enable;
 }
 
-void CSVWriter::release_buffer(size_t idx) {
-  if (idx < NUM_BUFFERS) {
-    buffer_in_flight_[idx] = false;
-    buffer_pool_[idx].clear();
+bool CSVWriter::set_output_stream_factory(OutputStreamFactory factory) {
+  if (header_written_) {
+    throw std::runtime_error("Cannot replace the CSV output stream after writing has begun");
   }
+  stream_ = factory(filepath_);
+  injected_ = true;
+  return true;
 }
 
 void CSVWriter::write_data(const void* data, size_t size) {
-  const uint8_t* byte_data = static_cast<const uint8_t*>(data);
-  size_t written = 0;
-
-  while (written < size) {
-    auto& buffer = buffer_pool_[current_buffer_idx_];
-    size_t available = BUFFER_SIZE - buffer_fill_size_;
-    size_t to_write = std::min(available, size - written);
-
-    // Add data to current buffer
-    buffer.insert(buffer.end(),
-                 byte_data + written,
-                 byte_data + written + to_write);
-    buffer_fill_size_ += to_write;
-    written += to_write;
-
-    // Submit if buffer is full
-    if (buffer_fill_size_ >= BUFFER_SIZE) {
-      flush_buffer();
-    }
-  }
-}
-
-void CSVWriter::flush_buffer() {
-  if (buffer_fill_size_ == 0) return;
-
-  size_t buf_idx = current_buffer_idx_;
-  auto& buffer = buffer_pool_[buf_idx];
-
-  if (!async_context_) {
-    // Use pwrite for sync (NOT ofstream)
-    ssize_t written = ::pwrite(file_descriptor_,
-                              buffer.data(),
-                              buffer_fill_size_,
-                              current_offset_);
-    if (written < 0) {
-      throw std::runtime_error("Write failed: " + std::string(strerror(errno)));
-    }
-    current_offset_ += written;
-    buffer.clear();
-    buffer_fill_size_ = 0;
-    return;
+  auto status = stream_->Write(data, static_cast<int64_t>(size));
+  if (!status.ok()) {
+    throw std::runtime_error("CSV write failed: " + status.ToString());
   }
-
-  // Submit async write with buffer index as user_data for tracking
-  // Buffer stays valid until completion callback
-  async_context_->queue_write(file_descriptor_,
-                             buffer.data(),
-                             buffer_fill_size_,
-                             current_offset_,
-                             static_cast<uint64_t>(buf_idx));  // Use buffer index as user_data
-  async_context_->submit_queued();  // Submit immediately
-  current_offset_ += buffer_fill_size_;
-
-  // Get next buffer (don't clear current - it's in-flight!)
-  current_buffer_idx_ = acquire_buffer();
-  buffer_fill_size_ = 0;
 }
 
 void CSVWriter::write_header(
@@ -223,9 +97,12 @@ std::string CSVWriter::escape_csv_value(const std::string& value) {
 
 void CSVWriter::write_batch(
     const std::shared_ptr<arrow::RecordBatch>& batch) {
-  if (file_descriptor_ < 0) {
+  if (closed_) {
     throw std::runtime_error("CSV output file is not open");
   }
+  if (!stream_) {
+    open_default_stream();
+  }
 
   // Write header on first batch
   if (!header_written_) {
@@ -290,21 +167,16 @@ void CSVWriter::write_batch(
 }
 
 void CSVWriter::close() {
-  // Flush current buffer if has data
-  if (buffer_fill_size_ > 0) {
-    flush_buffer();
+  if (closed_) {
+    return;
   }
-
-  // Wait for ALL in-flight operations
-  if (async_context_) {
-    async_context_->flush();
+  if (!stream_) {
+    open_default_stream();  // no batches: still leave an empty file behind
   }
-
-  // Sync file data to disk
-  if (file_descriptor_ >= 0) {
-    ::fsync(file_descriptor_);
-    ::close(file_descriptor_);
-    file_descriptor_ = -1;
+  closed_ = true;
+  auto status = stream_->Close();
+  if (!status.ok()) {
+    throw std::runtime_error("CSV close failed: " + status.ToString());
   }
 }
 
@@ -7,13 +7,15 @@
 //   • manifest_entry (per-data-file entries inside each manifest)
 //
 // Encoding subset covered:
-//   null, int, long, string, bytes, union<null, T>, empty record, empty array
+//   null, int, long, string, bytes, union<null, T>, records, arrays (Iceberg
+//   maps are arrays of key/value records)
 //
 // Reference: https://avro.apache.org/docs/1.11.1/specification/
 #pragma once
 
 #include <array>
 #include <cstdint>
+#include <map>
 #include <fstream>
 #include <random>
 #include <stdexcept>
@@ -73,6 +75,20 @@ inline void enc_union_int(int32_t v, std::vector<uint8_t>& buf) {
     enc_int(v, buf);
 }
 
+// union[null, T]: discriminant 1 → the caller encodes the value next
+inline void enc_union_value(std::vector<uint8_t>& buf) {
+    enc_long(1, buf);
+}
+
+// Array header for a single block of count items; enc_array_end() follows them
+inline void enc_array_start(size_t count, std::vector<uint8_t>& buf) {
+    if (count > 0) enc_long(static_cast<int64_t>(count), buf);
+}
+
+inline void enc_array_end(std::vector<uint8_t>& buf) {
+    enc_long(0, buf);
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Avro object-container file writer
 // ─────────────────────────────────────────────────────────────────────────────
@@ -92,6 +108,11 @@ public:
         for (auto& b : sync_marker_) b = static_cast<uint8_t>(dis(gen));
     }
 
+    // Extra file metadata (Iceberg: schema, partition-spec, ...), stored as bytes.
+    void set_metadata(const std::string& key, std::string value) {
+        metadata_[key] = std::move(value);
+    }
+
     // Add one fully-encoded record (must match the schema passed to constructor).
     void add_record(std::vector<uint8_t> record) {
         records_.push_back(std::move(record));
@@ -107,10 +128,10 @@ public:
         // Magic bytes
         f.write("Obj\x01", 4);
 
-        // File metadata: Avro map<string,bytes>  (2 entries)
+        // File metadata: Avro map<string,bytes>  (2 entries + extras)
         {
             std::vector<uint8_t> meta;
-            enc_long(2, meta);                           // block count = 2
+            enc_long(static_cast<int64_t>(2 + metadata_.size()), meta);  // block count
 
             enc_string("avro.codec", meta);
             enc_bytes("null", 4, meta);
@@ -118,6 +139,11 @@ public:
             enc_string("avro.schema", meta);
             enc_bytes(schema_json_.data(), schema_json_.size(), meta);
 
+            for (const auto& [key, value] : metadata_) {
+                enc_string(key, meta);
+                enc_bytes(value.data(), value.size(), meta);
+            }
+
             enc_long(0, meta);                           // end of map
             f.write(reinterpret_cast<const char*>(meta.data()),
                     static_cast<std::streamsize>(meta.size()));
@@ -149,6 +175,7 @@ public:
 private:
     std::string                       schema_json_;
     std::array<uint8_t, 16>           sync_marker_{};
+    std::map<std::string, std::string> metadata_;
     std::vector<std::vector<uint8_t>> records_;
 };
 
@@ -3,8 +3,13 @@
 #ifdef TPCH_ENABLE_ICEBERG
 
 #include "iceberg_avro.hpp"
+#include "tpch/batch_sizer.hpp"
+#include "tpch/row_group_clusterer.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
@@ -18,9 +23,14 @@
 #include <arrow/api.h>
 #include <arrow/io/file.h>
 #include <parquet/arrow/writer.h>
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
+#include <nlohmann/json.hpp>
 
 namespace tpch {
 
+using json = nlohmann::json;
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Iceberg v1 Avro schemas (stored verbatim in each manifest file's header).
 //
@@ -43,29 +53,246 @@ static const char* MANIFEST_LIST_SCHEMA = R"json(
   {"name":"deleted_rows_count","type":["null","long"],"default":null,"field-id":514}
 ]})json";
 
-// Schema for entries inside each manifest file (manifest-1.avro).
-// Column-level statistics are omitted (all optional, default null); readers
-// fall back to full-table scans, which is acceptable for benchmark use.
-static const char* MANIFEST_ENTRY_SCHEMA = R"json(
-{"type":"record","name":"manifest_entry","fields":[
-  {"name":"status","type":"int","field-id":0},
-  {"name":"snapshot_id","type":["null","long"],"default":null,"field-id":1},
-  {"name":"data_file","type":{
-    "type":"record","name":"r2","fields":[
-      {"name":"file_path","type":"string","field-id":100},
-      {"name":"file_format","type":"string","field-id":101},
-      {"name":"partition","type":{"type":"record","name":"r102","fields":[]},"field-id":102},
-      {"name":"record_count","type":"long","field-id":103},
-      {"name":"file_size_in_bytes","type":"long","field-id":104},
-      {"name":"block_size_in_bytes","type":"long","field-id":105}
-    ]
-  },"field-id":2}
-]})json";
+// Maps of the data_file record (column id → value), as Iceberg encodes them:
+// arrays of key/value records with field ids of their own.
+static const char* DATA_FILE_STATS_FIELDS = R"json(,
+      {"name":"column_sizes","type":["null",{"type":"array","items":{"type":"record","name":"k117_v118","fields":[
+        {"name":"key","type":"int","field-id":117},{"name":"value","type":"long","field-id":118}]},"logicalType":"map"}],"default":null,"field-id":108},
+      {"name":"value_counts","type":["null",{"type":"array","items":{"type":"record","name":"k119_v120","fields":[
+        {"name":"key","type":"int","field-id":119},{"name":"value","type":"long","field-id":120}]},"logicalType":"map"}],"default":null,"field-id":109},
+      {"name":"null_value_counts","type":["null",{"type":"array","items":{"type":"record","name":"k121_v122","fields":[
+        {"name":"key","type":"int","field-id":121},{"name":"value","type":"long","field-id":122}]},"logicalType":"map"}],"default":null,"field-id":110},
+      {"name":"lower_bounds","type":["null",{"type":"array","items":{"type":"record","name":"k126_v127","fields":[
+        {"name":"key","type":"int","field-id":126},{"name":"value","type":"bytes","field-id":127}]},"logicalType":"map"}],"default":null,"field-id":125},
+      {"name":"upper_bounds","type":["null",{"type":"array","items":{"type":"record","name":"k129_v130","fields":[
+        {"name":"key","type":"int","field-id":129},{"name":"value","type":"bytes","field-id":130}]},"logicalType":"map"}],"default":null,"field-id":128})json";
+
+// Partition field ids start here, as in Iceberg's PartitionSpec
+static constexpr int32_t PARTITION_FIELD_ID_BASE = 1000;
+
+// Row groups are capped at this many Arrow bytes (and at the target file size)
+static constexpr int64_t ROW_GROUP_BYTES = 128LL << 20;
+
+// Iceberg's default metrics mode truncates string bounds to 16 characters
+static constexpr size_t STRING_BOUND_CHARS = 16;
+
+namespace {
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Partition transforms
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct CivilDate {
+    int64_t year;
+    int     month;  // 1..12
+    int     day;    // 1..31
+};
+
+// Days since 1970-01-01 → proleptic Gregorian date (H. Hinnant's civil_from_days)
+CivilDate civil_from_days(int64_t days) {
+    const int64_t z = days + 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    const int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    return {yoe + era * 400 + (month <= 2 ? 1 : 0), month, day};
+}
+
+std::string format_date(int64_t days) {
+    const auto d = civil_from_days(days);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04lld-%02d-%02d", static_cast<long long>(d.year), d.month, d.day);
+    return buf;
+}
+
+// Proleptic Gregorian date → days since 1970-01-01 (H. Hinnant's days_from_civil)
+int64_t days_from_civil(int64_t year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yoe = year - era * 400;
+    const int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// "YYYY-MM-DD" → days since the epoch
+int32_t parse_iso_date(const std::string& text) {
+    int year = 0, month = 0, day = 0, used = 0;
+    if (sscanf(text.c_str(), "%4d-%2d-%2d%n", &year, &month, &day, &used) != 3 ||
+        used != static_cast<int>(text.size()) || month < 1 || month > 12 || day < 1 || day > 31) {
+        throw std::invalid_argument("IcebergWriter: '" + text + "' is not a YYYY-MM-DD date");
+    }
+    return static_cast<int32_t>(days_from_civil(year, month, day));
+}
+
+int64_t floor_div(int64_t a, int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+}
+
+bool is_string_like(const arrow::DataType& type) {
+    if (type.id() == arrow::Type::DICTIONARY) {
+        return is_string_like(*static_cast<const arrow::DictionaryType&>(type).value_type());
+    }
+    return type.id() == arrow::Type::STRING || type.id() == arrow::Type::LARGE_STRING;
+}
+
+// Integer or date value of a non-null slot
+int64_t integer_at(const arrow::Array& array, int64_t i) {
+    const auto& data = *array.data();
+    switch (array.type_id()) {
+        case arrow::Type::INT8:   return data.GetValues<int8_t>(1)[i];
+        case arrow::Type::INT16:  return data.GetValues<int16_t>(1)[i];
+        case arrow::Type::INT32:
+        case arrow::Type::DATE32: return data.GetValues<int32_t>(1)[i];
+        default:                  return data.GetValues<int64_t>(1)[i];
+    }
+}
+
+std::string string_at(const arrow::Array& array, int64_t i) {
+    if (array.type_id() == arrow::Type::DICTIONARY) {
+        const auto& dict = static_cast<const arrow::DictionaryArray&>(array);
+        return string_at(*dict.dictionary(), dict.GetValueIndex(i));
+    }
+    if (array.type_id() == arrow::Type::LARGE_STRING) {
+        return static_cast<const arrow::LargeStringArray&>(array).GetString(i);
+    }
+    return static_cast<const arrow::StringArray&>(array).GetString(i);
+}
+
+// Partition path values are URL-encoded, like Iceberg's PartitionSpec.partitionToPath
+std::string escape_path(const std::string& value) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '*') {
+            out += static_cast<char>(c);
+        } else if (c == ' ') {
+            out += '+';
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    return out;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Column bounds
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Compare two plain-encoded Parquet statistics values of a physical type
+int compare_encoded(parquet::Type::type type, const std::string& a, const std::string& b) {
+    auto three_way = [](auto x, auto y) { return x < y ? -1 : (y < x ? 1 : 0); };
+    auto load = [](const std::string& s, auto value) {
+        std::memcpy(&value, s.data(), std::min(sizeof(value), s.size()));
+        return value;
+    };
+    switch (type) {
+        case parquet::Type::BOOLEAN: return three_way(load(a, uint8_t{0}) & 1, load(b, uint8_t{0}) & 1);
+        case parquet::Type::INT32:   return three_way(load(a, int32_t{0}), load(b, int32_t{0}));
+        case parquet::Type::INT64:   return three_way(load(a, int64_t{0}), load(b, int64_t{0}));
+        case parquet::Type::FLOAT:   return three_way(load(a, 0.0f), load(b, 0.0f));
+        case parquet::Type::DOUBLE:  return three_way(load(a, 0.0), load(b, 0.0));
+        case parquet::Type::FIXED_LEN_BYTE_ARRAY: {
+            // Decimals: big-endian two's complement of equal width
+            const bool neg_a = !a.empty() && (static_cast<uint8_t>(a[0]) & 0x80);
+            const bool neg_b = !b.empty() && (static_cast<uint8_t>(b[0]) & 0x80);
+            if (neg_a != neg_b) return neg_a ? -1 : 1;
+            return three_way(a.compare(b), 0);
+        }
+        default:
+            return three_way(a.compare(b), 0);  // unsigned byte order, like UTF-8 statistics
+    }
+}
+
+// Length of the UTF-8 sequence starting with byte c
+size_t utf8_length(unsigned char c) {
+    return c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 1;
+}
+
+std::string encode_utf8(uint32_t cp) {
+    std::string out;
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+uint32_t decode_utf8(const std::string& s, size_t pos, size_t len) {
+    const auto c = static_cast<unsigned char>(s[pos]);
+    uint32_t cp = len == 1 ? c : len == 2 ? (c & 0x1F) : len == 3 ? (c & 0x0F) : (c & 0x07);
+    for (size_t k = 1; k < len; ++k) {
+        cp = (cp << 6) | (static_cast<unsigned char>(s[pos + k]) & 0x3F);
+    }
+    return cp;
+}
+
+// Iceberg's truncate(16) metrics: a prefix is a lower bound; an upper bound
+// is the prefix with its last character incremented. False if there is none.
+bool truncate_string_bounds(std::string& lower, std::string& upper) {
+    auto prefix_end = [](const std::string& s, std::vector<size_t>* starts) {
+        size_t pos = 0;
+        for (size_t chars = 0; pos < s.size() && chars < STRING_BOUND_CHARS; ++chars) {
+            if (starts) starts->push_back(pos);
+            pos += utf8_length(static_cast<unsigned char>(s[pos]));
+        }
+        return std::min(pos, s.size());
+    };
+    lower.resize(prefix_end(lower, nullptr));
+
+    std::vector<size_t> starts;
+    const size_t end = prefix_end(upper, &starts);
+    if (end == upper.size()) {
+        return true;
+    }
+    while (!starts.empty()) {
+        const size_t pos = starts.back();
+        starts.pop_back();
+        const size_t len = utf8_length(static_cast<unsigned char>(upper[pos]));
+        uint32_t cp = decode_utf8(upper, pos, std::min(len, upper.size() - pos)) + 1;
+        if (cp == 0xD800) cp = 0xE000;  // skip surrogates
+        if (cp <= 0x10FFFF) {
+            upper = upper.substr(0, pos) + encode_utf8(cp);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Constructor
 // ─────────────────────────────────────────────────────────────────────────────
 
+// One partition of the table: its open data file and the rows of its next row group.
+struct IcebergWriter::Partition {
+    std::vector<PartitionValue> values;
+    std::string path;  // "" (unpartitioned) or "name=value/..." under data/
+    std::vector<std::shared_ptr<arrow::RecordBatch>> pending;
+    int64_t pending_bytes = 0;
+    std::shared_ptr<arrow::io::OutputStream> stream;
+    std::unique_ptr<parquet::arrow::FileWriter> writer;
+    std::string filename;  // relative to data/
+    int64_t file_rows = 0;
+};
+
 IcebergWriter::IcebergWriter(const std::string& table_path,
                               const std::string& table_name)
     : table_path_(table_path), table_name_(table_name) {
@@ -77,6 +304,8 @@ IcebergWriter::IcebergWriter(const std::string& table_path,
     }
 }
 
+IcebergWriter::~IcebergWriter() = default;
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Static helpers
 // ─────────────────────────────────────────────────────────────────────────────
@@ -124,6 +353,58 @@ int64_t IcebergWriter::current_timestamp_ms() {
     return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
 }
 
+std::vector<IcebergWriter::PartitionField> IcebergWriter::parse_partition_spec(const std::string& spec) {
+    std::vector<PartitionField> fields;
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (item.empty()) {
+            throw std::invalid_argument("empty partition field in '" + spec + "'");
+        }
+
+        PartitionField field;
+        const size_t open = item.find('(');
+        if (open == std::string::npos) {
+            field.source = item;
+            field.transform = "identity";
+        } else {
+            if (item.back() != ')' || open + 2 > item.size() - 1) {
+                throw std::invalid_argument("invalid partition field '" + item + "'");
+            }
+            field.source = item.substr(open + 1, item.size() - open - 2);
+            field.transform = item.substr(0, open);
+            if (field.transform.rfind("truncate[", 0) == 0 && field.transform.back() == ']') {
+                try {
+                    field.width = std::stoll(field.transform.substr(9, field.transform.size() - 10));
+                } catch (const std::exception&) {
+                    field.width = 0;
+                }
+                if (field.width <= 0) {
+                    throw std::invalid_argument("invalid truncate width in '" + item + "'");
+                }
+                field.transform = "truncate";
+            } else if (field.transform != "identity" && field.transform != "year" &&
+                       field.transform != "month" && field.transform != "day") {
+                throw std::invalid_argument("unknown partition transform in '" + item +
+                                            "' (identity, year, month, day, truncate[W])");
+            }
+        }
+        if (field.source.empty() || field.source.find_first_of("() \t") != std::string::npos) {
+            throw std::invalid_argument("invalid partition field '" + item + "'");
+        }
+        field.name = field.transform == "identity" ? field.source
+                   : field.transform == "truncate" ? field.source + "_trunc"
+                                                   : field.source + "_" + field.transform;
+        fields.push_back(std::move(field));
+    }
+    return fields;
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Table initialisation (first batch)
 // ─────────────────────────────────────────────────────────────────────────────
@@ -133,6 +414,59 @@ void IcebergWriter::initialize_iceberg_table(
 
     schema_ = first_batch->schema();
 
+    // Keep the spec fields this table has; check their transforms
+    std::vector<PartitionField> present;
+    for (auto& field : partition_fields_) {
+        const int index = schema_->GetFieldIndex(field.source);
+        if (index < 0) continue;
+        const auto& type = *schema_->field(index)->type();
+        bool supported = false;
+        if (field.transform == "identity") {
+            supported = arrow::is_integer(type.id()) || type.id() == arrow::Type::DATE32 ||
+                        is_string_like(type);
+        } else if (field.transform == "truncate") {
+            supported = type.id() == arrow::Type::INT32 || type.id() == arrow::Type::INT64;
+        } else if (is_string_like(type)) {
+            // Dates generated as "YYYY-MM-DD" strings become a date column
+            if (std::find(date_columns_.begin(), date_columns_.end(), index) == date_columns_.end())
+                date_columns_.push_back(index);
+            supported = true;
+        } else {
+            supported = type.id() == arrow::Type::DATE32;
+        }
+        if (!supported) {
+            throw std::invalid_argument("IcebergWriter: cannot partition by " + field.transform +
+                                        " of " + field.source + " (" + type.ToString() + ")");
+        }
+        partition_sources_.push_back(index);
+        present.push_back(std::move(field));
+    }
+    partition_fields_ = std::move(present);
+    for (int index : date_columns_) {
+        const auto& field = schema_->field(index);
+        schema_ = *schema_->SetField(index, arrow::field(field->name(), arrow::date32(),
+                                                         field->nullable(), field->metadata()));
+    }
+
+    // Parquet columns carry their Iceberg field IDs, so readers need no name mapping
+    arrow::FieldVector fields;
+    for (int i = 0; i < schema_->num_fields(); ++i) {
+        const auto& field = schema_->field(i);
+        auto metadata = field->HasMetadata() ? field->metadata()->Copy()
+                                             : std::make_shared<arrow::KeyValueMetadata>();
+        metadata->Append("PARQUET:field_id", std::to_string(i + 1));
+        fields.push_back(field->WithMetadata(metadata));
+    }
+    file_schema_ = arrow::schema(std::move(fields), schema_->metadata());
+
+    layout_.schema = schema_json();
+    layout_.last_column_id = schema_->num_fields();
+    layout_.partition_spec = partition_spec_json();
+    layout_.manifest_entry_schema = manifest_entry_schema();
+    for (int index : partition_sources_) {
+        layout_.string_partitions.push_back(is_string_like(*schema_->field(index)->type()));
+    }
+
     try {
         std::filesystem::create_directories(table_path_ + "/metadata");
         std::filesystem::create_directories(table_path_ + "/data");
@@ -141,64 +475,382 @@ void IcebergWriter::initialize_iceberg_table(
         throw std::runtime_error(
             std::string("IcebergWriter: cannot initialise table: ") + e.what());
     }
+    if (partition_fields_.empty()) {
+        partitions_.push_back(std::make_unique<Partition>());
+    }
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-// Data file writing (batches → Parquet)
+// Data file writing (batches → Parquet, streamed per partition)
 // ─────────────────────────────────────────────────────────────────────────────
 
-std::string IcebergWriter::write_data_file() {
-    if (batches_.empty()) return "";
+std::shared_ptr<arrow::RecordBatch> IcebergWriter::convert_dates(
+    const std::shared_ptr<arrow::RecordBatch>& batch) const {
+    auto columns = batch->columns();
+    for (int index : date_columns_) {
+        const auto& column = *columns[index];
+        arrow::Date32Builder builder;
+        auto st = builder.Reserve(column.length());
+        if (column.type_id() == arrow::Type::DICTIONARY) {
+            // Parse each dictionary value once, then map the indices
+            const auto& dict = static_cast<const arrow::DictionaryArray&>(column);
+            std::vector<int32_t> days(dict.dictionary()->length());
+            for (int64_t d = 0; d < dict.dictionary()->length(); ++d) {
+                if (dict.dictionary()->IsValid(d)) days[d] = parse_iso_date(string_at(*dict.dictionary(), d));
+            }
+            for (int64_t i = 0; st.ok() && i < column.length(); ++i) {
+                if (column.IsNull(i)) builder.UnsafeAppendNull();
+                else builder.UnsafeAppend(days[dict.GetValueIndex(i)]);
+            }
+        } else {
+            for (int64_t i = 0; st.ok() && i < column.length(); ++i) {
+                if (column.IsNull(i)) builder.UnsafeAppendNull();
+                else builder.UnsafeAppend(parse_iso_date(string_at(column, i)));
+            }
+        }
+        std::shared_ptr<arrow::Array> dates;
+        if (st.ok()) st = builder.Finish(&dates);
+        if (!st.ok())
+            throw std::runtime_error("IcebergWriter: cannot convert dates: " + st.ToString());
+        columns[index] = std::move(dates);
+    }
+    return arrow::RecordBatch::Make(schema_, batch->num_rows(), std::move(columns));
+}
+
+IcebergWriter::Partition& IcebergWriter::partition_of(const arrow::RecordBatch& batch,
+                                                       int64_t i, std::string& key) {
+    std::vector<PartitionValue> values(partition_fields_.size());
+    key.clear();
+    for (size_t f = 0; f < partition_fields_.size(); ++f) {
+        const auto& field = partition_fields_[f];
+        const auto& column = *batch.column(partition_sources_[f]);
+        auto& value = values[f];
+        value.is_null = column.IsNull(i);
+        if (!value.is_null) {
+            if (is_string_like(*column.type())) {
+                value.text = string_at(column, i);
+            } else {
+                const int64_t v = integer_at(column, i);
+                if (field.transform == "year") {
+                    value.number = civil_from_days(v).year - 1970;
+                } else if (field.transform == "month") {
+                    const auto d = civil_from_days(v);
+                    value.number = (d.year - 1970) * 12 + d.month - 1;
+                } else if (field.transform == "truncate") {
+                    value.number = floor_div(v, field.width) * field.width;
+                } else {
+                    value.number = v;  // identity, day
+                }
+            }
+        }
+        key += value.is_null ? '\0' : '\1';
+        key.append(reinterpret_cast<const char*>(&value.number), sizeof(value.number));
+        key += value.text;
+        key += '\0';
+    }
+
+    auto found = partition_index_.find(key);
+    if (found != partition_index_.end()) {
+        return *partitions_[found->second];
+    }
+
+    auto partition = std::make_unique<Partition>();
+    for (size_t f = 0; f < partition_fields_.size(); ++f) {
+        const auto& field = partition_fields_[f];
+        const auto& value = values[f];
+        std::string human;
+        if (value.is_null) {
+            human = "null";
+        } else if (!value.text.empty() || is_string_like(*schema_->field(partition_sources_[f])->type())) {
+            human = escape_path(value.text);
+        } else if (field.transform == "year") {
+            human = std::to_string(1970 + value.number);
+        } else if (field.transform == "month") {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%04lld-%02lld", static_cast<long long>(1970 + floor_div(value.number, 12)),
+                     static_cast<long long>(value.number - floor_div(value.number, 12) * 12 + 1));
+            human = buf;
+        } else if (field.transform == "day" ||
+                   schema_->field(partition_sources_[f])->type()->id() == arrow::Type::DATE32) {
+            human = format_date(value.number);
+        } else {
+            human = std::to_string(value.number);
+        }
+        partition->path += (f ? "/" : "") + field.name + "=" + human;
+    }
+    partition->values = std::move(values);
+    try {
+        std::filesystem::create_directories(table_path_ + "/data/" + partition->path);
+    } catch (const std::exception& e) {
+        throw std::runtime_error(std::string("IcebergWriter: cannot create partition directory: ") + e.what());
+    }
+    partition_index_.emplace(key, partitions_.size());
+    partitions_.push_back(std::move(partition));
+    return *partitions_.back();
+}
+
+void IcebergWriter::add_rows(Partition& partition, const std::shared_ptr<arrow::RecordBatch>& rows) {
+    const int64_t bytes = measure_batch_bytes(*rows);
+    partition.pending.push_back(rows);
+    partition.pending_bytes += bytes;
+    buffered_bytes_ += bytes;
+
+    if (partition.pending_bytes >= std::min(ROW_GROUP_BYTES, target_file_size_)) {
+        write_row_group(partition);
+    }
+    // Over the buffer: the partition holding the most rows goes out as a smaller row group
+    while (buffered_bytes_ > write_buffer_size_) {
+        Partition* largest = nullptr;
+        for (auto& p : partitions_) {
+            if (!largest || p->pending_bytes > largest->pending_bytes) largest = p.get();
+        }
+        write_row_group(*largest);
+    }
+}
 
+void IcebergWriter::open_data_file(Partition& partition) {
     std::ostringstream name_ss;
-    name_ss << "data_" << std::setfill('0') << std::setw(5) << file_count_ << ".parquet";
-    std::string filename = name_ss.str();
-    std::string filepath = table_path_ + "/data/" + filename;
+    name_ss << "data_" << (writer_id_.empty() ? "" : writer_id_ + "_")
+            << std::setfill('0') << std::setw(5) << file_count_ << ".parquet";
+    partition.filename = partition.path.empty() ? name_ss.str() : partition.path + "/" + name_ss.str();
+    std::string filepath = table_path_ + "/data/" + partition.filename;
+    ++file_count_;
+
+    if (stream_factory_) {
+        partition.stream = stream_factory_(filepath);
+    } else {
+        auto file_result = arrow::io::FileOutputStream::Open(filepath);
+        if (!file_result.ok())
+            throw std::runtime_error("IcebergWriter: cannot open " + filepath + ": "
+                                     + file_result.status().ToString());
+        partition.stream = file_result.ValueOrDie();
+    }
 
-    // Count rows before clearing batches_
-    int64_t rows = 0;
-    for (const auto& b : batches_) rows += b->num_rows();
+    auto writer_result = parquet::arrow::FileWriter::Open(
+        *file_schema_, arrow::default_memory_pool(), partition.stream);
+    if (!writer_result.ok())
+        throw std::runtime_error("IcebergWriter: cannot start Parquet file: "
+                                 + writer_result.status().ToString());
+    partition.writer = std::move(*writer_result);
+    partition.file_rows = 0;
+}
 
-    // Combine batches into a table and write Parquet
-    auto table_result = arrow::Table::FromRecordBatches(batches_);
+void IcebergWriter::write_row_group(Partition& partition) {
+    if (partition.pending.empty()) return;
+    if (!partition.writer) open_data_file(partition);
+
+    auto table_result = arrow::Table::FromRecordBatches(schema_, partition.pending);
     if (!table_result.ok())
         throw std::runtime_error("IcebergWriter: cannot create Arrow table: "
                                  + table_result.status().ToString());
     auto table = table_result.ValueOrDie();
 
-    auto file_result = arrow::io::FileOutputStream::Open(filepath);
-    if (!file_result.ok())
-        throw std::runtime_error("IcebergWriter: cannot open " + filepath + ": "
-                                 + file_result.status().ToString());
-    auto file = file_result.ValueOrDie();
-
-    auto st = parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), file);
+    // Whole row groups, written through: nothing stays buffered in the writer
+    auto st = partition.writer->WriteTable(*table, table->num_rows());
     if (!st.ok())
         throw std::runtime_error("IcebergWriter: Parquet write failed: " + st.ToString());
 
-    auto close_st = file->Close();
+    partition.file_rows += table->num_rows();
+    buffered_bytes_ -= partition.pending_bytes;
+    partition.pending.clear();
+    partition.pending_bytes = 0;
+
+    if (partition.stream->Tell().ValueOr(0) >= target_file_size_) {
+        close_data_file(partition);
+    }
+}
+
+void IcebergWriter::close_data_file(Partition& partition) {
+    auto st = partition.writer->Close();
+    if (!st.ok())
+        throw std::runtime_error("IcebergWriter: Parquet write failed: " + st.ToString());
+    auto metadata = partition.writer->metadata();
+    partition.writer.reset();
+
+    // Record per-file metadata; Tell() is exact even when the bytes are
+    // still queued in an io_uring or I/O-process stream
+    auto size_result = partition.stream->Tell();
+    if (!size_result.ok())
+        throw std::runtime_error("IcebergWriter: file size unknown: " + size_result.status().ToString());
+    int64_t fsize = *size_result;
+
+    auto close_st = partition.stream->Close();
+    partition.stream.reset();
     if (!close_st.ok())
         throw std::runtime_error("IcebergWriter: file close failed: " + close_st.ToString());
 
-    // Record per-file metadata (need actual size after flush)
-    int64_t fsize = static_cast<int64_t>(std::filesystem::file_size(filepath));
+    row_count_ += partition.file_rows;
+    written_files_.push_back({partition.filename, partition.file_rows, fsize, partition.values,
+                              metadata ? column_stats(*metadata) : std::vector<ColumnStats>{}});
+}
 
-    row_count_ += rows;
-    written_files_.push_back({filename, rows, fsize});
-    ++file_count_;
-    batches_.clear();
+std::vector<IcebergWriter::ColumnStats> IcebergWriter::column_stats(
+    const parquet::FileMetaData& metadata) const {
+    std::vector<ColumnStats> stats;
+    if (metadata.num_columns() != schema_->num_fields()) {
+        return stats;  // nested columns: leaves do not map to fields one to one
+    }
+    for (int c = 0; c < metadata.num_columns(); ++c) {
+        ColumnStats column;
+        column.field_id = c + 1;
+        column.column_size = 0;
+        column.value_count = 0;
+        column.null_count = 0;
+        const auto physical = metadata.schema()->Column(c)->physical_type();
+        auto type = schema_->field(c)->type();
+        if (type->id() == arrow::Type::DICTIONARY) {
+            type = static_cast<const arrow::DictionaryType&>(*type).value_type();
+        }
+        // Timestamps: Parquet's unit need not be Iceberg's microseconds
+        bool bounds = type->id() != arrow::Type::TIMESTAMP;
+        bool seen = false;
+        std::string lower, upper;
+
+        for (int g = 0; g < metadata.num_row_groups(); ++g) {
+            auto chunk = metadata.RowGroup(g)->ColumnChunk(c);
+            column.column_size += chunk->total_compressed_size();
+            column.value_count += chunk->num_values();
+            auto chunk_stats = chunk->is_stats_set() ? chunk->statistics() : nullptr;
+            if (!chunk_stats || !chunk_stats->HasNullCount()) {
+                column.null_count = -1;  // unknown: left out of the manifest
+                bounds = false;
+                continue;
+            }
+            if (column.null_count >= 0) column.null_count += chunk_stats->null_count();
+            if (!chunk_stats->HasMinMax()) {
+                bounds = bounds && chunk_stats->null_count() == chunk->num_values();
+                continue;
+            }
+            const std::string min = chunk_stats->EncodeMin();
+            const std::string max = chunk_stats->EncodeMax();
+            if (!seen || compare_encoded(physical, min, lower) < 0) lower = min;
+            if (!seen || compare_encoded(physical, max, upper) > 0) upper = max;
+            seen = true;
+        }
+
+        if (bounds && seen) {
+            if (physical == parquet::Type::BYTE_ARRAY && is_string_like(*type)) {
+                bounds = truncate_string_bounds(lower, upper);
+            } else if (physical == parquet::Type::BYTE_ARRAY) {
+                bounds = false;  // binary: not truncated here, so not recorded
+            }
+            if (bounds) {
+                column.has_bounds = true;
+                column.lower_bound = std::move(lower);
+                column.upper_bound = std::move(upper);
+            }
+        }
+        stats.push_back(std::move(column));
+    }
+    return stats;
+}
+
+bool IcebergWriter::set_output_stream_factory(OutputStreamFactory factory) {
+    if (schema_locked_)
+        throw std::runtime_error("IcebergWriter: output stream factory must be set before the first write");
+    stream_factory_ = std::move(factory);
+    return true;
+}
+
+void IcebergWriter::set_partition_spec(const std::string& spec) {
+    if (schema_locked_)
+        throw std::runtime_error("IcebergWriter: partition spec must be set before the first write");
+    partition_fields_ = parse_partition_spec(spec);
+}
+
+void IcebergWriter::set_target_file_size(int64_t bytes) {
+    if (bytes <= 0)
+        throw std::invalid_argument("IcebergWriter: target file size must be positive");
+    target_file_size_ = bytes;
+}
 
-    return filepath;
+void IcebergWriter::set_write_buffer_size(int64_t bytes) {
+    if (bytes <= 0)
+        throw std::invalid_argument("IcebergWriter: write buffer size must be positive");
+    write_buffer_size_ = bytes;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
 // Avro manifest file  (manifest-1.avro)
 // ─────────────────────────────────────────────────────────────────────────────
 
+std::string IcebergWriter::schema_json() const {
+    std::ostringstream j;
+    j << "{\"type\": \"struct\", \"schema-id\": 0, \"fields\": [";
+    for (int i = 0; i < schema_->num_fields(); ++i) {
+        const auto& f = schema_->field(i);
+        j << (i ? ", " : "")
+          << "{\"id\": " << (i + 1)   // 1-based field IDs
+          << ", \"name\": \"" << f->name() << "\""
+          << ", \"required\": " << (!f->nullable() ? "true" : "false")
+          << ", \"type\": \"" << arrow_type_to_iceberg_type(f->type()) << "\"}";
+    }
+    j << "]}";
+    return j.str();
+}
+
+std::string IcebergWriter::partition_spec_json() const {
+    std::ostringstream j;
+    j << "[";
+    for (size_t f = 0; f < partition_fields_.size(); ++f) {
+        const auto& field = partition_fields_[f];
+        j << (f ? ", " : "")
+          << "{\"name\": \"" << field.name << "\", \"transform\": \""
+          << (field.transform == "truncate" ? "truncate[" + std::to_string(field.width) + "]"
+                                            : field.transform)
+          << "\", \"source-id\": " << (partition_sources_[f] + 1)
+          << ", \"field-id\": " << (PARTITION_FIELD_ID_BASE + static_cast<int32_t>(f)) << "}";
+    }
+    j << "]";
+    return j.str();
+}
+
+std::string IcebergWriter::manifest_entry_schema() const {
+    std::ostringstream j;
+    j << R"json({"type":"record","name":"manifest_entry","fields":[
+  {"name":"status","type":"int","field-id":0},
+  {"name":"snapshot_id","type":["null","long"],"default":null,"field-id":1},
+  {"name":"data_file","type":{
+    "type":"record","name":"r2","fields":[
+      {"name":"file_path","type":"string","field-id":100},
+      {"name":"file_format","type":"string","field-id":101},
+      {"name":"partition","type":{"type":"record","name":"r102","fields":[)json";
+    for (size_t f = 0; f < partition_fields_.size(); ++f) {
+        const auto& field = partition_fields_[f];
+        const auto& source = *schema_->field(partition_sources_[f])->type();
+        std::string type = "\"int\"";
+        if (is_string_like(source)) {
+            type = "\"string\"";
+        } else if (field.transform == "day" ||
+                   (field.transform == "identity" && source.id() == arrow::Type::DATE32)) {
+            type = R"({"type":"int","logicalType":"date"})";
+        } else if ((field.transform == "identity" || field.transform == "truncate") &&
+                   source.id() == arrow::Type::INT64) {
+            type = "\"long\"";
+        }
+        j << (f ? "," : "") << "\n        {\"name\":\"" << field.name << "\",\"type\":[\"null\","
+          << type << "],\"default\":null,\"field-id\":" << (PARTITION_FIELD_ID_BASE + static_cast<int32_t>(f))
+          << "}";
+    }
+    j << R"json(]},"field-id":102},
+      {"name":"record_count","type":"long","field-id":103},
+      {"name":"file_size_in_bytes","type":"long","field-id":104},
+      {"name":"block_size_in_bytes","type":"long","field-id":105})json"
+      << DATA_FILE_STATS_FIELDS << R"json(
+    ]
+  },"field-id":2}
+]})json";
+    return j.str();
+}
+
 std::pair<std::string, int64_t> IcebergWriter::write_manifest_avro() const {
     std::string manifest_path = table_path_ + "/metadata/manifest-1.avro";
 
-    avro::FileWriter fw(MANIFEST_ENTRY_SCHEMA);
+    avro::FileWriter fw(layout_.manifest_entry_schema);
+    fw.set_metadata("schema", layout_.schema);
+    fw.set_metadata("partition-spec", layout_.partition_spec);
+    fw.set_metadata("partition-spec-id", "0");
+    fw.set_metadata("format-version", "1");
 
     for (const auto& info : written_files_) {
         std::vector<uint8_t> rec;
@@ -210,11 +862,67 @@ std::pair<std::string, int64_t> IcebergWriter::write_manifest_avro() const {
         std::string abs_path = table_path_ + "/data/" + info.filename;
         avro::enc_string(abs_path, rec);                     // file_path
         avro::enc_string("PARQUET", rec);                    // file_format (string)
-        // partition record (r102) is empty — zero bytes
+
+        // partition record (r102): one union<null, T> per field
+        for (size_t f = 0; f < info.partition.size(); ++f) {
+            const auto& value = info.partition[f];
+            if (value.is_null) {
+                avro::enc_null_union(rec);
+                continue;
+            }
+            avro::enc_union_value(rec);
+            if (layout_.string_partitions[f]) {
+                avro::enc_string(value.text, rec);
+            } else {
+                avro::enc_long(value.number, rec);           // int and long share the varint
+            }
+        }
         avro::enc_long(info.record_count, rec);              // record_count
         avro::enc_long(info.file_size,    rec);              // file_size_in_bytes
         avro::enc_long(67108864LL,        rec);              // block_size_in_bytes (64 MiB, v1 legacy)
 
+        // column_sizes, value_counts, null_value_counts: map<int, long>
+        auto put_counts = [&](auto value_of, auto present) {
+            size_t count = 0;
+            for (const auto& c : info.columns) count += present(c) ? 1 : 0;
+            if (count == 0) {
+                avro::enc_null_union(rec);
+                return;
+            }
+            avro::enc_union_value(rec);
+            avro::enc_array_start(count, rec);
+            for (const auto& c : info.columns) {
+                if (!present(c)) continue;
+                avro::enc_int(c.field_id, rec);
+                avro::enc_long(value_of(c), rec);
+            }
+            avro::enc_array_end(rec);
+        };
+        auto always = [](const ColumnStats&) { return true; };
+        put_counts([](const ColumnStats& c) { return c.column_size; }, always);
+        put_counts([](const ColumnStats& c) { return c.value_count; }, always);
+        put_counts([](const ColumnStats& c) { return c.null_count; },
+                   [](const ColumnStats& c) { return c.null_count >= 0; });
+
+        // lower_bounds, upper_bounds: map<int, bytes>
+        for (bool lower : {true, false}) {
+            size_t count = 0;
+            for (const auto& c : info.columns) count += c.has_bounds ? 1 : 0;
+            if (count == 0) {
+                avro::enc_null_union(rec);
+                continue;
+            }
+            avro::enc_union_value(rec);
+            avro::enc_array_start(count, rec);
+            for (const auto& c : info.columns) {
+                if (!c.has_bounds) continue;
+                const std::string& bound = lower ? c.lower_bound : c.upper_bound;
+                avro::enc_int(c.field_id, rec);
+                avro::enc_bytes(bound.data(), bound.size(), rec);
+            }
+            avro::enc_array_end(rec);
+        }
+
         fw.add_record(std::move(rec));
     }
 
@@ -264,35 +972,25 @@ void IcebergWriter::write_metadata_json(const std::string& manifest_list_path) c
     int64_t ts = current_timestamp_ms();
     std::ostringstream j;
 
+    int64_t added_records = 0;
+    for (const auto& info : written_files_) added_records += info.record_count;
+    const std::string& spec = layout_.partition_spec;
+
     j << "{\n"
       << "  \"format-version\": 1,\n"
       << "  \"table-uuid\": \"" << generate_uuid() << "\",\n"
       << "  \"location\": \"" << table_path_ << "\",\n"
       << "  \"last-updated-ms\": " << ts << ",\n"
          // Field IDs are 1-based: highest assigned ID == num_fields().
-      << "  \"last-column-id\": " << schema_->num_fields() << ",\n"
-      << "  \"schema\": {\n"
-      << "    \"type\": \"struct\",\n"
-      << "    \"schema-id\": 0,\n"
-      << "    \"fields\": [\n";
-
-    for (int i = 0; i < schema_->num_fields(); ++i) {
-        const auto& f = schema_->field(i);
-        j << "      {\n"
-          << "        \"id\": " << (i + 1) << ",\n"   // 1-based field IDs
-          << "        \"name\": \"" << f->name() << "\",\n"
-          << "        \"required\": " << (!f->nullable() ? "true" : "false") << ",\n"
-          << "        \"type\": \"" << arrow_type_to_iceberg_type(f->type()) << "\"\n"
-          << "      }";
-        if (i < schema_->num_fields() - 1) j << ",";
-        j << "\n";
-    }
-
-    j << "    ]\n"
-      << "  },\n"
-      // Partition spec: one spec with no fields (unpartitioned table)
-      << "  \"partition-specs\": [{\"spec-id\": 0, \"fields\": []}],\n"
+      << "  \"last-column-id\": " << layout_.last_column_id << ",\n"
+      << "  \"schema\": " << layout_.schema << ",\n"
+      // v1 keeps the current spec's fields in partition-spec as well
+      << "  \"partition-spec\": " << spec << ",\n"
+      << "  \"partition-specs\": [{\"spec-id\": 0, \"fields\": " << spec << "}],\n"
       << "  \"current-spec-id\": 0,\n"
+      << "  \"last-partition-id\": "
+      << (PARTITION_FIELD_ID_BASE - 1 + static_cast<int32_t>(layout_.string_partitions.size()))
+      << ",\n"
       // Sort order: unsorted (order-id 0)
       << "  \"sort-orders\": [{\"order-id\": 0, \"fields\": []}],\n"
       << "  \"default-sort-order-id\": 0,\n"
@@ -302,7 +1000,11 @@ void IcebergWriter::write_metadata_json(const std::string& manifest_list_path) c
       << "    {\n"
       << "      \"snapshot-id\": " << current_snapshot_id_ << ",\n"
       << "      \"timestamp-ms\": " << ts << ",\n"
-      << "      \"summary\": {\"operation\": \"append\"},\n"
+      << "      \"summary\": {\"operation\": \"append\""
+      << ", \"added-data-files\": \"" << written_files_.size() << "\""
+      << ", \"added-records\": \"" << added_records << "\""
+      << ", \"total-data-files\": \"" << written_files_.size() << "\""
+      << ", \"total-records\": \"" << added_records << "\"},\n"
       << "      \"manifest-list\": \"" << manifest_list_path << "\"\n"
       << "    }\n"
       << "  ],\n"
@@ -330,46 +1032,244 @@ void IcebergWriter::write_version_hint() const {
     f << "1\n";
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// Deferred commit  (_pending/<writer-id>.json)
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+
+std::string to_hex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes) {
+        hex += digits[c >> 4];
+        hex += digits[c & 15];
+    }
+    return hex;
+}
+
+std::string from_hex(const std::string& hex) {
+    std::string bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+}  // namespace
+
+void IcebergWriter::set_deferred_commit(const std::string& writer_id) {
+    if (schema_locked_)
+        throw std::runtime_error("IcebergWriter: deferred commit must be set before the first write");
+    if (writer_id.empty() || writer_id[0] == '.' ||
+        writer_id.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_.-")
+            != std::string::npos)
+        throw std::invalid_argument("IcebergWriter: invalid writer id '" + writer_id + "'");
+    writer_id_ = writer_id;
+}
+
+void IcebergWriter::write_pending() const {
+    json files = json::array();
+    for (const auto& info : written_files_) {
+        json partition = json::array();
+        for (size_t f = 0; f < info.partition.size(); ++f) {
+            const auto& value = info.partition[f];
+            if (value.is_null) partition.push_back(nullptr);
+            else if (layout_.string_partitions[f]) partition.push_back(value.text);
+            else partition.push_back(value.number);
+        }
+        json columns = json::array();
+        for (const auto& c : info.columns) {
+            json column = {{"id", c.field_id}, {"size", c.column_size},
+                           {"values", c.value_count}, {"nulls", c.null_count}};
+            if (c.has_bounds) {
+                column["lower"] = to_hex(c.lower_bound);
+                column["upper"] = to_hex(c.upper_bound);
+            }
+            columns.push_back(std::move(column));
+        }
+        files.push_back({{"path", info.filename}, {"records", info.record_count},
+                         {"size", info.file_size}, {"partition", std::move(partition)},
+                         {"columns", std::move(columns)}});
+    }
+    const json pending = {
+        {"writer", writer_id_},
+        {"schema", layout_.schema},
+        {"last-column-id", layout_.last_column_id},
+        {"partition-spec", layout_.partition_spec},
+        {"manifest-entry-schema", layout_.manifest_entry_schema},
+        {"string-partitions", layout_.string_partitions},
+        {"files", std::move(files)},
+    };
+
+    // Written aside and renamed: commit() never sees half a sidecar
+    const std::string dir = table_path_ + "/_pending";
+    const std::string path = dir + "/" + writer_id_ + ".json";
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream f(path + ".tmp");
+        if (!f.is_open())
+            throw std::runtime_error("IcebergWriter: cannot write " + path);
+        f << pending.dump(1) << "\n";
+        if (!f.flush())
+            throw std::runtime_error("IcebergWriter: cannot write " + path);
+    }
+    std::filesystem::rename(path + ".tmp", path);
+}
+
+size_t IcebergWriter::commit(const std::string& table_path) {
+    const std::filesystem::path dir = table_path + "/_pending";
+    std::vector<std::filesystem::path> sidecars;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.path().extension() == ".json") sidecars.push_back(entry.path());
+    }
+    if (sidecars.empty()) return 0;
+    std::sort(sidecars.begin(), sidecars.end());
+    if (std::filesystem::exists(table_path + "/metadata/v1.metadata.json"))
+        throw std::runtime_error("IcebergWriter: " + table_path + " already has a snapshot");
+
+    IcebergWriter committer(table_path);
+    for (const auto& sidecar : sidecars) {
+        json pending;
+        try {
+            std::ifstream f(sidecar);
+            pending = json::parse(f);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("IcebergWriter: cannot read " + sidecar.string() + ": " + e.what());
+        }
+        Layout layout;
+        layout.schema = pending.at("schema").get<std::string>();
+        layout.last_column_id = pending.at("last-column-id").get<int32_t>();
+        layout.partition_spec = pending.at("partition-spec").get<std::string>();
+        layout.manifest_entry_schema = pending.at("manifest-entry-schema").get<std::string>();
+        layout.string_partitions = pending.at("string-partitions").get<std::vector<bool>>();
+        if (sidecar == sidecars.front()) {
+            committer.layout_ = layout;
+        } else if (layout.schema != committer.layout_.schema ||
+                   layout.partition_spec != committer.layout_.partition_spec) {
+            throw std::runtime_error("IcebergWriter: " + sidecar.string() +
+                                     " has another schema or partition spec than " +
+                                     sidecars.front().string());
+        }
+
+        for (const auto& file : pending.at("files")) {
+            DataFileInfo info;
+            info.filename = file.at("path").get<std::string>();
+            info.record_count = file.at("records").get<int64_t>();
+            info.file_size = file.at("size").get<int64_t>();
+            for (const auto& value : file.at("partition")) {
+                PartitionValue v;
+                v.is_null = value.is_null();
+                if (value.is_string()) v.text = value.get<std::string>();
+                else if (value.is_number()) v.number = value.get<int64_t>();
+                info.partition.push_back(std::move(v));
+            }
+            for (const auto& column : file.at("columns")) {
+                ColumnStats c;
+                c.field_id = column.at("id").get<int32_t>();
+                c.column_size = column.at("size").get<int64_t>();
+                c.value_count = column.at("values").get<int64_t>();
+                c.null_count = column.at("nulls").get<int64_t>();
+                c.has_bounds = column.contains("lower");
+                if (c.has_bounds) {
+                    c.lower_bound = from_hex(column.at("lower").get<std::string>());
+                    c.upper_bound = from_hex(column.at("upper").get<std::string>());
+                }
+                info.columns.push_back(std::move(c));
+            }
+            committer.row_count_ += info.record_count;
+            committer.written_files_.push_back(std::move(info));
+        }
+    }
+
+    std::filesystem::create_directories(table_path + "/metadata");
+    committer.commit_files();
+    std::filesystem::remove_all(dir);
+    return committer.written_files_.size();
+}
+
 // ─────────────────────────────────────────────────────────────────────────────
 // Public WriterInterface implementation
 // ─────────────────────────────────────────────────────────────────────────────
 
-void IcebergWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
-    if (!batch || batch->num_rows() == 0) return;
+void IcebergWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& input) {
+    if (!input || input->num_rows() == 0) return;
 
-    if (!schema_locked_) initialize_iceberg_table(batch);
+    if (!schema_locked_) initialize_iceberg_table(input);
 
-    if (batch->schema()->field_names() != schema_->field_names())
+    if (input->schema()->field_names() != schema_->field_names())
         throw std::runtime_error(
             "IcebergWriter: schema mismatch on subsequent batch");
 
-    batches_.push_back(batch);
+    const auto batch = date_columns_.empty() ? input : convert_dates(input);
+
+    if (partition_fields_.empty()) {
+        add_rows(*partitions_.front(), batch);
+        return;
+    }
+
+    // Route rows to their partitions, keeping generation order within each
+    std::vector<std::pair<Partition*, std::vector<RowGroupClusterer::RowRef>>> routed;
+    std::unordered_map<Partition*, size_t> slot;
+    std::string key;
+    Partition* previous = nullptr;
+    size_t current = 0;
+    for (int64_t i = 0; i < batch->num_rows(); ++i) {
+        Partition* partition = &partition_of(*batch, i, key);
+        if (partition != previous) {  // generated rows come in runs of one partition
+            auto [it, added] = slot.emplace(partition, routed.size());
+            if (added) routed.push_back({partition, {}});
+            current = it->second;
+            previous = partition;
+        }
+        routed[current].second.push_back({0, static_cast<uint32_t>(i)});
+    }
 
-    int64_t accumulated = 0;
-    for (const auto& b : batches_) accumulated += b->num_rows();
-    if (accumulated >= 10'000'000) write_data_file();
+    if (routed.size() == 1) {
+        add_rows(*routed.front().first, batch);
+        return;
+    }
+    for (auto& [partition, rows] : routed) {
+        add_rows(*partition, RowGroupClusterer::gather({batch}, rows));
+    }
 }
 
-void IcebergWriter::close() {
-    if (!schema_locked_) return;  // nothing written
+void IcebergWriter::commit_files() const {
+    if (written_files_.empty()) return;  // no data → skip metadata
 
-    try {
-        // 1. Flush any remaining buffered batches to a Parquet file.
-        if (!batches_.empty()) write_data_file();
+    // 1. Write manifest-1.avro (per-file entries).
+    auto [manifest_path, manifest_size] = write_manifest_avro();
 
-        if (written_files_.empty()) return;  // no data → skip metadata
+    // 2. Write snap-<id>.avro (manifest list).
+    std::string ml_path = write_manifest_list_avro(manifest_path, manifest_size);
 
-        // 2. Write manifest-1.avro (per-file entries).
-        auto [manifest_path, manifest_size] = write_manifest_avro();
+    // 3. Write v1.metadata.json (references manifest list).
+    write_metadata_json(ml_path);
 
-        // 3. Write snap-<id>.avro (manifest list).
-        std::string ml_path = write_manifest_list_avro(manifest_path, manifest_size);
+    // 4. Write version-hint.text.
+    write_version_hint();
+}
 
-        // 4. Write v1.metadata.json (references manifest list).
-        write_metadata_json(ml_path);
+void IcebergWriter::close() {
+    if (!schema_locked_) return;  // nothing written
 
-        // 5. Write version-hint.text.
-        write_version_hint();
+    try {
+        // 1. Write the remaining rows and close every open data file.
+        for (auto& partition : partitions_) {
+            write_row_group(*partition);
+            if (partition->writer) close_data_file(*partition);
+        }
+        partitions_.clear();
+        partition_index_.clear();
+
+        // 2. Deferred: describe the files for commit(); otherwise commit them now.
+        if (!writer_id_.empty()) {
+            write_pending();
+        } else {
+            commit_files();
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "IcebergWriter::close error: " << e.what() << "\n";
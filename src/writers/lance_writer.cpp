@@ -1,4 +1,7 @@
 #include "tpch/lance_writer.hpp"
+#include "tpch/row_group_clusterer.hpp"
+#include "tpch/s3_output_stream.hpp"
+#include "tpch/write_throttle.hpp"
 
 #include <filesystem>
 #include <iostream>
@@ -233,10 +236,12 @@ void LanceWriter::initialize_lance_dataset(
     schema_ = first_batch->schema();
     schema_locked_ = true;
 
-    // Create dataset directory structure
+    // Create dataset directory structure (s3:// datasets go through Lance's object store)
     try {
-        fs::create_directories(dataset_path_);
-        fs::create_directories(dataset_path_ + "/data");
+        if (!is_s3_uri(dataset_path_)) {
+            fs::create_directories(dataset_path_);
+            fs::create_directories(dataset_path_ + "/data");
+        }
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to create dataset directory: " +
                                 std::string(e.what()));
@@ -368,6 +373,14 @@ std::pair<void*, void*> LanceWriter::batch_to_ffi(
 //
 // Reference: Arrow C Data Interface specification - ownership transfers to callee
 
+bool LanceWriter::set_cluster_columns(const std::vector<std::string>& columns) {
+    if (schema_locked_ || clusterer_) {
+        throw std::runtime_error("Cannot cluster Lance rows after writing has begun");
+    }
+    cluster_columns_ = columns;
+    return true;
+}
+
 void LanceWriter::write_batch(
     const std::shared_ptr<arrow::RecordBatch>& batch) {
     if (!batch) {
@@ -378,6 +391,26 @@ void LanceWriter::write_batch(
         return;
     }
 
+    if (!cluster_columns_.empty()) {
+        auto clusterer = std::make_unique<RowGroupClusterer>(
+            batch->schema(), cluster_columns_, static_cast<int64_t>(preferred_unit_rows()));
+        if (clusterer->active()) {
+            clusterer_ = std::move(clusterer);
+        }
+        cluster_columns_.clear();
+    }
+    if (clusterer_) {
+        for (const auto& group : clusterer_->push(batch)) {
+            write_rows(group);
+        }
+        return;
+    }
+    write_rows(batch);
+}
+
+void LanceWriter::write_rows(
+    const std::shared_ptr<arrow::RecordBatch>& batch) {
+
     // Initialize on first batch
     if (!schema_locked_) {
         initialize_lance_dataset(batch);
@@ -402,6 +435,7 @@ void LanceWriter::write_batch(
             throw std::runtime_error("Lance streaming writer not initialized");
         }
         int64_t batch_bytes = estimate_batch_bytes(*batch);
+        WriteThrottle::acquire(static_cast<size_t>(batch_bytes));  // Rust writes it; charge up front
         stream_state_->push(batch, batch_bytes);
         row_count_ += batch->num_rows();
         batch_count_++;
@@ -446,6 +480,10 @@ void LanceWriter::write_batch(
         return;
     }
 
+    if (WriteThrottle::enabled()) {
+        WriteThrottle::acquire(static_cast<size_t>(estimate_batch_bytes(*batch)));
+    }
+
     // Convert batch to Arrow C Data Interface format
     auto [array_ptr, schema_ptr] = batch_to_ffi(batch);
 
@@ -504,6 +542,13 @@ void LanceWriter::write_batch(
 
 
 void LanceWriter::close() {
+    if (clusterer_) {
+        auto rest = clusterer_->flush();
+        clusterer_.reset();
+        if (rest) {
+            write_rows(rest);
+        }
+    }
     if (rust_writer_ == nullptr) {
         return;
     }
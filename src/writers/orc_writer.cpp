@@ -1,17 +1,21 @@
-#include <iostream>
+#include <cstring>
 #include <sstream>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
 
 // Minimal Arrow includes to avoid protobuf symbol pollution
 // These specific headers should NOT pull in protobuf infrastructure
 #include <arrow/record_batch.h>
 #include <arrow/array.h>
 #include <arrow/type.h>
+#include <arrow/io/interfaces.h>
+#include <arrow/util/bit_util.h>
 
 #include <orc/OrcFile.hh>
 
 #include "tpch/orc_writer.hpp"
+#include "tpch/row_group_clusterer.hpp"
 
 namespace tpch {
 
@@ -59,119 +63,203 @@ std::string build_orc_schema_string(const std::shared_ptr<arrow::Schema>& schema
 }
 
 /**
- * Copy Arrow array to ORC ColumnVectorBatch column.
- * Handles type conversions and null values.
+ * notNull / hasNulls from the Arrow validity bitmap. ORC reads notNull only
+ * when hasNulls is set, so null-free columns skip it.
+ */
+void fill_not_null(orc::ColumnVectorBatch* col, const arrow::ArrayData& data) {
+    col->hasNulls = data.GetNullCount() > 0;
+    if (!col->hasNulls) {
+        return;
+    }
+    const uint8_t* bits = data.buffers[0]->data();
+    char* not_null = col->notNull.data();
+    for (int64_t i = 0; i < data.length; ++i) {
+        not_null[i] = arrow::bit_util::GetBit(bits, data.offset + i) ? 1 : 0;
+    }
+}
+
+/** Values into an ORC data buffer: one memcpy when the widths match, else a widening loop. */
+template <typename In, typename Out>
+void copy_values(const arrow::ArrayData& data, Out* out) {
+    const In* in = data.GetValues<In>(1);
+    if constexpr (std::is_same_v<In, Out>) {
+        std::memcpy(out, in, static_cast<size_t>(data.length) * sizeof(In));
+    } else {
+        for (int64_t i = 0; i < data.length; ++i) {
+            out[i] = static_cast<Out>(in[i]);
+        }
+    }
+}
+
+char* string_values(const arrow::ArrayData& data) {
+    static char empty = 0;
+    return data.buffers[2] ? reinterpret_cast<char*>(const_cast<uint8_t*>(data.buffers[2]->data()))
+                           : &empty;
+}
+
+/**
+ * Point each ORC string at its bytes in Arrow's value buffer; nothing is
+ * copied until the ORC encoder reads them in Writer::add().
+ */
+void point_strings(orc::StringVectorBatch* col, const arrow::ArrayData& data) {
+    const int32_t* offsets = data.GetValues<int32_t>(1);
+    char* values = string_values(data);
+    char** out = col->data.data();
+    int64_t* length = col->length.data();
+    for (int64_t i = 0; i < data.length; ++i) {
+        out[i] = values + offsets[i];
+        length[i] = offsets[i + 1] - offsets[i];
+    }
+}
+
+/** Dictionary column: each row points at its dictionary entry. */
+template <typename Index>
+void point_dictionary_strings(orc::StringVectorBatch* col, const arrow::ArrayData& data) {
+    const arrow::ArrayData& dict = *data.dictionary;
+    const int32_t* offsets = dict.GetValues<int32_t>(1);
+    char* values = string_values(dict);
+    const Index* indices = data.GetValues<Index>(1);
+    const char* not_null = col->hasNulls ? col->notNull.data() : nullptr;
+    char** out = col->data.data();
+    int64_t* length = col->length.data();
+    for (int64_t i = 0; i < data.length; ++i) {
+        if (not_null && !not_null[i]) {
+            length[i] = 0;  // index slot of a null is undefined
+            continue;
+        }
+        const auto k = static_cast<int64_t>(indices[i]);
+        out[i] = values + offsets[k];
+        length[i] = offsets[k + 1] - offsets[k];
+    }
+}
+
+template <typename Batch>
+Batch* orc_column_as(orc::ColumnVectorBatch* col_batch, const char* what) {
+    auto* col = dynamic_cast<Batch*>(col_batch);
+    if (!col) {
+        throw std::runtime_error(std::string("Failed to cast ORC column to ") + what);
+    }
+    return col;
+}
+
+/**
+ * Fill an ORC ColumnVectorBatch (capacity >= array length) from an Arrow
+ * array: bulk copies for fixed-width columns, pointers into Arrow's buffers
+ * for strings and dictionary strings.
  */
 void copy_array_to_orc_column(
     orc::ColumnVectorBatch* col_batch,
     const std::shared_ptr<arrow::Array>& array) {
 
-    size_t size = static_cast<size_t>(array->length());
-    col_batch->numElements = size;
+    const arrow::ArrayData& data = *array->data();
+    col_batch->numElements = static_cast<uint64_t>(data.length);
+    fill_not_null(col_batch, data);
 
-    if (array->type()->id() == arrow::Type::INT64) {
-        auto int_array = std::static_pointer_cast<arrow::Int64Array>(array);
-        auto* long_col = dynamic_cast<orc::LongVectorBatch*>(col_batch);
-        if (!long_col) {
-            throw std::runtime_error("Failed to cast ORC column to LongVectorBatch");
-        }
-        for (size_t i = 0; i < size; ++i) {
-            if (int_array->IsNull(static_cast<int64_t>(i))) {
-                long_col->notNull[i] = 0;
-            } else {
-                long_col->notNull[i] = 1;
-                long_col->data[i] = int_array->Value(static_cast<int64_t>(i));
-            }
-        }
-    } else if (array->type()->id() == arrow::Type::INT32) {
+    const auto id = data.type->id();
+    if (id == arrow::Type::INT64) {
+        copy_values<int64_t>(data, orc_column_as<orc::LongVectorBatch>(col_batch, "LongVectorBatch")->data.data());
+    } else if (id == arrow::Type::INT32) {
         // ORC uses LongVectorBatch for all integer types (tinyint/smallint/int/bigint)
-        auto int_array = std::static_pointer_cast<arrow::Int32Array>(array);
-        auto* long_col = dynamic_cast<orc::LongVectorBatch*>(col_batch);
-        if (!long_col) {
-            throw std::runtime_error("Failed to cast ORC column to LongVectorBatch (int32)");
-        }
-        for (size_t i = 0; i < size; ++i) {
-            if (int_array->IsNull(static_cast<int64_t>(i))) {
-                long_col->notNull[i] = 0;
-            } else {
-                long_col->notNull[i] = 1;
-                long_col->data[i] = int_array->Value(static_cast<int64_t>(i));
-            }
-        }
-    } else if (array->type()->id() == arrow::Type::DOUBLE) {
-        auto double_array = std::static_pointer_cast<arrow::DoubleArray>(array);
-        auto* double_col = dynamic_cast<orc::DoubleVectorBatch*>(col_batch);
-        if (!double_col) {
-            throw std::runtime_error("Failed to cast ORC column to DoubleVectorBatch");
-        }
-        for (size_t i = 0; i < size; ++i) {
-            if (double_array->IsNull(static_cast<int64_t>(i))) {
-                double_col->notNull[i] = 0;
-            } else {
-                double_col->notNull[i] = 1;
-                double_col->data[i] = double_array->Value(static_cast<int64_t>(i));
-            }
+        copy_values<int32_t>(data, orc_column_as<orc::LongVectorBatch>(col_batch, "LongVectorBatch (int32)")->data.data());
+    } else if (id == arrow::Type::DOUBLE) {
+        copy_values<double>(data, orc_column_as<orc::DoubleVectorBatch>(col_batch, "DoubleVectorBatch")->data.data());
+    } else if (id == arrow::Type::FLOAT) {
+        copy_values<float>(data, orc_column_as<orc::DoubleVectorBatch>(col_batch, "DoubleVectorBatch")->data.data());
+    } else if (id == arrow::Type::STRING) {
+        point_strings(orc_column_as<orc::StringVectorBatch>(col_batch, "StringVectorBatch"), data);
+    } else if (id == arrow::Type::DICTIONARY) {
+        // dictionary<int8|int16, utf8>: ORC builds its own dictionary from
+        // these (DICTIONARY_V2 encoding); the values are never expanded
+        auto* string_col = orc_column_as<orc::StringVectorBatch>(col_batch, "StringVectorBatch");
+        const auto& dict_type = static_cast<const arrow::DictionaryType&>(*data.type);
+        if (dict_type.value_type()->id() != arrow::Type::STRING) {
+            throw std::runtime_error("Unsupported dictionary value type for ORC: " +
+                                     dict_type.value_type()->ToString());
         }
-    } else if (array->type()->id() == arrow::Type::FLOAT) {
-        auto float_array = std::static_pointer_cast<arrow::FloatArray>(array);
-        auto* double_col = dynamic_cast<orc::DoubleVectorBatch*>(col_batch);
-        if (!double_col) {
-            throw std::runtime_error("Failed to cast ORC column to DoubleVectorBatch");
-        }
-        for (size_t i = 0; i < size; ++i) {
-            if (float_array->IsNull(static_cast<int64_t>(i))) {
-                double_col->notNull[i] = 0;
-            } else {
-                double_col->notNull[i] = 1;
-                double_col->data[i] = float_array->Value(static_cast<int64_t>(i));
-            }
-        }
-    } else if (array->type()->id() == arrow::Type::STRING) {
-        auto string_array = std::static_pointer_cast<arrow::StringArray>(array);
-        auto* string_col = dynamic_cast<orc::StringVectorBatch*>(col_batch);
-        if (!string_col) {
-            throw std::runtime_error("Failed to cast ORC column to StringVectorBatch");
-        }
-        for (size_t i = 0; i < size; ++i) {
-            if (string_array->IsNull(static_cast<int64_t>(i))) {
-                string_col->notNull[i] = 0;
-            } else {
-                string_col->notNull[i] = 1;
-                auto str = string_array->GetString(static_cast<int64_t>(i));
-                string_col->data[i] = const_cast<char*>(str.data());
-                string_col->length[i] = static_cast<int64_t>(str.length());
-            }
-        }
-    } else if (array->type()->id() == arrow::Type::DICTIONARY) {
-        // Expand dictionary<int8|int16, utf8> to ORC string column via index lookup.
-        // GetValueIndex() returns int64 regardless of index width — works for both.
-        // string_view points into the dictionary buffer which outlives this function.
-        auto dict_array = std::static_pointer_cast<arrow::DictionaryArray>(array);
-        auto dict_values = std::static_pointer_cast<arrow::StringArray>(dict_array->dictionary());
-        auto* string_col = dynamic_cast<orc::StringVectorBatch*>(col_batch);
-        if (!string_col) {
-            throw std::runtime_error("Failed to cast ORC column to StringVectorBatch");
-        }
-        for (size_t i = 0; i < size; ++i) {
-            if (dict_array->IsNull(static_cast<int64_t>(i))) {
-                string_col->notNull[i] = 0;
-            } else {
-                string_col->notNull[i] = 1;
-                auto idx = dict_array->GetValueIndex(static_cast<int64_t>(i));
-                auto sv = dict_values->GetView(idx);
-                string_col->data[i] = const_cast<char*>(sv.data());
-                string_col->length[i] = static_cast<int64_t>(sv.length());
-            }
+        const auto index_id = dict_type.index_type()->id();
+        if (index_id == arrow::Type::INT8) {
+            point_dictionary_strings<int8_t>(string_col, data);
+        } else if (index_id == arrow::Type::INT16) {
+            point_dictionary_strings<int16_t>(string_col, data);
+        } else if (index_id == arrow::Type::INT32) {
+            point_dictionary_strings<int32_t>(string_col, data);
+        } else if (index_id == arrow::Type::INT64) {
+            point_dictionary_strings<int64_t>(string_col, data);
+        } else {
+            throw std::runtime_error("Unsupported dictionary index type for ORC");
         }
     } else {
         throw std::runtime_error("Unsupported Arrow type for ORC column copy");
     }
 }
 
+bool has_dictionary_columns(const arrow::Schema& schema) {
+    for (const auto& field : schema.fields()) {
+        if (field->type()->id() == arrow::Type::DICTIONARY) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * orc::OutputStream over an arrow::io::OutputStream, so ORC output can go
+ * through IoUringOutputStream, ShmRingOutputStream, etc.
+ */
+class ArrowOrcOutputStream : public orc::OutputStream {
+public:
+    ArrowOrcOutputStream(std::shared_ptr<arrow::io::OutputStream> out, std::string name)
+        : out_(std::move(out)), name_(std::move(name)) {}
+
+    ~ArrowOrcOutputStream() override {
+        if (!closed_) {
+            (void)out_->Close();
+        }
+    }
+
+    uint64_t getLength() const override { return length_; }
+
+    // ORC buffers up to this much before calling write(); match the
+    // 1 MiB staging buffers of IoUringOutputStream.
+    uint64_t getNaturalWriteSize() const override { return 1024 * 1024; }
+
+    void write(const void* buf, size_t length) override {
+        check(out_->Write(buf, static_cast<int64_t>(length)));
+        length_ += length;
+    }
+
+    const std::string& getName() const override { return name_; }
+
+    void close() override {
+        if (closed_) return;
+        closed_ = true;
+        check(out_->Close());
+    }
+
+#ifdef TPCH_ORC_STREAM_HAS_FLUSH
+    void flush() override { check(out_->Flush()); }
+#else
+    void flush() { check(out_->Flush()); }
+#endif
+
+private:
+    void check(const arrow::Status& st) const {
+        if (!st.ok()) {
+            throw std::runtime_error("ORC output stream " + name_ + ": " + st.ToString());
+        }
+    }
+
+    std::shared_ptr<arrow::io::OutputStream> out_;
+    std::string name_;
+    uint64_t length_ = 0;
+    bool closed_ = false;
+};
+
 }  // anonymous namespace
 
 ORCWriter::ORCWriter(const std::string& filepath)
-    : filepath_(filepath), orc_writer_(nullptr), orc_output_stream_(nullptr), orc_type_(nullptr) {
+    : filepath_(filepath), orc_writer_(nullptr), orc_output_stream_(nullptr), orc_type_(nullptr),
+      orc_row_batch_(nullptr) {
     // Constructor doesn't create writer yet - we wait for first batch to get schema
 }
 
@@ -182,6 +270,12 @@ ORCWriter::~ORCWriter() {
         // Suppress exceptions in destructor
     }
 
+    // Row batch memory comes from the writer's pool: release it first
+    if (orc_row_batch_) {
+        delete reinterpret_cast<std::unique_ptr<orc::ColumnVectorBatch>*>(orc_row_batch_);
+        orc_row_batch_ = nullptr;
+    }
+
     // Delete writer first (it owns references to stream)
     if (orc_writer_) {
         // Writer's destructor handles cleanup
@@ -207,6 +301,25 @@ void ORCWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
         return;
     }
 
+    if (!cluster_columns_.empty()) {
+        auto clusterer = std::make_unique<RowGroupClusterer>(
+            batch->schema(), cluster_columns_, static_cast<int64_t>(ROW_INDEX_STRIDE));
+        if (clusterer->active()) {
+            clusterer_ = std::move(clusterer);
+        }
+        cluster_columns_.clear();
+    }
+    if (clusterer_) {
+        // Whole strides, so each row-index entry covers one sorted group
+        for (const auto& group : clusterer_->push(batch)) {
+            write_rows(group);
+        }
+        return;
+    }
+    write_rows(batch);
+}
+
+void ORCWriter::write_rows(const std::shared_ptr<arrow::RecordBatch>& batch) {
     // Lock schema on first batch
     if (!schema_locked_) {
         first_batch_ = batch;
@@ -221,13 +334,26 @@ void ORCWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
             orc_type_ = new std::unique_ptr<orc::Type>(std::move(orc_type_local));
 
             // Create output file stream using ORC factory function - must be stored as member to stay alive
-            auto out_stream_local = orc::writeLocalFile(filepath_);
+            std::unique_ptr<orc::OutputStream> out_stream_local;
+            if (stream_factory_) {
+                out_stream_local = std::make_unique<ArrowOrcOutputStream>(
+                    stream_factory_(filepath_), filepath_);
+            } else {
+                out_stream_local = orc::writeLocalFile(filepath_);
+            }
             orc_output_stream_ = new std::unique_ptr<orc::OutputStream>(std::move(out_stream_local));
 
             // Create writer options
             orc::WriterOptions writer_options;
-            writer_options.setStripeSize(64 * 1024 * 1024);  // 64MB stripes
-            writer_options.setRowIndexStride(10000);
+            writer_options.setStripeSize(STRIPE_SIZE_BYTES);  // 64MB stripes
+            writer_options.setRowIndexStride(ROW_INDEX_STRIDE);
+            if (has_dictionary_columns(*schema)) {
+                // ORC C++ defaults to direct encoding for every string column;
+                // with a threshold, columns above the ratio (comments, names)
+                // still fall back to direct and the flag/date columns keep
+                // a dictionary
+                writer_options.setDictionaryKeySizeThreshold(DICTIONARY_KEY_SIZE_THRESHOLD);
+            }
 
             // Create ORC writer using factory function
             auto* out_stream_ptr = reinterpret_cast<std::unique_ptr<orc::OutputStream>*>(orc_output_stream_);
@@ -264,8 +390,16 @@ void ORCWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
         int num_cols = batch->num_columns();
         int64_t num_rows = batch->num_rows();
 
-        // Create root ColumnVectorBatch (ORC manages memory via MemoryPool)
-        auto root_batch = writer->createRowBatch(static_cast<uint64_t>(num_rows));
+        // One root ColumnVectorBatch for the whole file, grown to the largest
+        // batch: add() encodes immediately, so its buffers are free again after
+        if (!orc_row_batch_ || static_cast<uint64_t>(num_rows) > row_batch_capacity_) {
+            delete reinterpret_cast<std::unique_ptr<orc::ColumnVectorBatch>*>(orc_row_batch_);
+            orc_row_batch_ = nullptr;
+            orc_row_batch_ = new std::unique_ptr<orc::ColumnVectorBatch>(
+                writer->createRowBatch(static_cast<uint64_t>(num_rows)));
+            row_batch_capacity_ = static_cast<uint64_t>(num_rows);
+        }
+        auto& root_batch = *reinterpret_cast<std::unique_ptr<orc::ColumnVectorBatch>*>(orc_row_batch_);
 
         // root_batch should be a StructVectorBatch for the row data
         auto* struct_batch = dynamic_cast<orc::StructVectorBatch*>(root_batch.get());
@@ -294,16 +428,46 @@ void ORCWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
     }
 }
 
+bool ORCWriter::set_cluster_columns(const std::vector<std::string>& columns) {
+    if (schema_locked_ || clusterer_) {
+        throw std::runtime_error("Cannot cluster ORC rows after writing has begun");
+    }
+    cluster_columns_ = columns;
+    return true;
+}
+
+bool ORCWriter::set_output_stream_factory(OutputStreamFactory factory) {
+    if (schema_locked_) {
+        throw std::runtime_error("Cannot replace the ORC output stream after writing has begun");
+    }
+    stream_factory_ = std::move(factory);
+    return true;
+}
+
 void ORCWriter::close() {
-    if (orc_writer_) {
-        try {
-            auto* writer = reinterpret_cast<orc::Writer*>(orc_writer_);
-            writer->close();
-        } catch (const std::exception& e) {
-            // Log but don't rethrow - the data has been written
-            std::cerr << "Warning closing ORC writer: " << e.what() << std::endl;
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    if (clusterer_) {
+        auto rest = clusterer_->flush();
+        clusterer_.reset();
+        if (rest) {
+            write_rows(rest);
         }
     }
+    if (!orc_writer_) {
+        return;
+    }
+    try {
+        reinterpret_cast<orc::Writer*>(orc_writer_)->close();
+        // Writer::close() ends with the stream's close(); repeat it (a no-op
+        // then) so a failed final flush of an injected stream throws here
+        // rather than being dropped by the stream's destructor.
+        (*reinterpret_cast<std::unique_ptr<orc::OutputStream>*>(orc_output_stream_))->close();
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to close ORC file " + filepath_ + ": " + e.what());
+    }
 }
 
 }  // namespace tpch
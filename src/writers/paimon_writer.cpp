@@ -3,7 +3,12 @@
 #ifdef TPCH_ENABLE_PAIMON
 
 #include "tpch/avro_writer.hpp"
+#include "tpch/batch_sizer.hpp"
+#include "tpch/row_group_clusterer.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
@@ -12,13 +17,22 @@
 #include <sstream>
 #include <vector>
 #include <iomanip>
+#include <queue>
 #include <random>
 #include <chrono>
 #include <cstring>
 #include <limits>
+#include <string_view>
+#include <thread>
 
 #include <arrow/api.h>
 #include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/util/bit_util.h>
+#include <arrow/util/checked_cast.h>
+#include <arrow/util/future.h>
+#include <arrow/util/thread_pool.h>
 #include <parquet/arrow/writer.h>
 #include <nlohmann/json.hpp>
 
@@ -26,6 +40,288 @@ namespace tpch {
 
 using json = nlohmann::json;
 
+namespace {
+
+/** Comma-separated column list, as Paimon options spell it. */
+std::string join_names(const std::vector<std::string>& names) {
+    std::string joined;
+    for (const auto& name : names) {
+        joined += (joined.empty() ? "" : ",") + name;
+    }
+    return joined;
+}
+
+// Rows per batch of a sorted run: spill file slices and merge output
+constexpr int64_t kRunBatchRows = 64 * 1024;
+
+bool comparable_key_type(const arrow::DataType& type) {
+    if (type.id() == arrow::Type::DICTIONARY) {
+        return comparable_key_type(*static_cast<const arrow::DictionaryType&>(type).value_type());
+    }
+    return arrow::is_integer(type.id()) || type.id() == arrow::Type::DATE32 ||
+           arrow::is_base_binary_like(type.id());
+}
+
+int64_t integer_at(const arrow::ArrayData& data, int64_t i) {
+    switch (data.type->id()) {
+        case arrow::Type::INT8:   return data.GetValues<int8_t>(1)[i];
+        case arrow::Type::UINT8:  return data.GetValues<uint8_t>(1)[i];
+        case arrow::Type::INT16:  return data.GetValues<int16_t>(1)[i];
+        case arrow::Type::UINT16: return data.GetValues<uint16_t>(1)[i];
+        case arrow::Type::INT32:
+        case arrow::Type::DATE32: return data.GetValues<int32_t>(1)[i];
+        case arrow::Type::UINT32: return data.GetValues<uint32_t>(1)[i];
+        default:                  return data.GetValues<int64_t>(1)[i];
+    }
+}
+
+/** Three-way comparison of a[i] and b[j] (same type, no nulls), as Paimon orders keys. */
+int compare_values(const arrow::Array& a, int64_t i, const arrow::Array& b, int64_t j) {
+    if (a.type_id() == arrow::Type::DICTIONARY) {
+        const auto& da = static_cast<const arrow::DictionaryArray&>(a);
+        const auto& db = static_cast<const arrow::DictionaryArray&>(b);
+        return compare_values(*da.dictionary(), da.GetValueIndex(i), *db.dictionary(), db.GetValueIndex(j));
+    }
+    if (arrow::is_base_binary_like(a.type_id())) {
+        auto view = [](const arrow::Array& array, int64_t k) {
+            return arrow::is_large_binary_like(array.type_id())
+                       ? static_cast<const arrow::LargeBinaryArray&>(array).GetView(k)
+                       : static_cast<const arrow::BinaryArray&>(array).GetView(k);
+        };
+        // Unsigned byte order, like BinaryString.compareTo
+        const int c = view(a, i).compare(view(b, j));
+        return c < 0 ? -1 : (c > 0 ? 1 : 0);
+    }
+    if (a.type_id() == arrow::Type::UINT64) {
+        const uint64_t x = a.data()->GetValues<uint64_t>(1)[i];
+        const uint64_t y = b.data()->GetValues<uint64_t>(1)[j];
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    const int64_t x = integer_at(*a.data(), i);
+    const int64_t y = integer_at(*b.data(), j);
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/** Compare the keys (the first key_count columns) of a[i] and b[j]. */
+int compare_keys(const arrow::RecordBatch& a, int64_t i, const arrow::RecordBatch& b, int64_t j,
+                 int key_count) {
+    for (int k = 0; k < key_count; ++k) {
+        const int c = compare_values(*a.column(k), i, *b.column(k), j);
+        if (c != 0) return c;
+    }
+    return 0;
+}
+
+/** The rows of chunks in one batch, stably sorted by their keys. */
+std::shared_ptr<arrow::RecordBatch> sort_rows(
+    const std::vector<std::shared_ptr<arrow::RecordBatch>>& chunks, int key_count) {
+    std::vector<RowGroupClusterer::RowRef> order;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (int64_t r = 0; r < chunks[c]->num_rows(); ++r) {
+            order.push_back({static_cast<uint32_t>(c), static_cast<uint32_t>(r)});
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](const auto& x, const auto& y) {
+        return compare_keys(*chunks[x.chunk], x.row, *chunks[y.chunk], y.row, key_count) < 0;
+    });
+    return RowGroupClusterer::gather(chunks, order);
+}
+
+std::vector<int> leading_columns(int count) {
+    std::vector<int> columns(static_cast<size_t>(count));
+    for (int k = 0; k < count; ++k) columns[static_cast<size_t>(k)] = k;
+    return columns;
+}
+
+}  // namespace
+
+namespace paimon_detail {
+
+namespace {
+
+inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+void put_fixed(std::vector<uint8_t>& row, size_t slot, const void* value, size_t size) {
+    std::memcpy(row.data() + slot, value, size);
+}
+
+/** BinaryRowWriter.writeString/writeBinary: inline up to 7 bytes, else variable part. */
+void put_bytes(std::vector<uint8_t>& row, size_t slot, std::string_view value) {
+    uint64_t word = 0;
+    if (value.size() <= 7) {
+        word = static_cast<uint64_t>(0x80 | value.size()) << 56;
+        for (size_t i = 0; i < value.size(); ++i) {
+            word |= static_cast<uint64_t>(static_cast<uint8_t>(value[i])) << (8 * i);
+        }
+    } else {
+        const size_t offset = row.size();
+        row.resize(offset + (value.size() + 7) / 8 * 8, 0);  // word-aligned, zero padded
+        std::memcpy(row.data() + offset, value.data(), value.size());
+        word = (static_cast<uint64_t>(offset) << 32) | value.size();
+    }
+    put_fixed(row, slot, &word, sizeof(word));
+}
+
+void put_field(const arrow::Array& column, int64_t i, size_t slot, std::vector<uint8_t>& row) {
+    const auto& data = *column.data();
+    switch (column.type_id()) {
+        case arrow::Type::BOOL: {
+            const uint8_t value = arrow::bit_util::GetBit(data.buffers[1]->data(), data.offset + i);
+            return put_fixed(row, slot, &value, 1);
+        }
+        case arrow::Type::INT8:
+        case arrow::Type::UINT8:
+            return put_fixed(row, slot, data.GetValues<uint8_t>(1) + i, 1);
+        case arrow::Type::INT16:
+        case arrow::Type::UINT16:
+            return put_fixed(row, slot, data.GetValues<uint16_t>(1) + i, 2);
+        case arrow::Type::INT32:
+        case arrow::Type::UINT32:
+        case arrow::Type::DATE32:
+            return put_fixed(row, slot, data.GetValues<uint32_t>(1) + i, 4);
+        case arrow::Type::INT64:
+        case arrow::Type::UINT64:
+            return put_fixed(row, slot, data.GetValues<uint64_t>(1) + i, 8);
+        case arrow::Type::FLOAT: {
+            // Paimon normalizes NaN before writing
+            float value = data.GetValues<float>(1)[i];
+            if (std::isnan(value)) value = std::numeric_limits<float>::quiet_NaN();
+            return put_fixed(row, slot, &value, sizeof(value));
+        }
+        case arrow::Type::DOUBLE: {
+            double value = data.GetValues<double>(1)[i];
+            if (std::isnan(value)) value = std::numeric_limits<double>::quiet_NaN();
+            return put_fixed(row, slot, &value, sizeof(value));
+        }
+        case arrow::Type::DECIMAL128: {
+            const auto& type = arrow::internal::checked_cast<const arrow::Decimal128Type&>(*column.type());
+            if (type.precision() > 18) {
+                break;  // non-compact decimals are stored as BigInteger bytes
+            }
+            // Compact decimal: the unscaled value as a long (low word, little-endian)
+            return put_fixed(row, slot, data.GetValues<uint8_t>(1) + i * 16, 8);
+        }
+        case arrow::Type::STRING:
+        case arrow::Type::BINARY:
+            return put_bytes(row, slot,
+                             arrow::internal::checked_cast<const arrow::BinaryArray&>(column).GetView(i));
+        case arrow::Type::LARGE_STRING:
+        case arrow::Type::LARGE_BINARY:
+            return put_bytes(row, slot,
+                             arrow::internal::checked_cast<const arrow::LargeBinaryArray&>(column).GetView(i));
+        case arrow::Type::DICTIONARY: {
+            const auto& dict = arrow::internal::checked_cast<const arrow::DictionaryArray&>(column);
+            return put_field(*dict.dictionary(), dict.GetValueIndex(i), slot, row);
+        }
+        default:
+            break;
+    }
+    throw std::invalid_argument("Paimon key of type " + column.type()->ToString() +
+                                " is not supported");
+}
+
+/** BinaryRow of the key columns of row i: header word(s) with the row kind and null bits, then one 8-byte slot per field. */
+void binary_row(const std::vector<const arrow::Array*>& columns, int64_t i, std::vector<uint8_t>& row) {
+    const size_t arity = columns.size();
+    const size_t header = (arity + 63 + 8) / 64 * 8;
+    row.assign(header + arity * 8, 0);  // row kind INSERT, no nulls
+    for (size_t k = 0; k < arity; ++k) {
+        if (columns[k]->IsNull(i)) {
+            row[(k + 8) / 8] |= static_cast<uint8_t>(1 << ((k + 8) % 8));
+        } else {
+            put_field(*columns[k], i, header + k * 8, row);
+        }
+    }
+}
+
+std::vector<const arrow::Array*> key_arrays(const arrow::RecordBatch& batch,
+                                            const std::vector<int>& key_columns) {
+    std::vector<const arrow::Array*> columns;
+    for (int index : key_columns) {
+        columns.push_back(batch.column(index).get());
+    }
+    return columns;
+}
+
+}  // namespace
+
+int32_t hash_words(const uint8_t* data, size_t length, int32_t seed) {
+    uint32_t h1 = static_cast<uint32_t>(seed);
+    for (size_t i = 0; i + 4 <= length; i += 4) {
+        uint32_t k1;
+        std::memcpy(&k1, data + i, sizeof(k1));  // little-endian, like Paimon's MemorySegment
+        k1 *= 0xcc9e2d51U;
+        k1 = rotl32(k1, 15);
+        k1 *= 0x1b873593U;
+        h1 ^= k1;
+        h1 = rotl32(h1, 13);
+        h1 = h1 * 5 + 0xe6546b64U;
+    }
+    h1 ^= static_cast<uint32_t>(length);
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6bU;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35U;
+    h1 ^= h1 >> 16;
+    return static_cast<int32_t>(h1);
+}
+
+void compute_buckets(const arrow::RecordBatch& batch, const std::vector<int>& key_columns,
+                     int32_t buckets, std::vector<int32_t>* out) {
+    if (buckets <= 0) {
+        throw std::invalid_argument("Paimon bucket count must be positive");
+    }
+    const auto columns = key_arrays(batch, key_columns);
+    const int64_t n = batch.num_rows();
+    out->resize(static_cast<size_t>(n));
+    std::vector<uint8_t> row;
+    for (int64_t i = 0; i < n; ++i) {
+        binary_row(columns, i, row);
+        const int32_t hash = hash_words(row.data(), row.size());
+        (*out)[static_cast<size_t>(i)] = std::abs(hash % buckets);
+    }
+}
+
+std::vector<uint8_t> serialize_key(const arrow::RecordBatch& batch,
+                                   const std::vector<int>& key_columns, int64_t i) {
+    std::vector<uint8_t> row;
+    binary_row(key_arrays(batch, key_columns), i, row);
+    const auto arity = static_cast<uint32_t>(key_columns.size());
+    const uint8_t prefix[] = {static_cast<uint8_t>(arity >> 24), static_cast<uint8_t>(arity >> 16),
+                              static_cast<uint8_t>(arity >> 8), static_cast<uint8_t>(arity)};
+    row.insert(row.begin(), prefix, prefix + 4);
+    return row;
+}
+
+}  // namespace paimon_detail
+
+/** One bucket directory: its open data file and the batch in flight on it. */
+struct PaimonWriter::Bucket {
+    int32_t id = 0;
+    std::shared_ptr<arrow::io::OutputStream> stream;
+    std::unique_ptr<parquet::arrow::FileWriter> writer;
+    std::string file_name;
+    int64_t file_rows = 0;
+    int64_t file_arrow_bytes = 0;
+    int32_t file_count = 0;
+    double encoded_ratio = 1.0;  // encoded / Arrow bytes of the last closed file
+    arrow::Future<> in_flight = arrow::Future<>::MakeFinished();
+
+    // Primary-key tables
+    int32_t level = NUM_LEVELS - 1;     // level of the run being written
+    int64_t next_sequence = 0;
+    std::vector<uint8_t> file_min_key;
+    std::vector<uint8_t> file_max_key;
+    int64_t file_max_sequence = 0;
+    std::shared_ptr<arrow::RecordBatch> last_row;  // last streamed row (KeyValue layout)
+    bool sorting = false;                          // a row arrived out of key order
+    std::vector<std::shared_ptr<arrow::RecordBatch>> buffered;
+    int64_t buffered_bytes = 0;
+    std::vector<std::string> spills;               // sorted runs on disk, oldest first
+};
+
 PaimonWriter::PaimonWriter(const std::string& table_path, const std::string& table_name)
     : table_path_(table_path),
       table_name_(table_name) {
@@ -41,8 +337,8 @@ PaimonWriter::PaimonWriter(const std::string& table_path, const std::string& tab
 }
 
 PaimonWriter::~PaimonWriter() {
-    if (!schema_locked_ || closed_) {
-        return;  // Never initialized or already closed
+    if (!schema_locked_) {
+        return;  // Never initialized
     }
 
     try {
@@ -50,6 +346,10 @@ PaimonWriter::~PaimonWriter() {
     } catch (const std::exception& e) {
         std::cerr << "Warning closing Paimon writer: " << e.what() << std::endl;
     }
+    // A failed close may leave bucket writes running: they use this object
+    for (auto& bucket : buckets_) {
+        bucket->in_flight.Wait();
+    }
 }
 
 std::string PaimonWriter::arrow_type_to_paimon_type(
@@ -173,13 +473,82 @@ void PaimonWriter::initialize_paimon_table(
     const std::shared_ptr<arrow::RecordBatch>& first_batch) {
 
     schema_ = first_batch->schema();
+    file_schema_ = schema_;
 
     try {
+        if (has_primary_key_) {
+            if (primary_key_.empty()) {
+                primary_key_ = default_primary_key(*schema_);
+                if (primary_key_.empty()) {
+                    throw std::invalid_argument("no known primary key for this table; name the key columns");
+                }
+            }
+            arrow::FieldVector fields;
+            for (const auto& name : primary_key_) {
+                const int index = schema_->GetFieldIndex(name);
+                if (index < 0) {
+                    throw std::invalid_argument("primary key column " + name + " is not in the schema");
+                }
+                const auto& type = schema_->field(index)->type();
+                if (!comparable_key_type(*type)) {
+                    throw std::invalid_argument("primary key column " + name + " of type " +
+                                                type->ToString() + " is not supported");
+                }
+                primary_key_indices_.push_back(index);
+                fields.push_back(arrow::field("_KEY_" + name, type, false));
+            }
+            // KeyValue layout of primary-key data files
+            fields.push_back(arrow::field("_SEQUENCE_NUMBER", arrow::int64(), false));
+            fields.push_back(arrow::field("_VALUE_KIND", arrow::int8(), false));
+            for (const auto& field : schema_->fields()) {
+                fields.push_back(field);
+            }
+            file_schema_ = arrow::schema(std::move(fields));
+
+            // Every bucket holds whole keys: bucket on (a subset of) the primary key
+            if (bucket_count_ <= 0) {
+                bucket_count_ = 1;
+            }
+            if (bucket_key_.empty()) {
+                bucket_key_ = primary_key_;
+            }
+            for (const auto& name : bucket_key_) {
+                if (std::find(primary_key_.begin(), primary_key_.end(), name) == primary_key_.end()) {
+                    throw std::invalid_argument("bucket key column " + name + " is not in the primary key");
+                }
+            }
+        }
+        if (bucket_count_ > 0) {
+            if (bucket_key_.empty()) {
+                bucket_key_.push_back(schema_->field(0)->name());
+            }
+            for (const auto& name : bucket_key_) {
+                const int index = schema_->GetFieldIndex(name);
+                if (index < 0) {
+                    throw std::invalid_argument("bucket key column " + name + " is not in the schema");
+                }
+                bucket_key_indices_.push_back(index);
+            }
+        }
+        const int32_t buckets = std::max(bucket_count_, 1);
+
         // Create directory structure for Paimon table
         std::filesystem::create_directories(table_path_ + "/snapshot");
         std::filesystem::create_directories(table_path_ + "/manifest");
-        std::filesystem::create_directories(table_path_ + "/bucket-0");
         std::filesystem::create_directories(table_path_ + "/schema");
+        for (int32_t b = 0; b < buckets; ++b) {
+            std::filesystem::create_directories(table_path_ + "/bucket-" + std::to_string(b));
+            buckets_.push_back(std::make_unique<Bucket>());
+            buckets_.back()->id = b;
+        }
+
+        const auto cores = static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency()));
+        auto pool = arrow::internal::ThreadPool::Make(std::min(buckets, cores));
+        if (!pool.ok()) {
+            throw std::runtime_error("cannot start bucket writers: " + pool.status().ToString());
+        }
+        pool_ = *pool;
+        manifest_ = std::make_unique<AvroFileWriter>(manifest_entry_schema());
 
         schema_locked_ = true;
 
@@ -197,9 +566,16 @@ void PaimonWriter::initialize_paimon_table(
 void PaimonWriter::write_options_file() {
     try {
         std::ofstream options_file(table_path_ + "/OPTIONS");
-        options_file << "table.type=APPEND_ONLY\n";
+        options_file << "table.type=" << (has_primary_key_ ? "PRIMARY_KEY" : "APPEND_ONLY") << "\n";
         options_file << "data-files.format=parquet\n";
-        options_file << "bucket=-1\n";
+        if (has_primary_key_) {
+            options_file << "primary-key=" << join_names(primary_key_) << "\n";
+        }
+        options_file << "bucket=" << bucket_count_ << "\n";
+        if (bucket_count_ > 0) {
+            options_file << "bucket-key=" << join_names(bucket_key_) << "\n";
+        }
+        options_file << "target-file-size=" << target_file_size_ << "\n";
         options_file.close();
     } catch (const std::exception& e) {
         throw std::runtime_error(
@@ -220,13 +596,21 @@ void PaimonWriter::write_schema_file() {
             field_obj["id"] = i;
             field_obj["name"] = field->name();
             field_obj["type"] = arrow_type_to_paimon_type(field->type());
+            if (std::find(primary_key_indices_.begin(), primary_key_indices_.end(), i) !=
+                primary_key_indices_.end()) {
+                field_obj["type"] = field_obj["type"].get<std::string>() + " NOT NULL";
+            }
             fields_array.push_back(field_obj);
         }
 
         schema_json["fields"] = fields_array;
-        schema_json["primaryKeys"] = json::array();
+        schema_json["primaryKeys"] = primary_key_;
         schema_json["partitionKeys"] = json::array();
         schema_json["options"] = json::object();
+        if (bucket_count_ > 0) {
+            schema_json["options"]["bucket"] = std::to_string(bucket_count_);
+            schema_json["options"]["bucket-key"] = join_names(bucket_key_);
+        }
 
         std::ofstream schema_file(table_path_ + "/schema/schema-0");
         schema_file << schema_json.dump(2);  // Pretty-print with 2-space indent
@@ -239,59 +623,325 @@ void PaimonWriter::write_schema_file() {
     }
 }
 
-void PaimonWriter::write_data_file() {
-    if (batches_.empty()) {
-        return;
-    }
-
-    try {
-        // Generate data file name: data-<UUID>-<seq>.parquet
-        std::string uuid = generate_uuid();
-        std::ostringstream filename;
-        filename << "data-" << uuid << "-" << file_count_ << ".parquet";
-        std::string filepath = table_path_ + "/bucket-0/" + filename.str();
+void PaimonWriter::open_data_file(Bucket& bucket) {
+    // Data file name: data-<UUID>-<seq>.parquet
+    bucket.file_name = "data-" + generate_uuid() + "-" + std::to_string(bucket.file_count) + ".parquet";
+    const std::string filepath =
+        table_path_ + "/bucket-" + std::to_string(bucket.id) + "/" + bucket.file_name;
 
-        // Create table from batches
-        auto table_result = arrow::Table::FromRecordBatches(batches_);
-        if (!table_result.ok()) {
-            throw std::runtime_error("Failed to create Arrow table from batches: " + table_result.status().ToString());
-        }
-        auto table = table_result.ValueOrDie();
-
-        // Write to Parquet file
+    if (stream_factory_) {
+        bucket.stream = stream_factory_(filepath);
+    } else {
         auto file_result = arrow::io::FileOutputStream::Open(filepath);
         if (!file_result.ok()) {
             throw std::runtime_error("Failed to open file for writing: " + file_result.status().ToString());
         }
-        auto file = file_result.ValueOrDie();
+        bucket.stream = *file_result;
+    }
 
-        auto status = parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), file);
-        if (!status.ok()) {
-            throw std::runtime_error("Failed to write Parquet file: " + status.ToString());
+    // Buckets are the parallelism: each file is encoded on its own pool thread
+    auto arrow_props = parquet::ArrowWriterProperties::Builder().set_use_threads(false)->build();
+    auto writer_result = parquet::arrow::FileWriter::Open(
+        *file_schema_, arrow::default_memory_pool(), bucket.stream,
+        parquet::default_writer_properties(), arrow_props);
+    if (!writer_result.ok()) {
+        throw std::runtime_error("Failed to open Parquet writer: " + writer_result.status().ToString());
+    }
+    bucket.writer = std::move(*writer_result);
+    bucket.file_rows = 0;
+    bucket.file_arrow_bytes = 0;
+}
+
+void PaimonWriter::close_data_file(Bucket& bucket) {
+    auto status = bucket.writer->Close();
+    bucket.writer.reset();
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to write Parquet file: " + status.ToString());
+    }
+
+    // Size from the stream: the bytes may still be queued for the disk
+    auto size_result = bucket.stream->Tell();
+    if (!size_result.ok()) {
+        throw std::runtime_error("Failed to get Parquet file size: " + size_result.status().ToString());
+    }
+    const int64_t file_size = *size_result;
+
+    status = bucket.stream->Close();
+    bucket.stream.reset();
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to close Parquet file: " + status.ToString());
+    }
+
+    if (bucket.file_arrow_bytes > 0 && file_size > 0) {
+        bucket.encoded_ratio = static_cast<double>(file_size) / static_cast<double>(bucket.file_arrow_bytes);
+    }
+    bucket.file_count++;
+
+    DataFileInfo file{bucket.file_name, file_size, bucket.file_rows, bucket.id};
+    if (has_primary_key_) {
+        file.level = bucket.level;
+        file.min_key = std::move(bucket.file_min_key);
+        file.max_key = std::move(bucket.file_max_key);
+        file.max_sequence = bucket.file_max_sequence;
+    }
+    auto entry = encode_manifest_entry(file);
+    std::lock_guard<std::mutex> lock(files_mutex_);
+    manifest_->append_record(entry);
+    data_files_.push_back(file);
+    row_count_ += file.rows;
+}
+
+void PaimonWriter::write_to_bucket(Bucket& bucket, const std::shared_ptr<arrow::RecordBatch>& rows) {
+    if (!has_primary_key_) {
+        append_to_file(bucket, rows);
+        return;
+    }
+    const int key_count = static_cast<int>(primary_key_.size());
+    auto kv = to_key_value(*rows, bucket.next_sequence);
+    bucket.next_sequence += kv->num_rows();
+
+    // Rows that continue the streamed run in strictly ascending key order go
+    // straight to it; from the first one that does not, the bucket sorts
+    int64_t in_order = 0;
+    if (!bucket.sorting) {
+        const int64_t n = kv->num_rows();
+        while (in_order < n &&
+               (in_order > 0 ? compare_keys(*kv, in_order - 1, *kv, in_order, key_count) < 0
+                             : !bucket.last_row ||
+                                   compare_keys(*bucket.last_row, 0, *kv, 0, key_count) < 0)) {
+            ++in_order;
+        }
+        if (in_order > 0) {
+            append_to_file(bucket, in_order == n ? kv : kv->Slice(0, in_order));
+            bucket.last_row = kv->Slice(in_order - 1, 1);
+        }
+        if (in_order == n) {
+            return;
+        }
+        bucket.sorting = true;
+        bucket.last_row.reset();
+        if (bucket.writer) {
+            close_data_file(bucket);  // the streamed run ends here
         }
+    }
 
-        file->Close();
+    auto rest = in_order == 0 ? kv : kv->Slice(in_order);
+    bucket.buffered_bytes += measure_batch_bytes(*rest);
+    bucket.buffered.push_back(std::move(rest));
+    if (bucket.buffered_bytes >= sort_buffer_size_ / static_cast<int64_t>(buckets_.size())) {
+        spill(bucket);
+    }
+}
 
-        // Track file info
-        int64_t rows_written = 0;
-        for (const auto& batch : batches_) {
-            rows_written += batch->num_rows();
+std::shared_ptr<arrow::RecordBatch> PaimonWriter::to_key_value(const arrow::RecordBatch& rows,
+                                                               int64_t first_sequence) const {
+    const int64_t n = rows.num_rows();
+    arrow::ArrayVector columns;
+    for (size_t k = 0; k < primary_key_indices_.size(); ++k) {
+        const auto& key = rows.column(primary_key_indices_[k]);
+        if (key->null_count() > 0) {
+            throw std::runtime_error("primary key column " + primary_key_[k] + " has nulls");
         }
-        row_count_ += rows_written;
+        columns.push_back(key);
+    }
 
-        // Get file size
-        int64_t file_size = std::filesystem::file_size(filepath);
+    auto sequence = arrow::AllocateBuffer(n * static_cast<int64_t>(sizeof(int64_t)));
+    auto kind = arrow::AllocateBuffer(n);
+    if (!sequence.ok() || !kind.ok()) {
+        throw std::runtime_error("cannot allocate KeyValue columns");
+    }
+    auto* seq = reinterpret_cast<int64_t*>((*sequence)->mutable_data());
+    for (int64_t i = 0; i < n; ++i) {
+        seq[i] = first_sequence + i;
+    }
+    std::memset((*kind)->mutable_data(), 0, static_cast<size_t>(n));  // RowKind INSERT
+    columns.push_back(std::make_shared<arrow::Int64Array>(n, std::shared_ptr<arrow::Buffer>(std::move(*sequence))));
+    columns.push_back(std::make_shared<arrow::Int8Array>(n, std::shared_ptr<arrow::Buffer>(std::move(*kind))));
 
-        data_files_.push_back({filename.str(), file_size, rows_written});
-        file_count_++;
+    for (const auto& column : rows.columns()) {
+        columns.push_back(column);
+    }
+    return arrow::RecordBatch::Make(file_schema_, n, std::move(columns));
+}
 
-        // Clear batches for next file
-        batches_.clear();
+void PaimonWriter::spill(Bucket& bucket) {
+    if (bucket.buffered.empty()) {
+        return;
+    }
+    auto sorted = sort_rows(bucket.buffered, static_cast<int>(primary_key_.size()));
+    bucket.buffered.clear();
+    bucket.buffered_bytes = 0;
+
+    const std::string dir = spill_dir();
+    std::filesystem::create_directories(dir);
+    const std::string path = dir + "/bucket-" + std::to_string(bucket.id) + "-" +
+                             std::to_string(bucket.spills.size()) + ".arrow";
+    auto out = arrow::io::FileOutputStream::Open(path);
+    if (!out.ok()) {
+        throw std::runtime_error("cannot open spill file " + path + ": " + out.status().ToString());
+    }
+    auto writer = arrow::ipc::MakeFileWriter(*out, file_schema_);
+    if (!writer.ok()) {
+        throw std::runtime_error("cannot write spill file " + path + ": " + writer.status().ToString());
+    }
+    // Slices, so the merge reads one batch per run at a time
+    arrow::Status status;
+    for (int64_t offset = 0; status.ok() && offset < sorted->num_rows(); offset += kRunBatchRows) {
+        status = (*writer)->WriteRecordBatch(*sorted->Slice(offset, kRunBatchRows));
+    }
+    if (status.ok()) status = (*writer)->Close();
+    if (status.ok()) status = (*out)->Close();
+    if (!status.ok()) {
+        throw std::runtime_error("cannot write spill file " + path + ": " + status.ToString());
+    }
+    bucket.spills.push_back(path);
+}
 
-    } catch (const std::exception& e) {
-        throw std::runtime_error(
-            std::string("Failed to write Paimon data file: ") + e.what()
-        );
+void PaimonWriter::merge_spills(Bucket& bucket) {
+    const int key_count = static_cast<int>(primary_key_.size());
+    struct Run {
+        std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader;
+        int next_batch = 0;
+        std::shared_ptr<arrow::RecordBatch> batch;
+        int64_t row = 0;
+        uint32_t chunk = 0;
+    };
+    std::vector<Run> runs(bucket.spills.size());
+    std::vector<std::shared_ptr<arrow::RecordBatch>> chunks;  // batches the pending rows come from
+
+    auto advance = [&](Run& run) {
+        run.batch.reset();
+        run.row = 0;
+        while (!run.batch && run.next_batch < run.reader->num_record_batches()) {
+            auto batch = run.reader->ReadRecordBatch(run.next_batch++);
+            if (!batch.ok()) {
+                throw std::runtime_error("cannot read spill file: " + batch.status().ToString());
+            }
+            if ((*batch)->num_rows() > 0) {
+                run.batch = *batch;
+                run.chunk = static_cast<uint32_t>(chunks.size());
+                chunks.push_back(run.batch);
+            }
+        }
+        return run.batch != nullptr;
+    };
+
+    // Smallest key on top; equal keys come from the older run first
+    auto after = [&](size_t a, size_t b) {
+        const int c = compare_keys(*runs[a].batch, runs[a].row, *runs[b].batch, runs[b].row, key_count);
+        return c != 0 ? c > 0 : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+    for (size_t r = 0; r < runs.size(); ++r) {
+        auto file = arrow::io::ReadableFile::Open(bucket.spills[r]);
+        if (!file.ok()) {
+            throw std::runtime_error("cannot open spill file: " + file.status().ToString());
+        }
+        auto reader = arrow::ipc::RecordBatchFileReader::Open(*file);
+        if (!reader.ok()) {
+            throw std::runtime_error("cannot read spill file: " + reader.status().ToString());
+        }
+        runs[r].reader = *reader;
+        if (advance(runs[r])) heap.push(r);
+    }
+
+    std::vector<RowGroupClusterer::RowRef> order;
+    auto flush = [&]() {
+        if (order.empty()) return;
+        append_to_file(bucket, RowGroupClusterer::gather(chunks, order));
+        order.clear();
+        // Keep only the batches the runs are still reading
+        chunks.clear();
+        for (auto& run : runs) {
+            if (run.batch) {
+                run.chunk = static_cast<uint32_t>(chunks.size());
+                chunks.push_back(run.batch);
+            }
+        }
+    };
+    while (!heap.empty()) {
+        const size_t r = heap.top();
+        heap.pop();
+        Run& run = runs[r];
+        order.push_back({run.chunk, static_cast<uint32_t>(run.row)});
+        if (++run.row < run.batch->num_rows() || advance(run)) {
+            heap.push(r);
+        }
+        if (static_cast<int64_t>(order.size()) >= kRunBatchRows) {
+            flush();
+        }
+    }
+    flush();
+
+    for (const auto& path : bucket.spills) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    bucket.spills.clear();
+}
+
+void PaimonWriter::finish_bucket(Bucket& bucket) {
+    if (bucket.writer) {
+        close_data_file(bucket);
+    }
+    if (bucket.buffered.empty() && bucket.spills.empty()) {
+        return;
+    }
+    // The sorted rows form one more run, below the streamed one if there is one
+    bucket.level = bucket.file_count > 0 ? NUM_LEVELS - 2 : NUM_LEVELS - 1;
+    if (bucket.spills.empty()) {
+        auto sorted = sort_rows(bucket.buffered, static_cast<int>(primary_key_.size()));
+        bucket.buffered.clear();
+        for (int64_t offset = 0; offset < sorted->num_rows(); offset += kRunBatchRows) {
+            append_to_file(bucket, sorted->Slice(offset, kRunBatchRows));
+        }
+    } else {
+        spill(bucket);
+        merge_spills(bucket);
+    }
+    if (bucket.writer) {
+        close_data_file(bucket);
+    }
+}
+
+void PaimonWriter::append_to_file(Bucket& bucket, const std::shared_ptr<arrow::RecordBatch>& rows) {
+    if (!bucket.writer) {
+        open_data_file(bucket);
+    }
+    auto status = bucket.writer->WriteRecordBatch(*rows);
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to write Parquet data: " + status.ToString());
+    }
+    if (has_primary_key_) {
+        // Sorted rows: the file's key range runs from its first row to its last
+        const auto keys = leading_columns(static_cast<int>(primary_key_.size()));
+        if (bucket.file_rows == 0) {
+            bucket.file_min_key = paimon_detail::serialize_key(*rows, keys, 0);
+            bucket.file_max_sequence = 0;
+        }
+        bucket.file_max_key = paimon_detail::serialize_key(*rows, keys, rows->num_rows() - 1);
+        const auto* seq = rows->column(static_cast<int>(keys.size()))->data()->GetValues<int64_t>(1);
+        bucket.file_max_sequence = std::max(bucket.file_max_sequence,
+                                            *std::max_element(seq, seq + rows->num_rows()));
+    }
+    bucket.file_rows += rows->num_rows();
+    bucket.file_arrow_bytes += measure_batch_bytes(*rows);
+
+    // The open row group is not on the stream yet: estimate it at the
+    // encoded/Arrow ratio of the bucket's previous file
+    const int64_t flushed = bucket.stream->Tell().ValueOr(0);
+    const auto estimate = static_cast<int64_t>(static_cast<double>(bucket.file_arrow_bytes) *
+                                               bucket.encoded_ratio);
+    if (std::max(flushed, estimate) >= target_file_size_) {
+        close_data_file(bucket);
+    }
+}
+
+void PaimonWriter::await(Bucket& bucket) {
+    const auto status = bucket.in_flight.status();
+    bucket.in_flight = arrow::Future<>::MakeFinished();
+    if (!status.ok()) {
+        throw std::runtime_error("bucket " + std::to_string(bucket.id) + ": " + status.message());
     }
 }
 
@@ -305,11 +955,11 @@ std::vector<uint8_t> PaimonWriter::encode_manifest_entry(const DataFileInfo& fil
     const uint8_t empty_partition[] = {0x04, 0x00, 0x00, 0x00};
     avro_detail::write_avro_bytes(record, empty_partition, 4);
 
-    // _BUCKET: int 0
-    avro_detail::write_zigzag_int(record, 0);
+    // _BUCKET: int
+    avro_detail::write_zigzag_int(record, file.bucket);
 
-    // _TOTAL_BUCKETS: int -1
-    avro_detail::write_zigzag_int(record, -1);
+    // _TOTAL_BUCKETS: int (-1 for a bucket-unaware table)
+    avro_detail::write_zigzag_int(record, bucket_count_ > 0 ? bucket_count_ : -1);
 
     // _FILE (nested DataFileMetadata record, no length prefix)
     // fileName: string
@@ -318,14 +968,18 @@ std::vector<uint8_t> PaimonWriter::encode_manifest_entry(const DataFileInfo& fil
     // fileSize: long
     avro_detail::write_zigzag_long(record, file.size);
 
-    // level: int 0
-    avro_detail::write_zigzag_int(record, 0);
-
-    // minKey: union null (index 0)
-    avro_detail::write_union_null(record);
+    // level: int (0 for append tables; sorted runs sit at the top levels)
+    avro_detail::write_zigzag_int(record, file.level);
 
-    // maxKey: union null
-    avro_detail::write_union_null(record);
+    // minKey / maxKey: union null, or the serialized key BinaryRow
+    for (const auto* key : {&file.min_key, &file.max_key}) {
+        if (key->empty()) {
+            avro_detail::write_union_null(record);
+        } else {
+            avro_detail::write_union_index(record, 1);
+            avro_detail::write_avro_bytes(record, key->data(), key->size());
+        }
+    }
 
     // minColumnStats: union null
     avro_detail::write_union_null(record);
@@ -339,8 +993,8 @@ std::vector<uint8_t> PaimonWriter::encode_manifest_entry(const DataFileInfo& fil
     // rowCount: long
     avro_detail::write_zigzag_long(record, file.rows);
 
-    // sequenceNumber: long 0
-    avro_detail::write_zigzag_long(record, 0);
+    // sequenceNumber: long (highest _SEQUENCE_NUMBER in the file)
+    avro_detail::write_zigzag_long(record, file.max_sequence);
 
     // fileSource: string "APPEND"
     avro_detail::write_avro_string(record, "APPEND");
@@ -378,22 +1032,15 @@ std::vector<uint8_t> PaimonWriter::encode_manifest_list_entry(
 
 std::string PaimonWriter::write_data_manifest() {
     try {
-        // Create Avro file writer
-        AvroFileWriter writer(manifest_entry_schema());
-
-        // Encode and append one entry per data file
-        for (const auto& file : data_files_) {
-            auto entry = encode_manifest_entry(file);
-            writer.append_record(entry);
-        }
-
+        // Entries were encoded as the data files closed
         // Generate manifest filename
         std::string uuid = generate_uuid();
         std::string manifest_name = "manifest-" + uuid + "-0";
         std::string manifest_path = table_path_ + "/manifest/" + manifest_name;
 
         // Write Avro container file
-        writer.finish(manifest_path);
+        manifest_->finish(manifest_path);
+        manifest_.reset();
 
         return manifest_name;
 
@@ -505,17 +1152,40 @@ void PaimonWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch)
     }
 
     try {
-        // Accumulate batch for buffered writing
-        batches_.push_back(batch);
-
-        // Write when we have accumulated enough batches (~10M rows per file)
-        int64_t accumulated_rows = 0;
-        for (const auto& b : batches_) {
-            accumulated_rows += b->num_rows();
+        // At most one batch in flight per bucket: wait for the previous one
+        auto dispatch = [&](Bucket& bucket, std::vector<RowGroupClusterer::RowRef> rows) {
+            await(bucket);
+            auto task = [this, &bucket, batch, rows = std::move(rows)]() -> arrow::Status {
+                try {
+                    // A fixed bucket's rows are copied out here, on the pool thread
+                    const bool all = rows.empty() || static_cast<int64_t>(rows.size()) == batch->num_rows();
+                    write_to_bucket(bucket, all ? batch : RowGroupClusterer::gather({batch}, rows));
+                } catch (const std::exception& e) {
+                    return arrow::Status::IOError(e.what());
+                }
+                return arrow::Status::OK();
+            };
+            auto future = pool_->Submit(std::move(task));
+            if (!future.ok()) {
+                throw std::runtime_error("cannot queue bucket write: " + future.status().ToString());
+            }
+            bucket.in_flight = std::move(*future);
+        };
+
+        if (bucket_count_ <= 0) {
+            dispatch(*buckets_[0], {});
+            return;
         }
-
-        if (accumulated_rows >= 10000000) {
-            write_data_file();
+        paimon_detail::compute_buckets(*batch, bucket_key_indices_, bucket_count_, &row_buckets_);
+        std::vector<std::vector<RowGroupClusterer::RowRef>> rows(buckets_.size());
+        for (int64_t i = 0; i < batch->num_rows(); ++i) {
+            rows[static_cast<size_t>(row_buckets_[static_cast<size_t>(i)])].push_back(
+                {0, static_cast<uint32_t>(i)});
+        }
+        for (size_t b = 0; b < rows.size(); ++b) {
+            if (!rows[b].empty()) {
+                dispatch(*buckets_[b], std::move(rows[b]));
+            }
         }
 
     } catch (const std::exception& e) {
@@ -525,41 +1195,284 @@ void PaimonWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch)
     }
 }
 
-void PaimonWriter::close() {
-    if (!schema_locked_ || closed_) {
-        return;  // Nothing to close or already closed
+bool PaimonWriter::set_output_stream_factory(OutputStreamFactory factory) {
+    if (schema_locked_) {
+        throw std::runtime_error("Paimon output stream factory must be set before the first write");
     }
+    stream_factory_ = std::move(factory);
+    return true;
+}
 
-    try {
-        // Flush remaining batches to data file
-        if (!batches_.empty()) {
-            write_data_file();
+void PaimonWriter::set_buckets(int32_t buckets, std::vector<std::string> bucket_key) {
+    if (schema_locked_) {
+        throw std::runtime_error("Paimon buckets must be set before the first write");
+    }
+    bucket_count_ = buckets > 0 ? buckets : -1;
+    bucket_key_ = std::move(bucket_key);
+}
+
+void PaimonWriter::set_target_file_size(int64_t bytes) {
+    if (bytes <= 0) {
+        throw std::invalid_argument("Paimon target file size must be positive");
+    }
+    if (schema_locked_) {
+        throw std::runtime_error("Paimon target file size must be set before the first write");
+    }
+    target_file_size_ = bytes;
+}
+
+void PaimonWriter::set_primary_key(std::vector<std::string> columns) {
+    if (schema_locked_) {
+        throw std::runtime_error("Paimon primary key must be set before the first write");
+    }
+    has_primary_key_ = true;
+    primary_key_ = std::move(columns);
+}
+
+void PaimonWriter::set_sort_buffer_size(int64_t bytes) {
+    if (bytes <= 0) {
+        throw std::invalid_argument("Paimon sort buffer size must be positive");
+    }
+    if (schema_locked_) {
+        throw std::runtime_error("Paimon sort buffer size must be set before the first write");
+    }
+    sort_buffer_size_ = bytes;
+}
+
+std::vector<std::string> PaimonWriter::default_primary_key(const arrow::Schema& schema) {
+    static const std::vector<std::vector<std::string>> keys = {
+        // TPC-H
+        {"l_orderkey", "l_linenumber"}, {"o_orderkey"}, {"c_custkey"}, {"p_partkey"},
+        {"ps_partkey", "ps_suppkey"}, {"s_suppkey"}, {"n_nationkey"}, {"r_regionkey"},
+        // TPC-DS facts
+        {"ss_item_sk", "ss_ticket_number"}, {"sr_item_sk", "sr_ticket_number"},
+        {"cs_item_sk", "cs_order_number"}, {"cr_item_sk", "cr_order_number"},
+        {"ws_item_sk", "ws_order_number"}, {"wr_item_sk", "wr_order_number"},
+        {"inv_date_sk", "inv_item_sk", "inv_warehouse_sk"},
+        // TPC-DS dimensions: surrogate keys
+        {"c_customer_sk"}, {"ca_address_sk"}, {"cd_demo_sk"}, {"hd_demo_sk"},
+        {"ib_income_band_id"}, {"i_item_sk"}, {"d_date_sk"}, {"t_time_sk"},
+        {"cc_call_center_sk"}, {"cp_catalog_page_sk"}, {"wp_web_page_sk"}, {"web_site_sk"},
+        {"w_warehouse_sk"}, {"sm_ship_mode_sk"}, {"r_reason_sk"}, {"p_promo_sk"},
+        {"s_store_sk"},
+    };
+    for (const auto& key : keys) {
+        bool present = true;
+        for (const auto& column : key) {
+            present = present && schema.GetFieldIndex(column) >= 0;
         }
+        if (present) return key;
+    }
+    return {};
+}
 
-        // Write manifests and snapshot only if we have data files
-        if (!data_files_.empty()) {
-            // Write data manifest (contains all data file entries)
-            std::string manifest_name = write_data_manifest();
+void PaimonWriter::commit_files() {
+    // Write manifests and snapshot only if we have data files
+    if (!data_files_.empty()) {
+        // Write data manifest (contains all data file entries)
+        std::string manifest_name = write_data_manifest();
 
-            // Stat manifest file for size
-            int64_t manifest_size = std::filesystem::file_size(
-                table_path_ + "/manifest/" + manifest_name
-            );
+        // Stat manifest file for size
+        int64_t manifest_size = std::filesystem::file_size(
+            table_path_ + "/manifest/" + manifest_name
+        );
+
+        // Write manifest list (references the manifest file)
+        std::string manifest_list_name = write_manifest_list(manifest_name, manifest_size);
+
+        // Write snapshot metadata
+        write_snapshot(manifest_list_name);
+    }
+
+    // Write snapshot hint files
+    write_snapshot_hints();
+}
 
-            // Write manifest list (references the manifest file)
-            std::string manifest_list_name = write_manifest_list(manifest_name, manifest_size);
+std::string PaimonWriter::spill_dir() const {
+    return table_path_ + "/_spill" + (writer_id_.empty() ? "" : "/" + writer_id_);
+}
 
-            // Write snapshot metadata
-            write_snapshot(manifest_list_name);
+void PaimonWriter::set_deferred_commit(const std::string& writer_id) {
+    if (schema_locked_) {
+        throw std::runtime_error("Paimon deferred commit must be set before the first write");
+    }
+    if (writer_id.empty() || writer_id[0] == '.' ||
+        writer_id.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_.-")
+            != std::string::npos) {
+        throw std::invalid_argument("invalid Paimon writer id '" + writer_id + "'");
+    }
+    writer_id_ = writer_id;
+}
+
+void PaimonWriter::write_pending() {
+    auto hex = [](const std::vector<uint8_t>& bytes) {
+        static const char digits[] = "0123456789abcdef";
+        std::string out;
+        for (uint8_t b : bytes) {
+            out += digits[b >> 4];
+            out += digits[b & 15];
+        }
+        return out;
+    };
+    json files = json::array();
+    for (const auto& file : data_files_) {
+        json entry = {{"name", file.name}, {"size", file.size}, {"rows", file.rows},
+                      {"bucket", file.bucket}, {"level", file.level},
+                      {"maxSequence", file.max_sequence}};
+        if (!file.min_key.empty()) {
+            entry["minKey"] = hex(file.min_key);
+            entry["maxKey"] = hex(file.max_key);
         }
+        files.push_back(std::move(entry));
+    }
+    json pending;
+    pending["writer"] = writer_id_;
+    pending["bucket"] = bucket_count_;
+    pending["primaryKeys"] = primary_key_;
+    pending["files"] = std::move(files);
+
+    // Written aside and renamed: commit() never sees half a sidecar
+    const std::string dir = table_path_ + "/_pending";
+    const std::string path = dir + "/" + writer_id_ + ".json";
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream out(path + ".tmp");
+        out << pending.dump(1) << "\n";
+        if (!out.flush()) {
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+    std::filesystem::rename(path + ".tmp", path);
+}
+
+size_t PaimonWriter::commit(const std::string& table_path) {
+    const std::filesystem::path dir = table_path + "/_pending";
+    std::vector<std::filesystem::path> sidecars;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.path().extension() == ".json") {
+            sidecars.push_back(entry.path());
+        }
+    }
+    if (sidecars.empty()) {
+        return 0;
+    }
+    std::sort(sidecars.begin(), sidecars.end());
+    if (std::filesystem::exists(table_path + "/snapshot/snapshot-1")) {
+        throw std::runtime_error("Paimon table " + table_path + " already has a snapshot");
+    }
+
+    auto unhex = [](const std::string& hex) {
+        std::vector<uint8_t> bytes;
+        for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+            bytes.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+        }
+        return bytes;
+    };
+
+    PaimonWriter committer(table_path);
+    std::vector<std::vector<size_t>> writers_of_bucket;  // sidecar indices per bucket
+    for (size_t s = 0; s < sidecars.size(); ++s) {
+        json pending;
+        try {
+            std::ifstream in(sidecars[s]);
+            pending = json::parse(in);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("cannot read " + sidecars[s].string() + ": " + e.what());
+        }
+        const auto buckets = pending.at("bucket").get<int32_t>();
+        auto primary_key = pending.at("primaryKeys").get<std::vector<std::string>>();
+        if (s == 0) {
+            committer.bucket_count_ = buckets;
+            committer.primary_key_ = std::move(primary_key);
+            committer.has_primary_key_ = !committer.primary_key_.empty();
+        } else if (buckets != committer.bucket_count_ || primary_key != committer.primary_key_) {
+            throw std::runtime_error(sidecars[s].string() + " has other buckets or primary key than " +
+                                     sidecars[0].string());
+        }
+        for (const auto& entry : pending.at("files")) {
+            DataFileInfo file{entry.at("name").get<std::string>(), entry.at("size").get<int64_t>(),
+                              entry.at("rows").get<int64_t>(), entry.at("bucket").get<int32_t>()};
+            file.level = entry.at("level").get<int32_t>();
+            file.max_sequence = entry.at("maxSequence").get<int64_t>();
+            if (entry.contains("minKey")) {
+                file.min_key = unhex(entry.at("minKey").get<std::string>());
+                file.max_key = unhex(entry.at("maxKey").get<std::string>());
+            }
+            const auto b = static_cast<size_t>(std::max(file.bucket, 0));
+            if (writers_of_bucket.size() <= b) {
+                writers_of_bucket.resize(b + 1);
+            }
+            if (writers_of_bucket[b].empty() || writers_of_bucket[b].back() != s) {
+                writers_of_bucket[b].push_back(s);
+            }
+            committer.data_files_.push_back(std::move(file));
+        }
+    }
+
+    committer.manifest_ = std::make_unique<AvroFileWriter>(manifest_entry_schema());
+    for (auto& file : committer.data_files_) {
+        // Runs of different writers may overlap: level 0 files are merged on read
+        if (committer.has_primary_key_ && writers_of_bucket[std::max(file.bucket, 0)].size() > 1) {
+            file.level = 0;
+        }
+        committer.manifest_->append_record(committer.encode_manifest_entry(file));
+        committer.row_count_ += file.rows;
+    }
+    std::filesystem::create_directories(table_path + "/manifest");
+    std::filesystem::create_directories(table_path + "/snapshot");
+    committer.commit_files();
+    committer.manifest_.reset();
+    std::filesystem::remove_all(dir);
+    return committer.data_files_.size();
+}
+
+void PaimonWriter::close() {
+    if (!schema_locked_ || closed_) {
+        return;  // Nothing to close or already closed
+    }
 
-        // Write snapshot hint files
-        write_snapshot_hints();
+    closed_ = true;  // no second attempt from the destructor
 
-        closed_ = true;
+    try {
+        // Finish every bucket (open file, sort buffer, spills), concurrently like the writes
+        for (auto& bucket : buckets_) {
+            await(*bucket);
+            if (!bucket->writer && bucket->buffered.empty() && bucket->spills.empty()) {
+                continue;
+            }
+            Bucket* b = bucket.get();
+            auto future = pool_->Submit([this, b]() -> arrow::Status {
+                try {
+                    finish_bucket(*b);
+                } catch (const std::exception& e) {
+                    return arrow::Status::IOError(e.what());
+                }
+                return arrow::Status::OK();
+            });
+            if (!future.ok()) {
+                throw std::runtime_error("cannot queue bucket close: " + future.status().ToString());
+            }
+            bucket->in_flight = std::move(*future);
+        }
+        for (auto& bucket : buckets_) {
+            await(*bucket);
+        }
+        std::error_code ec;
+        std::filesystem::remove_all(spill_dir(), ec);
+        std::filesystem::remove(table_path_ + "/_spill", ec);  // if no other writer spills
+
+        // Deferred: describe the files for commit(); otherwise commit them now
+        if (!writer_id_.empty()) {
+            write_pending();
+        } else {
+            commit_files();
+        }
 
     } catch (const std::exception& e) {
-        std::cerr << "Warning finalizing Paimon table: " << e.what() << std::endl;
+        // Bucket files are written asynchronously: ENOSPC/EIO surface only here
+        std::cerr << "PaimonWriter::close error: " << e.what() << std::endl;
+        throw;
     }
 }
 
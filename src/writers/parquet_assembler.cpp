@@ -0,0 +1,314 @@
+#include "tpch/parquet_assembler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <arrow/io/memory.h>
+#include <arrow/util/thread_pool.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/metadata.h>
+#include <parquet/parquet_version.h>
+
+namespace tpch {
+
+namespace {
+
+// Thrift field ids from parquet.thrift
+namespace fmd { constexpr int16_t NUM_ROWS = 3, ROW_GROUPS = 4, ENCRYPTION = 8; }
+namespace rg  { constexpr int16_t COLUMNS = 1, NUM_ROWS = 3, FILE_OFFSET = 5, ORDINAL = 7; }
+namespace cc {
+constexpr int16_t FILE_OFFSET = 2, META = 3, OFFSET_INDEX_OFFSET = 4, OFFSET_INDEX_LENGTH = 5,
+                  COLUMN_INDEX_OFFSET = 6, COLUMN_INDEX_LENGTH = 7, CRYPTO = 8;
+}
+namespace cmd {
+constexpr int16_t COMPRESSED_SIZE = 7, DATA_PAGE = 9, INDEX_PAGE = 10, DICT_PAGE = 11,
+                  BLOOM_OFFSET = 14, BLOOM_LENGTH = 15;
+}
+constexpr int16_t PAGE_LOCATIONS = 1, PAGE_OFFSET = 1;  // OffsetIndex, PageLocation
+constexpr int16_t BLOOM_NUM_BYTES = 1;                  // BloomFilterHeader
+
+constexpr char MAGIC[4] = {'P', 'A', 'R', '1'};
+
+[[noreturn]] void fail(const std::string& what) {
+    throw std::runtime_error("Parquet assembler: " + what);
+}
+
+void set_int(ThriftValue& s, int16_t id, uint8_t type, int64_t v) {
+    if (ThriftValue* f = s.field(id)) {
+        f->i = v;
+        return;
+    }
+    ThriftValue f;
+    f.type = type;
+    f.i = v;
+    // Keep ids ascending so the encoder can use short field headers
+    auto it = std::find_if(s.fields.begin(), s.fields.end(),
+                           [&](const auto& p) { return p.first > id; });
+    s.fields.insert(it, {id, std::move(f)});
+}
+
+void shift(ThriftValue* f, int64_t delta) {
+    if (f && f->i > 0) f->i += delta;
+}
+
+// [begin, end) of a column chunk's pages
+std::pair<int64_t, int64_t> chunk_range(const ThriftValue& meta) {
+    int64_t begin = meta.int_field(cmd::DATA_PAGE);
+    for (int16_t id : {cmd::DICT_PAGE, cmd::INDEX_PAGE}) {
+        const int64_t off = meta.int_field(id);
+        if (off > 0) begin = std::min(begin, off);
+    }
+    return {begin, begin + meta.int_field(cmd::COMPRESSED_SIZE)};
+}
+
+std::string slice(const arrow::Buffer& file, int64_t off, int64_t len) {
+    if (off < 0 || len < 0 || off + len > file.size()) fail("index out of bounds");
+    return std::string(reinterpret_cast<const char*>(file.data()) + off, len);
+}
+
+}  // namespace
+
+ParquetFileAssembler::ParquetFileAssembler(std::shared_ptr<arrow::io::OutputStream> sink)
+    : sink_(std::move(sink)) {}
+
+void ParquetFileAssembler::write(std::shared_ptr<arrow::Buffer> data) {
+    const int64_t n = data->size();
+    auto status = sink_->Write(std::move(data));
+    if (!status.ok()) fail("write failed: " + status.ToString());
+    pos_ += n;
+}
+
+void ParquetFileAssembler::append(const std::shared_ptr<arrow::Buffer>& file) {
+    if (finished_) fail("append after finish");
+    const int64_t size = file->size();
+    const uint8_t* bytes = file->data();
+    if (size < 12 || std::memcmp(bytes, MAGIC, 4) != 0 || std::memcmp(bytes + size - 4, MAGIC, 4) != 0) {
+        fail("not a plain (unencrypted) Parquet file");
+    }
+    uint32_t footer_len = 0;
+    std::memcpy(&footer_len, bytes + size - 8, 4);  // little-endian hosts
+    if (footer_len > static_cast<uint64_t>(size - 12)) fail("bad footer length");
+    ThriftValue meta = decode_thrift_struct(bytes + size - 8 - footer_len, footer_len);
+    if (meta.field(fmd::ENCRYPTION)) fail("encrypted files are not supported");
+
+    ThriftValue* groups = meta.field(fmd::ROW_GROUPS);
+    if (!groups || groups->items.empty()) return;
+    // RowGroup.ordinal is an i16
+    if (row_groups_.size() + groups->items.size() >
+        static_cast<size_t>(std::numeric_limits<int16_t>::max()) + 1) {
+        fail("more than 32768 row groups in one file; raise --row-group-mb");
+    }
+
+    if (pos_ == 0) {
+        footer_ = meta;
+        write(std::make_shared<arrow::Buffer>(reinterpret_cast<const uint8_t*>(MAGIC), 4));
+    }
+
+    // Pages of all row groups are contiguous; copy them as one slice
+    int64_t begin = std::numeric_limits<int64_t>::max();
+    int64_t end = 0;
+    for (const auto& group : groups->items) {
+        const ThriftValue* columns = group.field(rg::COLUMNS);
+        if (!columns) fail("row group without columns");
+        for (const auto& chunk : columns->items) {
+            if (chunk.field(cc::CRYPTO)) fail("encrypted columns are not supported");
+            const ThriftValue* md = chunk.field(cc::META);
+            if (!md) fail("column chunk without metadata");
+            auto [b, e] = chunk_range(*md);
+            begin = std::min(begin, b);
+            end = std::max(end, e);
+        }
+    }
+    if (begin < 4 || end > size - 8 - static_cast<int64_t>(footer_len) || begin > end) {
+        fail("column chunks outside the data region");
+    }
+    const int64_t delta = pos_ - begin;
+    write(arrow::SliceBuffer(file, begin, end - begin));
+
+    for (auto& group : groups->items) {
+        shift(group.field(rg::FILE_OFFSET), delta);
+        set_int(group, rg::ORDINAL, ThriftValue::I16,
+                static_cast<int16_t>(row_groups_.size()));
+        num_rows_ += group.int_field(rg::NUM_ROWS);
+
+        std::vector<PageIndex> indexes;
+        for (auto& chunk : group.field(rg::COLUMNS)->items) {
+            shift(chunk.field(cc::FILE_OFFSET), delta);
+            ThriftValue& md = *chunk.field(cc::META);
+            for (int16_t id : {cmd::DATA_PAGE, cmd::INDEX_PAGE, cmd::DICT_PAGE}) {
+                shift(md.field(id), delta);
+            }
+
+            // Bloom filter: header + bitset, copied right after this file's pages
+            if (ThriftValue* bloom = md.field(cmd::BLOOM_OFFSET)) {
+                int64_t len = md.int_field(cmd::BLOOM_LENGTH, -1);
+                if (len < 0) {
+                    if (bloom->i < 0 || bloom->i >= size) fail("bloom filter out of bounds");
+                    size_t header_len = 0;
+                    auto header = decode_thrift_struct(bytes + bloom->i,
+                                                       static_cast<size_t>(size - bloom->i),
+                                                       &header_len);
+                    len = static_cast<int64_t>(header_len) + header.int_field(BLOOM_NUM_BYTES);
+                }
+                if (bloom->i < 0 || bloom->i + len > size) fail("bloom filter out of bounds");
+                const int64_t at = pos_;
+                write(arrow::SliceBuffer(file, bloom->i, len));
+                bloom->i = at;
+            }
+
+            PageIndex index;
+            const int64_t ci_len = chunk.int_field(cc::COLUMN_INDEX_LENGTH);
+            if (chunk.field(cc::COLUMN_INDEX_OFFSET) && ci_len > 0) {
+                index.column_index = slice(*file, chunk.int_field(cc::COLUMN_INDEX_OFFSET), ci_len);
+            }
+            const int64_t oi_len = chunk.int_field(cc::OFFSET_INDEX_LENGTH);
+            if (chunk.field(cc::OFFSET_INDEX_OFFSET) && oi_len > 0) {
+                // Page locations hold absolute offsets: rebase and re-encode
+                const int64_t oi_off = chunk.int_field(cc::OFFSET_INDEX_OFFSET);
+                slice(*file, oi_off, oi_len);  // bounds check
+                auto oi = decode_thrift_struct(bytes + oi_off, static_cast<size_t>(oi_len));
+                if (ThriftValue* locations = oi.field(PAGE_LOCATIONS)) {
+                    for (auto& loc : locations->items) shift(loc.field(PAGE_OFFSET), delta);
+                }
+                index.offset_index = encode_thrift_struct(oi);
+            }
+            indexes.push_back(std::move(index));
+        }
+        page_indexes_.push_back(std::move(indexes));
+        row_groups_.push_back(std::move(group));
+        ++num_row_groups_;
+    }
+}
+
+void ParquetFileAssembler::finish() {
+    if (finished_) return;
+    if (pos_ == 0) fail("no row groups appended");
+    finished_ = true;
+
+    // All column indexes, then all offset indexes, as Arrow lays them out
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t g = 0; g < row_groups_.size(); ++g) {
+            auto& columns = row_groups_[g].field(rg::COLUMNS)->items;
+            for (size_t c = 0; c < columns.size(); ++c) {
+                std::string& bytes = pass == 0 ? page_indexes_[g][c].column_index
+                                               : page_indexes_[g][c].offset_index;
+                if (bytes.empty()) continue;
+                set_int(columns[c], pass == 0 ? cc::COLUMN_INDEX_OFFSET : cc::OFFSET_INDEX_OFFSET,
+                        ThriftValue::I64, pos_);
+                set_int(columns[c], pass == 0 ? cc::COLUMN_INDEX_LENGTH : cc::OFFSET_INDEX_LENGTH,
+                        ThriftValue::I32, static_cast<int64_t>(bytes.size()));
+                write(arrow::Buffer::FromString(std::move(bytes)));
+            }
+        }
+    }
+    page_indexes_.clear();
+
+    set_int(footer_, fmd::NUM_ROWS, ThriftValue::I64, num_rows_);
+    ThriftValue* groups = footer_.field(fmd::ROW_GROUPS);
+    groups->items = std::move(row_groups_);
+    row_groups_.clear();
+
+    std::string footer = encode_thrift_struct(footer_);
+    const auto len = static_cast<int64_t>(footer.size());
+    if (len > std::numeric_limits<int32_t>::max()) fail("footer too large");
+#if PARQUET_VERSION_MAJOR >= 26
+    metadata_ = parquet::FileMetaData::Make(footer.data(), len);
+#else
+    uint32_t meta_len = static_cast<uint32_t>(len);
+    metadata_ = parquet::FileMetaData::Make(footer.data(), &meta_len);
+#endif
+    for (int shift = 0; shift < 32; shift += 8) {  // footer length, little-endian
+        footer.push_back(static_cast<char>((len >> shift) & 0xff));
+    }
+    footer.append(MAGIC, 4);
+    write(arrow::Buffer::FromString(std::move(footer)));
+}
+
+ParallelRowGroupWriter::ParallelRowGroupWriter(
+    std::shared_ptr<arrow::io::OutputStream> sink,
+    std::shared_ptr<arrow::Schema> schema,
+    std::shared_ptr<parquet::WriterProperties> props,
+    int threads,
+    arrow::MemoryPool* pool)
+    : schema_(std::move(schema))
+    , props_(std::move(props))
+    , pool_(pool)
+    , threads_(static_cast<size_t>(std::max(1, threads)))
+    , row_group_rows_(std::max<int64_t>(1, props_->max_row_group_length()))
+    , assembler_(std::move(sink)) {
+    auto encoders = arrow::internal::ThreadPool::Make(static_cast<int>(threads_));
+    if (!encoders.ok()) {
+        throw std::runtime_error("Failed to start row group encoders: " +
+                                 encoders.status().ToString());
+    }
+    encoders_ = *encoders;
+}
+
+ParallelRowGroupWriter::~ParallelRowGroupWriter() {
+    for (auto& f : inflight_) f.Wait();
+}
+
+void ParallelRowGroupWriter::write(const std::shared_ptr<arrow::RecordBatch>& batch,
+                                   std::shared_ptr<void> owner) {
+    if (closed_) throw std::runtime_error("Parquet row group writer is closed");
+    const int64_t rows = batch->num_rows();
+    int64_t offset = 0;
+    while (offset < rows) {
+        const int64_t take = std::min(rows - offset, row_group_rows_ - pending_rows_);
+        pending_.push_back(offset == 0 && take == rows ? batch : batch->Slice(offset, take));
+        if (owner) pending_owners_.push_back(owner);
+        pending_rows_ += take;
+        offset += take;
+        if (pending_rows_ == row_group_rows_) submit();
+    }
+}
+
+void ParallelRowGroupWriter::submit() {
+    drain(threads_ - 1);
+
+    auto task = [schema = schema_, props = props_, pool = pool_, batches = std::move(pending_),
+                 owners = std::move(pending_owners_)]()
+        -> arrow::Result<std::shared_ptr<arrow::Buffer>> {
+        ARROW_ASSIGN_OR_RAISE(auto sink, arrow::io::BufferOutputStream::Create(1 << 20, pool));
+        // One row group per task: columns are encoded on this thread
+        auto arrow_props = parquet::ArrowWriterProperties::Builder().set_use_threads(false)->build();
+        ARROW_ASSIGN_OR_RAISE(auto writer, parquet::arrow::FileWriter::Open(
+                                               *schema, pool, sink, props, arrow_props));
+        for (const auto& b : batches) ARROW_RETURN_NOT_OK(writer->WriteRecordBatch(*b));
+        ARROW_RETURN_NOT_OK(writer->Close());
+        return sink->Finish();
+    };
+    pending_.clear();
+    pending_owners_.clear();
+    pending_rows_ = 0;
+
+    auto future = encoders_->Submit(std::move(task));
+    if (!future.ok()) {
+        throw std::runtime_error("Failed to queue row group encode: " + future.status().ToString());
+    }
+    inflight_.push_back(std::move(*future));
+}
+
+void ParallelRowGroupWriter::drain(size_t keep) {
+    while (inflight_.size() > keep) {
+        auto result = inflight_.front().result();
+        inflight_.pop_front();
+        if (!result.ok()) {
+            throw std::runtime_error("Failed to encode Parquet row group: " +
+                                     result.status().ToString());
+        }
+        assembler_.append(*result);
+    }
+}
+
+void ParallelRowGroupWriter::close() {
+    if (closed_) return;
+    closed_ = true;
+    if (pending_rows_ > 0) submit();
+    drain(0);
+    assembler_.finish();
+}
+
+}  // namespace tpch
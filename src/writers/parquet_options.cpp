@@ -0,0 +1,370 @@
+#include "tpch/parquet_options.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/parquet_version.h>
+
+namespace tpch {
+
+namespace {
+
+bool ends_with(const std::string& s, const char* suffix) {
+    const std::string suf(suffix);
+    return s.size() >= suf.size() && s.compare(s.size() - suf.size(), suf.size(), suf) == 0;
+}
+
+// Surrogate and natural keys: dense, mostly generated in ascending order.
+bool is_key_column(const std::string& name) {
+    return ends_with(name, "key") || ends_with(name, "_sk") ||
+           ends_with(name, "_number") || ends_with(name, "_id");
+}
+
+bool is_integer_like(arrow::Type::type tid) {
+    return arrow::is_integer(tid) || tid == arrow::Type::DATE32 ||
+           tid == arrow::Type::DATE64 || tid == arrow::Type::TIMESTAMP;
+}
+
+bool is_float_or_double(arrow::Type::type tid) {
+    return tid == arrow::Type::DOUBLE || tid == arrow::Type::FLOAT;
+}
+
+bool is_string_like(arrow::Type::type tid) {
+    return tid == arrow::Type::STRING || tid == arrow::Type::LARGE_STRING ||
+           tid == arrow::Type::BINARY || tid == arrow::Type::LARGE_BINARY;
+}
+
+ColumnEncoding plain(const std::string& name) {
+    return {name, parquet::Encoding::PLAIN, false};
+}
+
+ColumnEncoding dictionary(const std::string& name) {
+    return {name, parquet::Encoding::RLE_DICTIONARY, true};
+}
+
+// Plain and Tuned: decided by type and name alone. An empty column name
+// leaves the writer default (e.g. Arrow dictionary columns keep theirs).
+ColumnEncoding rule_for(const arrow::Field& field, EncodingProfile profile) {
+    const auto tid = field.type()->id();
+    const auto& name = field.name();
+    if (profile == EncodingProfile::Plain) {
+        if (tid == arrow::Type::INT64 || tid == arrow::Type::INT32 || is_float_or_double(tid) ||
+            tid == arrow::Type::STRING || tid == arrow::Type::LARGE_STRING ||
+            tid == arrow::Type::BINARY) {
+            return plain(name);
+        }
+        return {};
+    }
+    if (is_integer_like(tid)) {
+        if (is_key_column(name)) return {name, parquet::Encoding::DELTA_BINARY_PACKED, false};
+        return dictionary(name);  // flags, quantities, line numbers: few distinct values
+    }
+    if (is_float_or_double(tid)) return {name, parquet::Encoding::BYTE_STREAM_SPLIT, false};
+    if (is_string_like(tid)) return plain(name);
+    return {};
+}
+
+std::vector<ColumnEncoding> candidates_for(const arrow::Field& field) {
+    const auto tid = field.type()->id();
+    const auto& name = field.name();
+    if (is_integer_like(tid)) {
+        return {plain(name), {name, parquet::Encoding::DELTA_BINARY_PACKED, false}, dictionary(name)};
+    }
+    if (is_float_or_double(tid)) {
+        return {plain(name), {name, parquet::Encoding::BYTE_STREAM_SPLIT, false}, dictionary(name)};
+    }
+    if (is_string_like(tid)) {
+        return {plain(name), {name, parquet::Encoding::DELTA_LENGTH_BYTE_ARRAY, false},
+                dictionary(name)};
+    }
+    return {};
+}
+
+// Encode one single-column batch in memory with candidate; fills
+// sample_bytes / sample_ms.
+void measure(ColumnEncoding& candidate, const std::shared_ptr<arrow::RecordBatch>& batch,
+             const ParquetOptions& options, parquet::Compression::type codec) {
+    parquet::WriterProperties::Builder builder;
+    builder.compression(codec);
+    apply_parquet_options(builder, {candidate}, options, codec);
+    auto props = builder.build();
+    auto arrow_props = parquet::ArrowWriterProperties::Builder().set_use_threads(false)->build();
+
+    auto sink = arrow::io::BufferOutputStream::Create();
+    if (!sink.ok()) throw std::runtime_error("encoding sample: " + sink.status().ToString());
+
+    const auto start = std::chrono::steady_clock::now();
+    auto writer = parquet::arrow::FileWriter::Open(*batch->schema(), arrow::default_memory_pool(),
+                                                   *sink, props, arrow_props);
+    arrow::Status st = writer.status();
+    if (st.ok()) st = (*writer)->WriteRecordBatch(*batch);
+    if (st.ok()) st = (*writer)->Close();
+    const auto stop = std::chrono::steady_clock::now();
+    if (!st.ok()) {
+        // Not supported for this column (e.g. by an older Parquet library)
+        candidate.sample_bytes = -1;
+        return;
+    }
+    candidate.sample_bytes = (*sink)->Tell().ValueOr(-1);
+    candidate.sample_ms = std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Sort keys of tables generated in key order. Column names are unique
+// across TPC-H and TPC-DS, so the first column identifies the table.
+const std::vector<std::vector<std::string>>& generation_orders() {
+    static const std::vector<std::vector<std::string>> orders = {
+        // TPC-H
+        {"l_orderkey", "l_linenumber"}, {"o_orderkey"}, {"c_custkey"}, {"p_partkey"},
+        {"ps_partkey"}, {"s_suppkey"}, {"n_nationkey"}, {"r_regionkey"},
+        // TPC-DS facts: one ticket / order per dsdgen row index
+        {"ss_ticket_number"}, {"sr_ticket_number"}, {"cs_order_number"},
+        {"cr_order_number"}, {"ws_order_number"}, {"wr_order_number"}, {"inv_date_sk"},
+        // TPC-DS dimensions: surrogate key = row index
+        {"c_customer_sk"}, {"ca_address_sk"}, {"cd_demo_sk"}, {"hd_demo_sk"},
+        {"ib_income_band_id"}, {"i_item_sk"}, {"d_date_sk"}, {"t_time_sk"},
+        {"cc_call_center_sk"}, {"cp_catalog_page_sk"}, {"wp_web_page_sk"}, {"web_site_sk"},
+        {"w_warehouse_sk"}, {"sm_ship_mode_sk"}, {"r_reason_sk"}, {"p_promo_sk"},
+        {"s_store_sk"},
+    };
+    return orders;
+}
+
+}  // namespace
+
+std::string ColumnEncoding::encoding_name() const {
+    return parquet::EncodingToString(encoding);
+}
+
+EncodingProfile ParquetOptions::parse_profile(const std::string& name) {
+    if (name == "plain") return EncodingProfile::Plain;
+    if (name == "tuned") return EncodingProfile::Tuned;
+    if (name == "auto")  return EncodingProfile::Auto;
+    throw std::invalid_argument("--encoding-profile must be plain, tuned or auto, not '" +
+                                name + "'");
+}
+
+void ParquetOptions::parse_zstd_levels(const std::string& spec) {
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        const std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) {
+            throw std::invalid_argument("--zstd-level: empty item in '" + spec + "'");
+        }
+
+        const size_t eq = item.find('=');
+        const std::string value = eq == std::string::npos ? item : item.substr(eq + 1);
+        int level = 0;
+        try {
+            size_t used = 0;
+            level = std::stoi(value, &used);
+            if (used != value.size()) throw std::invalid_argument(value);
+        } catch (const std::exception&) {
+            throw std::invalid_argument("--zstd-level: bad level '" + value + "'");
+        }
+        if (level < 1 || level > 22) {
+            throw std::invalid_argument("--zstd-level: level must be 1..22, not " + value);
+        }
+        if (eq == std::string::npos) {
+            zstd_level = level;
+        } else if (eq == 0) {
+            throw std::invalid_argument("--zstd-level: missing column name in '" + item + "'");
+        } else {
+            column_zstd_levels[item.substr(0, eq)] = level;
+        }
+    }
+}
+
+void ParquetOptions::parse_bloom_filter_columns(const std::string& spec) {
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        const std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) {
+            throw std::invalid_argument("--bloom-filter: empty item in '" + spec + "'");
+        }
+        if (item == "keys") {
+            const auto& keys = default_bloom_filter_columns();
+            bloom_filter_columns.insert(bloom_filter_columns.end(), keys.begin(), keys.end());
+        } else {
+            bloom_filter_columns.push_back(item);
+        }
+    }
+}
+
+void ParquetOptions::parse_cluster_columns(const std::string& spec) {
+    cluster_columns.clear();
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) comma = spec.size();
+        const std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) {
+            throw std::invalid_argument("--cluster-within-rowgroup: empty item in '" + spec + "'");
+        }
+        cluster_columns.push_back(item);
+    }
+}
+
+const std::vector<std::string>& default_bloom_filter_columns() {
+    static const std::vector<std::string> keys = {
+        "l_partkey", "l_suppkey", "ps_suppkey", "o_custkey",
+        "ss_item_sk", "ss_customer_sk", "cs_item_sk", "ws_item_sk",
+        "sr_item_sk", "cr_item_sk", "wr_item_sk", "inv_item_sk",
+    };
+    return keys;
+}
+
+std::vector<std::string> generation_sort_columns(const arrow::Schema& schema) {
+    for (const auto& order : generation_orders()) {
+        bool present = true;
+        for (const auto& column : order) {
+            present = present && schema.GetFieldIndex(column) >= 0;
+        }
+        if (present) return order;
+    }
+    return {};
+}
+
+std::vector<ColumnEncoding> choose_column_encodings(
+    const arrow::Schema& schema, const ParquetOptions& options,
+    parquet::Compression::type codec,
+    const std::shared_ptr<arrow::RecordBatch>& sample) {
+    std::vector<ColumnEncoding> chosen;
+    const bool sampling = options.encoding_profile == EncodingProfile::Auto && sample &&
+                          sample->num_rows() > 0;
+    const auto rule_profile = options.encoding_profile == EncodingProfile::Plain
+                                  ? EncodingProfile::Plain
+                                  : EncodingProfile::Tuned;
+
+    for (int i = 0; i < schema.num_fields(); ++i) {
+        const auto& field = *schema.field(i);
+        auto candidates = sampling ? candidates_for(field) : std::vector<ColumnEncoding>{};
+        if (candidates.empty()) {
+            auto rule = rule_for(field, rule_profile);
+            if (!rule.column.empty()) chosen.push_back(std::move(rule));
+            continue;
+        }
+
+        const int idx = sample->schema()->GetFieldIndex(field.name());
+        if (idx < 0) {
+            throw std::runtime_error("encoding sample has no column " + field.name());
+        }
+        const int64_t rows = std::min(sample->num_rows(), std::max<int64_t>(options.sample_rows, 1));
+        auto slice = arrow::RecordBatch::Make(arrow::schema({schema.field(i)}), rows,
+                                              {sample->column(idx)->Slice(0, rows)});
+        for (auto& c : candidates) measure(c, slice, options, codec);
+
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                        [](const ColumnEncoding& c) { return c.sample_bytes < 0; }),
+                         candidates.end());
+        if (candidates.empty()) {
+            chosen.push_back(rule_for(field, EncodingProfile::Tuned));
+            continue;
+        }
+        const auto smallest = std::min_element(
+            candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) { return a.sample_bytes < b.sample_bytes; });
+        const double limit = static_cast<double>(smallest->sample_bytes) * (1.0 + options.auto_size_slack);
+        const ColumnEncoding* best = &*smallest;
+        for (const auto& c : candidates) {
+            if (static_cast<double>(c.sample_bytes) <= limit && c.sample_ms < best->sample_ms) {
+                best = &c;
+            }
+        }
+        chosen.push_back(*best);
+    }
+    return chosen;
+}
+
+void apply_parquet_options(parquet::WriterProperties::Builder& builder,
+                           const std::vector<ColumnEncoding>& encodings,
+                           const ParquetOptions& options,
+                           parquet::Compression::type codec) {
+    for (const auto& e : encodings) {
+        if (e.dictionary) {
+            builder.enable_dictionary(e.column);
+        } else {
+            builder.disable_dictionary(e.column);
+            if (e.encoding != parquet::Encoding::PLAIN) {
+                builder.encoding(e.column, e.encoding);
+            }
+        }
+    }
+
+    if (!options.has_zstd_levels()) return;
+    if (codec != parquet::Compression::ZSTD) {
+        throw std::invalid_argument("--zstd-level needs zstd compression");
+    }
+    if (options.zstd_level != 0) {
+        builder.compression_level(options.zstd_level);
+    }
+    for (const auto& [column, level] : options.column_zstd_levels) {
+        builder.compression_level(column, level);
+    }
+}
+
+void apply_layout_options(parquet::WriterProperties::Builder& builder,
+                          const arrow::Schema& schema,
+                          const ParquetOptions& options,
+                          int64_t row_bytes) {
+    if (options.row_group_bytes > 0 && row_bytes > 0) {
+        builder.max_row_group_length(std::max<int64_t>(1, options.row_group_bytes / row_bytes));
+    }
+    if (options.page_bytes > 0) {
+        builder.data_pagesize(options.page_bytes);
+    }
+
+    if (options.page_index) {
+#if PARQUET_VERSION_MAJOR >= 12
+        builder.enable_write_page_index();
+#else
+        throw std::runtime_error("--page-index needs Parquet C++ 12 or later");
+#endif
+    }
+
+    if (!options.bloom_filter_columns.empty()) {
+#if PARQUET_VERSION_MAJOR >= 22
+        parquet::BloomFilterOptions bloom;
+        bloom.fpp = options.bloom_filter_fpp;  // NDV defaults to the row group length
+        for (const auto& column : options.bloom_filter_columns) {
+            if (schema.GetFieldIndex(column) >= 0) builder.enable_bloom_filter(column, bloom);
+        }
+#else
+        throw std::runtime_error("--bloom-filter needs Parquet C++ 22 or later");
+#endif
+    }
+
+    std::vector<std::string> clustered;
+    for (const auto& column : options.cluster_columns) {
+        if (schema.GetFieldIndex(column) >= 0) clustered.push_back(column);
+    }
+    if (options.declare_sort_order || !clustered.empty()) {
+        // Rows clustered within each row group no longer follow the key order
+        const auto order = clustered.empty() ? generation_sort_columns(schema) : clustered;
+        if (!order.empty()) {
+#if PARQUET_VERSION_MAJOR >= 15
+            // Flat schemas: the Parquet leaf index is the Arrow field index
+            std::vector<parquet::SortingColumn> sorting;
+            for (const auto& column : order) {
+                // The clusterer puts nulls first
+                sorting.push_back({schema.GetFieldIndex(column), false, !clustered.empty()});
+            }
+            builder.set_sorting_columns(std::move(sorting));
+#else
+            throw std::runtime_error("sorting_columns need Parquet C++ 15 or later");
+#endif
+        }
+    }
+}
+
+}  // namespace tpch
@@ -1,6 +1,10 @@
 #include "tpch/parquet_writer.hpp"
 #include "tpch/async_io.hpp"
+#include "tpch/parquet_assembler.hpp"
+#include "tpch/batch_sizer.hpp"
 #include "tpch/performance_counters.hpp"
+#include "tpch/row_group_clusterer.hpp"
+#include "tpch/s3_output_stream.hpp"
 
 #include <iostream>
 #include <vector>
@@ -13,6 +17,7 @@
 #include <arrow/api.h>
 #include <arrow/io/api.h>
 #include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
 
 namespace tpch {
 
@@ -28,11 +33,11 @@ ParquetWriter::ParquetWriter(
     , memory_pool_(memory_pool ? memory_pool : arrow::default_memory_pool())
     , estimated_rows_(estimated_rows) {
 
-    // Create parent directory if it doesn't exist
+    // Create parent directory if it doesn't exist (object store keys need none)
     std::filesystem::path file_path(filepath);
     std::filesystem::path parent_dir = file_path.parent_path();
 
-    if (!parent_dir.empty()) {
+    if (!parent_dir.empty() && !is_s3_uri(filepath)) {
         std::error_code ec;
         std::filesystem::create_directories(parent_dir, ec);
         if (ec) {
@@ -86,17 +91,18 @@ void ParquetWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch
     if (streaming_mode_) {
         // Streaming mode: Write batch immediately (NO ACCUMULATION!)
         // Lazy initialization of FileWriter on first batch
-        if (!parquet_file_writer_) {
+        if (!parquet_file_writer_ && !row_group_writer_) {
             init_file_writer();
         }
-
-        // Write batch immediately
-        auto status = parquet_file_writer_->WriteRecordBatch(*batch);
-        if (!status.ok()) {
-            throw std::runtime_error("Failed to write RecordBatch: " + status.message());
+        if (clusterer_) {
+            for (const auto& group : clusterer_->push(batch)) {
+                write_streaming(group);
+            }
+            return;
         }
 
         // Batch is discarded after write (no memory accumulation)
+        write_streaming(batch);
     } else {
         // Batch accumulation mode (original behavior)
         batches_.push_back(batch);
@@ -118,11 +124,18 @@ void ParquetWriter::enable_streaming_write(bool use_threads) {
 void ParquetWriter::set_output_stream(std::shared_ptr<arrow::io::OutputStream> stream) {
     if (!streaming_mode_)
         throw std::runtime_error("set_output_stream: streaming mode must be enabled first");
-    if (parquet_file_writer_)
+    if (parquet_file_writer_ || row_group_writer_)
         throw std::runtime_error("set_output_stream: must be called before the first write");
     injected_stream_ = std::move(stream);
 }
 
+bool ParquetWriter::set_output_stream_factory(OutputStreamFactory factory) {
+    if (!streaming_mode_)
+        enable_streaming_write();
+    set_output_stream(factory(filepath_));
+    return true;
+}
+
 void ParquetWriter::write_managed_batch(const ManagedRecordBatch& managed_batch) {
     if (closed_) {
         throw std::runtime_error("Cannot write to a closed Parquet writer");
@@ -144,15 +157,19 @@ void ParquetWriter::write_managed_batch(const ManagedRecordBatch& managed_batch)
     if (streaming_mode_) {
         // Streaming mode: Write batch immediately
         // Lifetime manager is freed after this function returns (optimal memory usage)
-        if (!parquet_file_writer_) {
+        if (!parquet_file_writer_ && !row_group_writer_) {
             init_file_writer();
         }
+        if (clusterer_) {
+            // Buffered until its row group is full; groups are fresh copies
+            for (const auto& group : clusterer_->push(managed_batch.batch, managed_batch.lifetime_mgr)) {
+                write_streaming(group);
+            }
+            return;
+        }
 
         // Write batch immediately
-        auto status = parquet_file_writer_->WriteRecordBatch(*managed_batch.batch);
-        if (!status.ok()) {
-            throw std::runtime_error("Failed to write RecordBatch: " + status.message());
-        }
+        write_streaming(managed_batch.batch, managed_batch.lifetime_mgr);
 
         // After this function returns, managed_batch goes out of scope
         // → lifetime_mgr refcount drops to 0
@@ -165,13 +182,45 @@ void ParquetWriter::write_managed_batch(const ManagedRecordBatch& managed_batch)
     }
 }
 
-// Build WriterProperties with chosen compression.
-// Disables Parquet's auto-dict for:
-//   - numeric types (int64, int32, float64): high-cardinality FK/price cols
-//   - plain string types (utf8, large_utf8, binary): high-cardinality comment/name cols
-//     where BinaryMemoTable hashtable is pure overhead.
-// Arrow DictionaryArray columns (dict8 string fields) are NOT affected —
-// Parquet receives pre-built index arrays for those and never runs its own dict encoder.
+void ParquetWriter::write_streaming(const std::shared_ptr<arrow::RecordBatch>& batch,
+                                    std::shared_ptr<void> owner) {
+    if (row_group_writer_) {
+        // Encoded later on a pool thread: the batch keeps its owner until then
+        row_group_writer_->write(batch, std::move(owner));
+        return;
+    }
+    auto status = parquet_file_writer_->WriteRecordBatch(*batch);
+    if (!status.ok()) {
+        throw std::runtime_error("Failed to write RecordBatch: " + status.message());
+    }
+}
+
+void ParquetWriter::write_buffered(parquet::arrow::FileWriter& writer, int64_t row_group_rows) {
+    auto write = [&](const std::shared_ptr<arrow::RecordBatch>& batch) {
+        auto status = writer.WriteRecordBatch(*batch);
+        if (!status.ok()) {
+            throw std::runtime_error("Failed to write RecordBatch: " + status.message());
+        }
+    };
+    RowGroupClusterer clusterer(first_batch_->schema(), parquet_options_.cluster_columns,
+                                row_group_rows);
+    if (!clusterer.active()) {
+        // Write each RecordBatch directly (NO TABLE CONSTRUCTION!)
+        for (const auto& batch : batches_) write(batch);
+        for (const auto& managed_batch : managed_batches_) write(managed_batch.batch);
+        return;
+    }
+    for (const auto& batch : batches_) {
+        for (const auto& group : clusterer.push(batch)) write(group);
+    }
+    for (const auto& managed_batch : managed_batches_) {
+        for (const auto& group : clusterer.push(managed_batch.batch)) write(group);
+    }
+    if (auto rest = clusterer.flush()) {
+        write(rest);
+    }
+}
+
 static parquet::Compression::type parse_compression(const std::string& codec)
 {
     if (codec == "snappy") return parquet::Compression::SNAPPY;
@@ -181,21 +230,32 @@ static parquet::Compression::type parse_compression(const std::string& codec)
         " (supported: snappy, zstd, none)");
 }
 
-static std::shared_ptr<parquet::WriterProperties>
-make_writer_props(const arrow::Schema& schema, const std::string& codec)
+// Build WriterProperties with the chosen compression and column encodings.
+// The default (plain) profile disables Parquet's auto-dict for:
+//   - numeric types (int64, int32, float64): high-cardinality FK/price cols
+//   - plain string types (utf8, large_utf8, binary): high-cardinality comment/name cols
+//     where BinaryMemoTable hashtable is pure overhead.
+// Arrow DictionaryArray columns (dict8 string fields) are NOT affected —
+// Parquet receives pre-built index arrays for those and never runs its own dict encoder.
+// The auto profile samples first_batch_; the choice is made once per file.
+std::shared_ptr<parquet::WriterProperties> ParquetWriter::make_writer_props()
 {
-    auto builder = parquet::WriterProperties::Builder();
-    builder.compression(parse_compression(codec));
-    for (const auto& field : schema.fields()) {
-        auto tid = field->type()->id();
-        if (tid == arrow::Type::INT64  || tid == arrow::Type::INT32  ||
-            tid == arrow::Type::DOUBLE || tid == arrow::Type::FLOAT  ||
-            tid == arrow::Type::STRING  || tid == arrow::Type::LARGE_STRING ||
-            tid == arrow::Type::BINARY) {
-            builder.disable_dictionary(field->name());
-        }
+    const auto codec = parse_compression(compression_codec_);
+    if (!encodings_chosen_) {
+        TPCH_SCOPED_TIMER("parquet_choose_encodings");
+        column_encodings_ = choose_column_encodings(*first_batch_->schema(), parquet_options_,
+                                                    codec, first_batch_);
+        encodings_chosen_ = true;
     }
-    return builder.build();
+    auto builder = parquet::WriterProperties::Builder();
+    builder.compression(codec);
+    apply_parquet_options(builder, column_encodings_, parquet_options_, codec);
+    const int64_t rows = first_batch_->num_rows();
+    apply_layout_options(builder, *first_batch_->schema(), parquet_options_,
+                         rows > 0 ? measure_batch_bytes(*first_batch_) / rows : 0);
+    auto props = builder.build();
+    row_group_rows_ = props->max_row_group_length();
+    return props;
 }
 
 void ParquetWriter::set_compression(const std::string& codec)
@@ -203,8 +263,43 @@ void ParquetWriter::set_compression(const std::string& codec)
     compression_codec_ = codec;
 }
 
+void ParquetWriter::set_parquet_options(const ParquetOptions& options)
+{
+    if (parquet_file_writer_ || row_group_writer_) {
+        throw std::runtime_error("Cannot change Parquet options after writing has begun");
+    }
+    parquet_options_ = options;
+    encodings_chosen_ = false;
+    row_group_rows_ = 0;
+}
+
+bool ParquetWriter::set_cluster_columns(const std::vector<std::string>& columns)
+{
+    if (parquet_file_writer_ || row_group_writer_) {
+        throw std::runtime_error("Cannot change Parquet options after writing has begun");
+    }
+    parquet_options_.cluster_columns = columns;
+    return true;
+}
+
+size_t ParquetWriter::preferred_unit_rows() const
+{
+    if (row_group_rows_ > 0) {
+        return static_cast<size_t>(row_group_rows_);  // what the FileWriter was given
+    }
+    if (parquet_options_.row_group_bytes > 0) {
+        return 0;  // sized in bytes: the batch sizer converts with its bytes/row
+    }
+    return static_cast<size_t>(parquet::default_writer_properties()->max_row_group_length());
+}
+
+size_t ParquetWriter::preferred_unit_bytes() const
+{
+    return static_cast<size_t>(parquet_options_.row_group_bytes);
+}
+
 void ParquetWriter::init_file_writer() {
-    if (parquet_file_writer_) {
+    if (parquet_file_writer_ || row_group_writer_) {
         return;  // Already initialized
     }
 
@@ -213,7 +308,7 @@ void ParquetWriter::init_file_writer() {
     }
 
     // Configure Parquet writer properties
-    auto writer_props = make_writer_props(*first_batch_->schema(), compression_codec_);
+    auto writer_props = make_writer_props();
 
     auto arrow_props = parquet::ArrowWriterProperties::Builder()
         .set_use_threads(use_threads_)
@@ -231,6 +326,23 @@ void ParquetWriter::init_file_writer() {
         outfile = outfile_result.ValueOrDie();
     }
 
+    if (!parquet_options_.cluster_columns.empty()) {
+        auto clusterer = std::make_unique<RowGroupClusterer>(
+            first_batch_->schema(), parquet_options_.cluster_columns,
+            writer_props->max_row_group_length());
+        if (clusterer->active()) {
+            clusterer_ = std::move(clusterer);
+        }
+    }
+
+    if (parquet_options_.row_group_threads > 1) {
+        // Several row groups compress at once; the assembler appends them in order
+        row_group_writer_ = std::make_unique<ParallelRowGroupWriter>(
+            outfile, first_batch_->schema(), writer_props,
+            parquet_options_.row_group_threads, memory_pool_);
+        return;
+    }
+
     // Create FileWriter for streaming RecordBatches
     auto writer_result = parquet::arrow::FileWriter::Open(
         *first_batch_->schema(),
@@ -261,14 +373,36 @@ void ParquetWriter::close() {
     try {
         if (streaming_mode_) {
             // Streaming mode: All batches already written, just close the writer
+            if (clusterer_) {
+                if (auto rest = clusterer_->flush()) {
+                    write_streaming(rest);
+                }
+                clusterer_.reset();
+            }
             if (parquet_file_writer_) {
                 TPCH_SCOPED_TIMER("parquet_close_streaming");
                 auto status = parquet_file_writer_->Close();
                 if (!status.ok()) {
                     throw std::runtime_error("Failed to close Parquet writer: " + status.message());
                 }
+                file_metadata_ = parquet_file_writer_->metadata();
                 parquet_file_writer_.reset();
             }
+            if (row_group_writer_) {
+                TPCH_SCOPED_TIMER("parquet_close_streaming");
+                row_group_writer_->close();
+                file_metadata_ = row_group_writer_->metadata();
+                row_group_writer_.reset();
+            }
+            // FileWriter leaves the sink open; an injected stream may only
+            // publish the file on Close() (S3 multipart upload).
+            if (injected_stream_) {
+                auto status = injected_stream_->Close();
+                injected_stream_.reset();
+                if (!status.ok()) {
+                    throw std::runtime_error("Failed to close Parquet output: " + status.message());
+                }
+            }
         } else if (async_context_) {
             // Async batch mode: Write all batches to memory buffer, then async write to disk
 
@@ -285,7 +419,7 @@ void ParquetWriter::close() {
                 TPCH_SCOPED_TIMER("parquet_encode_batches");
 
                 // Configure Parquet writer properties
-                auto writer_props = make_writer_props(*first_batch_->schema(), compression_codec_);
+                auto writer_props = make_writer_props();
 
                 auto arrow_props = parquet::ArrowWriterProperties::Builder()
                     .set_use_threads(use_threads_)
@@ -305,27 +439,15 @@ void ParquetWriter::close() {
                 }
                 auto writer = std::move(writer_result.ValueOrDie());
 
-                // Write each RecordBatch directly (NO TABLE CONSTRUCTION!)
-                for (const auto& batch : batches_) {
-                    auto status = writer->WriteRecordBatch(*batch);
-                    if (!status.ok()) {
-                        throw std::runtime_error("Failed to write RecordBatch: " + status.message());
-                    }
-                }
-
-                // Also write managed batches (Phase 14.2.3)
-                for (const auto& managed_batch : managed_batches_) {
-                    auto status = writer->WriteRecordBatch(*managed_batch.batch);
-                    if (!status.ok()) {
-                        throw std::runtime_error("Failed to write ManagedRecordBatch: " + status.message());
-                    }
-                }
+                // Batches, then managed batches (Phase 14.2.3)
+                write_buffered(*writer, writer_props->max_row_group_length());
 
                 // Close writer
                 auto close_status = writer->Close();
                 if (!close_status.ok()) {
                     throw std::runtime_error("Failed to close Parquet writer: " + close_status.message());
                 }
+                file_metadata_ = writer->metadata();
             }
 
             // Get the complete buffer
@@ -373,7 +495,7 @@ void ParquetWriter::close() {
             TPCH_SCOPED_TIMER("parquet_encode_sync");
 
             // Configure Parquet writer properties
-            auto writer_props = make_writer_props(*first_batch_->schema(), compression_codec_);
+            auto writer_props = make_writer_props();
 
             auto arrow_props = parquet::ArrowWriterProperties::Builder()
                 .set_use_threads(use_threads_)
@@ -400,27 +522,15 @@ void ParquetWriter::close() {
             }
             auto writer = std::move(writer_result.ValueOrDie());
 
-            // Write each RecordBatch directly (NO TABLE CONSTRUCTION!)
-            for (const auto& batch : batches_) {
-                auto status = writer->WriteRecordBatch(*batch);
-                if (!status.ok()) {
-                    throw std::runtime_error("Failed to write RecordBatch: " + status.message());
-                }
-            }
-
-            // Also write managed batches (Phase 14.2.3)
-            for (const auto& managed_batch : managed_batches_) {
-                auto status = writer->WriteRecordBatch(*managed_batch.batch);
-                if (!status.ok()) {
-                    throw std::runtime_error("Failed to write ManagedRecordBatch: " + status.message());
-                }
-            }
+            // Batches, then managed batches (Phase 14.2.3)
+            write_buffered(*writer, writer_props->max_row_group_length());
 
             // Close writer
             auto close_status = writer->Close();
             if (!close_status.ok()) {
                 throw std::runtime_error("Failed to close Parquet writer: " + close_status.message());
             }
+            file_metadata_ = writer->metadata();
         }
 
         closed_ = true;
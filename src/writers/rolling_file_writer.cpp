@@ -0,0 +1,316 @@
+#include "tpch/rolling_file_writer.hpp"
+#include "tpch/batch_sizer.hpp"
+#include "tpch/parquet_writer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/metadata.h>
+
+namespace tpch {
+
+RollingFileWriter::RollingFileWriter(std::string dir, std::string extension,
+                                     int64_t target_bytes, PartFactory factory)
+    : dir_(std::move(dir))
+    , extension_(std::move(extension))
+    , target_bytes_(target_bytes)
+    , factory_(std::move(factory)) {
+    if (target_bytes_ <= 0) {
+        throw std::invalid_argument("RollingFileWriter: target file size must be positive");
+    }
+    if (dir_.find("://") == std::string::npos) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+        if (ec) {
+            throw std::runtime_error("RollingFileWriter: cannot create " + dir_ + ": " +
+                                     ec.message());
+        }
+    }
+    // Part 0 up front: stream factory, async context and the batch sizer's
+    // unit queries all need a writer before the first batch
+    open_part();
+}
+
+RollingFileWriter::~RollingFileWriter() = default;
+
+std::string RollingFileWriter::part_name(size_t index, const std::string& extension) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "part-%05zu.", index);
+    return buf + extension;
+}
+
+std::string RollingFileWriter::dataset_dir(const std::string& file_path) {
+    const size_t slash = file_path.find_last_of('/');
+    const size_t dot = file_path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return file_path;
+    }
+    return file_path.substr(0, dot);
+}
+
+void RollingFileWriter::open_part() {
+    current_path_ = dir_ + "/" + part_name(parts_.size(), extension_);
+    current_stream_.reset();
+    part_rows_ = 0;
+    part_arrow_bytes_ = 0;
+    current_ = factory_(current_path_);
+    if (async_context_) {
+        current_->set_async_context(async_context_);
+    }
+    if (!cluster_columns_.empty()) {
+        current_->set_cluster_columns(cluster_columns_);
+    }
+    if (stream_factory_) {
+        current_->set_output_stream_factory([this](const std::string& path) {
+            current_stream_ = stream_factory_(path);
+            return current_stream_;
+        });
+    }
+}
+
+int64_t RollingFileWriter::current_bytes() const {
+    int64_t written = 0;
+    if (current_stream_) {
+        written = current_stream_->Tell().ValueOr(0);
+    } else {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(current_path_, ec);
+        if (!ec) written = static_cast<int64_t>(size);
+    }
+    if (written > 0) {
+        return written;
+    }
+    // Nothing on disk yet: the writer holds the file until close()
+    return static_cast<int64_t>(static_cast<double>(part_arrow_bytes_) * encoded_ratio_);
+}
+
+void RollingFileWriter::close_part() {
+    WriterPtr writer = std::move(current_);
+    writer->close();
+    if (part_rows_ == 0) {
+        return;  // empty table: no part
+    }
+
+    // Repository streams keep Tell() after Close(); FileOutputStream does not
+    int64_t bytes = current_stream_ ? current_stream_->Tell().ValueOr(-1) : -1;
+    if (bytes <= 0) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(current_path_, ec);
+        bytes = ec ? 0 : static_cast<int64_t>(size);
+    }
+    if (bytes > 0 && part_arrow_bytes_ > 0) {
+        encoded_ratio_ = static_cast<double>(bytes) / static_cast<double>(part_arrow_bytes_);
+    }
+
+    if (auto* pw = dynamic_cast<ParquetWriter*>(writer.get())) {
+        parquet_footers_.push_back(pw->file_metadata());
+    }
+    parts_.push_back({part_name(parts_.size(), extension_), part_rows_, bytes});
+    current_stream_.reset();
+}
+
+void RollingFileWriter::write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) {
+    if (closed_) {
+        throw std::runtime_error("RollingFileWriter: write after close");
+    }
+    if (!batch || batch->num_rows() == 0) {
+        return;
+    }
+    // Roll only between whole row groups / strides. A batch that crosses a
+    // unit boundary is split there: adaptive or non-dividing batch sizes
+    // would otherwise rarely land on one, and the part would never roll.
+    const int64_t batch_bytes = measure_batch_bytes(*batch);
+    int64_t offset = 0;
+    while (offset < batch->num_rows()) {
+        if (!current_) {
+            open_part();
+        }
+        const auto unit = static_cast<int64_t>(current_->preferred_unit_rows());
+        int64_t rows = batch->num_rows() - offset;
+        if (unit > 0) {
+            rows = std::min(rows, unit - part_rows_ % unit);
+        }
+        current_->write_batch(rows == batch->num_rows() ? batch : batch->Slice(offset, rows));
+        part_rows_ += rows;
+        part_arrow_bytes_ += batch_bytes * rows / batch->num_rows();
+        offset += rows;
+
+        if ((unit == 0 || part_rows_ % unit == 0) && current_bytes() >= target_bytes_) {
+            close_part();
+        }
+    }
+}
+
+void RollingFileWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    if (current_) {
+        close_part();
+    }
+    write_parquet_summaries();
+    write_manifest();
+}
+
+void RollingFileWriter::set_async_context(std::shared_ptr<AsyncIOContext> context) {
+    async_context_ = std::move(context);
+    if (current_) {
+        current_->set_async_context(async_context_);
+    }
+}
+
+bool RollingFileWriter::set_output_stream_factory(OutputStreamFactory factory) {
+    if (!parts_.empty() || part_rows_ > 0) {
+        throw std::runtime_error("RollingFileWriter: cannot set the output stream after writing has begun");
+    }
+    stream_factory_ = std::move(factory);
+    const bool accepted = current_->set_output_stream_factory([this](const std::string& path) {
+        current_stream_ = stream_factory_(path);
+        return current_stream_;
+    });
+    if (!accepted) {
+        stream_factory_ = nullptr;  // the format opens its own files
+    }
+    return accepted;
+}
+
+bool RollingFileWriter::set_cluster_columns(const std::vector<std::string>& columns) {
+    if (!parts_.empty() || part_rows_ > 0) {
+        throw std::runtime_error("RollingFileWriter: cannot cluster after writing has begun");
+    }
+    cluster_columns_ = columns;
+    if (!current_->set_cluster_columns(cluster_columns_)) {
+        cluster_columns_.clear();
+        return false;
+    }
+    return true;
+}
+
+size_t RollingFileWriter::preferred_unit_rows() const {
+    return current_ ? current_->preferred_unit_rows() : 0;
+}
+
+size_t RollingFileWriter::preferred_unit_bytes() const {
+    return current_ ? current_->preferred_unit_bytes() : 0;
+}
+
+std::shared_ptr<arrow::io::OutputStream> RollingFileWriter::open_side_file(
+        const std::string& name) const {
+    const std::string path = dir_ + "/" + name;
+    if (stream_factory_) {
+        return stream_factory_(path);
+    }
+    auto file = arrow::io::FileOutputStream::Open(path);
+    if (!file.ok()) {
+        throw std::runtime_error("RollingFileWriter: cannot open " + path + ": " +
+                                 file.status().ToString());
+    }
+    return *file;
+}
+
+void RollingFileWriter::write_side_file(const std::string& name,
+                                        const std::string& contents) const {
+    auto out = open_side_file(name);
+    auto status = out->Write(contents.data(), static_cast<int64_t>(contents.size()));
+    if (status.ok()) status = out->Close();
+    if (!status.ok()) {
+        throw std::runtime_error("RollingFileWriter: cannot write " + dir_ + "/" + name + ": " +
+                                 status.ToString());
+    }
+}
+
+void RollingFileWriter::write_parquet_summaries() {
+    if (parquet_footers_.empty() || parquet_footers_.size() != parts_.size()) {
+        return;
+    }
+    std::shared_ptr<parquet::FileMetaData> summary;
+    for (size_t i = 0; i < parts_.size(); ++i) {
+        const auto& footer = parquet_footers_[i];
+        if (!footer) {
+            return;
+        }
+        footer->set_file_path(parts_[i].name);
+        if (!summary) {
+            summary = footer;
+        } else {
+            summary->AppendRowGroups(*footer);
+        }
+    }
+
+    auto write_summary = [&](const std::string& name, const parquet::FileMetaData& metadata) {
+        auto out = open_side_file(name);
+        auto status = parquet::arrow::WriteMetaDataFile(metadata, out.get());
+        if (status.ok()) status = out->Close();
+        if (!status.ok()) {
+            throw std::runtime_error("RollingFileWriter: cannot write " + dir_ + "/" + name +
+                                     ": " + status.ToString());
+        }
+    };
+    write_summary("_common_metadata", *summary->Subset({}));
+    write_summary("_metadata", *summary);
+    parquet_footers_.clear();
+}
+
+void RollingFileWriter::write_manifest() {
+    int64_t rows = 0;
+    int64_t bytes = 0;
+    for (const auto& p : parts_) {
+        rows += p.rows;
+        bytes += p.bytes;
+    }
+
+    std::string json;
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\n  \"target_file_size\": %lld,\n  \"rows\": %lld,\n  \"bytes\": %lld,\n  \"files\": [",
+             static_cast<long long>(target_bytes_), static_cast<long long>(rows),
+             static_cast<long long>(bytes));
+    json += buf;
+    for (size_t i = 0; i < parts_.size(); ++i) {
+        snprintf(buf, sizeof(buf), "%s\n    {\"path\": \"%s\", \"rows\": %lld, \"bytes\": %lld}",
+                 i ? "," : "", parts_[i].name.c_str(), static_cast<long long>(parts_[i].rows),
+                 static_cast<long long>(parts_[i].bytes));
+        json += buf;
+    }
+    json += "\n  ]\n}\n";
+    write_side_file("_manifest.json", json);
+}
+
+int64_t parse_byte_size(const std::string& text) {
+    size_t used = 0;
+    double value = 0;
+    try {
+        value = std::stod(text, &used);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("invalid size '" + text + "'");
+    }
+    std::string suffix;
+    for (char c : text.substr(used)) {
+        suffix += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (suffix.size() >= 2 && suffix.compare(suffix.size() - 2, 2, "ib") == 0) {
+        suffix.resize(suffix.size() - 2);
+    } else if (!suffix.empty() && suffix.back() == 'b') {
+        suffix.pop_back();
+    }
+    double scale = 1;
+    if (suffix == "k")      scale = 1024.0;
+    else if (suffix == "m") scale = 1024.0 * 1024;
+    else if (suffix == "g") scale = 1024.0 * 1024 * 1024;
+    else if (suffix == "t") scale = 1024.0 * 1024 * 1024 * 1024;
+    else if (!suffix.empty()) throw std::invalid_argument("invalid size '" + text + "'");
+
+    const double bytes = value * scale;
+    if (!(bytes >= 1) || bytes > 4.0e18) {
+        throw std::invalid_argument("size out of range: '" + text + "'");
+    }
+    return static_cast<int64_t>(bytes);
+}
+
+}  // namespace tpch
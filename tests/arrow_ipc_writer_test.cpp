@@ -0,0 +1,147 @@
+// Unit tests: GatherOutputStream in-place writes and ArrowIpcWriter round trips
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+
+#include "tpch/arrow_ipc_writer.hpp"
+#include "tpch/gather_output_stream.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t n) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+    return v;
+}
+
+std::vector<uint8_t> slurp(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows) {
+    arrow::Int64Builder keys;
+    arrow::StringBuilder comments;
+    for (int64_t i = 0; i < rows; ++i) {
+        EXPECT_TRUE(keys.Append(base + i).ok());
+        EXPECT_TRUE(comments.Append("comment " + std::to_string(base + i)).ok());
+    }
+    auto schema = arrow::schema({arrow::field("key", arrow::int64()),
+                                 arrow::field("comment", arrow::utf8())});
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *comments.Finish()});
+}
+
+}  // namespace
+
+TEST(GatherOutputStream, BuffersInPlaceAndSmallWritesCopied) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_gather_stream_test.bin";
+
+    GatherStreamConfig config;
+    config.batch_bytes = 256 * 1024;  // several pwritev calls
+    auto data = pattern(3'000'017);
+    {
+        GatherOutputStream out(path.string(), nullptr, config);
+        size_t off = 0, step = 1;
+        int64_t big = 0;
+        while (off < data.size()) {
+            size_t n = std::min(step, data.size() - off);
+            if (n >= config.copy_threshold) {
+                ASSERT_TRUE(out.Write(std::make_shared<arrow::Buffer>(data.data() + off,
+                                                                      static_cast<int64_t>(n)))
+                                .ok());
+                big += static_cast<int64_t>(n);
+            } else {
+                ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            }
+            off += n;
+            step = step * 7 % 200'003 + 1;  // headers and body-sized buffers
+        }
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(data.size()));
+        EXPECT_EQ(out.gathered_bytes(), big);
+        EXPECT_GT(big, 0);
+        ASSERT_TRUE(out.Close().ok());
+        EXPECT_TRUE(out.closed());
+        EXPECT_FALSE(out.Write(data.data(), 1).ok());
+    }
+
+    EXPECT_EQ(slurp(path), data);
+    std::filesystem::remove(path);
+}
+
+TEST(ArrowIpcWriter, FileAndStreamRoundTripWithCompression) {
+    auto dir = std::filesystem::temp_directory_path();
+    for (const char* format : {"arrow", "arrow-stream"}) {
+        for (const char* codec : {"none", "lz4", "zstd"}) {
+            const bool stream = std::string(format) == "arrow-stream";
+            auto path = dir / ("tpch_ipc_test." + format_extension(format));
+            {
+                ArrowIpcWriter writer(path.string(), stream);
+                writer.set_compression(codec);
+                for (int i = 0; i < 4; ++i) writer.write_batch(make_batch(i * 10'000, 10'000));
+                writer.close();
+            }
+
+            auto file = *arrow::io::ReadableFile::Open(path.string());
+            std::shared_ptr<arrow::Table> table;
+            if (stream) {
+                auto reader = *arrow::ipc::RecordBatchStreamReader::Open(file);
+                table = *reader->ToTable();
+            } else {
+                auto reader = *arrow::ipc::RecordBatchFileReader::Open(file);
+                EXPECT_EQ(reader->num_record_batches(), 4);
+                table = *reader->ToTable();
+            }
+            ASSERT_EQ(table->num_rows(), 40'000) << format << " " << codec;
+            auto keys = std::static_pointer_cast<arrow::Int64Array>(
+                table->column(0)->chunk(3));
+            EXPECT_EQ(keys->Value(9'999), 39'999);
+            auto comments = std::static_pointer_cast<arrow::StringArray>(
+                table->column(1)->chunk(2));
+            EXPECT_EQ(comments->GetString(5), "comment 20005");
+            std::filesystem::remove(path);
+        }
+    }
+}
+
+TEST(ArrowIpcWriter, ManagedBatchOwnerOutlivesWriteAndBadCodecRejected) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_ipc_managed_test.arrow";
+    std::weak_ptr<BufferLifetimeManager> watch;
+    {
+        ArrowIpcWriter writer(path.string());
+        {
+            auto mgr  = std::make_shared<BufferLifetimeManager>();
+            auto vals = mgr->create_int64_buffer(50'000);
+            for (int64_t i = 0; i < 50'000; ++i) vals->push_back(i * 3);
+            auto buf = arrow::Buffer::Wrap(vals->data(), vals->size());
+            auto arr = std::make_shared<arrow::Int64Array>(50'000, buf);
+            auto schema = arrow::schema({arrow::field("v", arrow::int64())});
+            writer.write_managed_batch(
+                ManagedRecordBatch(arrow::RecordBatch::Make(schema, 50'000, {arr}), mgr));
+            watch = mgr;
+        }
+        EXPECT_FALSE(watch.expired());  // referenced buffers not written yet
+        writer.close();
+    }
+    EXPECT_TRUE(watch.expired());
+
+    auto file   = *arrow::io::ReadableFile::Open(path.string());
+    auto reader = *arrow::ipc::RecordBatchFileReader::Open(file);
+    auto batch  = *reader->ReadRecordBatch(0);
+    auto values = std::static_pointer_cast<arrow::Int64Array>(batch->column(0));
+    EXPECT_EQ(values->Value(49'999), 149'997);
+    std::filesystem::remove(path);
+
+    ArrowIpcWriter writer(path.string());
+    EXPECT_THROW(writer.set_compression("snappy"), std::runtime_error);
+}
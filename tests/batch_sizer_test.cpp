@@ -0,0 +1,104 @@
+// Unit tests for AdaptiveBatchSizer (cache-budget sizing, unit alignment, feedback)
+
+#include <gtest/gtest.h>
+
+#include <arrow/type.h>
+
+#include "tpch/batch_sizer.hpp"
+#include "tpch/writer_interface.hpp"
+#include "tpch/writer_tuning.hpp"
+
+using namespace tpch;
+
+namespace {
+
+// Writer that only reports a row unit, like ORC's row-index stride
+class StrideWriter : public WriterInterface {
+public:
+    void write_batch(const std::shared_ptr<arrow::RecordBatch>&) override {}
+    void close() override {}
+    size_t preferred_unit_rows() const override { return 10000; }
+};
+
+}  // namespace
+
+TEST(AdaptiveBatchSizer, SizesByBytesNotRows) {
+    // 1 MiB budget: wide rows get fewer rows per batch than narrow rows
+    AdaptiveBatchSizer wide(160, 1 << 20);
+    AdaptiveBatchSizer narrow(16, 1 << 20);
+    EXPECT_LT(wide.rows(), narrow.rows());
+    EXPECT_GE(wide.rows(), AdaptiveBatchSizer::DEFAULT_MIN_ROWS);
+    EXPECT_LE(narrow.rows(), AdaptiveBatchSizer::DEFAULT_MAX_ROWS);
+}
+
+TEST(AdaptiveBatchSizer, AlignRowsToUnit) {
+    // Below the unit: pick a divisor of the unit
+    EXPECT_EQ(AdaptiveBatchSizer::align_rows(6000, 8192), 4096u);
+    EXPECT_EQ(8192 % AdaptiveBatchSizer::align_rows(7000, 8192), 0u);
+    EXPECT_EQ(AdaptiveBatchSizer::align_rows(6000, 10000), 5000u);
+    // Above the unit: whole multiples of the unit
+    EXPECT_EQ(AdaptiveBatchSizer::align_rows(20000, 8192), 16384u);
+    // No unit: unchanged
+    EXPECT_EQ(AdaptiveBatchSizer::align_rows(6000, 0), 6000u);
+}
+
+TEST(AdaptiveBatchSizer, WriterUnitAndCaps) {
+    AdaptiveBatchSizer sizer(100, 1 << 20);
+    sizer.set_writer_unit(8192, 0);
+    EXPECT_EQ(8192 % sizer.rows(), 0u);
+
+    sizer.set_max_rows(2048);
+    EXPECT_LE(sizer.rows(), 2048u);
+
+    sizer.set_fixed_rows(5000);
+    EXPECT_EQ(sizer.rows(), 5000u);
+    sizer.record(5000, 5000 * 400, 1.0, 1.0);  // fixed size ignores feedback
+    EXPECT_EQ(sizer.rows(), 5000u);
+}
+
+TEST(AdaptiveBatchSizer, MeasuredBytesUpdateEstimate) {
+    AdaptiveBatchSizer sizer(50, 1 << 20);
+    size_t before = sizer.rows();
+    for (int i = 0; i < 20; ++i) {
+        sizer.record(sizer.rows(), static_cast<int64_t>(sizer.rows()) * 200, 0.0, 0.0);
+    }
+    EXPECT_GT(sizer.row_bytes(), 150.0);
+    EXPECT_LT(sizer.rows(), before);
+}
+
+TEST(AdaptiveBatchSizer, FeedbackTurnsAroundWhenCostRises) {
+    AdaptiveBatchSizer sizer(100, 1 << 20);
+    const size_t initial_budget = sizer.target_bytes();
+
+    // First window at a flat cost: the sizer probes upwards
+    for (size_t i = 0; i < AdaptiveBatchSizer::FEEDBACK_WINDOW; ++i) {
+        sizer.record(sizer.rows(), static_cast<int64_t>(sizer.rows()) * 100, sizer.rows() * 1e-8, 0.0);
+    }
+    EXPECT_GT(sizer.target_bytes(), initial_budget);
+
+    // Larger batches spill the cache and cost more per row: turn around
+    const size_t grown = sizer.target_bytes();
+    for (size_t i = 0; i < AdaptiveBatchSizer::FEEDBACK_WINDOW; ++i) {
+        sizer.record(sizer.rows(), static_cast<int64_t>(sizer.rows()) * 100, sizer.rows() * 2e-8, 0.0);
+    }
+    EXPECT_LT(sizer.target_bytes(), grown);
+}
+
+TEST(AdaptiveBatchSizer, MakeBatchSizerAppliesUnitCapAndFixedSize) {
+    auto schema = arrow::schema({arrow::field("k", arrow::int64()),
+                                 arrow::field("s", arrow::utf8())});
+    StrideWriter writer;
+
+    auto adaptive = make_batch_sizer(*schema, writer, nullptr, 0);
+    EXPECT_EQ(adaptive.unit_rows(), 10000u);
+    EXPECT_TRUE(10000 % adaptive.rows() == 0 || adaptive.rows() % 10000 == 0);
+
+    AutoTuning tuning;
+    tuning.max_batch_rows = 2000;
+    auto capped = make_batch_sizer(*schema, writer, &tuning, 0);
+    EXPECT_LE(capped.rows(), 2000u);
+    EXPECT_EQ(10000 % capped.rows(), 0u);
+
+    auto fixed = make_batch_sizer(*schema, writer, &tuning, 3000);
+    EXPECT_EQ(fixed.rows(), 3000u);
+}
@@ -0,0 +1,121 @@
+// Unit tests: CSVWriter through its default stream and an injected one
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+
+#include "tpch/csv_writer.hpp"
+
+using namespace tpch;
+
+namespace {
+
+const std::vector<std::string> FLAGS = {"A", "N", "R"};
+
+std::string slurp(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// Rows [base, base + rows); every 11th comment is null, every 5th needs quoting
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows) {
+    arrow::Int64Builder keys;
+    arrow::StringBuilder comments;
+    arrow::Int8Builder flags;
+    for (int64_t k = base; k < base + rows; ++k) {
+        EXPECT_TRUE(keys.Append(k).ok());
+        if (k % 11 == 0) {
+            EXPECT_TRUE(comments.AppendNull().ok());
+        } else {
+            EXPECT_TRUE(comments.Append(k % 5 == 0 ? "a, \"b\"" : "comment " + std::to_string(k)).ok());
+        }
+        EXPECT_TRUE(flags.Append(static_cast<int8_t>(k % 3)).ok());
+    }
+    arrow::StringBuilder dict;
+    EXPECT_TRUE(dict.AppendValues(FLAGS).ok());
+    auto flag_type = arrow::dictionary(arrow::int8(), arrow::utf8());
+    auto flag = arrow::DictionaryArray::FromArrays(flag_type, *flags.Finish(), *dict.Finish());
+    EXPECT_TRUE(flag.ok());
+    auto schema = arrow::schema({arrow::field("key", arrow::int64()),
+                                 arrow::field("comment", arrow::utf8()),
+                                 arrow::field("flag", flag_type)});
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *comments.Finish(), *flag});
+}
+
+std::string expected_csv(int64_t rows) {
+    std::string s = "key,comment,flag\n";
+    for (int64_t k = 0; k < rows; ++k) {
+        s += std::to_string(k) + ",";
+        if (k % 11 != 0) {
+            s += k % 5 == 0 ? "\"a, \"\"b\"\"\"" : "comment " + std::to_string(k);
+        }
+        s += "," + FLAGS[static_cast<size_t>(k % 3)] + "\n";
+    }
+    return s;
+}
+
+// Two batches, the first one row, so the header and rows span several 1 MiB staging buffers
+constexpr int64_t FIRST = 1;
+constexpr int64_t SECOND = 60000;
+
+void write_rows(CSVWriter& writer) {
+    writer.write_batch(make_batch(0, FIRST));
+    writer.write_batch(make_batch(FIRST, SECOND));
+    writer.close();
+}
+
+}  // namespace
+
+TEST(CSVWriter, DefaultStreamWritesHeaderAndRows) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_csv_writer_test.csv";
+    {
+        CSVWriter writer(path.string());
+        write_rows(writer);
+    }
+    EXPECT_EQ(slurp(path), expected_csv(FIRST + SECOND));
+    std::filesystem::remove(path);
+}
+
+TEST(CSVWriter, DirectIoTailIsTruncated) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_csv_writer_direct_test.csv";
+
+    // Falls back to buffered I/O where O_DIRECT is rejected; same bytes either way.
+    const auto expected = expected_csv(FIRST + SECOND);
+    ASSERT_NE(expected.size() % 4096, 0u);  // the last block is padded, then truncated
+    {
+        CSVWriter writer(path.string());
+        writer.enable_direct_io(true);
+        write_rows(writer);
+    }
+    EXPECT_EQ(std::filesystem::file_size(path), expected.size());
+    EXPECT_EQ(slurp(path), expected);
+    std::filesystem::remove(path);
+}
+
+TEST(CSVWriter, InjectedStreamReceivesAllBytes) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_csv_writer_injected_test.csv";
+    std::filesystem::remove(path);
+
+    std::shared_ptr<arrow::io::BufferOutputStream> sink = *arrow::io::BufferOutputStream::Create();
+    std::string opened;
+    {
+        CSVWriter writer(path.string());
+        writer.set_output_stream_factory([&](const std::string& p) {
+            opened = p;
+            return sink;
+        });
+        EXPECT_THROW(writer.enable_direct_io(true), std::runtime_error);
+        write_rows(writer);
+    }
+    EXPECT_EQ(opened, path.string());
+    EXPECT_TRUE(sink->closed());
+    EXPECT_EQ((*sink->Finish())->ToString(), expected_csv(FIRST + SECOND));
+    EXPECT_FALSE(std::filesystem::exists(path));  // the injected stream replaced the file
+}
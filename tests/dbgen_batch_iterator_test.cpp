@@ -67,3 +67,104 @@ TEST(DBGenBatchIterator, LineitemBatchBoundary) {
         ASSERT_EQ(cmp, 0) << "Row mismatch at index " << i;
     }
 }
+
+TEST(DBGenBatchIterator, LineitemRingMatchesCallback) {
+    // In-place ring fill must yield the same sequence as the callback path,
+    // including when the batch size changes between batches.
+    DBGenWrapper dbgen_base(1, false);
+    DBGenWrapper dbgen_iter(1, false);
+
+    const long max_rows = 5000;
+
+    std::vector<line_t> baseline;
+    baseline.reserve(max_rows);
+    dbgen_base.generate_lineitem([&](const void* row) { baseline.push_back(*static_cast<const line_t*>(row)); },
+                                 max_rows);
+
+    auto iter = dbgen_iter.generate_lineitem_batches(1000, max_rows);
+    const size_t sizes[] = {1000, 7, 1024, 333, 4096};
+    std::vector<line_t> batched;
+    batched.reserve(max_rows);
+    size_t batch_idx = 0;
+    while (iter.has_next()) {
+        iter.set_batch_size(sizes[batch_idx++ % std::size(sizes)]);
+        auto batch = iter.next_span();
+        ASSERT_LE(batch.size(), iter.batch_size());
+        batched.insert(batched.end(), batch.rows.begin(), batch.rows.end());
+        iter.release(batch);
+    }
+
+    ASSERT_EQ(baseline.size(), batched.size());
+    for (size_t i = 0; i < baseline.size(); ++i) {
+        ASSERT_EQ(std::memcmp(&baseline[i], &batched[i], sizeof(line_t)), 0) << "Row mismatch at index " << i;
+    }
+}
+
+TEST(DBGenBatchIterator, RingExhaustionThrows) {
+    DBGenWrapper dbgen(1, false);
+    auto iter = dbgen.generate_nation_batches(5, -1);
+    iter.set_ring_slots(1);
+
+    auto held = iter.next_span();
+    EXPECT_THROW(iter.next_span(), std::runtime_error);
+    iter.release(held);
+    EXPECT_NO_THROW({
+        auto batch = iter.next_span();
+        iter.release(batch);
+    });
+}
+
+TEST(DBGenBatchIterator, InterleavedTablesMatchSeparateRuns) {
+    // orders and lineitem both drive mk_order; with per-iterator seed state,
+    // stepping them alternately must match running each on its own.
+    const long max_rows = 3000;
+    const size_t batch_size = 256;
+
+    std::vector<order_t> orders_alone;
+    std::vector<line_t> lineitem_alone;
+    {
+        DBGenWrapper dbgen(1, false);
+        auto it = dbgen.generate_orders_batches(batch_size, max_rows);
+        while (it.has_next()) {
+            auto b = it.next_span();
+            orders_alone.insert(orders_alone.end(), b.rows.begin(), b.rows.end());
+            it.release(b);
+        }
+    }
+    {
+        DBGenWrapper dbgen(1, false);
+        auto it = dbgen.generate_lineitem_batches(batch_size, max_rows);
+        while (it.has_next()) {
+            auto b = it.next_span();
+            lineitem_alone.insert(lineitem_alone.end(), b.rows.begin(), b.rows.end());
+            it.release(b);
+        }
+    }
+
+    DBGenWrapper dbgen(1, false);
+    auto orders_it = dbgen.generate_orders_batches(batch_size, max_rows);
+    auto lineitem_it = dbgen.generate_lineitem_batches(batch_size, max_rows);
+    std::vector<order_t> orders_mixed;
+    std::vector<line_t> lineitem_mixed;
+    while (orders_it.has_next() || lineitem_it.has_next()) {
+        if (lineitem_it.has_next()) {
+            auto b = lineitem_it.next_span();
+            lineitem_mixed.insert(lineitem_mixed.end(), b.rows.begin(), b.rows.end());
+            lineitem_it.release(b);
+        }
+        if (orders_it.has_next()) {
+            auto b = orders_it.next_span();
+            orders_mixed.insert(orders_mixed.end(), b.rows.begin(), b.rows.end());
+            orders_it.release(b);
+        }
+    }
+
+    ASSERT_EQ(orders_alone.size(), orders_mixed.size());
+    ASSERT_EQ(lineitem_alone.size(), lineitem_mixed.size());
+    for (size_t i = 0; i < orders_alone.size(); ++i) {
+        ASSERT_EQ(std::memcmp(&orders_alone[i], &orders_mixed[i], sizeof(order_t)), 0) << "orders row " << i;
+    }
+    for (size_t i = 0; i < lineitem_alone.size(); ++i) {
+        ASSERT_EQ(std::memcmp(&lineitem_alone[i], &lineitem_mixed[i], sizeof(line_t)), 0) << "lineitem row " << i;
+    }
+}
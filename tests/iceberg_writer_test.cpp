@@ -0,0 +1,321 @@
+// Unit tests: streamed, partitioned Iceberg data files with column statistics
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/schema.h>
+
+#include "tpch/iceberg_writer.hpp"
+
+using namespace tpch;
+namespace fs = std::filesystem;
+
+namespace {
+
+// 1995-01-01 as days since the epoch
+constexpr int32_t JAN_1995 = 9131;
+
+// l_orderkey, l_shipdate (a new day every 50 rows), l_comment (long strings, some null)
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows) {
+    arrow::Int64Builder keys;
+    arrow::Date32Builder dates;
+    arrow::StringBuilder comments;
+    for (int64_t i = base; i < base + rows; ++i) {
+        EXPECT_TRUE(keys.Append(i).ok());
+        EXPECT_TRUE(dates.Append(JAN_1995 + static_cast<int32_t>(i / 50)).ok());
+        if (i % 13 == 0) {
+            EXPECT_TRUE(comments.AppendNull().ok());
+        } else {
+            EXPECT_TRUE(comments.Append("carefully final deposits " + std::to_string(i * 7919 % 100'003)).ok());
+        }
+    }
+    auto schema = arrow::schema({arrow::field("l_orderkey", arrow::int64(), false),
+                                 arrow::field("l_shipdate", arrow::date32(), false),
+                                 arrow::field("l_comment", arrow::utf8())});
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *dates.Finish(), *comments.Finish()});
+}
+
+std::string read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+fs::path fresh_dir(const std::string& name) {
+    auto dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    return dir;
+}
+
+std::shared_ptr<arrow::Table> read_table(const fs::path& path) {
+    auto file = *arrow::io::ReadableFile::Open(path.string());
+    auto reader = *parquet::arrow::OpenFile(file, arrow::default_memory_pool());
+    std::shared_ptr<arrow::Table> table;
+    EXPECT_TRUE(reader->ReadTable(&table).ok());
+    return *table->CombineChunks();
+}
+
+int64_t decode_long(const std::string& bytes) {
+    int64_t v = 0;
+    EXPECT_EQ(bytes.size(), sizeof(v));
+    std::memcpy(&v, bytes.data(), sizeof(v));
+    return v;
+}
+
+}  // namespace
+
+TEST(IcebergWriter, ParsePartitionSpec) {
+    auto fields = IcebergWriter::parse_partition_spec("month(l_shipdate), l_returnflag,truncate[30](ss_sold_date_sk)");
+    ASSERT_EQ(fields.size(), 3u);
+    EXPECT_EQ(fields[0].source, "l_shipdate");
+    EXPECT_EQ(fields[0].transform, "month");
+    EXPECT_EQ(fields[0].name, "l_shipdate_month");
+    EXPECT_EQ(fields[1].transform, "identity");
+    EXPECT_EQ(fields[1].name, "l_returnflag");
+    EXPECT_EQ(fields[2].transform, "truncate");
+    EXPECT_EQ(fields[2].width, 30);
+    EXPECT_EQ(fields[2].name, "ss_sold_date_sk_trunc");
+
+    EXPECT_THROW(IcebergWriter::parse_partition_spec("bucket(l_orderkey)"), std::invalid_argument);
+    EXPECT_THROW(IcebergWriter::parse_partition_spec("truncate[0](l_orderkey)"), std::invalid_argument);
+    EXPECT_THROW(IcebergWriter::parse_partition_spec("month(l_shipdate"), std::invalid_argument);
+    EXPECT_THROW(IcebergWriter::parse_partition_spec("a,,b"), std::invalid_argument);
+}
+
+TEST(IcebergWriter, MonthPartitionsWithColumnStatistics) {
+    auto dir = fresh_dir("tpch_iceberg_partition_test");
+    const int64_t total = 20'000;  // 400 days: 14 months
+    {
+        IcebergWriter writer(dir.string());
+        writer.set_partition_spec("month(l_shipdate),o_orderdate");
+        for (int64_t base = 0; base < total; base += 3'000) {
+            writer.write_batch(make_batch(base, std::min<int64_t>(3'000, total - base)));
+        }
+        writer.close();
+
+        ASSERT_EQ(writer.partition_fields().size(), 1u);  // o_orderdate: not in this table
+        ASSERT_EQ(writer.data_files().size(), 14u);
+
+        int64_t rows = 0;
+        for (const auto& file : writer.data_files()) {
+            const fs::path path = dir / "data" / file.filename;
+            ASSERT_TRUE(fs::exists(path)) << file.filename;
+            EXPECT_EQ(file.file_size, static_cast<int64_t>(fs::file_size(path)));
+            ASSERT_EQ(file.partition.size(), 1u);
+            ASSERT_FALSE(file.partition[0].is_null);
+
+            // Month ordinal since 1970-01, and the human-readable directory
+            const int64_t month = file.partition[0].number;
+            char dirname[64];
+            snprintf(dirname, sizeof(dirname), "l_shipdate_month=%04lld-%02lld/",
+                     static_cast<long long>(1970 + month / 12), static_cast<long long>(month % 12 + 1));
+            EXPECT_EQ(file.filename.rfind(dirname, 0), 0u) << file.filename;
+
+            auto table = read_table(path);
+            ASSERT_EQ(table->num_rows(), file.record_count);
+            rows += file.record_count;
+            const auto& keys = static_cast<const arrow::Int64Array&>(*table->column(0)->chunk(0));
+            const auto& comments = static_cast<const arrow::StringArray&>(*table->column(2)->chunk(0));
+            int64_t min_key = INT64_MAX, max_key = INT64_MIN, nulls = 0;
+            std::string min_comment = "\xff", max_comment;
+            for (int64_t i = 0; i < table->num_rows(); ++i) {
+                min_key = std::min(min_key, keys.Value(i));
+                max_key = std::max(max_key, keys.Value(i));
+                if (comments.IsNull(i)) {
+                    ++nulls;
+                    continue;
+                }
+                min_comment = std::min(min_comment, comments.GetString(i));
+                max_comment = std::max(max_comment, comments.GetString(i));
+            }
+
+            // Every row belongs to the file's month
+            const auto& dates = static_cast<const arrow::Date32Array&>(*table->column(1)->chunk(0));
+            for (int64_t i = 0; i < table->num_rows(); ++i) {
+                const std::chrono::year_month_day ymd{
+                    std::chrono::sys_days{std::chrono::days{dates.Value(i)}}};
+                ASSERT_EQ((static_cast<int>(ymd.year()) - 1970) * 12 +
+                              static_cast<int>(static_cast<unsigned>(ymd.month())) - 1,
+                          month);
+            }
+
+            ASSERT_EQ(file.columns.size(), 3u);
+            const auto& key_stats = file.columns[0];
+            EXPECT_EQ(key_stats.field_id, 1);
+            EXPECT_EQ(key_stats.value_count, file.record_count);
+            EXPECT_EQ(key_stats.null_count, 0);
+            EXPECT_GT(key_stats.column_size, 0);
+            ASSERT_TRUE(key_stats.has_bounds);
+            EXPECT_EQ(decode_long(key_stats.lower_bound), min_key);
+            EXPECT_EQ(decode_long(key_stats.upper_bound), max_key);
+
+            // Strings: truncated to 16 characters, still bounding every value
+            const auto& comment_stats = file.columns[2];
+            EXPECT_EQ(comment_stats.null_count, nulls);
+            ASSERT_TRUE(comment_stats.has_bounds);
+            EXPECT_LE(comment_stats.lower_bound.size(), 16u);
+            EXPECT_LE(comment_stats.upper_bound.size(), 16u);
+            EXPECT_LE(comment_stats.lower_bound, min_comment);
+            EXPECT_GT(comment_stats.upper_bound, max_comment);
+
+            // Parquet columns carry the Iceberg field IDs
+            auto footer = parquet::ParquetFileReader::OpenFile(path.string())->metadata();
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_EQ(footer->schema()->Column(c)->schema_node()->field_id(), c + 1);
+            }
+        }
+        EXPECT_EQ(rows, total);
+    }
+
+    const std::string metadata = read_file(dir / "metadata" / "v1.metadata.json");
+    EXPECT_NE(metadata.find("\"transform\": \"month\""), std::string::npos);
+    EXPECT_NE(metadata.find("\"field-id\": 1000"), std::string::npos);
+    EXPECT_NE(metadata.find("\"total-records\": \"20000\""), std::string::npos);
+    EXPECT_NE(metadata.find("\"last-partition-id\": 1000"), std::string::npos);
+
+    // Manifest header: partition record type and the spec as file metadata
+    const std::string manifest = read_file(dir / "metadata" / "manifest-1.avro");
+    EXPECT_NE(manifest.find("\"name\":\"l_shipdate_month\""), std::string::npos);
+    EXPECT_NE(manifest.find("lower_bounds"), std::string::npos);
+    EXPECT_NE(manifest.find("partition-spec"), std::string::npos);
+    fs::remove_all(dir);
+}
+
+TEST(IcebergWriter, RollsFilesAtTargetSize) {
+    auto dir = fresh_dir("tpch_iceberg_rolling_test");
+    {
+        IcebergWriter writer(dir.string());
+        writer.set_target_file_size(256 * 1024);
+        writer.set_write_buffer_size(64 * 1024);
+        for (int64_t base = 0; base < 200'000; base += 2'000) {
+            writer.write_batch(make_batch(base, 2'000));
+        }
+        writer.close();
+
+        ASSERT_GT(writer.data_files().size(), 2u);
+        int64_t rows = 0;
+        int64_t previous_max = -1;
+        for (const auto& file : writer.data_files()) {
+            EXPECT_TRUE(file.partition.empty());
+            EXPECT_EQ(file.filename.find('/'), std::string::npos);
+            auto footer = parquet::ParquetFileReader::OpenFile((dir / "data" / file.filename).string())->metadata();
+            EXPECT_GT(footer->num_row_groups(), 1);
+            EXPECT_EQ(footer->num_rows(), file.record_count);
+            // Files keep generation order
+            EXPECT_EQ(decode_long(file.columns[0].lower_bound), previous_max + 1);
+            previous_max = decode_long(file.columns[0].upper_bound);
+            rows += file.record_count;
+        }
+        EXPECT_EQ(rows, 200'000);
+    }
+    fs::remove_all(dir);
+}
+
+TEST(IcebergWriter, MonthOfIsoDateStringsBecomesDateColumn) {
+    // TPC-H generates dates as dictionary-encoded "YYYY-MM-DD" strings
+    arrow::StringBuilder values;
+    ASSERT_TRUE(values.AppendValues({"1998-12-01", "1992-01-02", "1992-02-29"}).ok());
+    auto dictionary = *values.Finish();
+    arrow::Int16Builder indices;
+    arrow::Int32Builder keys;
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_TRUE(indices.Append(static_cast<int16_t>(i % 3)).ok());
+        ASSERT_TRUE(keys.Append(i).ok());
+    }
+    auto dict16 = arrow::dictionary(arrow::int16(), arrow::utf8());
+    auto shipdate = *arrow::DictionaryArray::FromArrays(dict16, *indices.Finish(), dictionary);
+    auto schema = arrow::schema({arrow::field("l_orderkey", arrow::int32()),
+                                 arrow::field("l_shipdate", dict16)});
+    auto batch = arrow::RecordBatch::Make(schema, 300, {*keys.Finish(), shipdate});
+
+    auto dir = fresh_dir("tpch_iceberg_iso_date_test");
+    {
+        IcebergWriter writer(dir.string());
+        writer.set_partition_spec("month(l_shipdate)");
+        writer.write_batch(batch);
+        writer.close();
+
+        ASSERT_EQ(writer.data_files().size(), 3u);
+        std::map<std::string, int64_t> rows;
+        for (const auto& file : writer.data_files()) {
+            rows[file.filename.substr(0, file.filename.find('/'))] = file.record_count;
+            // Bounds of the date column: 4-byte little-endian days
+            ASSERT_TRUE(file.columns[1].has_bounds);
+            EXPECT_EQ(file.columns[1].lower_bound.size(), 4u);
+        }
+        EXPECT_EQ(rows, (std::map<std::string, int64_t>{{"l_shipdate_month=1992-01", 100},
+                                                         {"l_shipdate_month=1992-02", 100},
+                                                         {"l_shipdate_month=1998-12", 100}}));
+        auto table = read_table(dir / "data" / writer.data_files()[0].filename);
+        ASSERT_EQ(table->column(1)->type()->id(), arrow::Type::DATE32);
+        EXPECT_EQ(static_cast<const arrow::Date32Array&>(*table->column(1)->chunk(0)).Value(0),
+                  10561);  // 1998-12-01
+    }
+    const std::string metadata = read_file(dir / "metadata" / "v1.metadata.json");
+    EXPECT_NE(metadata.find("\"name\": \"l_shipdate\", \"required\": false, \"type\": \"date\""),
+              std::string::npos);
+    fs::remove_all(dir);
+}
+
+TEST(IcebergWriter, RejectsTransformOfWrongType) {
+    auto dir = fresh_dir("tpch_iceberg_bad_spec_test");
+    IcebergWriter writer(dir.string());
+    writer.set_partition_spec("month(l_orderkey)");
+    EXPECT_THROW(writer.write_batch(make_batch(0, 10)), std::invalid_argument);
+    fs::remove_all(dir);
+}
+
+TEST(IcebergWriter, DeferredWritersCommitOneSnapshot) {
+    auto dir = fresh_dir("tpch_iceberg_deferred_test");
+    size_t files = 0;
+    for (const char* id : {"node-a", "node-b"}) {
+        IcebergWriter writer(dir.string());
+        writer.set_partition_spec("month(l_shipdate)");
+        writer.set_deferred_commit(id);
+        const int64_t base = id[5] == 'a' ? 0 : 10'000;
+        for (int64_t offset = 0; offset < 10'000; offset += 2'500) {
+            writer.write_batch(make_batch(base + offset, 2'500));
+        }
+        writer.close();
+        files += writer.data_files().size();
+        for (const auto& file : writer.data_files()) {
+            EXPECT_NE(file.filename.find(std::string("/data_") + id + "_"), std::string::npos) << file.filename;
+        }
+        // Data files and a sidecar only: nothing is visible yet
+        EXPECT_TRUE(fs::exists(dir / "_pending" / (std::string(id) + ".json")));
+        EXPECT_FALSE(fs::exists(dir / "metadata" / "v1.metadata.json"));
+    }
+    EXPECT_THROW(IcebergWriter(dir.string()).set_deferred_commit("../x"), std::invalid_argument);
+
+    ASSERT_EQ(IcebergWriter::commit(dir.string()), files);
+    EXPECT_FALSE(fs::exists(dir / "_pending"));
+    const std::string metadata = read_file(dir / "metadata" / "v1.metadata.json");
+    EXPECT_NE(metadata.find("\"total-records\": \"20000\""), std::string::npos);
+    EXPECT_NE(metadata.find("\"total-data-files\": \"" + std::to_string(files) + "\""), std::string::npos);
+    EXPECT_NE(metadata.find("\"transform\": \"month\""), std::string::npos);
+    EXPECT_EQ(read_file(dir / "metadata" / "version-hint.text"), "1\n");
+
+    // Nothing left to commit; a second snapshot cannot be added
+    EXPECT_EQ(IcebergWriter::commit(dir.string()), 0u);
+    {
+        IcebergWriter late(dir.string());
+        late.set_deferred_commit("late");
+        late.write_batch(make_batch(0, 100));
+        late.close();
+    }
+    EXPECT_THROW(IcebergWriter::commit(dir.string()), std::runtime_error);
+    fs::remove_all(dir);
+}
@@ -0,0 +1,84 @@
+// Unit tests: shared-memory rings drained by the dedicated I/O process
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "tpch/io_process.hpp"
+#include "tpch/shm_ring_output_stream.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t n, uint32_t seed) {
+    std::vector<uint8_t> v(n);
+    uint32_t x = seed;
+    for (auto& b : v) {
+        x = x * 1664525u + 1013904223u;
+        b = static_cast<uint8_t>(x >> 24);
+    }
+    return v;
+}
+
+std::vector<uint8_t> slurp(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+TEST(IoProcess, RingsRoundTripThroughDrainer) {
+    auto dir = std::filesystem::temp_directory_path() / "tpch_io_process_test";
+    std::filesystem::create_directories(dir);
+
+    // Small rings so the producer wraps and blocks many times.
+    IoProcess io(2, size_t{2} << 20);
+    io.start();
+
+    const size_t sizes[] = {1, 17, 4096, 300000, 65536, 3 << 20};
+    std::vector<std::vector<uint8_t>> expected;
+    for (int f = 0; f < 4; ++f) {
+        auto path = dir / ("file" + std::to_string(f) + ".bin");
+        auto data = pattern(9'000'000 + f * 12345, f + 1);
+        ShmRingOutputStream out(io.ring(f % 2), path.string());
+        size_t off = 0;
+        for (size_t i = 0; off < data.size(); ++i) {
+            size_t n = std::min(sizes[i % std::size(sizes)], data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            off += n;
+            if (i % 7 == 0) {
+                ASSERT_TRUE(out.Flush().ok());
+            }
+        }
+        ASSERT_TRUE(out.Close().ok());
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(data.size()));
+        expected.push_back(std::move(data));
+    }
+
+    ASSERT_EQ(io.finish(), 0);
+    for (int f = 0; f < 4; ++f) {
+        auto got = slurp(dir / ("file" + std::to_string(f) + ".bin"));
+        ASSERT_EQ(got.size(), expected[f].size()) << "file " << f;
+        EXPECT_TRUE(got == expected[f]) << "file " << f;
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(IoProcess, OpenFailureSurfacesOnClose) {
+    IoProcess io(1, size_t{1} << 20);
+    io.start();
+
+    ShmRingOutputStream out(io.ring(0), "/nonexistent-dir/tpch/out.bin");
+    auto data = pattern(100000, 7);
+    (void)out.Write(data.data(), static_cast<int64_t>(data.size()));
+    EXPECT_FALSE(out.Close().ok());
+    EXPECT_NE(io.finish(), 0);
+}
@@ -0,0 +1,134 @@
+// Unit tests: IoUringOutputStream staging, coalescing and deferred errors
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "tpch/io_uring_output_stream.hpp"
+#include "tpch/io_uring_pool.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t n) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+    return v;
+}
+
+std::vector<uint8_t> slurp(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+TEST(IoUringOutputStream, CoalescedWritesRoundTrip) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_io_uring_stream_test.bin";
+
+    // Uses a real ring when io_uring is built in and available, else pwrite.
+    IoUringPool::init(path.parent_path().string());
+    IoUringStreamConfig config;
+    config.staging_bytes      = 64 * 1024;
+    config.max_inflight_bytes = 256 * 1024;
+    config.fdatasync_on_close = true;
+
+    auto data = pattern(3'000'000);
+    {
+        IoUringOutputStream out(path.string(), IoUringPool::create_child_ring_struct(), config);
+        const size_t sizes[] = {3, 100, 8192, 65536, 70000, 1};
+        size_t off = 0;
+        for (size_t i = 0; off < data.size(); ++i) {
+            size_t n = std::min(sizes[i % std::size(sizes)], data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            off += n;
+            EXPECT_LE(out.inflight_bytes(), config.max_inflight_bytes);
+        }
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(data.size()));
+        ASSERT_TRUE(out.Close().ok());
+        EXPECT_EQ(out.inflight_bytes(), 0u);
+        EXPECT_FALSE(out.Write(data.data(), 1).ok());
+    }
+
+    EXPECT_TRUE(slurp(path) == data);
+    std::filesystem::remove(path);
+}
+
+TEST(IoUringOutputStream, WriteErrorIsDeferred) {
+    // /dev/full accepts open() but fails every write with ENOSPC.
+    if (!std::filesystem::exists("/dev/full")) GTEST_SKIP();
+
+    IoUringStreamConfig config;
+    config.staging_bytes = 4096;
+    IoUringOutputStream out("/dev/full", nullptr, config);
+
+    auto data = pattern(1000);
+    EXPECT_TRUE(out.Write(data.data(), 1000).ok());  // still staged
+    arrow::Status st;
+    for (int i = 0; i < 8 && st.ok(); ++i) {
+        st = out.Write(data.data(), 1000);
+    }
+    EXPECT_FALSE(st.ok());
+    EXPECT_FALSE(out.Close().ok());
+}
+
+TEST(IoUringOutputStream, DirectIoTailIsTruncated) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_io_uring_direct_test.bin";
+
+    // Falls back to buffered I/O where O_DIRECT is rejected; same bytes either way.
+    IoUringPool::init(path.parent_path().string());
+    IoUringStreamConfig config;
+    config.staging_bytes      = 64 * 1024;
+    config.max_inflight_bytes = 256 * 1024;
+    config.direct_io          = true;
+
+    auto data = pattern(200'003);  // not a multiple of the 4 KiB block
+    {
+        IoUringOutputStream out(path.string(), IoUringPool::create_child_ring_struct(), config);
+        ASSERT_TRUE(out.Write(data.data(), 777).ok());
+        ASSERT_TRUE(out.Flush().ok());
+        ASSERT_TRUE(out.Write(data.data() + 777, static_cast<int64_t>(data.size() - 777)).ok());
+        ASSERT_TRUE(out.Close().ok());
+    }
+
+    EXPECT_EQ(std::filesystem::file_size(path), data.size());
+    EXPECT_TRUE(slurp(path) == data);
+    std::filesystem::remove(path);
+}
+
+TEST(IoUringOutputStream, PreallocationReleasedOnClose) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_io_uring_prealloc_test.bin";
+
+    IoUringPool::init(path.parent_path().string());
+    IoUringStreamConfig config;
+    config.staging_bytes                 = 64 * 1024;
+    config.max_inflight_bytes            = 256 * 1024;
+    config.page_cache.preallocate_bytes  = 16 << 20;   // far more than written
+    config.page_cache.dirty_window_bytes = 128 * 1024;
+
+    auto data = pattern(1'000'001);
+    {
+        IoUringOutputStream out(path.string(), IoUringPool::create_child_ring_struct(), config);
+        for (size_t off = 0; off < data.size(); off += 50'000) {
+            size_t n = std::min<size_t>(50'000, data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+        }
+        ASSERT_TRUE(out.Close().ok());
+    }
+
+    EXPECT_EQ(std::filesystem::file_size(path), data.size());
+    EXPECT_TRUE(slurp(path) == data);
+    struct stat st{};
+    ASSERT_EQ(::stat(path.c_str(), &st), 0);
+    EXPECT_LT(static_cast<int64_t>(st.st_blocks) * 512, int64_t{4} << 20);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,71 @@
+// Unit tests: MmapOutputStream extents, non-temporal copies and final size
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "tpch/mmap_output_stream.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t n) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+    return v;
+}
+
+std::vector<uint8_t> slurp(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+TEST(MmapOutputStream, WritesSpanExtentsAndTruncateOnClose) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_mmap_stream_test.bin";
+
+    MmapStreamConfig config;
+    config.extent_bytes       = 64 * 1024;  // many extents
+    config.writeback          = true;
+    config.non_temporal_bytes = 4096;       // exercise the streaming-store path
+
+    auto data = pattern(1'000'003);
+    {
+        MmapOutputStream out(path.string(), config);
+        size_t off = 0, step = 1;
+        while (off < data.size()) {
+            size_t n = std::min(step, data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            off += n;
+            step = step * 7 % 100'003 + 1;  // small and large, unaligned writes
+        }
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(data.size()));
+        ASSERT_TRUE(out.Close().ok());
+        EXPECT_TRUE(out.closed());
+    }
+
+    EXPECT_EQ(std::filesystem::file_size(path), data.size());
+    EXPECT_EQ(slurp(path), data);
+    std::filesystem::remove(path);
+}
+
+TEST(MmapOutputStream, EmptyStreamLeavesEmptyFile) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_mmap_stream_empty.bin";
+    {
+        MmapOutputStream out(path.string());
+        ASSERT_TRUE(out.Close().ok());
+    }
+    EXPECT_EQ(std::filesystem::file_size(path), 0u);
+    std::filesystem::remove(path);
+
+    EXPECT_THROW(MmapOutputStream("/nonexistent-dir/x.bin"), std::runtime_error);
+}
@@ -0,0 +1,209 @@
+// Unit tests: ORCWriter round trips and injected output streams
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+
+#include <orc/OrcFile.hh>
+
+#include "tpch/orc_writer.hpp"
+
+using namespace tpch;
+
+namespace {
+
+const std::vector<std::string> FLAGS = {"A", "N", "R"};
+const std::vector<std::string> MODES = {"AIR", "FOB", "MAIL", "RAIL", "REG AIR", "SHIP", "TRUCK"};
+
+bool comment_is_null(int64_t k) { return k % 7 == 3; }
+bool mode_is_null(int64_t k) { return k % 5 == 0; }
+std::string comment_of(int64_t k) { return "comment " + std::to_string(k); }
+
+std::shared_ptr<arrow::Schema> test_schema() {
+    return arrow::schema({
+        arrow::field("key", arrow::int64()),
+        arrow::field("quantity", arrow::int32()),
+        arrow::field("price", arrow::float64()),
+        arrow::field("comment", arrow::utf8()),
+        arrow::field("flag", arrow::dictionary(arrow::int8(), arrow::utf8())),
+        arrow::field("mode", arrow::dictionary(arrow::int16(), arrow::utf8())),
+    });
+}
+
+std::shared_ptr<arrow::Array> strings(const std::vector<std::string>& values) {
+    arrow::StringBuilder b;
+    EXPECT_TRUE(b.AppendValues(values).ok());
+    return *b.Finish();
+}
+
+// Rows [base, base + rows): every column is a function of the key
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows) {
+    arrow::Int64Builder keys;
+    arrow::Int32Builder quantities;
+    arrow::DoubleBuilder prices;
+    arrow::StringBuilder comments;
+    arrow::Int8Builder flags;
+    arrow::Int16Builder modes;
+    for (int64_t k = base; k < base + rows; ++k) {
+        EXPECT_TRUE(keys.Append(k).ok());
+        EXPECT_TRUE(quantities.Append(static_cast<int32_t>(k % 50)).ok());
+        EXPECT_TRUE(prices.Append(static_cast<double>(k) * 0.5).ok());
+        EXPECT_TRUE((comment_is_null(k) ? comments.AppendNull() : comments.Append(comment_of(k))).ok());
+        EXPECT_TRUE(flags.Append(static_cast<int8_t>(k % 3)).ok());
+        EXPECT_TRUE((mode_is_null(k) ? modes.AppendNull() : modes.Append(static_cast<int16_t>(k % 7))).ok());
+    }
+    auto schema = test_schema();
+    auto flag = arrow::DictionaryArray::FromArrays(schema->field(4)->type(), *flags.Finish(), strings(FLAGS));
+    auto mode = arrow::DictionaryArray::FromArrays(schema->field(5)->type(), *modes.Finish(), strings(MODES));
+    EXPECT_TRUE(flag.ok() && mode.ok());
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *quantities.Finish(), *prices.Finish(),
+                                                  *comments.Finish(), *flag, *mode});
+}
+
+std::vector<char> slurp(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// Accepts every write, fails the final Close() (e.g. a lost last upload part)
+class FailingCloseStream : public arrow::io::OutputStream {
+public:
+    arrow::Status Write(const void*, int64_t nbytes) override {
+        position_ += nbytes;
+        return arrow::Status::OK();
+    }
+    arrow::Status Flush() override { return arrow::Status::OK(); }
+    arrow::Status Close() override {
+        closed_ = true;
+        return arrow::Status::IOError("final flush failed");
+    }
+    arrow::Result<int64_t> Tell() const override { return position_; }
+    bool closed() const override { return closed_; }
+
+private:
+    int64_t position_ = 0;
+    bool closed_ = false;
+};
+
+std::string string_at(const orc::StringVectorBatch& col, uint64_t i) {
+    return std::string(col.data[i], static_cast<size_t>(col.length[i]));
+}
+
+bool is_null(const orc::ColumnVectorBatch& col, uint64_t i) {
+    return col.hasNulls && !col.notNull[i];
+}
+
+}  // namespace
+
+TEST(ORCWriter, RoundTripsTypesNullsAndDictionaries) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_orc_writer_test.orc";
+
+    // The second batch is larger than the first, so the reused row batch
+    // grows, and it spans a row-index stride boundary
+    const int64_t first = 1000;
+    const int64_t second = static_cast<int64_t>(ORCWriter::ROW_INDEX_STRIDE) + 15000;
+    {
+        ORCWriter writer(path.string());
+        writer.write_batch(make_batch(0, first));
+        writer.write_batch(make_batch(first, second));
+        writer.close();
+    }
+
+    auto reader = orc::createReader(orc::readLocalFile(path.string()), orc::ReaderOptions());
+    EXPECT_EQ(reader->getType().toString(),
+              "struct<key:bigint,quantity:int,price:double,comment:string,flag:string,mode:string>");
+    ASSERT_EQ(reader->getNumberOfRows(), static_cast<uint64_t>(first + second));
+
+    // Low-cardinality columns keep ORC's dictionary; unique comments fall back to direct
+    auto stripe = reader->getStripe(0);
+    EXPECT_EQ(stripe->getColumnEncoding(4), orc::ColumnEncodingKind_DIRECT_V2);
+    EXPECT_EQ(stripe->getColumnEncoding(5), orc::ColumnEncodingKind_DICTIONARY_V2);
+    EXPECT_EQ(stripe->getColumnEncoding(6), orc::ColumnEncodingKind_DICTIONARY_V2);
+
+    auto rows = reader->createRowReader(orc::RowReaderOptions());
+    auto batch = rows->createRowBatch(4096);
+    int64_t k = 0;
+    while (rows->next(*batch)) {
+        auto& root = dynamic_cast<orc::StructVectorBatch&>(*batch);
+        auto& keys = dynamic_cast<orc::LongVectorBatch&>(*root.fields[0]);
+        auto& quantities = dynamic_cast<orc::LongVectorBatch&>(*root.fields[1]);
+        auto& prices = dynamic_cast<orc::DoubleVectorBatch&>(*root.fields[2]);
+        auto& comments = dynamic_cast<orc::StringVectorBatch&>(*root.fields[3]);
+        auto& flags = dynamic_cast<orc::StringVectorBatch&>(*root.fields[4]);
+        auto& modes = dynamic_cast<orc::StringVectorBatch&>(*root.fields[5]);
+        for (uint64_t i = 0; i < batch->numElements; ++i, ++k) {
+            ASSERT_EQ(keys.data[i], k);
+            EXPECT_EQ(quantities.data[i], k % 50);
+            EXPECT_EQ(prices.data[i], static_cast<double>(k) * 0.5);
+
+            EXPECT_EQ(is_null(comments, i), comment_is_null(k)) << "row " << k;
+            if (!comment_is_null(k)) {
+                EXPECT_EQ(string_at(comments, i), comment_of(k));
+            }
+
+            EXPECT_FALSE(is_null(flags, i));
+            EXPECT_EQ(string_at(flags, i), FLAGS[static_cast<size_t>(k % 3)]);
+
+            EXPECT_EQ(is_null(modes, i), mode_is_null(k)) << "row " << k;
+            if (!mode_is_null(k)) {
+                EXPECT_EQ(string_at(modes, i), MODES[static_cast<size_t>(k % 7)]);
+            }
+        }
+    }
+    EXPECT_EQ(k, first + second);
+
+    std::filesystem::remove(path);
+}
+
+TEST(ORCWriter, InjectedStreamMatchesLocalFile) {
+    auto local = std::filesystem::temp_directory_path() / "tpch_orc_writer_local_test.orc";
+    auto injected = std::filesystem::temp_directory_path() / "tpch_orc_writer_injected_test.orc";
+    auto target = std::filesystem::temp_directory_path() / "tpch_orc_writer_target_test.orc";
+    std::filesystem::remove(target);
+
+    {
+        ORCWriter writer(local.string());
+        writer.write_batch(make_batch(0, 1000));
+        writer.write_batch(make_batch(1000, 20000));
+        writer.close();
+    }
+    std::string opened;
+    {
+        ORCWriter writer(target.string());
+        writer.set_output_stream_factory([&](const std::string& p) {
+            opened = p;
+            return std::shared_ptr<arrow::io::OutputStream>(
+                *arrow::io::FileOutputStream::Open(injected.string()));
+        });
+        writer.write_batch(make_batch(0, 1000));
+        writer.write_batch(make_batch(1000, 20000));
+        writer.close();
+    }
+
+    EXPECT_EQ(opened, target.string());
+    EXPECT_FALSE(std::filesystem::exists(target));
+    EXPECT_TRUE(slurp(injected) == slurp(local));  // same bytes as orc::writeLocalFile
+
+    std::filesystem::remove(local);
+    std::filesystem::remove(injected);
+}
+
+TEST(ORCWriter, FailingStreamCloseThrowsFromClose) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_orc_writer_failing_test.orc";
+
+    auto stream = std::make_shared<FailingCloseStream>();
+    ORCWriter writer(path.string());
+    writer.set_output_stream_factory([&](const std::string&) { return stream; });
+    writer.write_batch(make_batch(0, 100));
+    EXPECT_THROW(writer.close(), std::runtime_error);
+    EXPECT_TRUE(stream->closed());
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
@@ -5,10 +5,15 @@
 #include <filesystem>
 #include <cstring>
 #include <limits>
+#include <map>
+#include <algorithm>
 
 #include "tpch/avro_writer.hpp"
+#include "tpch/io_uring_output_stream.hpp"
 #include "tpch/paimon_writer.hpp"
 #include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
 
 namespace tpch {
 namespace test {
@@ -441,5 +446,381 @@ TEST_F(PaimonWriterIntegrationTest, MultipleBatches) {
     EXPECT_NE(content.find("\"totalRecordCount\": 10"), std::string::npos);
 }
 
+TEST_F(PaimonWriterIntegrationTest, DataFilesThroughStreamFactory) {
+    PaimonWriter writer(temp_table_dir, "test_table");
+    std::vector<std::string> opened;
+    ASSERT_TRUE(writer.set_output_stream_factory([&](const std::string& path) {
+        opened.push_back(path);
+        return std::make_shared<IoUringOutputStream>(path);  // sync pwrite mode
+    }));
+    writer.write_batch(create_test_batch(100));
+    writer.close();
+
+    ASSERT_EQ(opened.size(), 1u);
+    EXPECT_NE(opened[0].find("/bucket-0/data-"), std::string::npos);
+    EXPECT_GT(fs::file_size(opened[0]), 0u);
+
+    std::ifstream snapshot_file(temp_table_dir + "/snapshot/snapshot-1");
+    std::string content((std::istreambuf_iterator<char>(snapshot_file)),
+                        std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("\"totalRecordCount\": 100"), std::string::npos);
+}
+
+namespace {
+
+// Accepts every byte, then fails like a full disk when the file is closed
+class FullDiskStream : public arrow::io::OutputStream {
+public:
+    arrow::Status Write(const void*, int64_t nbytes) override {
+        position_ += nbytes;
+        return arrow::Status::OK();
+    }
+    arrow::Status Close() override {
+        closed_ = true;
+        return arrow::Status::IOError("No space left on device");
+    }
+    arrow::Result<int64_t> Tell() const override { return position_; }
+    bool closed() const override { return closed_; }
+
+private:
+    int64_t position_ = 0;
+    bool closed_ = false;
+};
+
+}  // namespace
+
+TEST_F(PaimonWriterIntegrationTest, DataFileErrorsFailClose) {
+    PaimonWriter writer(temp_table_dir, "test_table");
+    ASSERT_TRUE(writer.set_output_stream_factory([](const std::string&) {
+        return std::make_shared<FullDiskStream>();
+    }));
+    writer.write_batch(create_test_batch(100));
+    EXPECT_THROW(writer.close(), std::runtime_error);
+    EXPECT_FALSE(fs::exists(temp_table_dir + "/snapshot/snapshot-1"));
+}
+
+// =====================================================================
+// Bucketed, rolling data files
+// =====================================================================
+
+TEST(PaimonBucketTest, HashMatchesMurmur3) {
+    // MurmurHash3_x86_32 reference values (seed 0)
+    const uint8_t zeros[4] = {0, 0, 0, 0};
+    EXPECT_EQ(static_cast<uint32_t>(paimon_detail::hash_words(zeros, 4, 0)), 0x2362F9DEu);
+    const uint8_t test[4] = {'t', 'e', 's', 't'};
+    EXPECT_EQ(static_cast<uint32_t>(paimon_detail::hash_words(test, 4, 0)), 0xBA6BD213u);
+    EXPECT_EQ(paimon_detail::hash_words(nullptr, 0, 0), 0);
+}
+
+TEST(PaimonBucketTest, BucketsFollowTheKey) {
+    arrow::Int64Builder keys;
+    arrow::StringBuilder names;
+    for (int64_t i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(keys.Append(i % 250).ok());
+        ASSERT_TRUE(names.Append(i % 2 ? "short" : "a name longer than seven bytes").ok());
+    }
+    auto schema = arrow::schema({arrow::field("k", arrow::int64()), arrow::field("s", arrow::utf8())});
+    auto batch = arrow::RecordBatch::Make(schema, 1000, {*keys.Finish(), *names.Finish()});
+
+    std::vector<int32_t> buckets;
+    paimon_detail::compute_buckets(*batch, {0}, 8, &buckets);
+    ASSERT_EQ(buckets.size(), 1000u);
+    std::vector<int> per_bucket(8, 0);
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        ASSERT_GE(buckets[i], 0);
+        ASSERT_LT(buckets[i], 8);
+        EXPECT_EQ(buckets[i], buckets[i % 250]);  // same key, same bucket
+        per_bucket[static_cast<size_t>(buckets[i])]++;
+    }
+    for (int count : per_bucket) {
+        EXPECT_GT(count, 0);
+    }
+
+    // Composite keys with inline and variable-length strings
+    std::vector<int32_t> composite;
+    paimon_detail::compute_buckets(*batch, {0, 1}, 8, &composite);
+    EXPECT_EQ(composite[0], composite[500]);
+    EXPECT_EQ(composite[1], composite[501]);
+
+    auto nested = arrow::schema({arrow::field("l", arrow::list(arrow::int32()))});
+    arrow::ListBuilder lists(arrow::default_memory_pool(), std::make_shared<arrow::Int32Builder>());
+    ASSERT_TRUE(lists.Append().ok());
+    auto list_batch = arrow::RecordBatch::Make(nested, 1, {*lists.Finish()});
+    EXPECT_THROW(paimon_detail::compute_buckets(*list_batch, {0}, 8, &buckets), std::invalid_argument);
+}
+
+TEST_F(PaimonWriterIntegrationTest, FixedBucketsRollDataFiles) {
+    constexpr int kBuckets = 4;
+    constexpr int kRows = 200'000;
+    {
+        PaimonWriter writer(temp_table_dir, "test_table");
+        writer.set_buckets(kBuckets);
+        writer.set_target_file_size(256 * 1024);
+        for (int base = 0; base < kRows; base += 10'000) {
+            arrow::Int64Builder ids;
+            arrow::StringBuilder names;
+            for (int i = base; i < base + 10'000; ++i) {
+                ASSERT_TRUE(ids.Append(i).ok());
+                ASSERT_TRUE(names.Append("name_" + std::to_string(i * 7919 % 100'003)).ok());
+            }
+            auto schema = arrow::schema({arrow::field("id", arrow::int64()),
+                                         arrow::field("name", arrow::utf8())});
+            writer.write_batch(arrow::RecordBatch::Make(schema, 10'000, {*ids.Finish(), *names.Finish()}));
+        }
+        writer.close();
+    }
+
+    std::ifstream options_file(temp_table_dir + "/OPTIONS");
+    std::string options((std::istreambuf_iterator<char>(options_file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(options.find("bucket=4\n"), std::string::npos);
+    EXPECT_NE(options.find("bucket-key=id\n"), std::string::npos);
+
+    // Every row sits in the bucket its key hashes to; buckets roll into several files
+    int64_t total = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        int files = 0;
+        for (const auto& entry : fs::directory_iterator(temp_table_dir + "/bucket-" + std::to_string(b))) {
+            ++files;
+            auto input = *arrow::io::ReadableFile::Open(entry.path().string());
+            auto reader = *parquet::arrow::OpenFile(input, arrow::default_memory_pool());
+            std::shared_ptr<arrow::Table> table;
+            ASSERT_TRUE(reader->ReadTable(&table).ok());
+            auto batch = *table->CombineChunksToBatch();
+            std::vector<int32_t> buckets;
+            paimon_detail::compute_buckets(*batch, {0}, kBuckets, &buckets);
+            for (int32_t bucket : buckets) {
+                ASSERT_EQ(bucket, b);
+            }
+            total += batch->num_rows();
+        }
+        EXPECT_GT(files, 1) << "bucket " << b;
+    }
+    EXPECT_EQ(total, kRows);
+
+    std::ifstream snapshot_file(temp_table_dir + "/snapshot/snapshot-1");
+    std::string snapshot((std::istreambuf_iterator<char>(snapshot_file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(snapshot.find("\"totalRecordCount\": 200000"), std::string::npos);
+}
+
+// =====================================================================
+// Primary-key tables: sorted runs, spill sort
+// =====================================================================
+
+namespace {
+
+std::shared_ptr<arrow::RecordBatch> make_orders(const std::vector<int64_t>& keys) {
+    arrow::Int64Builder ids;
+    arrow::StringBuilder comments;
+    for (int64_t key : keys) {
+        EXPECT_TRUE(ids.Append(key).ok());
+        EXPECT_TRUE(comments.Append("comment " + std::to_string(key * 31 % 9973)).ok());
+    }
+    auto schema = arrow::schema({arrow::field("o_orderkey", arrow::int64()),
+                                 arrow::field("o_comment", arrow::utf8())});
+    return arrow::RecordBatch::Make(schema, static_cast<int64_t>(keys.size()),
+                                    {*ids.Finish(), *comments.Finish()});
+}
+
+void write_orders(PaimonWriter& writer, const std::vector<int64_t>& keys) {
+    for (size_t base = 0; base < keys.size(); base += 5'000) {
+        const size_t end = std::min(keys.size(), base + 5'000);
+        writer.write_batch(make_orders({keys.begin() + base, keys.begin() + end}));
+    }
+    writer.close();
+}
+
+/** _KEY_o_orderkey of each file of a sorted run, files in key order. */
+std::vector<int64_t> read_keys(const std::string& table, const PaimonWriter::DataFileInfo& file) {
+    auto input = *arrow::io::ReadableFile::Open(table + "/bucket-" + std::to_string(file.bucket) + "/" + file.name);
+    auto reader = *parquet::arrow::OpenFile(input, arrow::default_memory_pool());
+    std::shared_ptr<arrow::Table> contents;
+    EXPECT_TRUE(reader->ReadTable(&contents).ok());
+    EXPECT_EQ(contents->schema()->field(0)->name(), "_KEY_o_orderkey");
+    EXPECT_EQ(contents->schema()->field(1)->name(), "_SEQUENCE_NUMBER");
+    EXPECT_EQ(contents->schema()->field(2)->name(), "_VALUE_KIND");
+    EXPECT_EQ(contents->schema()->field(3)->name(), "o_orderkey");
+    std::vector<int64_t> keys;
+    for (const auto& chunk : contents->column(0)->chunks()) {
+        const auto& values = static_cast<const arrow::Int64Array&>(*chunk);
+        for (int64_t i = 0; i < values.length(); ++i) keys.push_back(values.Value(i));
+    }
+    EXPECT_EQ(static_cast<int64_t>(keys.size()), file.rows);
+    return keys;
+}
+
+/** Keys of every run of bucket, by level; checks each run is sorted and its files' key ranges. */
+std::map<int32_t, std::vector<int64_t>> read_runs(const std::string& table, const PaimonWriter& writer,
+                                                  int32_t bucket) {
+    std::map<int32_t, std::vector<int64_t>> runs;
+    for (const auto& file : writer.data_files()) {
+        if (file.bucket != bucket) continue;
+        auto keys = read_keys(table, file);
+        EXPECT_FALSE(keys.empty());
+        EXPECT_EQ(file.min_key, paimon_detail::serialize_key(*make_orders({keys.front()}), {0}, 0));
+        EXPECT_EQ(file.max_key, paimon_detail::serialize_key(*make_orders({keys.back()}), {0}, 0));
+        auto& run = runs[file.level];
+        run.insert(run.end(), keys.begin(), keys.end());
+    }
+    for (const auto& [level, keys] : runs) {
+        EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end())) << "level " << level;
+        EXPECT_EQ(std::adjacent_find(keys.begin(), keys.end()), keys.end()) << "level " << level;
+    }
+    return runs;
+}
+
+std::string read_text(const std::string& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(PaimonPrimaryKeyTest, DefaultPrimaryKey) {
+    auto lineitem = arrow::schema({arrow::field("l_orderkey", arrow::int64()),
+                                   arrow::field("l_partkey", arrow::int64()),
+                                   arrow::field("l_linenumber", arrow::int32())});
+    EXPECT_EQ(PaimonWriter::default_primary_key(*lineitem),
+              (std::vector<std::string>{"l_orderkey", "l_linenumber"}));
+    auto store_sales = arrow::schema({arrow::field("ss_sold_date_sk", arrow::int64()),
+                                      arrow::field("ss_item_sk", arrow::int64()),
+                                      arrow::field("ss_ticket_number", arrow::int64())});
+    EXPECT_EQ(PaimonWriter::default_primary_key(*store_sales),
+              (std::vector<std::string>{"ss_item_sk", "ss_ticket_number"}));
+    EXPECT_TRUE(PaimonWriter::default_primary_key(*arrow::schema({arrow::field("id", arrow::int64())})).empty());
+
+    auto key = paimon_detail::serialize_key(*make_orders({5}), {0}, 0);
+    // Big-endian arity, 8-byte header, one slot holding the little-endian long
+    const std::vector<uint8_t> expected = {0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(key, expected);
+}
+
+TEST_F(PaimonWriterIntegrationTest, PrimaryKeyTableStreamsKeyOrderedRows) {
+    std::vector<int64_t> keys(60'000);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = static_cast<int64_t>(i) * 3;
+
+    PaimonWriter writer(temp_table_dir, "orders");
+    writer.set_primary_key();
+    writer.set_buckets(2);
+    writer.set_target_file_size(128 * 1024);
+    write_orders(writer, keys);
+
+    const std::string options = read_text(temp_table_dir + "/OPTIONS");
+    EXPECT_NE(options.find("table.type=PRIMARY_KEY\n"), std::string::npos);
+    EXPECT_NE(options.find("primary-key=o_orderkey\n"), std::string::npos);
+    EXPECT_NE(options.find("bucket-key=o_orderkey\n"), std::string::npos);
+    const std::string schema = read_text(temp_table_dir + "/schema/schema-0");
+    EXPECT_NE(schema.find("\"bigint NOT NULL\""), std::string::npos);
+    EXPECT_NE(schema.find("\"primaryKeys\": [\n    \"o_orderkey\""), std::string::npos);
+
+    // Rows in key order never touch the sort: one run per bucket, at the top level
+    size_t total = 0;
+    for (int32_t b = 0; b < 2; ++b) {
+        auto runs = read_runs(temp_table_dir, writer, b);
+        ASSERT_EQ(runs.size(), 1u);
+        EXPECT_EQ(runs.begin()->first, PaimonWriter::NUM_LEVELS - 1);
+        total += runs.begin()->second.size();
+    }
+    EXPECT_EQ(total, keys.size());
+    EXPECT_GT(writer.data_files().size(), 2u);
+    EXPECT_FALSE(fs::exists(temp_table_dir + "/_spill"));
+}
+
+TEST_F(PaimonWriterIntegrationTest, PrimaryKeyTableSpillSortsShuffledRows) {
+    constexpr int64_t kRows = 100'003;  // prime: i * 7919 % kRows is a permutation
+    std::vector<int64_t> keys(kRows);
+    for (int64_t i = 0; i < kRows; ++i) keys[static_cast<size_t>(i)] = i * 7919 % kRows;
+
+    PaimonWriter writer(temp_table_dir, "orders");
+    writer.set_primary_key({"o_orderkey"});
+    writer.set_sort_buffer_size(256 * 1024);  // many spilled runs
+    writer.set_target_file_size(512 * 1024);
+    write_orders(writer, keys);
+
+    auto runs = read_runs(temp_table_dir, writer, 0);
+    // The leading ascending rows stream into one run; the rest is merged into a run below it
+    ASSERT_EQ(runs.size(), 2u);
+    const auto& streamed = runs[PaimonWriter::NUM_LEVELS - 1];
+    const auto& merged = runs[PaimonWriter::NUM_LEVELS - 2];
+    EXPECT_EQ(streamed.size(), 13u);
+    EXPECT_EQ(static_cast<int64_t>(streamed.size() + merged.size()), kRows);
+    std::vector<int64_t> all = streamed;
+    all.insert(all.end(), merged.begin(), merged.end());
+    std::sort(all.begin(), all.end());
+    for (int64_t i = 0; i < kRows; ++i) {
+        ASSERT_EQ(all[static_cast<size_t>(i)], i);
+    }
+    EXPECT_FALSE(fs::exists(temp_table_dir + "/_spill"));
+
+    std::ifstream snapshot_file(temp_table_dir + "/snapshot/snapshot-1");
+    std::string snapshot((std::istreambuf_iterator<char>(snapshot_file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(snapshot.find("\"totalRecordCount\": 100003"), std::string::npos);
+}
+
+TEST_F(PaimonWriterIntegrationTest, PrimaryKeyTableSortsInMemoryWithoutSpilling) {
+    std::vector<int64_t> keys;
+    for (int64_t i = 20'000; i > 0; --i) keys.push_back(i);
+
+    PaimonWriter writer(temp_table_dir, "orders");
+    writer.set_primary_key();
+    write_orders(writer, keys);
+
+    auto runs = read_runs(temp_table_dir, writer, 0);
+    ASSERT_EQ(runs.size(), 2u);
+    EXPECT_EQ(runs[PaimonWriter::NUM_LEVELS - 1], std::vector<int64_t>{20'000});
+    EXPECT_EQ(runs[PaimonWriter::NUM_LEVELS - 2].size(), 19'999u);
+    for (const auto& file : writer.data_files()) {
+        if (file.level == PaimonWriter::NUM_LEVELS - 2) {
+            EXPECT_EQ(file.max_sequence, 19'999);
+        }
+    }
+
+    // Null keys cannot be written to a primary-key table
+    PaimonWriter nulls((fs::path(temp_table_dir) / "nulls").string(), "orders");
+    nulls.set_primary_key();
+    arrow::Int64Builder ids;
+    arrow::StringBuilder comments;
+    ASSERT_TRUE(ids.AppendNull().ok());
+    ASSERT_TRUE(comments.Append("x").ok());
+    auto batch = arrow::RecordBatch::Make(make_orders({})->schema(), 1, {*ids.Finish(), *comments.Finish()});
+    nulls.write_batch(batch);
+    EXPECT_THROW(nulls.write_batch(batch), std::runtime_error);
+}
+
+TEST_F(PaimonWriterIntegrationTest, DeferredWritersCommitOneSnapshot) {
+    size_t files = 0;
+    for (const char* id : {"node-a", "node-b"}) {
+        std::vector<int64_t> keys;
+        for (int64_t i = 0; i < 30'000; ++i) keys.push_back(i * 2 + (id[5] == 'b'));
+
+        PaimonWriter writer(temp_table_dir, "orders");
+        writer.set_primary_key();
+        writer.set_buckets(2);
+        writer.set_deferred_commit(id);
+        write_orders(writer, keys);
+        files += writer.data_files().size();
+
+        // Data files and a sidecar only: nothing is visible yet
+        EXPECT_TRUE(fs::exists(temp_table_dir + "/_pending/" + id + ".json"));
+        EXPECT_FALSE(fs::exists(temp_table_dir + "/snapshot/snapshot-1"));
+        EXPECT_FALSE(fs::exists(temp_table_dir + "/_spill"));
+    }
+    EXPECT_THROW(PaimonWriter(temp_table_dir).set_deferred_commit("a/b"), std::invalid_argument);
+
+    ASSERT_EQ(PaimonWriter::commit(temp_table_dir), files);
+    EXPECT_FALSE(fs::exists(temp_table_dir + "/_pending"));
+    const std::string snapshot = read_text(temp_table_dir + "/snapshot/snapshot-1");
+    EXPECT_NE(snapshot.find("\"totalRecordCount\": 60000"), std::string::npos);
+    EXPECT_EQ(read_text(temp_table_dir + "/snapshot/LATEST"), "1");
+
+    // Nothing left to commit; a second snapshot cannot be added
+    EXPECT_EQ(PaimonWriter::commit(temp_table_dir), 0u);
+    {
+        PaimonWriter late(temp_table_dir, "orders");
+        late.set_deferred_commit("late");
+        write_orders(late, {1, 2, 3});
+    }
+    EXPECT_THROW(PaimonWriter::commit(temp_table_dir), std::runtime_error);
+}
+
 }  // namespace test
 }  // namespace tpch
@@ -0,0 +1,193 @@
+// Unit tests: Thrift compact footer codec and parallel row group encoding
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/io/memory.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/bloom_filter.h>
+#include <parquet/bloom_filter_reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/page_index.h>
+
+#include "tpch/parquet_assembler.hpp"
+#include "tpch/parquet_options.hpp"
+#include "tpch/parquet_writer.hpp"
+#include "tpch/thrift_compact.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows) {
+    static const char* flags[] = {"A", "N", "R"};
+    arrow::Int64Builder keys;
+    arrow::Int64Builder parts;
+    arrow::StringBuilder flag;
+    arrow::StringBuilder comments;
+    for (int64_t i = base; i < base + rows; ++i) {
+        EXPECT_TRUE(keys.Append(i).ok());
+        EXPECT_TRUE(parts.Append((i * 7919) % 200'000).ok());
+        EXPECT_TRUE(flag.Append(flags[i % 3]).ok());
+        EXPECT_TRUE(comments.Append("comment " + std::to_string(i * 31 % 9973)).ok());
+    }
+    auto schema = arrow::schema({arrow::field("l_orderkey", arrow::int64()),
+                                 arrow::field("l_partkey", arrow::int64()),
+                                 arrow::field("l_returnflag", arrow::utf8()),
+                                 arrow::field("l_comment", arrow::utf8())});
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *parts.Finish(),
+                                                   *flag.Finish(), *comments.Finish()});
+}
+
+std::shared_ptr<parquet::WriterProperties> props(int64_t row_group_rows) {
+    parquet::WriterProperties::Builder builder;
+    builder.compression(parquet::Compression::ZSTD)
+        ->max_row_group_length(row_group_rows)
+        ->data_pagesize(8 * 1024)
+        ->enable_write_page_index();
+#if PARQUET_VERSION_MAJOR >= 22
+    builder.enable_bloom_filter("l_partkey", parquet::BloomFilterOptions{});
+#endif
+    return builder.build();
+}
+
+std::shared_ptr<arrow::Table> read_table(const std::string& path) {
+    auto file = *arrow::io::ReadableFile::Open(path);
+    auto reader = *parquet::arrow::OpenFile(file, arrow::default_memory_pool());
+    std::shared_ptr<arrow::Table> table;
+    EXPECT_TRUE(reader->ReadTable(&table).ok());
+    return table;
+}
+
+}  // namespace
+
+TEST(ThriftCompact, FooterRoundTripsByteForByte) {
+    auto sink = *arrow::io::BufferOutputStream::Create();
+    auto batch = make_batch(0, 30'000);
+    auto writer = *parquet::arrow::FileWriter::Open(*batch->schema(), arrow::default_memory_pool(),
+                                                    sink, props(10'000));
+    ASSERT_TRUE(writer->WriteRecordBatch(*batch).ok());
+    ASSERT_TRUE(writer->Close().ok());
+    auto file = *sink->Finish();
+
+    uint32_t len = 0;
+    std::memcpy(&len, file->data() + file->size() - 8, 4);
+    const uint8_t* footer = file->data() + file->size() - 8 - len;
+    size_t used = 0;
+    auto meta = decode_thrift_struct(footer, len, &used);
+    EXPECT_EQ(used, len);
+    EXPECT_EQ(meta.int_field(3), 30'000);             // num_rows
+    EXPECT_EQ(meta.field(4)->items.size(), 3u);       // row groups
+    EXPECT_EQ(encode_thrift_struct(meta), std::string(reinterpret_cast<const char*>(footer), len));
+
+    EXPECT_THROW(decode_thrift_struct(footer, len / 2), std::runtime_error);
+}
+
+TEST(ParallelRowGroupWriter, MatchesSequentialWriterWithIndexes) {
+    auto dir = std::filesystem::temp_directory_path();
+    auto path = dir / "tpch_parallel_rowgroups_test.parquet";
+    {
+        auto out = *arrow::io::FileOutputStream::Open(path.string());
+        ParallelRowGroupWriter writer(out, make_batch(0, 1)->schema(), props(25'000), 3);
+        // Batches that straddle row group boundaries
+        for (int64_t base = 0; base < 130'000; base += 17'000) {
+            writer.write(make_batch(base, std::min<int64_t>(17'000, 130'000 - base)));
+        }
+        writer.close();
+        EXPECT_EQ(writer.num_row_groups(), 6);
+        ASSERT_TRUE(out->Close().ok());
+    }
+
+    auto table = read_table(path.string());
+    ASSERT_EQ(table->num_rows(), 130'000);
+    auto expected = *arrow::Table::FromRecordBatches({make_batch(0, 130'000)});
+    EXPECT_TRUE(table->Equals(*expected));
+
+    auto reader = parquet::ParquetFileReader::OpenFile(path.string());
+    auto meta = reader->metadata();
+    ASSERT_EQ(meta->num_row_groups(), 6);
+    auto page_index = reader->GetPageIndexReader();
+    ASSERT_NE(page_index, nullptr);
+    for (int g = 0; g < meta->num_row_groups(); ++g) {
+        auto rg = meta->RowGroup(g);
+        EXPECT_EQ(rg->num_rows(), g < 5 ? 25'000 : 5'000);
+        for (int c = 0; c < rg->num_columns(); ++c) {
+            auto chunk = rg->ColumnChunk(c);
+            const int64_t start = chunk->has_dictionary_page() ? chunk->dictionary_page_offset()
+                                                               : chunk->data_page_offset();
+            auto oi = page_index->RowGroup(g)->GetOffsetIndex(c);
+            ASSERT_NE(oi, nullptr);
+            // First data page follows the dictionary page, if any
+            EXPECT_EQ(oi->page_locations().front().offset, chunk->data_page_offset());
+            EXPECT_GE(chunk->data_page_offset(), start);
+            ASSERT_NE(page_index->RowGroup(g)->GetColumnIndex(c), nullptr);
+        }
+    }
+
+#if PARQUET_VERSION_MAJOR >= 22
+    auto& blooms = reader->GetBloomFilterReader();
+    auto filter = blooms.RowGroup(5)->GetColumnBloomFilter(1);
+    ASSERT_NE(filter, nullptr);
+    const int64_t present = (125'000 * 7919) % 200'000;
+    EXPECT_TRUE(filter->FindHash(filter->Hash(present)));
+#endif
+    std::filesystem::remove(path);
+}
+
+TEST(ParquetFileAssembler, RejectsRowGroupOrdinalsPastInt16) {
+    // One file with 32768 single-row groups fills every ordinal; one more must throw
+    auto schema = arrow::schema({arrow::field("k", arrow::int64())});
+    auto encode = [&](int64_t rows) {
+        arrow::Int64Builder keys;
+        for (int64_t i = 0; i < rows; ++i) EXPECT_TRUE(keys.Append(i).ok());
+        auto table = arrow::Table::Make(schema, {*keys.Finish()});
+        auto out = *arrow::io::BufferOutputStream::Create();
+        auto file_props = parquet::WriterProperties::Builder()
+                              .max_row_group_length(1)
+                              ->compression(parquet::Compression::UNCOMPRESSED)
+                              ->build();
+        EXPECT_TRUE(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), out,
+                                               rows, file_props)
+                        .ok());
+        return *out->Finish();
+    };
+
+    ParquetFileAssembler assembler(*arrow::io::BufferOutputStream::Create());
+    assembler.append(encode(32768));
+    EXPECT_EQ(assembler.num_row_groups(), 32768);
+    EXPECT_THROW(assembler.append(encode(1)), std::runtime_error);
+    EXPECT_EQ(assembler.num_row_groups(), 32768);
+}
+
+TEST(ParquetWriter, RowGroupThreadsKeepManagedBatchOwners) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_rowgroup_threads_test.parquet";
+    ParquetOptions options;
+    options.row_group_threads = 4;
+    options.row_group_bytes = 256 * 1024;
+    std::weak_ptr<BufferLifetimeManager> watch;
+    {
+        ParquetWriter writer(path.string());
+        writer.set_parquet_options(options);
+        writer.enable_streaming_write();
+        for (int64_t base = 0; base < 100'000; base += 20'000) {
+            auto mgr = std::make_shared<BufferLifetimeManager>();
+            watch = mgr;
+            writer.write_managed_batch(ManagedRecordBatch(make_batch(base, 20'000), mgr));
+        }
+        writer.close();
+    }
+    EXPECT_TRUE(watch.expired());
+
+    auto table = read_table(path.string());
+    auto expected = *arrow::Table::FromRecordBatches({make_batch(0, 100'000)});
+    EXPECT_TRUE(table->Equals(*expected));
+    EXPECT_GT(parquet::ParquetFileReader::OpenFile(path.string())->metadata()->num_row_groups(), 4);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,202 @@
+// Unit tests: Parquet encoding profiles, the auto selector and zstd levels
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+
+#include "tpch/parquet_options.hpp"
+#include "tpch/parquet_writer.hpp"
+
+using namespace tpch;
+
+namespace {
+
+// l_orderkey ascending, l_linenumber 1..7, l_extendedprice, l_shipmode (7 values)
+std::shared_ptr<arrow::RecordBatch> make_lineitem_like(int64_t rows) {
+    static const char* modes[] = {"AIR", "FOB", "MAIL", "RAIL", "REG AIR", "SHIP", "TRUCK"};
+    arrow::Int64Builder keys;
+    arrow::Int32Builder lines;
+    arrow::DoubleBuilder prices;
+    arrow::StringBuilder shipmodes;
+    for (int64_t i = 0; i < rows; ++i) {
+        EXPECT_TRUE(keys.Append(1 + i / 4).ok());
+        EXPECT_TRUE(lines.Append(static_cast<int32_t>(i % 7 + 1)).ok());
+        EXPECT_TRUE(prices.Append(901.0 + static_cast<double>((i * 7919) % 104'000) / 100.0).ok());
+        EXPECT_TRUE(shipmodes.Append(modes[(i * 5) % 7]).ok());
+    }
+    auto schema = arrow::schema({arrow::field("l_orderkey", arrow::int64()),
+                                 arrow::field("l_linenumber", arrow::int32()),
+                                 arrow::field("l_extendedprice", arrow::float64()),
+                                 arrow::field("l_shipmode", arrow::utf8())});
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *lines.Finish(),
+                                                   *prices.Finish(), *shipmodes.Finish()});
+}
+
+const ColumnEncoding& find(const std::vector<ColumnEncoding>& v, const std::string& column) {
+    for (const auto& e : v) {
+        if (e.column == column) return e;
+    }
+    throw std::runtime_error("no encoding for " + column);
+}
+
+}  // namespace
+
+TEST(ParquetOptions, ParsesProfilesAndZstdLevels) {
+    EXPECT_EQ(ParquetOptions::parse_profile("plain"), EncodingProfile::Plain);
+    EXPECT_EQ(ParquetOptions::parse_profile("tuned"), EncodingProfile::Tuned);
+    EXPECT_EQ(ParquetOptions::parse_profile("auto"), EncodingProfile::Auto);
+    EXPECT_THROW(ParquetOptions::parse_profile("fast"), std::invalid_argument);
+
+    ParquetOptions options;
+    EXPECT_FALSE(options.has_zstd_levels());
+    options.parse_zstd_levels("3,l_comment=9");
+    EXPECT_EQ(options.zstd_level, 3);
+    EXPECT_EQ(options.column_zstd_levels.at("l_comment"), 9);
+    EXPECT_TRUE(options.has_zstd_levels());
+
+    for (const char* bad : {"", "0", "23", "x", "3,", "=4", "l_comment="}) {
+        ParquetOptions o;
+        EXPECT_THROW(o.parse_zstd_levels(bad), std::invalid_argument) << bad;
+    }
+}
+
+TEST(ParquetOptions, TunedRulesAndAutoSampling) {
+    auto batch = make_lineitem_like(40'000);
+    ParquetOptions options;
+
+    auto plain = choose_column_encodings(*batch->schema(), options, parquet::Compression::ZSTD);
+    for (const auto& e : plain) {
+        EXPECT_EQ(e.encoding, parquet::Encoding::PLAIN) << e.column;
+        EXPECT_FALSE(e.dictionary) << e.column;
+    }
+
+    options.encoding_profile = EncodingProfile::Tuned;
+    auto tuned = choose_column_encodings(*batch->schema(), options, parquet::Compression::ZSTD);
+    EXPECT_EQ(find(tuned, "l_orderkey").encoding, parquet::Encoding::DELTA_BINARY_PACKED);
+    EXPECT_TRUE(find(tuned, "l_linenumber").dictionary);
+    EXPECT_EQ(find(tuned, "l_extendedprice").encoding, parquet::Encoding::BYTE_STREAM_SPLIT);
+    EXPECT_EQ(find(tuned, "l_shipmode").encoding, parquet::Encoding::PLAIN);
+
+    // Sorted, dense keys delta-encode best; seven ship modes compress to a dictionary
+    options.encoding_profile = EncodingProfile::Auto;
+    options.sample_rows = 20'000;
+    auto chosen = choose_column_encodings(*batch->schema(), options,
+                                          parquet::Compression::UNCOMPRESSED, batch);
+    ASSERT_EQ(chosen.size(), 4u);
+    EXPECT_EQ(find(chosen, "l_orderkey").encoding, parquet::Encoding::DELTA_BINARY_PACKED);
+    EXPECT_TRUE(find(chosen, "l_shipmode").dictionary);
+    for (const auto& e : chosen) EXPECT_GT(e.sample_bytes, 0) << e.column;
+
+    // No sample: Auto falls back to the tuned rules
+    auto fallback = choose_column_encodings(*batch->schema(), options, parquet::Compression::ZSTD);
+    EXPECT_EQ(find(fallback, "l_extendedprice").encoding, parquet::Encoding::BYTE_STREAM_SPLIT);
+
+    parquet::WriterProperties::Builder builder;
+    options.zstd_level = 5;
+    EXPECT_THROW(apply_parquet_options(builder, chosen, options, parquet::Compression::SNAPPY),
+                 std::invalid_argument);
+}
+
+TEST(ParquetWriter, WritesChosenEncodingsAndZstdLevels) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_parquet_options_test.parquet";
+    auto batch = make_lineitem_like(50'000);
+
+    ParquetOptions options;
+    options.encoding_profile = EncodingProfile::Tuned;
+    options.parse_zstd_levels("1,l_shipmode=19");
+    {
+        ParquetWriter writer(path.string());
+        writer.set_compression("zstd");
+        writer.set_parquet_options(options);
+        writer.enable_streaming_write();
+        writer.write_batch(batch);
+        writer.write_batch(batch);
+        EXPECT_THROW(writer.set_parquet_options(options), std::runtime_error);
+        writer.close();
+        EXPECT_EQ(find(writer.column_encodings(), "l_orderkey").encoding,
+                  parquet::Encoding::DELTA_BINARY_PACKED);
+    }
+
+    auto reader = parquet::ParquetFileReader::OpenFile(path.string());
+    auto meta = reader->metadata();
+    EXPECT_EQ(meta->num_rows(), 100'000);
+    auto rg = meta->RowGroup(0);
+    auto encodings_of = [&](int col) {
+        auto chunk = rg->ColumnChunk(col);
+        const auto& e = chunk->encodings();
+        return std::set<parquet::Encoding::type>(e.begin(), e.end());
+    };
+    EXPECT_TRUE(encodings_of(0).count(parquet::Encoding::DELTA_BINARY_PACKED));
+    EXPECT_TRUE(encodings_of(1).count(parquet::Encoding::RLE_DICTIONARY));
+    EXPECT_TRUE(encodings_of(2).count(parquet::Encoding::BYTE_STREAM_SPLIT));
+    EXPECT_EQ(rg->ColumnChunk(3)->compression(), parquet::Compression::ZSTD);
+    std::filesystem::remove(path);
+}
+
+TEST(ParquetOptions, GenerationOrderAndBloomFilterColumns) {
+    auto lineitem = make_lineitem_like(1)->schema();
+    EXPECT_EQ(generation_sort_columns(*lineitem),
+              (std::vector<std::string>{"l_orderkey", "l_linenumber"}));
+    auto other = arrow::schema({arrow::field("ss_sold_date_sk", arrow::int64()),
+                                arrow::field("ss_ticket_number", arrow::int64())});
+    EXPECT_EQ(generation_sort_columns(*other), std::vector<std::string>{"ss_ticket_number"});
+    EXPECT_TRUE(generation_sort_columns(*arrow::schema({arrow::field("x", arrow::int64())})).empty());
+
+    ParquetOptions options;
+    options.parse_bloom_filter_columns("keys,l_comment");
+    EXPECT_EQ(options.bloom_filter_columns.size(), default_bloom_filter_columns().size() + 1);
+    EXPECT_EQ(options.bloom_filter_columns.back(), "l_comment");
+    EXPECT_THROW(options.parse_bloom_filter_columns("l_partkey,"), std::invalid_argument);
+}
+
+TEST(ParquetWriter, WritesPageIndexBloomFiltersSortOrderAndByteSizedRowGroups) {
+    auto path = std::filesystem::temp_directory_path() / "tpch_parquet_layout_test.parquet";
+    auto batch = make_lineitem_like(50'000);
+
+    ParquetOptions options;
+    options.page_index = true;
+    options.parse_bloom_filter_columns("l_extendedprice");
+    options.declare_sort_order = true;
+    options.row_group_bytes = 512 * 1024;  // ~28 Arrow bytes/row: three row groups
+    options.page_bytes = 16 * 1024;
+    size_t unit_rows = 0;
+    {
+        ParquetWriter writer(path.string());
+        writer.set_parquet_options(options);
+        EXPECT_EQ(writer.preferred_unit_rows(), 0u);
+        EXPECT_EQ(writer.preferred_unit_bytes(), 512u * 1024);
+        writer.enable_streaming_write();
+        writer.write_batch(batch);
+        unit_rows = writer.preferred_unit_rows();  // derived from the measured bytes/row
+        writer.close();
+    }
+
+    auto reader = parquet::ParquetFileReader::OpenFile(path.string());
+    auto meta = reader->metadata();
+    ASSERT_EQ(meta->num_rows(), 50'000);
+    EXPECT_GT(meta->num_row_groups(), 1);
+    auto rg = meta->RowGroup(0);
+    EXPECT_LT(rg->num_rows(), 50'000);
+    EXPECT_EQ(static_cast<size_t>(rg->num_rows()), unit_rows);
+
+    auto sorting = rg->sorting_columns();
+    ASSERT_EQ(sorting.size(), 2u);
+    EXPECT_EQ(sorting[0].column_idx, 0);
+    EXPECT_EQ(sorting[1].column_idx, 1);
+    EXPECT_FALSE(sorting[0].descending);
+
+    auto price = rg->ColumnChunk(2);
+    EXPECT_TRUE(price->GetColumnIndexLocation().has_value());
+    EXPECT_TRUE(price->GetOffsetIndexLocation().has_value());
+    EXPECT_TRUE(price->bloom_filter_offset().has_value());
+    EXPECT_FALSE(rg->ColumnChunk(0)->bloom_filter_offset().has_value());
+    std::filesystem::remove(path);
+}
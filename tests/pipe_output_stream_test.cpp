@@ -0,0 +1,171 @@
+// Unit tests: PipeOutputStream staging, pipes and regular files
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "tpch/pipe_output_stream.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::vector<uint8_t> pattern(size_t n) {
+    std::vector<uint8_t> v(n);
+    // (i >> 18) varies per chunk: a reused chunk must not look identical
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9) ^ ((i >> 18) * 29));
+    return v;
+}
+
+std::vector<uint8_t> drain(int fd, bool slow) {
+    std::vector<uint8_t> out;
+    uint8_t buf[64 * 1024];
+    for (ssize_t n; (n = ::read(fd, buf, sizeof(buf))) > 0;) {
+        out.insert(out.end(), buf, buf + n);
+        if (slow) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return out;
+}
+
+}  // namespace
+
+TEST(PipeOutputStream, ChunksSurviveSlowReader) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    // Reader lags behind: the reused chunk must not change bytes still in the pipe.
+    std::vector<uint8_t> got;
+    std::thread reader([&] { got = drain(fds[0], /*slow=*/true); });
+
+    auto data = pattern(6 * PipeOutputStream::CHUNK_BYTES + 12345);
+    {
+        PipeOutputStream out(fds[1], "pipe");
+        size_t off = 0, step = 1000;
+        while (off < data.size()) {
+            size_t n = std::min(step, data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            off += n;
+            step = step * 3 % 70001 + 1;
+            if (off % 7 == 0) {
+                ASSERT_TRUE(out.Flush().ok());  // short chunks in the pipe
+            }
+        }
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(data.size()));
+        ASSERT_TRUE(out.Close().ok());
+    }
+    reader.join();
+    ::close(fds[0]);
+
+    EXPECT_EQ(got, data);
+}
+
+TEST(PipeOutputStream, PagesSplicedOnwardAreNeverRewritten) {
+    // cat-like relay: splice(2) moves page references from the first pipe
+    // into a second one, so the first pipe looks drained long before the
+    // bytes are actually read; reusing the chunk must not change them.
+    int first[2], second[2];
+    ASSERT_EQ(::pipe(first), 0);
+    ASSERT_EQ(::pipe(second), 0);
+    (void)::fcntl(second[1], F_SETPIPE_SZ, static_cast<int>(PipeOutputStream::PIPE_BYTES));
+
+    std::thread relay([&] {
+        while (::splice(first[0], nullptr, second[1], nullptr, 1 << 20, SPLICE_F_MOVE) > 0) {}
+        ::close(second[1]);
+    });
+    std::vector<uint8_t> got;
+    std::thread reader([&] {
+        // Let both pipes fill so the chunk is reused while bytes are in flight
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        got = drain(second[0], /*slow=*/true);
+    });
+
+    auto data = pattern(12 * PipeOutputStream::CHUNK_BYTES + 4321);
+    {
+        PipeOutputStream out(first[1], "pipe");
+        ASSERT_TRUE(out.Write(data.data(), static_cast<int64_t>(data.size())).ok());
+        ASSERT_TRUE(out.Close().ok());
+    }
+    relay.join();
+    reader.join();
+    ::close(first[0]);
+    ::close(second[0]);
+
+    EXPECT_EQ(got, data);
+}
+
+TEST(PipeOutputStream, LargeWritesKeepOrderWithStagedBytes) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    std::vector<uint8_t> got;
+    std::thread reader([&] { got = drain(fds[0], /*slow=*/false); });
+
+    // small, large (bypasses the chunk), small, exactly one chunk, small
+    const size_t sizes[] = {100, 3 * PipeOutputStream::CHUNK_BYTES + 5, 7,
+                            PipeOutputStream::CHUNK_BYTES, 4096};
+    size_t total = 0;
+    for (size_t n : sizes) total += n;
+    auto data = pattern(total);
+    {
+        PipeOutputStream out(fds[1], "pipe");
+        size_t off = 0;
+        for (size_t n : sizes) {
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            off += n;
+        }
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(total));
+        ASSERT_TRUE(out.Close().ok());
+    }
+    reader.join();
+    ::close(fds[0]);
+
+    EXPECT_EQ(got, data);
+}
+
+TEST(PipeOutputStream, NonBlockingPipeWaitsInsteadOfFailing) {
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+
+    std::vector<uint8_t> got;
+    std::thread reader([&] {
+        int flags = ::fcntl(fds[0], F_GETFL);
+        ::fcntl(fds[0], F_SETFL, flags & ~O_NONBLOCK);
+        got = drain(fds[0], /*slow=*/true);
+    });
+
+    auto data = pattern(5 * PipeOutputStream::CHUNK_BYTES + 99);
+    {
+        PipeOutputStream out(fds[1], "pipe");
+        ASSERT_TRUE(out.Write(data.data(), static_cast<int64_t>(data.size())).ok());
+        ASSERT_TRUE(out.Close().ok());
+    }
+    reader.join();
+    ::close(fds[0]);
+
+    EXPECT_EQ(got, data);
+}
+
+TEST(PipeOutputStream, RegularFileFallsBackToWrite) {
+    FILE* f = std::tmpfile();
+    ASSERT_NE(f, nullptr);
+
+    auto data = pattern(PipeOutputStream::CHUNK_BYTES + 77);
+    {
+        PipeOutputStream out(::fileno(f), "tmpfile", /*owns_fd=*/false);
+        ASSERT_TRUE(out.Write(data.data(), static_cast<int64_t>(data.size())).ok());
+        ASSERT_TRUE(out.Close().ok());
+    }
+
+    ::lseek(::fileno(f), 0, SEEK_SET);
+    EXPECT_EQ(drain(::fileno(f), /*slow=*/false), data);
+    std::fclose(f);
+}
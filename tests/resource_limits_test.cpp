@@ -0,0 +1,81 @@
+// Unit tests for cgroup v2 limit parsing and auto-tuning plan
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "tpch/resource_limits.hpp"
+
+using namespace tpch;
+
+TEST(ResourceLimits, ParseCpuMax) {
+    EXPECT_DOUBLE_EQ(parse_cgroup_cpu_max("max 100000"), 0.0);
+    EXPECT_DOUBLE_EQ(parse_cgroup_cpu_max("1600000 100000"), 16.0);
+    EXPECT_DOUBLE_EQ(parse_cgroup_cpu_max("50000 100000\n"), 0.5);
+    EXPECT_DOUBLE_EQ(parse_cgroup_cpu_max(""), 0.0);
+}
+
+TEST(ResourceLimits, ParseMemoryMax) {
+    EXPECT_EQ(parse_cgroup_memory_max("max"), 0);
+    EXPECT_EQ(parse_cgroup_memory_max("68719476736\n"), int64_t{68719476736});
+    EXPECT_EQ(parse_cgroup_memory_max("garbage"), 0);
+}
+
+TEST(ResourceLimits, ParseCpuList) {
+    EXPECT_EQ(parse_cpu_list_count("0-3,8,10-11"), 7u);
+    EXPECT_EQ(parse_cpu_list_count("5"), 1u);
+    EXPECT_EQ(parse_cpu_list_count("0-127\n"), 128u);
+    EXPECT_EQ(parse_cpu_list_count("3-1"), 0u);
+}
+
+TEST(ResourceLimits, DetectFromFakeCgroupRoot) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "tpch_resource_limits_test";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "cgroup.controllers") << "cpuset cpu memory\n";
+    std::ofstream(root / "cpu.max") << "200000 100000\n";
+    std::ofstream(root / "memory.max") << "4294967296\n";
+
+    auto limits = detect_resource_limits(root.string());
+    EXPECT_TRUE(limits.cgroup_v2);
+    EXPECT_DOUBLE_EQ(limits.cpu_quota, 2.0);
+    EXPECT_EQ(limits.memory_max, int64_t{4294967296});
+    EXPECT_LE(limits.effective_cpus(), 2u);
+
+    fs::remove_all(root);
+}
+
+TEST(ResourceLimits, PlanMatchesQuotaNotHost) {
+    ResourceLimits limits;
+    limits.host_cpus   = 128;
+    limits.cpuset_cpus = 128;
+    limits.cpu_quota   = 16.0;
+    limits.memory_max  = int64_t{64} << 30;
+
+    auto t = plan_auto_tuning(limits, 8);
+    EXPECT_EQ(t.parallel_slots, 8u);
+    EXPECT_EQ(t.arrow_cpu_threads, 2);
+    EXPECT_EQ(t.lance_threads, 2);
+    EXPECT_EQ(t.max_batch_rows, 0u);
+
+    // Explicit --parallel-tables wins over the planner.
+    auto explicit_slots = plan_auto_tuning(limits, 8, 4);
+    EXPECT_EQ(explicit_slots.parallel_slots, 4u);
+    EXPECT_EQ(explicit_slots.arrow_cpu_threads, 4);
+}
+
+TEST(ResourceLimits, TightMemoryCapsSlotsAndBatch) {
+    ResourceLimits limits;
+    limits.host_cpus   = 64;
+    limits.cpuset_cpus = 64;
+    limits.memory_max  = int64_t{3} << 30;
+
+    auto t = plan_auto_tuning(limits, 24);
+    EXPECT_EQ(t.parallel_slots, 3u);
+
+    auto forced = plan_auto_tuning(limits, 24, 12);
+    EXPECT_LT(forced.max_batch_rows, 8192u);
+    EXPECT_GE(forced.max_batch_rows, 1024u);
+}
@@ -0,0 +1,205 @@
+// Unit tests: size-targeted part files, Parquet summary files and manifest
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include <parquet/statistics.h>
+
+#include "tpch/csv_writer.hpp"
+#include "tpch/parquet_writer.hpp"
+#include "tpch/rolling_file_writer.hpp"
+
+using namespace tpch;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows) {
+    arrow::Int64Builder keys;
+    arrow::StringBuilder comments;
+    for (int64_t i = base; i < base + rows; ++i) {
+        EXPECT_TRUE(keys.Append(i).ok());
+        EXPECT_TRUE(comments.Append("comment " + std::to_string(i * 7919 % 100'003)).ok());
+    }
+    auto schema = arrow::schema({arrow::field("o_orderkey", arrow::int64()),
+                                 arrow::field("o_comment", arrow::utf8())});
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), *comments.Finish()});
+}
+
+std::string read_file(const fs::path& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+fs::path fresh_dir(const std::string& name) {
+    auto dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    return dir;
+}
+
+}  // namespace
+
+TEST(RollingFileWriter, ParseByteSize) {
+    EXPECT_EQ(parse_byte_size("4096"), 4096);
+    EXPECT_EQ(parse_byte_size("512MB"), 512LL << 20);
+    EXPECT_EQ(parse_byte_size("512m"), 512LL << 20);
+    EXPECT_EQ(parse_byte_size("1.5GiB"), 3LL << 29);
+    EXPECT_EQ(parse_byte_size("64k"), 64LL << 10);
+    EXPECT_THROW(parse_byte_size("MB"), std::invalid_argument);
+    EXPECT_THROW(parse_byte_size("12XB"), std::invalid_argument);
+    EXPECT_THROW(parse_byte_size("0"), std::invalid_argument);
+    EXPECT_THROW(parse_byte_size("-5M"), std::invalid_argument);
+
+    EXPECT_EQ(RollingFileWriter::part_name(7, "parquet"), "part-00007.parquet");
+    EXPECT_EQ(RollingFileWriter::dataset_dir("out/lineitem.parquet"), "out/lineitem");
+    EXPECT_EQ(RollingFileWriter::dataset_dir("out.d/lineitem"), "out.d/lineitem");
+}
+
+TEST(RollingFileWriter, ParquetPartsWithSummaryFiles) {
+    auto dir = fresh_dir("tpch_rolling_parquet_test");
+    {
+        RollingFileWriter writer(dir.string(), "parquet", 128 * 1024, [](const std::string& path) {
+            auto w = std::make_unique<ParquetWriter>(path);
+            ParquetOptions options;
+            options.row_group_bytes = 64 * 1024;
+            w->set_parquet_options(options);
+            w->enable_streaming_write();
+            return w;
+        });
+        for (int64_t base = 0; base < 200'000; base += 10'000) {
+            writer.write_batch(make_batch(base, 10'000));
+        }
+        writer.close();
+
+        ASSERT_GT(writer.parts().size(), 2u);
+        int64_t rows = 0;
+        for (size_t i = 0; i < writer.parts().size(); ++i) {
+            const auto& part = writer.parts()[i];
+            EXPECT_EQ(part.name, RollingFileWriter::part_name(i, "parquet"));
+            EXPECT_EQ(part.bytes, static_cast<int64_t>(fs::file_size(dir / part.name)));
+            rows += part.rows;
+        }
+        EXPECT_EQ(rows, 200'000);
+    }
+
+    // _metadata: every row group of every part, addressed by file_path
+    auto summary = parquet::ParquetFileReader::OpenFile((dir / "_metadata").string());
+    auto meta = summary->metadata();
+    EXPECT_EQ(meta->num_rows(), 200'000);
+    int row_groups = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().extension() != ".parquet") continue;
+        auto part = parquet::ParquetFileReader::OpenFile(entry.path().string());
+        row_groups += part->metadata()->num_row_groups();
+    }
+    ASSERT_EQ(meta->num_row_groups(), row_groups);
+    int64_t first_key = -1;
+    for (int g = 0; g < meta->num_row_groups(); ++g) {
+        auto chunk = meta->RowGroup(g)->ColumnChunk(0);
+        ASSERT_FALSE(chunk->file_path().empty());
+        EXPECT_TRUE(fs::exists(dir / chunk->file_path()));
+        // Row groups stay in generation order across parts
+        auto stats = std::static_pointer_cast<parquet::Int64Statistics>(chunk->statistics());
+        EXPECT_GT(stats->min(), first_key);
+        first_key = stats->max();
+    }
+
+    auto common = parquet::ParquetFileReader::OpenFile((dir / "_common_metadata").string());
+    EXPECT_EQ(common->metadata()->num_row_groups(), 0);
+    EXPECT_TRUE(common->metadata()->schema()->Equals(*meta->schema()));
+
+    const std::string manifest = read_file(dir / "_manifest.json");
+    EXPECT_NE(manifest.find("\"rows\": 200000"), std::string::npos);
+    EXPECT_NE(manifest.find("\"path\": \"part-00000.parquet\""), std::string::npos);
+    fs::remove_all(dir);
+}
+
+TEST(RollingFileWriter, CsvPartsThroughStreamFactory) {
+    auto dir = fresh_dir("tpch_rolling_csv_test");
+    std::vector<std::string> opened;
+    {
+        RollingFileWriter writer(dir.string(), "csv", 100 * 1024, [](const std::string& path) {
+            return std::make_unique<CSVWriter>(path);
+        });
+        ASSERT_TRUE(writer.set_output_stream_factory([&](const std::string& path) {
+            opened.push_back(path);
+            return *arrow::io::FileOutputStream::Open(path);
+        }));
+        for (int64_t base = 0; base < 50'000; base += 5'000) {
+            writer.write_batch(make_batch(base, 5'000));
+        }
+        writer.close();
+        ASSERT_GT(writer.parts().size(), 1u);
+        // Every part, then the manifest, went through the factory
+        EXPECT_EQ(opened.size(), writer.parts().size() + 1);
+        EXPECT_EQ(opened.back(), (dir / "_manifest.json").string());
+    }
+    EXPECT_FALSE(fs::exists(dir / "_metadata"));
+    fs::remove_all(dir);
+}
+
+namespace {
+
+// Writes nothing; reports a fixed unit and records the batches it receives
+class UnitWriter : public WriterInterface {
+public:
+    UnitWriter(std::vector<int64_t>& rows, size_t unit) : rows_(rows), unit_(unit) {}
+    void write_batch(const std::shared_ptr<arrow::RecordBatch>& batch) override {
+        rows_.push_back(batch->num_rows());
+    }
+    void close() override {}
+    size_t preferred_unit_rows() const override { return unit_; }
+
+private:
+    std::vector<int64_t>& rows_;
+    size_t unit_;
+};
+
+}  // namespace
+
+TEST(RollingFileWriter, RollsAtUnitBoundariesForAnyBatchSize) {
+    auto dir = fresh_dir("tpch_rolling_unit_test");
+    constexpr int64_t kUnit = 4'096;
+    std::vector<int64_t> written;
+    {
+        RollingFileWriter writer(dir.string(), "bin", 64 * 1024, [&](const std::string&) {
+            return std::make_unique<UnitWriter>(written, kUnit);
+        });
+        // Neither size divides the unit; the sizes change as the adaptive sizer's do
+        int64_t base = 0;
+        for (int i = 0; i < 40; ++i) {
+            const int64_t rows = i < 20 ? 1'000 : 1'000 + 337 * (i % 7);
+            writer.write_batch(make_batch(base, rows));
+            base += rows;
+        }
+        writer.close();
+
+        ASSERT_GT(writer.parts().size(), 2u);
+        int64_t rows = 0;
+        for (size_t i = 0; i < writer.parts().size(); ++i) {
+            if (i + 1 < writer.parts().size()) {
+                EXPECT_EQ(writer.parts()[i].rows % kUnit, 0) << "part " << i;
+            }
+            rows += writer.parts()[i].rows;
+        }
+        EXPECT_EQ(rows, base);
+    }
+    // No piece handed to a part straddles a unit boundary
+    int64_t offset = 0;
+    for (int64_t rows : written) {
+        EXPECT_LE(offset % kUnit + rows, kUnit);
+        offset += rows;
+    }
+    fs::remove_all(dir);
+}
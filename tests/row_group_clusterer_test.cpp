@@ -0,0 +1,197 @@
+// Unit tests: clustering rows within row groups by dictionary columns
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+
+#include "tpch/parquet_writer.hpp"
+#include "tpch/row_group_clusterer.hpp"
+
+using namespace tpch;
+
+namespace {
+
+std::shared_ptr<arrow::Array> make_dictionary(const std::vector<std::string>& values) {
+    arrow::StringBuilder builder;
+    EXPECT_TRUE(builder.AppendValues(values).ok());
+    return *builder.Finish();
+}
+
+// l_orderkey, l_returnflag (dict8), l_linestatus (dict8), l_comment.
+// Flags change value from row to row, as in generated lineitem data.
+std::shared_ptr<arrow::RecordBatch> make_batch(int64_t base, int64_t rows,
+                                               const std::shared_ptr<arrow::Array>& flags,
+                                               const std::shared_ptr<arrow::Array>& statuses) {
+    arrow::Int64Builder keys;
+    arrow::Int8Builder flag_idx;
+    arrow::Int8Builder status_idx;
+    arrow::StringBuilder comments;
+    for (int64_t i = base; i < base + rows; ++i) {
+        EXPECT_TRUE(keys.Append(i).ok());
+        const uint64_t h = static_cast<uint64_t>(i) * 0x9E3779B97F4A7C15ULL;
+        EXPECT_TRUE(flag_idx.Append(static_cast<int8_t>((h >> 40) % flags->length())).ok());
+        if (i % 11 == 0) {
+            EXPECT_TRUE(status_idx.AppendNull().ok());
+        } else {
+            EXPECT_TRUE(status_idx.Append(static_cast<int8_t>((h >> 20) % statuses->length())).ok());
+        }
+        EXPECT_TRUE(comments.Append("comment " + std::to_string(i * 31 % 9973)).ok());
+    }
+    auto dict8 = arrow::dictionary(arrow::int8(), arrow::utf8());
+    auto schema = arrow::schema({arrow::field("l_orderkey", arrow::int64()),
+                                 arrow::field("l_returnflag", dict8),
+                                 arrow::field("l_linestatus", dict8),
+                                 arrow::field("l_comment", arrow::utf8())});
+    auto flag = *arrow::DictionaryArray::FromArrays(dict8, *flag_idx.Finish(), flags);
+    auto status = *arrow::DictionaryArray::FromArrays(dict8, *status_idx.Finish(), statuses);
+    return arrow::RecordBatch::Make(schema, rows, {*keys.Finish(), flag, status, *comments.Finish()});
+}
+
+using Row = std::tuple<std::string, std::string, int64_t, std::string>;
+
+std::string dict_value(const arrow::Array& column, int64_t i) {
+    if (column.IsNull(i)) return "";
+    const auto& dict = static_cast<const arrow::DictionaryArray&>(column);
+    return static_cast<const arrow::StringArray&>(*dict.dictionary()).GetString(dict.GetValueIndex(i));
+}
+
+std::vector<Row> rows_of(const arrow::RecordBatch& batch) {
+    const auto& keys = static_cast<const arrow::Int64Array&>(*batch.column(0));
+    const auto& comments = static_cast<const arrow::StringArray&>(*batch.column(3));
+    std::vector<Row> rows;
+    for (int64_t i = 0; i < batch.num_rows(); ++i) {
+        rows.emplace_back(dict_value(*batch.column(1), i), dict_value(*batch.column(2), i),
+                          keys.Value(i), comments.GetString(i));
+    }
+    return rows;
+}
+
+}  // namespace
+
+TEST(RowGroupClusterer, SortsEachGroupStablyAcrossDictionaries) {
+    auto flags = make_dictionary({"R", "A", "N"});
+    auto statuses = make_dictionary({"O", "F"});
+    // A later batch with its own dictionary: merged within the group
+    auto flags2 = make_dictionary({"N", "R", "X", "A"});
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> input = {
+        make_batch(0, 3000, flags, statuses), make_batch(3000, 4500, flags2, statuses),
+        make_batch(7500, 2600, flags, statuses)};
+
+    RowGroupClusterer clusterer(input[0]->schema(), {"l_returnflag", "l_linestatus", "missing"},
+                                4000);
+    ASSERT_TRUE(clusterer.active());
+    EXPECT_EQ(clusterer.key_names(), (std::vector<std::string>{"l_returnflag", "l_linestatus"}));
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> groups;
+    for (const auto& batch : input) {
+        for (auto& group : clusterer.push(batch)) groups.push_back(group);
+    }
+    ASSERT_EQ(groups.size(), 2u);
+    groups.push_back(clusterer.flush());
+    ASSERT_NE(groups.back(), nullptr);
+    EXPECT_EQ(clusterer.flush(), nullptr);
+
+    int64_t first_key = 0;
+    for (size_t g = 0; g < groups.size(); ++g) {
+        ASSERT_TRUE(groups[g]->ValidateFull().ok());
+        EXPECT_EQ(groups[g]->num_rows(), g < 2 ? 4000 : 2100);
+        const auto rows = rows_of(*groups[g]);
+        // Sorted by (flag, status), nulls first; ties keep generation order
+        EXPECT_TRUE(std::is_sorted(rows.begin(), rows.end()));
+
+        // Same rows as the input range of this group
+        std::map<int64_t, Row> expected;
+        for (const auto& batch : input) {
+            for (const auto& row : rows_of(*batch)) {
+                if (std::get<2>(row) >= first_key && std::get<2>(row) < first_key + 4000) {
+                    expected.emplace(std::get<2>(row), row);
+                }
+            }
+        }
+        ASSERT_EQ(expected.size(), rows.size());
+        for (const auto& row : rows) {
+            EXPECT_EQ(expected.at(std::get<2>(row)), row);
+        }
+        first_key += 4000;
+    }
+
+    auto plain = arrow::schema({arrow::field("l_returnflag", arrow::utf8())});
+    EXPECT_THROW(RowGroupClusterer(plain, {"l_returnflag"}, 100), std::invalid_argument);
+    EXPECT_FALSE(RowGroupClusterer(plain, {"o_orderstatus"}, 100).active());
+}
+
+TEST(ParquetWriter, ClusterWithinRowGroupRecordsSortingColumns) {
+    auto flags = make_dictionary({"R", "A", "N"});
+    auto statuses = make_dictionary({"O", "F"});
+    auto dir = std::filesystem::temp_directory_path();
+
+    auto write = [&](const std::filesystem::path& path, bool cluster, bool streaming) {
+        ParquetWriter writer(path.string());
+        ParquetOptions options;
+        options.row_group_bytes = 512 * 1024;
+        if (cluster) options.parse_cluster_columns("l_returnflag,l_linestatus");
+        writer.set_parquet_options(options);
+        if (streaming) writer.enable_streaming_write();
+        for (int64_t base = 0; base < 60'000; base += 7'000) {
+            writer.write_batch(make_batch(base, std::min<int64_t>(7'000, 60'000 - base), flags, statuses));
+        }
+        writer.close();
+    };
+
+    auto flag_bytes = [](const std::filesystem::path& path) {
+        auto meta = parquet::ParquetFileReader::OpenFile(path.string())->metadata();
+        int64_t bytes = 0;
+        for (int g = 0; g < meta->num_row_groups(); ++g) {
+            bytes += meta->RowGroup(g)->ColumnChunk(1)->total_compressed_size();
+            bytes += meta->RowGroup(g)->ColumnChunk(2)->total_compressed_size();
+        }
+        return bytes;
+    };
+
+    const auto plain = dir / "tpch_cluster_plain_test.parquet";
+    write(plain, false, true);
+    for (bool streaming : {true, false}) {
+        const auto path = dir / "tpch_cluster_test.parquet";
+        write(path, true, streaming);
+
+        auto reader = parquet::ParquetFileReader::OpenFile(path.string());
+        auto meta = reader->metadata();
+        ASSERT_GT(meta->num_row_groups(), 1);
+        for (int g = 0; g < meta->num_row_groups(); ++g) {
+            const auto sorting = meta->RowGroup(g)->sorting_columns();
+            ASSERT_EQ(sorting.size(), 2u);
+            EXPECT_EQ(sorting[0].column_idx, 1);
+            EXPECT_EQ(sorting[1].column_idx, 2);
+            EXPECT_TRUE(sorting[0].nulls_first);
+        }
+        // Runs of flags/statuses encode smaller than values changing every row
+        EXPECT_LT(flag_bytes(path), flag_bytes(plain) / 2);
+
+        // Row groups keep their key ranges; every row is still there
+        std::unique_ptr<parquet::arrow::FileReader> arrow_reader;
+        auto file = *arrow::io::ReadableFile::Open(path.string());
+        arrow_reader = *parquet::arrow::OpenFile(file, arrow::default_memory_pool());
+        std::shared_ptr<arrow::Table> table;
+        ASSERT_TRUE(arrow_reader->ReadTable(&table).ok());
+        ASSERT_EQ(table->num_rows(), 60'000);
+        auto keys = table->column(0);
+        int64_t sum = 0;
+        for (const auto& chunk : keys->chunks()) {
+            const auto& values = static_cast<const arrow::Int64Array&>(*chunk);
+            for (int64_t i = 0; i < values.length(); ++i) sum += values.Value(i);
+        }
+        EXPECT_EQ(sum, 60'000LL * 59'999 / 2);
+        std::filesystem::remove(path);
+    }
+    std::filesystem::remove(plain);
+}
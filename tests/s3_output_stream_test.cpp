@@ -0,0 +1,270 @@
+// Unit tests: S3OutputStream part cutting, upload window and abort
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <arrow/buffer.h>
+#include <arrow/memory_pool.h>
+#include <arrow/result.h>
+#include <arrow/status.h>
+
+#include "tpch/s3_output_stream.hpp"
+
+using namespace tpch;
+
+namespace {
+
+constexpr size_t PART = S3UploadConfig::ARROW_PART_BYTES;
+
+// Stands in for Arrow's S3 stream: records each write.
+class RecordingUpload : public arrow::io::OutputStream {
+public:
+    arrow::Status Write(const void* data, int64_t nbytes) override {
+        auto* p = static_cast<const uint8_t*>(data);
+        writes.emplace_back(p, p + nbytes);
+        return arrow::Status::OK();
+    }
+    arrow::Status Flush() override {
+        ++flushes;
+        return arrow::Status::OK();
+    }
+    arrow::Status Close() override {
+        closed_ = true;
+        return arrow::Status::OK();
+    }
+    arrow::Status Abort() override {
+        aborted = true;
+        closed_ = true;
+        return arrow::Status::OK();
+    }
+    arrow::Result<int64_t> Tell() const override { return 0; }
+    bool closed() const override { return closed_; }
+
+    std::vector<std::vector<uint8_t>> writes;
+    int  flushes = 0;
+    bool aborted = false;
+    bool closed_ = false;
+};
+
+// Stands in for Arrow's S3 stream with background writes: copies writes
+// into a PART-byte part buffer from the window, allocated at the part's
+// first byte and queued once full. A worker acknowledges (frees) the oldest
+// queued part, after a short round trip, only once `busy` parts are queued
+// (a slow link), or while draining.
+class WindowedUpload : public arrow::io::OutputStream {
+public:
+    WindowedUpload(std::shared_ptr<UploadWindow> w, size_t busy)
+        : window(std::move(w)), busy_(busy), worker_([this] { run(); }) {}
+
+    ~WindowedUpload() override {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    arrow::Status Write(const void* data, int64_t nbytes) override {
+        auto* p = static_cast<const uint8_t*>(data);
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!part_) {
+            ARROW_ASSIGN_OR_RAISE(part_, arrow::AllocateBuffer(static_cast<int64_t>(PART), window.get()));
+            held_at_part_start.push_back(window->bytes_allocated());
+        }
+        if (used_ + static_cast<size_t>(nbytes) > PART) {
+            return arrow::Status::Invalid("write crosses a part boundary");
+        }
+        std::memcpy(part_->mutable_data() + used_, data, static_cast<size_t>(nbytes));
+        used_ += static_cast<size_t>(nbytes);
+        bytes.insert(bytes.end(), p, p + nbytes);
+        if (used_ == PART) commit();
+        return arrow::Status::OK();
+    }
+    arrow::Status Flush() override {
+        ++flushes;
+        drain();
+        return arrow::Status::OK();
+    }
+    arrow::Status Close() override {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (part_) commit();  // the short tail
+        }
+        drain();
+        closed_ = true;
+        return arrow::Status::OK();
+    }
+    arrow::Status Abort() override {
+        closed_ = true;
+        return arrow::Status::OK();
+    }
+    arrow::Result<int64_t> Tell() const override { return 0; }
+    bool closed() const override { return closed_; }
+
+    std::shared_ptr<UploadWindow> window;
+    std::vector<uint8_t> bytes;
+    std::vector<int64_t> held_at_part_start;  // window bytes, new part included
+    int  flushes = 0;
+    bool closed_ = false;
+
+private:
+    void commit() {
+        queue_.push_back(std::move(part_));
+        used_ = 0;
+        cv_.notify_all();
+    }
+
+    void drain() {
+        std::unique_lock<std::mutex> lock(mu_);
+        draining_ = true;
+        cv_.notify_all();
+        cv_.wait(lock, [&] { return queue_.empty(); });
+        draining_ = false;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mu_);
+        for (;;) {
+            cv_.wait(lock, [&] {
+                return stop_ || queue_.size() >= busy_ || (draining_ && !queue_.empty());
+            });
+            if (queue_.empty()) return;
+            // Round trip: the producer runs on meanwhile unless it waits
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            lock.lock();
+            queue_.pop_front();  // frees the part into the window
+            cv_.notify_all();
+        }
+    }
+
+    std::mutex              mu_;
+    std::condition_variable cv_;
+    std::shared_ptr<arrow::Buffer>             part_;
+    size_t                                     used_ = 0;
+    std::deque<std::shared_ptr<arrow::Buffer>> queue_;
+    size_t      busy_;
+    bool        draining_ = false;
+    bool        stop_     = false;
+    std::thread worker_;
+};
+
+std::vector<uint8_t> pattern(size_t n) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>((i * 131) ^ (i >> 9));
+    return v;
+}
+
+}  // namespace
+
+TEST(S3OutputStream, WritesForwardedAndCutAtPartBoundaries) {
+    auto upload = std::make_shared<RecordingUpload>();
+    auto data = pattern(7 * PART + 12345);  // 8 parts, the last one short
+    {
+        S3OutputStream out(upload, "s3://bucket/t.bin");
+        size_t off = 0, step = 1;
+        while (off < data.size()) {
+            size_t n = std::min(step, data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+            off += n;
+            step = step * 7 % 23'000'017 + 1;  // small and multi-part, unaligned writes
+        }
+        EXPECT_EQ(*out.Tell(), static_cast<int64_t>(data.size()));
+        EXPECT_EQ(out.parts(), 8);
+        ASSERT_TRUE(out.Close().ok());
+    }
+
+    // Every write lands in the uploader as is, split only where a part ends
+    size_t pos = 0;
+    std::vector<uint8_t> joined;
+    for (const auto& w : upload->writes) {
+        EXPECT_LE(pos % PART + w.size(), PART) << "write at " << pos;
+        pos += w.size();
+        joined.insert(joined.end(), w.begin(), w.end());
+    }
+    EXPECT_EQ(joined, data);
+    EXPECT_EQ(upload->flushes, 0);
+    EXPECT_TRUE(upload->closed());
+}
+
+TEST(S3OutputStream, WindowBoundsHeldPartBuffers) {
+    auto window = std::make_shared<UploadWindow>();
+    auto upload = std::make_shared<WindowedUpload>(window, 3);
+    S3UploadConfig config;
+    config.max_uploads = 2;  // default window: 3 parts
+
+    auto data = pattern(8 * PART + 777);
+    {
+        S3OutputStream out(upload, "s3://bucket/t.bin", config, window);
+        for (size_t off = 0; off < data.size(); off += 3 << 20) {
+            size_t n = std::min<size_t>(3 << 20, data.size() - off);
+            ASSERT_TRUE(out.Write(data.data() + off, static_cast<int64_t>(n)).ok());
+        }
+        ASSERT_TRUE(out.Close().ok());
+    }
+
+    // The uploader acknowledges only with 3 parts queued: a new part must
+    // wait until one is freed, and the window is never drained
+    ASSERT_EQ(upload->held_at_part_start.size(), 9u);
+    for (size_t i = 0; i < upload->held_at_part_start.size(); ++i) {
+        EXPECT_EQ(upload->held_at_part_start[i], static_cast<int64_t>(std::min<size_t>(i + 1, 3) * PART))
+            << "part " << i;
+    }
+    EXPECT_EQ(upload->flushes, 0);
+    EXPECT_EQ(window->bytes_allocated(), 0);
+    EXPECT_EQ(window->total_bytes_allocated(), static_cast<int64_t>(9 * PART));
+    EXPECT_EQ(upload->bytes, data);
+}
+
+TEST(S3OutputStream, SmallWindowIsOnePart) {
+    auto window = std::make_shared<UploadWindow>();
+    auto upload = std::make_shared<WindowedUpload>(window, 1);
+    S3UploadConfig config;
+    config.window_bytes = 1024;  // below one Arrow part
+
+    auto data = pattern(3 * PART);
+    {
+        S3OutputStream out(upload, "s3://bucket/t.bin", config, window);
+        ASSERT_TRUE(out.Write(data.data(), static_cast<int64_t>(data.size())).ok());
+        ASSERT_TRUE(out.Close().ok());
+    }
+    for (int64_t held : upload->held_at_part_start) {
+        EXPECT_EQ(held, static_cast<int64_t>(PART));  // one part at a time
+    }
+    EXPECT_EQ(upload->bytes, data);
+}
+
+TEST(S3OutputStream, AbortCancelsUpload) {
+    auto upload = std::make_shared<RecordingUpload>();
+    auto data = pattern(3 * 1024 * 1024);
+
+    S3OutputStream out(upload, "s3://bucket/t.bin");
+    ASSERT_TRUE(out.Write(data.data(), static_cast<int64_t>(data.size())).ok());
+    ASSERT_TRUE(out.Abort().ok());
+    EXPECT_TRUE(upload->aborted);
+    EXPECT_FALSE(out.Write(data.data(), 1).ok());
+
+    auto dropped = std::make_shared<RecordingUpload>();
+    {
+        S3OutputStream unclosed(dropped, "s3://bucket/u.bin");
+        ASSERT_TRUE(unclosed.Write(data.data(), 100).ok());
+    }
+    EXPECT_TRUE(dropped->aborted);  // an unclosed stream is never completed
+}
+
+TEST(S3OutputStream, OpenRejectsNonS3Uri) {
+    EXPECT_FALSE(is_s3_uri("/tmp/x.parquet"));
+    EXPECT_TRUE(is_s3_uri("s3://bucket/prefix/x.parquet"));
+    EXPECT_THROW(S3OutputStream::open("/tmp/x.parquet"), std::runtime_error);
+}
@@ -0,0 +1,69 @@
+// Unit tests: StripeLayout placement policies and manifest
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "tpch/stripe_layout.hpp"
+
+using namespace tpch;
+
+TEST(StripeLayout, ParseSplitsCommaList) {
+    EXPECT_EQ(StripeLayout::parse("/a,/b,,/c"), (std::vector<std::string>{"/a", "/b", "/c"}));
+    EXPECT_EQ(StripeLayout::parse("/tmp"), (std::vector<std::string>{"/tmp"}));
+    EXPECT_TRUE(StripeLayout::parse("").empty());
+    EXPECT_THROW(StripeLayout::parse_policy("random"), std::invalid_argument);
+}
+
+TEST(StripeLayout, LeastBytesBalancesLargestFirst) {
+    StripeLayout layout({"/d0", "/d1/"});
+    // TPC-H-like sizes, largest first: lineitem alone on one drive
+    EXPECT_EQ(layout.place("lineitem", "lineitem.parquet", 700), "/d0/lineitem.parquet");
+    EXPECT_EQ(layout.place("orders", "orders.parquet", 170), "/d1/orders.parquet");
+    EXPECT_EQ(layout.place("partsupp", "partsupp.parquet", 110), "/d1/partsupp.parquet");
+    EXPECT_EQ(layout.place("part", "part.parquet", 25), "/d1/part.parquet");
+
+    // Unknown sizes fall back to the fewest pieces
+    StripeLayout unknown({"/d0", "/d1", "/d2"});
+    EXPECT_EQ(unknown.place("a", "a.csv"), "/d0/a.csv");
+    EXPECT_EQ(unknown.place("b", "b.csv"), "/d1/b.csv");
+    EXPECT_EQ(unknown.place("c", "c.csv"), "/d2/c.csv");
+    EXPECT_EQ(unknown.place("d", "d.csv"), "/d0/d.csv");
+}
+
+TEST(StripeLayout, RoundRobinIgnoresSizes) {
+    StripeLayout layout({"/d0", "/d1"}, StripeLayout::Policy::RoundRobin);
+    EXPECT_EQ(layout.place("a", "a", 1000), "/d0/a");
+    EXPECT_EQ(layout.place("b", "b", 1), "/d1/b");
+    EXPECT_EQ(layout.place("c", "c", 1), "/d0/c");
+}
+
+TEST(StripeLayout, ManifestRecordsMeasuredBytes) {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / "tpch_stripe_layout_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "d0");
+    fs::create_directories(root / "d1");
+
+    StripeLayout layout({(root / "d0").string(), (root / "d1").string()});
+    std::string file = layout.place("nation", "nation.csv", 10);
+    std::string dir  = layout.place("region", "region.paimon", 5);
+    std::ofstream(file) << "0123456789";
+    fs::create_directories(fs::path(dir) / "bucket-0");
+    std::ofstream(fs::path(dir) / "bucket-0" / "data.parquet") << "abc";
+
+    std::string manifest = (root / "d0" / "manifest.json").string();
+    layout.write_manifest(manifest);
+
+    std::ifstream in(manifest);
+    std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    EXPECT_NE(text.find("\"table\": \"nation\", \"path\": \"" + file + "\", \"directory\": 0, \"bytes\": 10"),
+              std::string::npos) << text;
+    EXPECT_NE(text.find("\"table\": \"region\", \"path\": \"" + dir + "\", \"directory\": 1, \"bytes\": 3"),
+              std::string::npos) << text;
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,59 @@
+// Unit tests: WriteThrottle shared token bucket
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tpch/write_throttle.hpp"
+
+using namespace tpch;
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+}  // namespace
+
+TEST(WriteThrottle, DisabledIsFree) {
+    EXPECT_FALSE(WriteThrottle::init(0, 0));
+    EXPECT_FALSE(WriteThrottle::enabled());
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i) WriteThrottle::acquire(1 << 20);
+    EXPECT_LT(seconds_since(t0), 0.1);
+    EXPECT_EQ(WriteThrottle::total_throttled_seconds(), 0.0);
+}
+
+TEST(WriteThrottle, BandwidthSharedAcrossFork) {
+    // 16 MiB/s shared: two processes writing 4 MiB each need ~0.5 s
+    ASSERT_TRUE(WriteThrottle::init(16.0 * 1024 * 1024, 0));
+    auto t0 = std::chrono::steady_clock::now();
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    for (int i = 0; i < 16; ++i) WriteThrottle::acquire(256 * 1024);
+    if (pid == 0) _exit(0);
+
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    double elapsed = seconds_since(t0);
+
+    EXPECT_GT(elapsed, 0.4);
+    EXPECT_LT(elapsed, 1.5);
+    EXPECT_GT(WriteThrottle::total_throttled_seconds(), WriteThrottle::throttled_seconds());
+    EXPECT_GT(WriteThrottle::throttled_seconds(), 0.0);
+    WriteThrottle::init(0, 0);
+}
+
+TEST(WriteThrottle, IopsLimit) {
+    // 200 writes/s, no credit right after init: 60 writes take ~0.3 s
+    ASSERT_TRUE(WriteThrottle::init(0, 200));
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 60; ++i) WriteThrottle::acquire(1);
+    EXPECT_GT(seconds_since(t0), 0.25);
+    WriteThrottle::init(0, 0);
+}